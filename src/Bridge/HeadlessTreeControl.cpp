@@ -0,0 +1,182 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "HeadlessTreeControl.h"
+
+#include <algorithm>
+
+
+HTREEITEM HeadlessTreeControl::insertItem(HTREEITEM parent, HTREEITEM insertAfter, const TreeItemSpec& item) {
+	if (parent && parent != TVI_ROOT && !items.contains(parent)) {
+		return nullptr;		// TreeView refuses unknown parents too
+	}
+
+	const HTREEITEM handle = reinterpret_cast<HTREEITEM>(++nextHandle);
+	Item& inserted = items[handle];
+	inserted.parent = parent ? parent : TVI_ROOT;
+	inserted.spec = item;
+
+	std::vector<HTREEITEM>& siblings = childListOf(parent);
+	auto position = siblings.end();
+	if (insertAfter == TVI_FIRST) {
+		position = siblings.begin();
+	}
+	else if (insertAfter && insertAfter != TVI_LAST) {
+		const auto after = std::find(siblings.begin(), siblings.end(), insertAfter);
+		if (after != siblings.end()) {
+			position = after + 1;
+		}
+	}
+	siblings.insert(position, handle);
+
+	record(TreeOperationKind::Insert, handle);
+	return handle;
+}
+
+void HeadlessTreeControl::deleteItem(HTREEITEM item) {
+	record(TreeOperationKind::Delete, item);
+	const auto found = items.find(item);
+	if (found == items.end()) {
+		return;
+	}
+
+	std::vector<HTREEITEM>& siblings = childListOf(found->second.parent);
+	siblings.erase(std::remove(siblings.begin(), siblings.end(), item), siblings.end());
+	forget(item);
+}
+
+void HeadlessTreeControl::setItem(HTREEITEM item, const TreeItemChange& change) {
+	record(TreeOperationKind::Set, item);
+	const auto found = items.find(item);
+	if (found == items.end()) {
+		return;
+	}
+
+	TreeItemSpec& spec = found->second.spec;
+	if (change.text) spec.text = *change.text;
+	if (change.image) spec.image = *change.image;
+	if (change.selectedImage) spec.selectedImage = *change.selectedImage;
+	if (change.stateImage) spec.stateImage = *change.stateImage;
+	if (change.param) spec.param = *change.param;
+}
+
+void HeadlessTreeControl::expand(HTREEITEM item, bool expanded) {
+	record(TreeOperationKind::Expand, item);
+	const auto found = items.find(item);
+	if (found == items.end() || found->second.expanded == expanded) {
+		return;
+	}
+
+	if (expanded && onExpanding) {
+		onExpanding(item);
+	}
+	items[item].expanded = expanded;	// onExpanding may have inserted items
+}
+
+void HeadlessTreeControl::selectItem(HTREEITEM item) {
+	record(TreeOperationKind::Select, item);
+	selection = items.contains(item) ? item : nullptr;
+}
+
+void HeadlessTreeControl::ensureVisible(HTREEITEM item) {
+	record(TreeOperationKind::EnsureVisible, item);
+}
+
+void HeadlessTreeControl::setRedraw(bool) {
+	record(TreeOperationKind::Redraw, nullptr);
+}
+
+void HeadlessTreeControl::resetOperations() {
+	log.clear();
+	counts.fill(0);
+}
+
+void HeadlessTreeControl::sortChildren(HTREEITEM parent) {
+	record(TreeOperationKind::Sort, parent);
+	std::vector<HTREEITEM>& children = childListOf(parent);
+	std::stable_sort(children.begin(), children.end(), [this](HTREEITEM first, HTREEITEM second) {
+		return items.at(first).spec.param < items.at(second).spec.param;
+	});
+}
+
+std::vector<HTREEITEM> HeadlessTreeControl::childrenOf(HTREEITEM parent) const {
+	if (!parent || parent == TVI_ROOT) {
+		return topLevel;
+	}
+	const auto found = items.find(parent);
+	return found != items.end() ? found->second.children : std::vector<HTREEITEM>();
+}
+
+bool HeadlessTreeControl::getItem(HTREEITEM item, TreeItemSpec& spec) {
+	const TreeItemSpec* found = find(item);
+	if (!found) {
+		return false;
+	}
+	spec = *found;
+	spec.childrenOnDemand = false;
+	return true;
+}
+
+const TreeItemSpec* HeadlessTreeControl::find(HTREEITEM item) const {
+	const auto found = items.find(item);
+	return found != items.end() ? &found->second.spec : nullptr;
+}
+
+bool HeadlessTreeControl::isExpanded(HTREEITEM item) const {
+	const auto found = items.find(item);
+	return found != items.end() && found->second.expanded;
+}
+
+void HeadlessTreeControl::clear() {
+	for (HTREEITEM item : std::vector<HTREEITEM>(topLevel)) {
+		forget(item);
+	}
+	topLevel.clear();
+	items.clear();
+	selection = nullptr;
+	resetOperations();
+}
+
+void HeadlessTreeControl::record(TreeOperationKind kind, HTREEITEM item) {
+	log.push_back({ kind, item });
+	++counts[static_cast<size_t>(kind)];
+}
+
+std::vector<HTREEITEM>& HeadlessTreeControl::childListOf(HTREEITEM parent) {
+	if (!parent || parent == TVI_ROOT) {
+		return topLevel;
+	}
+	return items[parent].children;
+}
+
+void HeadlessTreeControl::forget(HTREEITEM item) {
+	const auto found = items.find(item);
+	if (found == items.end()) {
+		return;
+	}
+
+	const std::vector<HTREEITEM> children = std::move(found->second.children);
+	for (HTREEITEM child : children) {
+		forget(child);
+	}
+	if (onDeleted) {
+		onDeleted(item);
+	}
+	if (selection == item) {
+		selection = nullptr;
+	}
+	items.erase(item);
+}
@@ -0,0 +1,98 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "TreeControl.h"
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// TreeControl without a window: keeps the item hierarchy in memory and
+// records every operation, so tools/HostSimulator can count what a workload
+// costs in control calls and check the tree it produced. The callbacks stand
+// in for the TVN_ITEMEXPANDING and TVN_DELETEITEM notifications the panel
+// handles.
+
+enum class TreeOperationKind {
+	Insert,
+	Delete,
+	Set,
+	Expand,
+	Select,
+	EnsureVisible,
+	Redraw,
+	Sort,
+	Count
+};
+
+struct TreeOperation {
+	TreeOperationKind kind = TreeOperationKind::Insert;
+	HTREEITEM item = nullptr;
+};
+
+class HeadlessTreeControl : public TreeControl {
+public:
+	HTREEITEM insertItem(HTREEITEM parent, HTREEITEM insertAfter, const TreeItemSpec& item) override;
+	void deleteItem(HTREEITEM item) override;
+	void setItem(HTREEITEM item, const TreeItemChange& change) override;
+	void expand(HTREEITEM item, bool expanded) override;
+	void selectItem(HTREEITEM item) override;
+	void ensureVisible(HTREEITEM item) override;
+	HTREEITEM selectedItem() override { return selection; }
+	void setRedraw(bool enabled) override;
+	void sortChildren(HTREEITEM parent) override;
+	std::vector<HTREEITEM> childrenOf(HTREEITEM parent) override { return std::as_const(*this).childrenOf(parent); }
+	bool getItem(HTREEITEM item, TreeItemSpec& spec) override;
+
+	std::function<void(HTREEITEM)> onExpanding;	// Before a collapsed item expands
+	std::function<void(HTREEITEM)> onDeleted;	// For the item and each of its children
+
+	const std::vector<TreeOperation>& operations() const { return log; }
+	size_t operationCount() const { return log.size(); }
+	size_t count(TreeOperationKind kind) const { return counts[static_cast<size_t>(kind)]; }
+	void resetOperations();
+
+	// Tree state
+	size_t itemCount() const { return items.size(); }
+	std::vector<HTREEITEM> childrenOf(HTREEITEM parent) const;	// nullptr or TVI_ROOT for the top level
+	const TreeItemSpec* find(HTREEITEM item) const;
+	bool isExpanded(HTREEITEM item) const;
+	void clear();
+
+private:
+	struct Item {
+		HTREEITEM parent = TVI_ROOT;
+		TreeItemSpec spec;
+		bool expanded = false;
+		std::vector<HTREEITEM> children;
+	};
+
+	void record(TreeOperationKind kind, HTREEITEM item);
+	std::vector<HTREEITEM>& childListOf(HTREEITEM parent);
+	void forget(HTREEITEM item);
+
+	std::unordered_map<HTREEITEM, Item> items;
+	std::vector<HTREEITEM> topLevel;
+	HTREEITEM selection = nullptr;
+	uintptr_t nextHandle = 0;
+	std::vector<TreeOperation> log;
+	std::array<size_t, static_cast<size_t>(TreeOperationKind::Count)> counts{};
+};
@@ -0,0 +1,113 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "HostBridge.h"
+
+#include <stdexcept>
+
+
+namespace {
+HostBridge* installedBridge = nullptr;
+}
+
+
+HostBridge& hostBridge() {
+	if (!installedBridge) {
+		throw std::logic_error("No host bridge installed");
+	}
+	return *installedBridge;
+}
+
+void setHostBridge(HostBridge* bridge) {
+	installedBridge = bridge;
+}
+
+unsigned openViewsOfBuffer(HostBridge& host, HostBufferID bufferID) {
+	// The position of a buffer open in both views is in the view asked first.
+	const intptr_t inMain = host.positionOfBuffer(bufferID, HOST_MAIN_VIEW);
+	if (inMain == -1) {
+		return 0;
+	}
+	const intptr_t inSub = host.positionOfBuffer(bufferID, HOST_SUB_VIEW);
+	return (1u << positionView(inMain)) | (1u << positionView(inSub));
+}
+
+std::string hostPathToUtf8(const std::wstring& path) {
+	std::string utf8;
+	utf8.reserve(path.size());
+	for (size_t i = 0; i < path.size(); ++i) {
+		char32_t code = static_cast<char32_t>(path[i]);
+		if constexpr (sizeof(wchar_t) == 2) {
+			if (code >= 0xD800 && code <= 0xDBFF && i + 1 < path.size()) {
+				const char32_t low = static_cast<char32_t>(path[i + 1]);
+				if (low >= 0xDC00 && low <= 0xDFFF) {
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					++i;
+				}
+			}
+		}
+
+		if (code < 0x80) {
+			utf8 += static_cast<char>(code);
+		}
+		else if (code < 0x800) {
+			utf8 += static_cast<char>(0xC0 | (code >> 6));
+			utf8 += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000) {
+			utf8 += static_cast<char>(0xE0 | (code >> 12));
+			utf8 += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			utf8 += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else {
+			utf8 += static_cast<char>(0xF0 | (code >> 18));
+			utf8 += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			utf8 += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			utf8 += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+	return utf8;
+}
+
+std::wstring utf8ToHostPath(const std::string& path) {
+	std::wstring wide;
+	wide.reserve(path.size());
+	for (size_t i = 0; i < path.size(); ) {
+		const unsigned char lead = static_cast<unsigned char>(path[i]);
+		size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+		if (length == 0 || i + length > path.size()) {
+			wide += static_cast<wchar_t>(0xFFFD);	// Not valid UTF-8
+			++i;
+			continue;
+		}
+
+		char32_t code = length == 1 ? lead : lead & (0x7F >> length);
+		for (size_t k = 1; k < length; ++k) {
+			code = (code << 6) | (static_cast<unsigned char>(path[i + k]) & 0x3F);
+		}
+		i += length;
+
+		if (sizeof(wchar_t) == 2 && code >= 0x10000) {
+			code -= 0x10000;
+			wide += static_cast<wchar_t>(0xD800 + (code >> 10));
+			wide += static_cast<wchar_t>(0xDC00 + (code & 0x3FF));
+		}
+		else {
+			wide += static_cast<wchar_t>(code);
+		}
+	}
+	return wide;
+}
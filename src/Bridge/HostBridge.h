@@ -0,0 +1,91 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+// Narrow view of the Notepad++ queries the plugin makes while it handles a
+// notification. Handlers used to send the same NPPM_* message several times
+// per event (dark mode once per folder and icon, buffer positions and paths
+// on every activation); going through the bridge lets an implementation
+// memoize the answers, and lets the model and sync code run without
+// Notepad++ at all (see InMemoryHostBridge).
+//
+// Views and positions follow the Notepad++ conventions: view 0 is the main
+// view, view 1 the sub view, and a buffer position carries the view in bits
+// 30-31 and the 0-based tab index in the lower 30 bits (-1 if not open).
+
+using HostBufferID = uintptr_t;
+
+constexpr int HOST_MAIN_VIEW = 0;
+constexpr int HOST_SUB_VIEW = 1;
+
+inline intptr_t encodeBufferPosition(int view, int index) { return (static_cast<intptr_t>(view) << 30) | (index & 0x3FFFFFFF); }
+inline int positionView(intptr_t position) { return static_cast<int>((position >> 30) & 0x3); }
+inline int positionIndex(intptr_t position) { return static_cast<int>(position & 0x3FFFFFFF); }
+
+// What a notification made stale.
+enum class HostInvalidation {
+	DarkMode,		// Theme switched
+	BufferPath,		// One buffer was renamed, saved under a new name, opened or closed
+	Buffers,		// Tabs were opened, closed, moved or activated
+	All
+};
+
+class HostBridge {
+public:
+	virtual ~HostBridge() = default;
+
+	virtual bool isDarkModeEnabled() = 0;
+	virtual HostBufferID currentBufferID() = 0;
+	virtual intptr_t positionOfBuffer(HostBufferID bufferID, int priorityView) = 0;
+	virtual std::wstring fullPathOfBuffer(HostBufferID bufferID) = 0;	// Empty if the buffer is unknown
+	virtual int openFileCount(int view) = 0;
+	virtual HostBufferID bufferIDAt(int index, int view) = 0;
+	virtual intptr_t currentDocIndex(int view) = 0;
+
+	virtual void activateDocument(int view, int index) = 0;
+	virtual void runMenuCommand(int commandID) = 0;
+
+	// Answers that depend on the tab layout are only reused between
+	// beginEvent() and the matching endEvent(); events may nest.
+	virtual void beginEvent() {}
+	virtual void endEvent() {}
+	virtual void invalidate(HostInvalidation what, HostBufferID bufferID = 0) { (void)what; (void)bufferID; }
+};
+
+HostBridge& hostBridge();
+void setHostBridge(HostBridge* bridge);
+
+// The views a buffer is open in, bit 1 << view for each; 0 once it is closed
+// in both.
+unsigned openViewsOfBuffer(HostBridge& host, HostBufferID bufferID);
+
+// Host paths are UTF-16 on Windows; the model keeps UTF-8.
+std::string hostPathToUtf8(const std::wstring& path);
+std::wstring utf8ToHostPath(const std::string& path);
+
+class ScopedHostEvent {
+public:
+	ScopedHostEvent() { hostBridge().beginEvent(); }
+	~ScopedHostEvent() { hostBridge().endEvent(); }
+
+	ScopedHostEvent(const ScopedHostEvent&) = delete;
+	ScopedHostEvent& operator=(const ScopedHostEvent&) = delete;
+};
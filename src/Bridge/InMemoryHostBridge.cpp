@@ -0,0 +1,185 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "InMemoryHostBridge.h"
+
+#include <algorithm>
+
+
+namespace {
+bool isValidView(int view) {
+	return view == HOST_MAIN_VIEW || view == HOST_SUB_VIEW;
+}
+}
+
+
+bool InMemoryHostBridge::isDarkModeEnabled() {
+	++queries;
+	return darkMode;
+}
+
+HostBufferID InMemoryHostBridge::currentBufferID() {
+	++queries;
+	const intptr_t index = activeIndex[activeView];
+	return index < 0 ? 0 : tabs[activeView][static_cast<size_t>(index)];
+}
+
+intptr_t InMemoryHostBridge::positionOfBuffer(HostBufferID bufferID, int priorityView) {
+	++queries;
+	const int firstView = priorityView == HOST_SUB_VIEW ? HOST_SUB_VIEW : HOST_MAIN_VIEW;
+	for (int view : { firstView, 1 - firstView }) {
+		const int index = indexInView(bufferID, view);
+		if (index >= 0) {
+			return encodeBufferPosition(view, index);
+		}
+	}
+	return -1;
+}
+
+std::wstring InMemoryHostBridge::fullPathOfBuffer(HostBufferID bufferID) {
+	++queries;
+	const Buffer* buffer = findBuffer(bufferID);
+	return buffer ? buffer->path : std::wstring();
+}
+
+int InMemoryHostBridge::openFileCount(int view) {
+	++queries;
+	return isValidView(view) ? static_cast<int>(tabs[view].size()) : 0;
+}
+
+HostBufferID InMemoryHostBridge::bufferIDAt(int index, int view) {
+	++queries;
+	if (!isValidView(view) || index < 0 || index >= static_cast<int>(tabs[view].size())) {
+		return 0;
+	}
+	return tabs[view][static_cast<size_t>(index)];
+}
+
+intptr_t InMemoryHostBridge::currentDocIndex(int view) {
+	++queries;
+	return isValidView(view) ? activeIndex[view] : -1;
+}
+
+void InMemoryHostBridge::activateDocument(int view, int index) {
+	++queries;
+	if (!isValidView(view) || index < 0 || index >= static_cast<int>(tabs[view].size())) {
+		return;
+	}
+	activeView = view;
+	activeIndex[view] = index;
+}
+
+void InMemoryHostBridge::runMenuCommand(int commandID) {
+	++queries;
+	(void)commandID;	// Menu commands have no effect on the simulated layout
+}
+
+HostBufferID InMemoryHostBridge::openBuffer(const std::wstring& path, int view) {
+	const HostBufferID bufferID = nextBufferID++;
+	buffers.push_back({ bufferID, path });
+	openBufferInView(bufferID, view);
+	return bufferID;
+}
+
+HostBufferID InMemoryHostBridge::reopenBuffer(HostBufferID bufferID, const std::wstring& path, int view) {
+	if (findBuffer(bufferID)) {
+		return 0;
+	}
+	buffers.push_back({ bufferID, path });
+	openBufferInView(bufferID, view);
+	return bufferID;
+}
+
+void InMemoryHostBridge::openBufferInView(HostBufferID bufferID, int view) {
+	if (!isValidView(view) || !findBuffer(bufferID)) {
+		return;
+	}
+	if (indexInView(bufferID, view) < 0) {
+		tabs[view].push_back(bufferID);
+	}
+	activeView = view;
+	activeIndex[view] = indexInView(bufferID, view);
+}
+
+void InMemoryHostBridge::closeBuffer(HostBufferID bufferID, int view) {
+	if (!isValidView(view)) {
+		return;
+	}
+	const int index = indexInView(bufferID, view);
+	if (index < 0) {
+		return;
+	}
+	tabs[view].erase(tabs[view].begin() + index);
+
+	// Notepad++ activates the tab that took the closed one's place.
+	const intptr_t count = static_cast<intptr_t>(tabs[view].size());
+	if (count == 0) {
+		activeIndex[view] = -1;
+		if (activeView == view) {
+			activeView = 1 - view;
+		}
+	}
+	else if (activeIndex[view] >= count || activeIndex[view] > index) {
+		activeIndex[view] = std::min<intptr_t>(activeIndex[view] - 1, count - 1);
+	}
+	else if (activeIndex[view] == index) {
+		activeIndex[view] = std::min<intptr_t>(index, count - 1);
+	}
+
+	if (indexInView(bufferID, 1 - view) < 0) {
+		std::erase_if(buffers, [bufferID](const Buffer& buffer) { return buffer.bufferID == bufferID; });
+	}
+}
+
+void InMemoryHostBridge::renameBuffer(HostBufferID bufferID, const std::wstring& path) {
+	for (Buffer& buffer : buffers) {
+		if (buffer.bufferID == bufferID) {
+			buffer.path = path;
+			return;
+		}
+	}
+}
+
+void InMemoryHostBridge::setActiveView(int view) {
+	if (isValidView(view)) {
+		activeView = view;
+	}
+}
+
+void InMemoryHostBridge::clear() {
+	buffers.clear();
+	for (int view = HOST_MAIN_VIEW; view <= HOST_SUB_VIEW; ++view) {
+		tabs[view].clear();
+		activeIndex[view] = -1;
+	}
+	activeView = HOST_MAIN_VIEW;
+	queries = 0;
+}
+
+const InMemoryHostBridge::Buffer* InMemoryHostBridge::findBuffer(HostBufferID bufferID) const {
+	for (const Buffer& buffer : buffers) {
+		if (buffer.bufferID == bufferID) {
+			return &buffer;
+		}
+	}
+	return nullptr;
+}
+
+int InMemoryHostBridge::indexInView(HostBufferID bufferID, int view) const {
+	const auto& viewTabs = tabs[view];
+	auto it = std::find(viewTabs.begin(), viewTabs.end(), bufferID);
+	return it == viewTabs.end() ? -1 : static_cast<int>(it - viewTabs.begin());
+}
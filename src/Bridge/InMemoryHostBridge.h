@@ -0,0 +1,72 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "HostBridge.h"
+
+#include <vector>
+
+
+// HostBridge that keeps the tab layout of both views in plain vectors, for
+// running the model and sync code on any platform (benchmarks, replaying
+// notification traces). The mutators mirror what Notepad++ does to its tabs;
+// queryCount() tells how many host round trips the code under test made.
+
+class InMemoryHostBridge : public HostBridge {
+public:
+	bool isDarkModeEnabled() override;
+	HostBufferID currentBufferID() override;
+	intptr_t positionOfBuffer(HostBufferID bufferID, int priorityView) override;
+	std::wstring fullPathOfBuffer(HostBufferID bufferID) override;
+	int openFileCount(int view) override;
+	HostBufferID bufferIDAt(int index, int view) override;
+	intptr_t currentDocIndex(int view) override;
+
+	void activateDocument(int view, int index) override;
+	void runMenuCommand(int commandID) override;
+
+	// Layout mutators
+	HostBufferID openBuffer(const std::wstring& path, int view = HOST_MAIN_VIEW);
+	// Opens a buffer under the ID of one that was closed, as Notepad++ reuses them.
+	HostBufferID reopenBuffer(HostBufferID bufferID, const std::wstring& path, int view = HOST_MAIN_VIEW);
+	void openBufferInView(HostBufferID bufferID, int view);	// Clone or move target
+	void closeBuffer(HostBufferID bufferID, int view);
+	void renameBuffer(HostBufferID bufferID, const std::wstring& path);
+	void setDarkMode(bool enabled) { darkMode = enabled; }
+	void setActiveView(int view);
+	void clear();
+
+	size_t queryCount() const { return queries; }
+	void resetQueryCount() { queries = 0; }
+
+private:
+	struct Buffer {
+		HostBufferID bufferID = 0;
+		std::wstring path;
+	};
+
+	const Buffer* findBuffer(HostBufferID bufferID) const;
+	int indexInView(HostBufferID bufferID, int view) const;
+
+	std::vector<Buffer> buffers;
+	std::vector<HostBufferID> tabs[2];
+	intptr_t activeIndex[2] = { -1, -1 };
+	int activeView = HOST_MAIN_VIEW;
+	bool darkMode = false;
+	HostBufferID nextBufferID = 1;
+	size_t queries = 0;
+};
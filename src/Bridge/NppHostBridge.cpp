@@ -0,0 +1,206 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "NppHostBridge.h"
+#include "../Framework/UtilityFramework.h"
+
+
+namespace {
+
+uint64_t memoKey(uintptr_t value, int view) {
+	return (static_cast<uint64_t>(value) << 1) | static_cast<uint64_t>(view & 1);
+}
+
+bool isValidView(int view) {
+	return view == HOST_MAIN_VIEW || view == HOST_SUB_VIEW;
+}
+
+}
+
+
+bool NppHostBridge::isDarkModeEnabled() {
+	if (!darkMode) {
+		darkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0) != 0;
+	}
+	return *darkMode;
+}
+
+HostBufferID NppHostBridge::currentBufferID() {
+	if (inEvent() && eventMemo.currentBufferID) {
+		return *eventMemo.currentBufferID;
+	}
+	const HostBufferID bufferID = static_cast<HostBufferID>(npp(NPPM_GETCURRENTBUFFERID, 0, 0));
+	if (inEvent()) {
+		eventMemo.currentBufferID = bufferID;
+	}
+	return bufferID;
+}
+
+intptr_t NppHostBridge::positionOfBuffer(HostBufferID bufferID, int priorityView) {
+	const uint64_t key = memoKey(bufferID, priorityView);
+	if (inEvent()) {
+		auto it = eventMemo.positions.find(key);
+		if (it != eventMemo.positions.end()) {
+			return it->second;
+		}
+	}
+	const intptr_t position = static_cast<intptr_t>(npp(NPPM_GETPOSFROMBUFFERID, bufferID, priorityView));
+	if (inEvent()) {
+		eventMemo.positions[key] = position;
+	}
+	return position;
+}
+
+std::wstring NppHostBridge::fullPathOfBuffer(HostBufferID bufferID) {
+	auto it = paths.find(bufferID);
+	if (it != paths.end()) {
+		return it->second;
+	}
+
+	const int len = static_cast<int>(npp(NPPM_GETFULLPATHFROMBUFFERID, bufferID, 0));
+	if (len < 0) {
+		return {};	// Unknown buffer; do not cache, the ID may show up later
+	}
+	std::wstring path(static_cast<size_t>(len), L'\0');
+	npp(NPPM_GETFULLPATHFROMBUFFERID, bufferID, path.data());
+	paths[bufferID] = path;
+	return path;
+}
+
+int NppHostBridge::openFileCount(int view) {
+	if (!isValidView(view)) {
+		return 0;
+	}
+	if (inEvent() && eventMemo.openFileCount[view]) {
+		return *eventMemo.openFileCount[view];
+	}
+	const int count = static_cast<int>(npp(NPPM_GETNBOPENFILES, 0, view == HOST_MAIN_VIEW ? PRIMARY_VIEW : SECOND_VIEW));
+	if (inEvent()) {
+		eventMemo.openFileCount[view] = count;
+	}
+	return count;
+}
+
+HostBufferID NppHostBridge::bufferIDAt(int index, int view) {
+	const uint64_t key = memoKey(static_cast<uintptr_t>(index), view);
+	if (inEvent()) {
+		auto it = eventMemo.bufferIDs.find(key);
+		if (it != eventMemo.bufferIDs.end()) {
+			return it->second;
+		}
+	}
+	const HostBufferID bufferID = static_cast<HostBufferID>(npp(NPPM_GETBUFFERIDFROMPOS, index, view));
+	if (inEvent()) {
+		eventMemo.bufferIDs[key] = bufferID;
+	}
+	return bufferID;
+}
+
+intptr_t NppHostBridge::currentDocIndex(int view) {
+	if (!isValidView(view)) {
+		return -1;
+	}
+	if (inEvent() && eventMemo.currentDocIndex[view]) {
+		return *eventMemo.currentDocIndex[view];
+	}
+	const intptr_t index = static_cast<intptr_t>(npp(NPPM_GETCURRENTDOCINDEX, 0, view));
+	if (inEvent()) {
+		eventMemo.currentDocIndex[view] = index;
+	}
+	return index;
+}
+
+void NppHostBridge::activateDocument(int view, int index) {
+	clearEventMemo();
+	npp(NPPM_ACTIVATEDOC, view, index);
+	clearEventMemo();
+}
+
+void NppHostBridge::runMenuCommand(int commandID) {
+	clearEventMemo();
+	npp(NPPM_MENUCOMMAND, 0, commandID);
+	clearEventMemo();
+}
+
+void NppHostBridge::beginEvent() {
+	if (eventDepth++ == 0) {
+		clearEventMemo();
+	}
+}
+
+void NppHostBridge::endEvent() {
+	if (eventDepth > 0 && --eventDepth == 0) {
+		clearEventMemo();
+	}
+}
+
+void NppHostBridge::invalidate(HostInvalidation what, HostBufferID bufferID) {
+	switch (what) {
+	case HostInvalidation::DarkMode:
+		darkMode.reset();
+		break;
+	case HostInvalidation::BufferPath:
+		paths.erase(bufferID);
+		clearEventMemo();
+		break;
+	case HostInvalidation::Buffers:
+		clearEventMemo();
+		break;
+	case HostInvalidation::All:
+		darkMode.reset();
+		paths.clear();
+		clearEventMemo();
+		break;
+	}
+}
+
+void NppHostBridge::clearEventMemo() {
+	eventMemo.currentBufferID.reset();
+	for (int view = HOST_MAIN_VIEW; view <= HOST_SUB_VIEW; ++view) {
+		eventMemo.openFileCount[view].reset();
+		eventMemo.currentDocIndex[view].reset();
+	}
+	eventMemo.positions.clear();
+	eventMemo.bufferIDs.clear();
+}
+
+
+void invalidateHostBridgeFor(const NMHDR* nmhdr) {
+	if (nmhdr->hwndFrom != plugin.nppData._nppHandle) {
+		return;
+	}
+
+	HostBridge& bridge = hostBridge();
+	const HostBufferID bufferID = static_cast<HostBufferID>(nmhdr->idFrom);
+	switch (nmhdr->code) {
+	case NPPN_DARKMODECHANGED:
+		bridge.invalidate(HostInvalidation::DarkMode);
+		break;
+	case NPPN_FILEOPENED:
+	case NPPN_FILECLOSED:
+	case NPPN_FILERENAMED:
+	case NPPN_FILESAVED:
+		bridge.invalidate(HostInvalidation::BufferPath, bufferID);
+		break;
+	case NPPN_READY:
+	case NPPN_SHUTDOWN:
+		bridge.invalidate(HostInvalidation::All);
+		break;
+	default:
+		bridge.invalidate(HostInvalidation::Buffers);
+		break;
+	}
+}
@@ -0,0 +1,75 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "HostBridge.h"
+
+#include <optional>
+#include <unordered_map>
+#include <windows.h>
+
+
+// HostBridge backed by SendMessage to Notepad++.
+//
+// Two caches with different lifetimes:
+// - dark mode and buffer paths stay valid until a notification says they
+//   changed (NPPN_DARKMODECHANGED, NPPN_FILERENAMED, NPPN_FILESAVED, ...);
+// - positions, counts and the current buffer depend on the tab layout and are
+//   only memoized for the duration of one notification.
+// Activating a document or running a menu command through the bridge drops
+// the per-event answers, since both can move tabs around.
+
+class NppHostBridge : public HostBridge {
+public:
+	bool isDarkModeEnabled() override;
+	HostBufferID currentBufferID() override;
+	intptr_t positionOfBuffer(HostBufferID bufferID, int priorityView) override;
+	std::wstring fullPathOfBuffer(HostBufferID bufferID) override;
+	int openFileCount(int view) override;
+	HostBufferID bufferIDAt(int index, int view) override;
+	intptr_t currentDocIndex(int view) override;
+
+	void activateDocument(int view, int index) override;
+	void runMenuCommand(int commandID) override;
+
+	void beginEvent() override;
+	void endEvent() override;
+	void invalidate(HostInvalidation what, HostBufferID bufferID = 0) override;
+
+private:
+	struct EventMemo {
+		std::optional<HostBufferID> currentBufferID;
+		std::optional<int> openFileCount[2];
+		std::optional<intptr_t> currentDocIndex[2];
+		std::unordered_map<uint64_t, intptr_t> positions;		// bufferID and priority view
+		std::unordered_map<uint64_t, HostBufferID> bufferIDs;	// index and view
+	};
+
+	bool inEvent() const { return eventDepth > 0; }
+	void clearEventMemo();
+
+	std::optional<bool> darkMode;
+	std::unordered_map<HostBufferID, std::wstring> paths;
+	EventMemo eventMemo;
+	int eventDepth = 0;
+};
+
+inline NppHostBridge nppHostBridge;
+
+// Called for every notification, including the ones the plugin ignores while
+// it is busy, so cached answers never outlive the state they describe.
+void invalidateHostBridgeFor(const NMHDR* nmhdr);
@@ -0,0 +1,36 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreeControl.h"
+
+#include <stdexcept>
+
+
+namespace {
+TreeControl* installedControl = nullptr;
+}
+
+
+TreeControl& treeControl() {
+	if (!installedControl) {
+		throw std::logic_error("No tree control installed");
+	}
+	return *installedControl;
+}
+
+void setTreeControl(TreeControl* control) {
+	installedControl = control;
+}
@@ -0,0 +1,73 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../model/PortableTypes.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// The TreeView operations the plugin performs when it mirrors the model in
+// the panel. Inserting, deleting, updating, expanding and selecting items all
+// go through this interface, so the same model-to-view code can run against
+// the real control (Win32TreeControl) or against HeadlessTreeControl, which
+// records every call and lets benchmarks count what an action costs.
+//
+// Item handles are the control's own; TVI_ROOT, TVI_FIRST and TVI_LAST keep
+// their TreeView meaning as parent and insert-after positions.
+
+struct TreeItemSpec {
+	std::wstring text;
+	int image = 0;
+	int selectedImage = 0;
+	unsigned stateImage = 0;		// 1-based index in the state image list, 0 for none
+	LPARAM param = 0;
+	bool childrenOnDemand = false;	// cChildren = I_CHILDRENCALLBACK
+};
+
+// Only the fields that are set change.
+struct TreeItemChange {
+	std::optional<std::wstring> text;
+	std::optional<int> image;
+	std::optional<int> selectedImage;
+	std::optional<unsigned> stateImage;
+	std::optional<LPARAM> param;
+};
+
+class TreeControl {
+public:
+	virtual ~TreeControl() = default;
+
+	virtual HTREEITEM insertItem(HTREEITEM parent, HTREEITEM insertAfter, const TreeItemSpec& item) = 0;
+	virtual void deleteItem(HTREEITEM item) = 0;	// Together with its children
+	virtual void setItem(HTREEITEM item, const TreeItemChange& change) = 0;
+	virtual void expand(HTREEITEM item, bool expanded) = 0;
+	virtual void selectItem(HTREEITEM item) = 0;
+	virtual void ensureVisible(HTREEITEM item) = 0;
+	virtual HTREEITEM selectedItem() = 0;
+	virtual void setRedraw(bool enabled) = 0;
+	virtual void sortChildren(HTREEITEM parent) = 0;	// By param, moving the items in place
+
+	// Current state, for TreeRenderer. childrenOnDemand is not reported.
+	virtual std::vector<HTREEITEM> childrenOf(HTREEITEM parent) = 0;	// nullptr or TVI_ROOT for the top level
+	virtual bool getItem(HTREEITEM item, TreeItemSpec& spec) = 0;
+};
+
+TreeControl& treeControl();
+void setTreeControl(TreeControl* control);
@@ -0,0 +1,164 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Win32TreeControl.h"
+
+
+HTREEITEM Win32TreeControl::insertItem(HTREEITEM parent, HTREEITEM insertAfter, const TreeItemSpec& item) {
+	if (!hTree) {
+		return nullptr;
+	}
+
+	std::wstring text = item.text;
+	TVINSERTSTRUCT tvis = { 0 };
+	tvis.hParent = parent;
+	tvis.hInsertAfter = insertAfter;
+	tvis.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_PARAM;
+	tvis.item.pszText = text.data();
+	tvis.item.iImage = item.image;
+	tvis.item.iSelectedImage = item.selectedImage;
+	tvis.item.lParam = item.param;
+	if (item.stateImage) {
+		tvis.item.mask |= TVIF_STATE;
+		tvis.item.stateMask = TVIS_STATEIMAGEMASK;
+		tvis.item.state = INDEXTOSTATEIMAGEMASK(item.stateImage);
+	}
+	if (item.childrenOnDemand) {
+		tvis.item.mask |= TVIF_CHILDREN;
+		tvis.item.cChildren = I_CHILDRENCALLBACK;
+	}
+	return TreeView_InsertItem(hTree, &tvis);
+}
+
+void Win32TreeControl::deleteItem(HTREEITEM item) {
+	if (hTree && item) {
+		TreeView_DeleteItem(hTree, item);
+	}
+}
+
+void Win32TreeControl::setItem(HTREEITEM item, const TreeItemChange& change) {
+	if (!hTree || !item) {
+		return;
+	}
+
+	std::wstring text = change.text.value_or(std::wstring());
+	TVITEM tvi = { 0 };
+	tvi.hItem = item;
+	if (change.text) {
+		tvi.mask |= TVIF_TEXT;
+		tvi.pszText = text.data();
+	}
+	if (change.image) {
+		tvi.mask |= TVIF_IMAGE;
+		tvi.iImage = *change.image;
+	}
+	if (change.selectedImage) {
+		tvi.mask |= TVIF_SELECTEDIMAGE;
+		tvi.iSelectedImage = *change.selectedImage;
+	}
+	if (change.stateImage) {
+		tvi.mask |= TVIF_STATE;
+		tvi.stateMask = TVIS_STATEIMAGEMASK;
+		tvi.state = INDEXTOSTATEIMAGEMASK(*change.stateImage);
+	}
+	if (change.param) {
+		tvi.mask |= TVIF_PARAM;
+		tvi.lParam = *change.param;
+	}
+	TreeView_SetItem(hTree, &tvi);
+}
+
+void Win32TreeControl::expand(HTREEITEM item, bool expanded) {
+	if (hTree && item) {
+		TreeView_Expand(hTree, item, expanded ? TVE_EXPAND : TVE_COLLAPSE);
+	}
+}
+
+void Win32TreeControl::selectItem(HTREEITEM item) {
+	if (hTree) {
+		TreeView_SelectItem(hTree, item);
+	}
+}
+
+void Win32TreeControl::ensureVisible(HTREEITEM item) {
+	if (hTree && item) {
+		TreeView_EnsureVisible(hTree, item);
+	}
+}
+
+HTREEITEM Win32TreeControl::selectedItem() {
+	return hTree ? TreeView_GetSelection(hTree) : nullptr;
+}
+
+void Win32TreeControl::setRedraw(bool enabled) {
+	if (!hTree) {
+		return;
+	}
+	SendMessage(hTree, WM_SETREDRAW, enabled ? TRUE : FALSE, 0);
+	if (enabled) {
+		InvalidateRect(hTree, nullptr, TRUE);
+	}
+}
+
+static int CALLBACK compareParams(LPARAM first, LPARAM second, LPARAM) {
+	return first < second ? -1 : first > second ? 1 : 0;
+}
+
+void Win32TreeControl::sortChildren(HTREEITEM parent) {
+	if (!hTree) {
+		return;
+	}
+	TVSORTCB sort = { 0 };
+	sort.hParent = parent ? parent : TVI_ROOT;
+	sort.lpfnCompare = compareParams;
+	TreeView_SortChildrenCB(hTree, &sort, FALSE);
+}
+
+std::vector<HTREEITEM> Win32TreeControl::childrenOf(HTREEITEM parent) {
+	std::vector<HTREEITEM> children;
+	if (!hTree) {
+		return children;
+	}
+	for (HTREEITEM child = TreeView_GetChild(hTree, parent ? parent : TVI_ROOT); child; child = TreeView_GetNextSibling(hTree, child)) {
+		children.push_back(child);
+	}
+	return children;
+}
+
+bool Win32TreeControl::getItem(HTREEITEM item, TreeItemSpec& spec) {
+	if (!hTree || !item) {
+		return false;
+	}
+
+	wchar_t text[MAX_PATH] = {};
+	TVITEM tvi = { 0 };
+	tvi.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_STATE | TVIF_PARAM;
+	tvi.hItem = item;
+	tvi.pszText = text;
+	tvi.cchTextMax = MAX_PATH;
+	tvi.stateMask = TVIS_STATEIMAGEMASK;
+	if (!TreeView_GetItem(hTree, &tvi)) {
+		return false;
+	}
+
+	spec.text = text;
+	spec.image = tvi.iImage;
+	spec.selectedImage = tvi.iSelectedImage;
+	spec.stateImage = (tvi.state & TVIS_STATEIMAGEMASK) >> 12;
+	spec.param = tvi.lParam;
+	spec.childrenOnDemand = false;
+	return true;
+}
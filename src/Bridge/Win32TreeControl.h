@@ -0,0 +1,50 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "TreeControl.h"
+
+#include <windows.h>
+#include <commctrl.h>
+
+
+// TreeControl backed by the panel's TreeView. The panel attaches the control
+// when it creates the tree and detaches it when the tree goes away; without a
+// window every operation is a no-op.
+
+class Win32TreeControl : public TreeControl {
+public:
+	void attach(HWND tree) { hTree = tree; }
+	HWND window() const { return hTree; }
+
+	HTREEITEM insertItem(HTREEITEM parent, HTREEITEM insertAfter, const TreeItemSpec& item) override;
+	void deleteItem(HTREEITEM item) override;
+	void setItem(HTREEITEM item, const TreeItemChange& change) override;
+	void expand(HTREEITEM item, bool expanded) override;
+	void selectItem(HTREEITEM item) override;
+	void ensureVisible(HTREEITEM item) override;
+	HTREEITEM selectedItem() override;
+	void setRedraw(bool enabled) override;
+	void sortChildren(HTREEITEM parent) override;
+	std::vector<HTREEITEM> childrenOf(HTREEITEM parent) override;
+	bool getItem(HTREEITEM item, TreeItemSpec& spec) override;
+
+private:
+	HWND hTree = nullptr;
+};
+
+inline Win32TreeControl win32TreeControl;
@@ -0,0 +1,256 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "BufferHandlers.h"
+#include "TreeItems.h"
+#include "model/BufferStates.h"
+#include "model/BufferSync.h"
+#include "model/FileIndex.h"
+#include "model/FileTable.h"
+
+#include <unordered_set>
+
+
+int resolveBufferView(HostBridge& host, UINT_PTR bufferID, int reportedView) {
+    if (bufferID == 0) {
+        return reportedView;
+    }
+
+    const intptr_t position = host.positionOfBuffer(bufferID, reportedView);
+    if (position == -1) {
+        return reportedView;
+    }
+
+    const int actualView = positionView(position);
+    return actualView == HOST_MAIN_VIEW || actualView == HOST_SUB_VIEW ? actualView : reportedView;
+}
+
+bool isTransientSecondaryPlaceholder(const VFolder& root, HostBridge& host, UINT_PTR bufferID, int view) {
+    if (view != HOST_SUB_VIEW) {
+        return false;
+    }
+
+    const int secondaryFileCount = host.openFileCount(HOST_SUB_VIEW);
+    if (secondaryFileCount != 1) {
+        return false;
+    }
+
+    // A real move/clone or a restored session entry already has a matching
+    // model item. The temporary empty document created while Notepad++ tears
+    // down the secondary view does not.
+    if (root.findFileByBufferID(bufferID)) {
+        return false;
+    }
+
+    const string name = hostPathToUtf8(host.fullPathOfBuffer(bufferID));
+    if (name.empty() || name.find_first_of("/\\") != string::npos) {
+        return false;
+    }
+
+    return root.findFileByName(name, HOST_SUB_VIEW) == nullptr;
+}
+
+VFile* handleBufferActivated(VFolder& root, HostBridge& host, UINT_PTR bufferID, int reportedView, bool selectItem,
+    const BufferHandlerHooks& hooks) {
+    // When the final document leaves the secondary view, Notepad++ can still
+    // report that Scintilla as current while it is being torn down. The
+    // buffer position already contains its real destination view.
+    const int view = resolveBufferView(host, bufferID, reportedView);
+
+    if (isTransientSecondaryPlaceholder(root, host, bufferID, view)) {
+        return nullptr;
+    }
+
+    // isActive represents a single TreeView item, not every clone of a
+    // buffer. Only the activation that wins the batch has to update it.
+    if (selectItem) {
+        markActiveFile(root, bufferID, view);
+    }
+
+    return mirrorBufferActivation(root, host, bufferID, view, selectItem, hooks);
+}
+
+VFile* mirrorBufferActivation(VFolder& root, HostBridge& host, UINT_PTR bufferID, int view, bool selectItem,
+    const BufferHandlerHooks& hooks) {
+    if (bufferID == 0) {
+        bufferID = host.currentBufferID();
+    }
+    if (hooks.beginActivation && !hooks.beginActivation(bufferID, view)) {
+        return nullptr;
+    }
+
+    // Bind the buffer to its model entry (binding a session entry, cloning
+    // into the other view or appending a new one), then mirror it in the tree.
+    BufferActivation activation = bindActivatedBuffer(root, host, bufferID, view);
+    if (activation.binding == BufferBinding::Ignored) {
+        return nullptr;
+    }
+    VFile* vFile = activation.file;
+
+    if (activation.binding == BufferBinding::Cloned) {
+        addFileToTree(vFile, activation.parentFolder ? activation.parentFolder->hTreeItem : nullptr,
+            host.isDarkModeEnabled(), activation.insertAfter);
+    }
+    else if (activation.binding == BufferBinding::Appended) {
+        addFileToTree(vFile, TVI_ROOT, host.isDarkModeEnabled(), TVI_LAST);
+    }
+    if (activation.modelChanged()) {
+        hooks.writeStorage();
+    }
+    if (hooks.activated) {
+        hooks.activated(vFile);
+    }
+
+    // Superseded activations of a batch only bind their buffer.
+    if (!selectItem) {
+        return vFile;
+    }
+    const bool hasItem = hooks.ensureItem ? hooks.ensureItem(vFile) : vFile->hTreeItem || materializeAncestors(root, vFile);
+    if (hasItem && treeControl().selectedItem() != vFile->hTreeItem) {
+        if (hooks.selectItem) {
+            hooks.selectItem(vFile->hTreeItem);
+        }
+        else {
+            treeControl().selectItem(vFile->hTreeItem);
+        }
+    }
+    return vFile;
+}
+
+int handleBufferClosed(VFolder& root, HostBridge& host, UINT_PTR bufferID, unsigned openViews, const BufferHandlerHooks& hooks) {
+    // Closed in both views.
+    if (openViews == 0) {
+        const bool removedMain = removeBufferEntry(root, bufferID, HOST_MAIN_VIEW);
+        const bool removedSub = removeBufferEntry(root, bufferID, HOST_SUB_VIEW);
+        if (removedMain || removedSub) {
+            hooks.writeStorage();
+        }
+        return -1;
+    }
+
+    // Still open in both: the notification was for neither entry.
+    const unsigned bothViews = (1u << HOST_MAIN_VIEW) | (1u << HOST_SUB_VIEW);
+    if (openViews == bothViews) {
+        return -1;
+    }
+
+    // 1. Buffer moved: the entry of the view it left follows it.
+    // 2. Clone closed, or moved onto its original: the entry of the view it
+    //    left goes; the same for the original of a clone.
+    const int openView = openViews & (1u << HOST_MAIN_VIEW) ? HOST_MAIN_VIEW : HOST_SUB_VIEW;
+    const int leftView = 1 - openView;
+    optional<VFile*> left = root.findFileByBufferID(bufferID, leftView);
+    if (!left) {
+        return openView;
+    }
+    if (root.findFileByBufferID(bufferID, openView)) {
+        removeBufferEntry(root, bufferID, leftView);
+    }
+    else {
+        VFile* moved = left.value();
+        moved->view = openView;
+        bufferStates.bind(*moved);
+        bufferStates.unbind(bufferID, leftView);
+        fileTable.refreshBuffer(bufferID);
+    }
+
+    refreshFileIcon(root, host, bufferID, HOST_MAIN_VIEW);
+    refreshFileIcon(root, host, bufferID, HOST_SUB_VIEW);
+    hooks.writeStorage();
+    return openView;
+}
+
+bool removeBufferEntry(VFolder& root, UINT_PTR bufferID, int view) {
+    // Files inside a collapsed folder may not have a tree item yet.
+    optional<VFile*> vFile = root.findFileByBufferID(bufferID, view);
+    if (vFile && vFile.value()->hTreeItem) {
+        treeControl().deleteItem(vFile.value()->hTreeItem);
+    }
+    return removeClosedBuffer(root, bufferID, view);
+}
+
+VFile* handleBufferRenamed(VFolder& root, UINT_PTR bufferID, const string& fullPath, const BufferHandlerHooks& hooks) {
+    VFile* renamed = renameBufferFile(root, bufferID, fullPath);
+    if (!renamed) {
+        return nullptr;
+    }
+    // The item is missing while its collapsed folder was never expanded.
+    if (renamed->hTreeItem) {
+        TreeItemChange change;
+        change.text = utf8ToHostPath(renamed->name);
+        treeControl().setItem(renamed->hTreeItem, change);
+    }
+    hooks.writeStorage();
+    return renamed;
+}
+
+void handleBufferSaved(VFolder& root, HostBridge& host, UINT_PTR bufferID, const string& fullPath, const BufferHandlerHooks& hooks) {
+    // The buffer is at its save point now, so only isEdited counts.
+    for (VFile* saved : markBufferSaved(root, bufferID, fullPath)) {
+        refreshFileIcon(root, host, bufferID, saved->view);
+    }
+    hooks.writeStorage();
+}
+
+size_t handleSessionFilesChecked(VFolder& root, const vector<string>& paths, const FileStatBatchResult& result,
+    const BufferHandlerHooks& hooks) {
+    std::unordered_set<string> missing;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!result.existsAt(i)) {
+            missing.insert(paths[i]);
+        }
+    }
+    if (missing.empty()) {
+        return 0;
+    }
+
+    // Removing invalidates the pointers of getAllFiles(), so go by order.
+    vector<int> goneOrders;
+    for (const VFile* vFile : root.getAllFiles()) {
+        if (vFile->bufferID == 0 && vFile->backupFilePath.empty() && missing.contains(vFile->path.str())) {
+            goneOrders.push_back(vFile->getOrder());
+        }
+    }
+    for (const int order : goneOrders) {
+        optional<VFile*> vFile = root.findFileByOrder(order);
+        if (!vFile) {
+            continue;
+        }
+        if (vFile.value()->hTreeItem) {
+            treeControl().deleteItem(vFile.value()->hTreeItem);
+        }
+        fileIndex.remove(*vFile.value());
+        VFolder* parentFolder = root.findParentFolder(order);
+        if (parentFolder) {
+            parentFolder->removeFile(order);
+        }
+        else {
+            root.removeFile(order);
+        }
+    }
+    if (!goneOrders.empty()) {
+        hooks.writeStorage();
+    }
+    return goneOrders.size();
+}
+
+void refreshFileIcon(const VFolder& root, HostBridge& host, UINT_PTR bufferID, int view) {
+    optional<VFile*> vFile = root.findFileByBufferID(bufferID, view);
+    if (!vFile || !vFile.value()->hTreeItem) {
+        return;
+    }
+    applyFileIcon(vFile.value(), fileIconOf(vFile.value(), host.isDarkModeEnabled()));
+}
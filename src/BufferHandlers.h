@@ -0,0 +1,74 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "model/VData.h"
+#include "Bridge/HostBridge.h"
+#include "Services/FileStatService.h"
+
+#include <functional>
+
+
+// What the buffer notifications do once beNotified has decided to apply
+// them: the model update (BufferSync), then the tree items that mirror it
+// (TreeItems). Free of Win32, so the panel and tools/HostSimulator call the
+// same handlers. What only the panel has, such as the storage file, tree
+// population and its selection guard, comes in through BufferHandlerHooks.
+
+struct BufferHandlerHooks {
+    std::function<void()> writeStorage;                        // writeJsonFile()
+    std::function<bool(UINT_PTR bufferID, int view)> beginActivation;  // False drops the activation
+    std::function<void(VFile* vFile)> activated;               // After binding, before selecting
+    std::function<bool(VFile* vFile)> ensureItem;              // The file has a tree item afterwards
+    std::function<void(HTREEITEM item)> selectItem;
+};
+
+// The view a buffer really is in; Notepad++ can report the one being torn down.
+int resolveBufferView(HostBridge& host, UINT_PTR bufferID, int reportedView);
+// The empty document Notepad++ creates while it tears down the sub view.
+bool isTransientSecondaryPlaceholder(const VFolder& root, HostBridge& host, UINT_PTR bufferID, int view);
+
+// NPPN_BUFFERACTIVATED and NPPN_FILEOPENED: resolves the view, marks the
+// active file if this activation selects, then mirrorBufferActivation().
+VFile* handleBufferActivated(VFolder& root, HostBridge& host, UINT_PTR bufferID, int reportedView, bool selectItem,
+    const BufferHandlerHooks& hooks);
+// Binds the buffer to its entry, adds the item of a cloned or appended
+// entry, and selects the entry's item. Returns the entry, nullptr if the
+// buffer is ignored.
+VFile* mirrorBufferActivation(VFolder& root, HostBridge& host, UINT_PTR bufferID, int view, bool selectItem,
+    const BufferHandlerHooks& hooks);
+
+// NPPN_FILECLOSED, with the openViewsOfBuffer() taken when it arrived. An
+// entry in a view the buffer left is removed, unless the buffer moved and
+// has no entry in its new view yet; then the entry follows it. Returns the
+// view the buffer is still open in, -1 if none.
+int handleBufferClosed(VFolder& root, HostBridge& host, UINT_PTR bufferID, unsigned openViews, const BufferHandlerHooks& hooks);
+// Removes the item, then the entry, of a buffer in a view. False if there is none.
+bool removeBufferEntry(VFolder& root, UINT_PTR bufferID, int view);
+
+// NPPN_FILERENAMED and NPPN_FILESAVED with the buffer's new path.
+VFile* handleBufferRenamed(VFolder& root, UINT_PTR bufferID, const string& fullPath, const BufferHandlerHooks& hooks);
+void handleBufferSaved(VFolder& root, HostBridge& host, UINT_PTR bufferID, const string& fullPath, const BufferHandlerHooks& hooks);
+
+// The answer of the disk check of the session's saved files, which comes in
+// after the panel was built from them. An entry of a path found missing is
+// removed with its item, unless a buffer holds it by now. Returns how many.
+size_t handleSessionFilesChecked(VFolder& root, const vector<string>& paths, const FileStatBatchResult& result,
+    const BufferHandlerHooks& hooks);
+
+// The icon of the buffer's entry in a view, from its current state.
+void refreshFileIcon(const VFolder& root, HostBridge& host, UINT_PTR bufferID, int view);
@@ -19,7 +19,11 @@
 #include "Framework/PluginFramework.h"
 #include "Framework/ConfigFramework.h"
 #include "Framework/UtilityFramework.h"
+#include "Bridge/HostBridge.h"
 #include "model/VData.h"
+#include "model/BufferSync.h"
+#include "model/FileSequence.h"
+#include "model/ModelSnapshot.h"
 #include <CommCtrl.h>
 #include <format>
 #include <filesystem>
@@ -47,6 +51,12 @@ NLOHMANN_JSON_SERIALIZE_ENUM(MyPreference, {
     {MyPreference::Pizza   , "Pizza"}
 })
 
+NLOHMANN_JSON_SERIALIZE_ENUM(SiblingScope, {
+    {SiblingScope::AllFiles     , "all"},
+    {SiblingScope::VisibleFiles , "visible"},
+    {SiblingScope::CurrentFolder, "folder"}
+})
+
 
 // Common data structure
 
@@ -63,13 +73,13 @@ inline struct CommonData {
 	config<std::wstring> fontFamily = { "fontFamily", L"Segoe UI" };
     //config<MyPreference> myPref  = { "MyPreference", MyPreference::Bacon };
     config<bool>         virtualFoldersTabSelected = { "VirtualFoldersTabSelected", false };
+    config<bool>         traceNotifications = { "traceNotifications", false };  // Record notifications to VirtualFolders.trace
+    config<SiblingScope> siblingNavigation = { "siblingNavigation", SiblingScope::AllFiles };  // Files Ctrl+PgUp/PgDn steps through
 
     std::vector<VFile> openFiles;
     VFolder rootVFolder;
     HWND hTree;
     UINT_PTR activeBufferID;
-    std::map<UINT_PTR, bool> bufferStates;  // for save points
-    std::map<UINT_PTR, int> bufferViewMap;  // to keep buffers view
 
 	std::unique_ptr<Translator> nativeTranslator;
     std::unique_ptr<Translator> shortcutTranslator;
@@ -80,13 +90,18 @@ inline struct CommonData {
 
 inline std::wstring jsonFilePath;
 
-inline void writeJsonFile() {
+// While a ScopedStorageWriteBatch is alive, writeJsonFile() only marks the
+// storage as dirty; the file is written once when the outermost batch ends.
+inline int storageWriteBatchDepth = 0;
+inline bool storageWritePending = false;
+
+inline void writeJsonFileNow() {
     if (jsonFilePath.empty()) {
         return;
     }
 
     commonData.rootVFolder.vFolderSort();
-    json vDataJson = commonData.rootVFolder;
+    json vDataJson = modelSnapshots.publish(commonData.rootVFolder)->root();  // Keeps the snapshot for other threads current
     const std::string serialized = vDataJson.dump(4);
 
     const std::filesystem::path target(jsonFilePath);
@@ -153,6 +168,35 @@ inline void writeJsonFile() {
     }
 }
 
+inline void writeJsonFile() {
+    if (storageWriteBatchDepth > 0) {
+        storageWritePending = true;
+        return;
+    }
+    writeJsonFileNow();
+}
+
+class ScopedStorageWriteBatch final {
+public:
+    ScopedStorageWriteBatch() { ++storageWriteBatchDepth; }
+
+    ~ScopedStorageWriteBatch() {
+        if (--storageWriteBatchDepth == 0 && storageWritePending) {
+            storageWritePending = false;
+            // Destructors must not throw; serialization errors are only logged here.
+            try {
+                writeJsonFileNow();
+            }
+            catch (const std::exception& e) {
+                OutputDebugStringA((std::string("VirtualFolders storage write failed: ") + e.what() + "\n").c_str());
+            }
+        }
+    }
+
+    ScopedStorageWriteBatch(const ScopedStorageWriteBatch&) = delete;
+    ScopedStorageWriteBatch& operator=(const ScopedStorageWriteBatch&) = delete;
+};
+
 inline string folderToMinJson(VFolder folder) 
 {
 
@@ -20,6 +20,7 @@
 #include "Shlwapi.h"
 #include "Translator.h"
 #include "resource.h"
+#include "Services/TraceRecorder.h"
 
 
 
@@ -104,6 +105,12 @@ void loadConfiguration() {
     // If there are settings you want to copy immediately from the JSON store (configuration)
     // to program storage, do that here.
 
+    if (commonData.traceNotifications.get()) {
+        std::filesystem::path traceFile(filePath);
+        traceFile.replace_filename(L"VirtualFolders.trace");
+        traceRecorder.start(traceFile);
+    }
+
 }
 
 
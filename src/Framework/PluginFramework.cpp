@@ -15,6 +15,8 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "PluginFramework.h"
+#include "../Bridge/NppHostBridge.h"
+#include "../Bridge/Win32TreeControl.h"
 
 PluginData plugin;
 
@@ -93,6 +95,8 @@ void toggleShortcutOverride() {
 
 extern "C" __declspec(dllexport) void setInfo(NPP::NppData nppData) {
     plugin.nppData = nppData;
+    setHostBridge(&nppHostBridge);
+    setTreeControl(&win32TreeControl);
     plugin.directStatusScintilla = reinterpret_cast<Scintilla::FunctionDirect>
         (SendMessage(plugin.nppData._scintillaMainHandle, static_cast<UINT>(Scintilla::Message::GetDirectStatusFunction), 0, 0));
 }
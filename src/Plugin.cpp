@@ -17,6 +17,11 @@
 #include "Framework/PluginFramework.h"
 #include <iostream>
 #include "CommonData.h"
+#include "Bridge/NppHostBridge.h"
+#include "Services/TraceRecorder.h"
+#include "Services/NotificationQueue.h"
+#include "Services/StartupSequence.h"
+#include "TreePalette.h"
 
 
 using namespace NPP;
@@ -46,11 +51,15 @@ void fileClosed(const NMHDR*);
 void fileOpened(const NMHDR*);
 void fileRenamed(const NMHDR*);
 void fileSaved(const NMHDR*);
+void fileBeforeDelete(const NMHDR*);
+void fileDeleted(const NMHDR*);
+void fileLoading(const NMHDR*);
 void readOnlyChanged(const NMHDR*);
 void modifyAll(const NMHDR*);
 void nppReady();
 void nppBeforeShutdown();
 void nppShutdown();
+void flushQueuedNotifications();
 
 // Routines that process menu commands
 
@@ -98,6 +107,80 @@ private:
     bool& flag_;
     bool previousValue_;
 };
+
+// Reads the editor colors again and repaints the tree with them.
+void repaintTreeWithEditorColors() {
+    treePalette.invalidate();
+    if (!virtualPanelWnd || !IsWindow(virtualPanelWnd)) {
+        return;
+    }
+    HWND hTree = GetDlgItem(virtualPanelWnd, 1023);
+    if (hTree) {
+        const TreePalette& palette = treePalette.get();
+        TreeView_SetBkColor(hTree, palette.background);
+        TreeView_SetTextColor(hTree, palette.text);
+        InvalidateRect(hTree, nullptr, TRUE);
+    }
+}
+
+static_assert(TRACE_NPPN_READY == NPPN_READY && TRACE_NPPN_FILEOPENED == NPPN_FILEOPENED
+    && TRACE_NPPN_FILECLOSED == NPPN_FILECLOSED && TRACE_NPPN_FILESAVED == NPPN_FILESAVED
+    && TRACE_NPPN_BUFFERACTIVATED == NPPN_BUFFERACTIVATED && TRACE_NPPN_FILERENAMED == NPPN_FILERENAMED,
+    "notification trace codes out of sync with Notepad_plus_msgs.h");
+
+void recordNotification(const NMHDR* nmhdr) {
+    if (nmhdr->hwndFrom == plugin.nppData._scintillaMainHandle) {
+        traceRecorder.record(nmhdr->code, commonData.activeBufferID, MAIN_VIEW, NotificationSource::MainScintilla);
+    }
+    else if (nmhdr->hwndFrom == plugin.nppData._scintillaSecondHandle) {
+        traceRecorder.record(nmhdr->code, commonData.activeBufferID, SUB_VIEW, NotificationSource::SubScintilla);
+    }
+    else if (nmhdr->hwndFrom == plugin.nppData._nppHandle) {
+        long whichScintilla = -1;
+        npp(NPPM_GETCURRENTSCINTILLA, 0, &whichScintilla);
+        traceRecorder.record(nmhdr->code, nmhdr->idFrom, whichScintilla, NotificationSource::Notepad);
+    }
+}
+
+// Notifications that only add to the notification queue. Every other one is
+// handled with the queue applied first, so it sees an up-to-date model.
+bool isQueuedNotification(const NMHDR* nmhdr) {
+    if (nmhdr->hwndFrom == plugin.nppData._nppHandle) {
+        switch (nmhdr->code) {
+        case NPPN_BUFFERACTIVATED:
+        case NPPN_FILEBEFOREOPEN:
+        case NPPN_FILEOPENED:
+        case NPPN_FILEBEFORECLOSE:
+        case NPPN_FILECLOSED:
+            return true;
+        }
+        return false;
+    }
+    // Of the Scintilla notifications only save points touch the tree.
+    const auto code = static_cast<Scintilla::Notification>(nmhdr->code);
+    return code != Scintilla::Notification::SavePointLeft && code != Scintilla::Notification::SavePointReached;
+}
+}
+
+
+// Applies the notifications queued during a burst; the panel calls this when
+// it gets WM_VF_FLUSH_NOTIFICATIONS. Returns false if it has to be retried
+// because a notification is still being handled (e.g. a message box is
+// pumping messages from inside beNotified).
+bool processQueuedNotifications() {
+    if (notificationQueue.empty()) return true;
+    if (plugin.bypassNotifications) return false;
+
+    ScopedNotificationBypass bypassGuard(plugin.bypassNotifications);
+    ScopedHostEvent hostEvent;
+    try {
+        flushQueuedNotifications();
+    }
+    catch (const std::exception& e) {
+        const std::string message = std::string("VirtualFolders notification error: ") + e.what() + "\n";
+        OutputDebugStringA(message.c_str());
+    }
+    return true;
 }
 
 
@@ -133,6 +216,7 @@ extern "C" __declspec(dllexport) const wchar_t* getName() {
 // Tell Notepad++ about the plugin menu
 
 extern "C" __declspec(dllexport) FuncItem * getFuncsArray(int *n) {
+    startupSequence.reach(StartupPhase::Loaded);
     loadConfiguration();
 	loadLocalization();
 
@@ -180,12 +264,22 @@ extern "C" __declspec(dllexport) FuncItem * getFuncsArray(int *n) {
 
 extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
 
+    if (traceRecorderEnabled) {
+        recordNotification(reinterpret_cast<const NMHDR*>(np));
+    }
+    invalidateHostBridgeFor(reinterpret_cast<const NMHDR*>(np));
+
     if (plugin.bypassNotifications) return;
     ScopedNotificationBypass bypassGuard(plugin.bypassNotifications);
+    ScopedHostEvent hostEvent;
 
     try {
         auto*& nmhdr = reinterpret_cast<NMHDR*&>(np);
 
+    if (!notificationQueue.empty() && !isQueuedNotification(nmhdr)) {
+        flushQueuedNotifications();
+    }
+
     // Example Notepad++ notifications; you can add others as needed.
     // Note that most of the notifications listed below have some connection to plugin framework code;
     // it's best to leave those and just remove any function calls you don't use.
@@ -201,6 +295,7 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
 
         case NPPN_BUFFERACTIVATED:
             if (!plugin.startupOrShutdown && !plugin.fileIsOpening) {
+                treePalette.bufferLanguage(static_cast<int>(npp(NPPM_GETBUFFERLANGTYPE, nmhdr->idFrom, 0)));
                 plugin.getScintillaPointers();
                 bufferActivated(nmhdr);
             }
@@ -232,6 +327,16 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
         case NPPN_FILESAVED:
             fileSaved(nmhdr);
             break;
+        case NPPN_FILEBEFOREDELETE:
+            fileBeforeDelete(nmhdr);
+            break;
+        case NPPN_FILEDELETED:
+            fileDeleted(nmhdr);
+            break;
+        case NPPN_FILEBEFORELOAD:
+        case NPPN_FILELOADFAILED:
+            fileLoading(nmhdr);
+            break;
         case NPPN_GLOBALMODIFIED:
             modifyAll(nmhdr);
             break;
@@ -247,12 +352,18 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
                 if (hTree) {
                     updateTreeColorsExternal(hTree);
                 }
+                repaintTreeWithEditorColors();
                 
                 // Resize the panel to match the new theme
                 resizeVirtualPanel();
             }
             break;
         case NPPN_WORDSTYLESUPDATED:
+            repaintTreeWithEditorColors();
+            break;
+        case NPPN_LANGCHANGED:
+            treePalette.bufferLanguage(static_cast<int>(npp(NPPM_GETBUFFERLANGTYPE, nmhdr->idFrom, 0)));
+            repaintTreeWithEditorColors();
             break;
         case NPPN_READONLYCHANGED:
 			readOnlyChanged(nmhdr);
@@ -43,7 +43,9 @@ vector<VFile> listOpenFiles() {
     Session session = loadSessionFromXMLFile(sessionPath);
 
     vector<VFile> fileList;
-    
+
+    // Saved files that are gone from disk are taken out again when
+    // checkOpenFilesOnDisk() has the answer; the check does not hold up the panel.
     size_t i = 0;
     // Convert SessionFile objects to VFile objects
     // Process main view files
@@ -79,16 +81,13 @@ optional<VFile> sessionFileToVFile(const SessionFile& sessionFile, int view) {
     // Extract just the filename from the path
     if (sessionFile.backupFilePath.empty()) {
         std::filesystem::path filePath(sessionFile.filename);
-        if (!std::filesystem::exists(filePath)) {
-            return nullopt;
-        }
         vFile.name = filePath.filename().string();
         vFile.path = sessionFile.filename; // Keep original path
-        vFile.isEdited = false;
+        vFile.setEdited(false);
     } else {
         vFile.name = sessionFile.filename;
         vFile.path = sessionFile.backupFilePath;
-        vFile.isEdited = true;
+        vFile.setEdited(true);
     }
 
     string fileName = vFile.name;
@@ -101,7 +100,7 @@ optional<VFile> sessionFileToVFile(const SessionFile& sessionFile, int view) {
     vFile.view = view; // Use the passed view parameter
     vFile.session = 0; // Default session index
     vFile.backupFilePath = sessionFile.backupFilePath;
-	vFile.isReadOnly = sessionFile.userReadOnly;
+	vFile.setReadOnly(sessionFile.userReadOnly);
 
     return vFile;
     return const_cast<VFile&>(vFile);
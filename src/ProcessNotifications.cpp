@@ -16,21 +16,27 @@
 
 #include "CommonData.h"
 #include "model/VData.h"
+#include "model/BufferStates.h"
+#include "model/FileTable.h"
 #include "ProcessCommands.h"
 #include "resource.h"
 #include "Translator.h"
+#include "Services/TraceRecorder.h"
+#include "Services/NotificationQueue.h"
+#include "Services/StartupSequence.h"
+#include "Services/TaskScheduler.h"
+#include "TreeViewManager.h"
+#include "TreePopulator.h"
+#include "BufferHandlers.h"
 
 
 
 
 extern void updateStatusDialog();
-extern void updateVirtualPanel(UINT_PTR bufferID, int activeView);
-extern void onFileClosed(UINT_PTR bufferID, int view = 0);
-extern void onFileRenamed(UINT_PTR bufferID, wstring filepath, wstring fullpath);
 void scnSavePointEvent(UINT_PTR bufferID, bool isSavePoint);
 extern void changeTreeItemIcon(UINT_PTR bufferID, int view);
 extern void syncVDataWithBufferIDs();
-extern void toggleViewOfVFile(UINT_PTR bufferID);
+extern const BufferHandlerHooks& panelBufferHooks();
 
 
 
@@ -43,61 +49,203 @@ wchar_t* getFullPathFromBufferID(UINT_PTR bufferID);
 wchar_t* getPluginHomePath();
 int GetActiveViewForBuffer(UINT_PTR bufferID);
 void loadLocalization();
+void bufferActivated(const NMHDR* nmhdr);
 
 namespace {
-int resolveBufferView(UINT_PTR bufferID, int reportedView) {
-    if (bufferID == 0) {
-        return reportedView;
+int currentScintillaView() {
+    long whichScintilla = 0;
+    npp(NPPM_GETCURRENTSCINTILLA, 0, (LPARAM)&whichScintilla);
+    return (whichScintilla == 0) ? MAIN_VIEW : SUB_VIEW;
+}
+
+// Suspends tree painting while a batch of notifications is applied.
+class ScopedTreeRedrawSuspend final {
+public:
+    explicit ScopedTreeRedrawSuspend(HWND hTree) : hTree_(hTree && IsWindow(hTree) ? hTree : nullptr) {
+        if (hTree_) SendMessage(hTree_, WM_SETREDRAW, FALSE, 0);
     }
 
-    const LRESULT position = npp(NPPM_GETPOSFROMBUFFERID, bufferID, reportedView);
-    if (position == -1) {
-        return reportedView;
+    ~ScopedTreeRedrawSuspend() {
+        if (hTree_) {
+            SendMessage(hTree_, WM_SETREDRAW, TRUE, 0);
+            InvalidateRect(hTree_, nullptr, TRUE);
+        }
     }
 
-    const int actualView = static_cast<int>((position >> 30) & 0x3);
-    return actualView == MAIN_VIEW || actualView == SUB_VIEW ? actualView : reportedView;
+    ScopedTreeRedrawSuspend(const ScopedTreeRedrawSuspend&) = delete;
+    ScopedTreeRedrawSuspend& operator=(const ScopedTreeRedrawSuspend&) = delete;
+
+private:
+    HWND hTree_;
+};
+
+void applyBufferActivation(UINT_PTR bufferID, int reportedView, bool selectItem) {
+    handleBufferActivated(commonData.rootVFolder, hostBridge(), bufferID, reportedView, selectItem, panelBufferHooks());
 }
 
-bool isTransientSecondaryPlaceholder(UINT_PTR bufferID, int view) {
-    if (view != SUB_VIEW) {
-        return false;
+void applyFileClosed(UINT_PTR bufferID, unsigned openViews) {
+    // If the file (buffer) is closed in one view but remains open in the other, or is moved from one view to the other,
+    // we still get this notification. openViews says where it was still open when the notification arrived.
+    const int openView = handleBufferClosed(commonData.rootVFolder, hostBridge(), bufferID, openViews, panelBufferHooks());
+    if (openView != -1) {
+        currentView = openView;
     }
+}
+
+void queueNotification(QueuedNotificationKind kind, UINT_PTR bufferID, int view, unsigned openViews = 0) {
+    const bool firstInBurst = notificationQueue.push(kind, bufferID, view, openViews);
+    // Without the panel there is no tree to update and nothing to batch.
+    if (virtualPanelWnd && IsWindow(virtualPanelWnd)) {
+        if (firstInBurst) PostMessage(virtualPanelWnd, WM_VF_FLUSH_NOTIFICATIONS, 0, 0);
+    }
+    else {
+        flushQueuedNotifications();
+    }
+}
+}
 
-    const int secondaryFileCount = static_cast<int>(
-        npp(NPPM_GETNBOPENFILES, 0, SECOND_VIEW));
-    if (secondaryFileCount != 1) {
-        return false;
+
+void flushQueuedNotifications() {
+    if (notificationQueue.empty()) {
+        return;
     }
 
-    // A real move/clone or a restored session entry already has a matching
-    // model item. The temporary empty document created while Notepad++ tears
-    // down the secondary view does not.
-    if (commonData.rootVFolder.findFileByBufferID(bufferID)) {
-        return false;
+    const std::vector<QueuedNotification> batch = notificationQueue.take();
+    const bool removesEntries = std::any_of(batch.begin(), batch.end(), [](const QueuedNotification& queued) {
+        return queued.kind == QueuedNotificationKind::Closed;
+    });
+    if (removesEntries) {
+        treePopulator.finish();
     }
 
-    const int len = static_cast<int>(
-        npp(NPPM_GETFULLPATHFROMBUFFERID, bufferID, 0));
-    if (len < 0) {
-        return false;
+    ScopedStorageWriteBatch storageBatch;
+    ScopedTreeRedrawSuspend redrawSuspend(batch.size() > 1 ? commonData.hTree : nullptr);
+
+    for (const QueuedNotification& queued : batch) {
+        // One bad entry must not drop the rest of the burst.
+        try {
+            if (queued.kind == QueuedNotificationKind::Closed) {
+                applyFileClosed(queued.bufferID, queued.openViews);
+            }
+            else {
+                applyBufferActivation(queued.bufferID, queued.view, queued.selectItem);
+            }
+        }
+        catch (const std::exception& e) {
+            const std::string message = std::string("VirtualFolders queued notification error: ") + e.what() + "\n";
+            OutputDebugStringA(message.c_str());
+        }
     }
+}
 
-    vector<wchar_t> filePath(static_cast<size_t>(len) + 1);
-    npp(NPPM_GETFULLPATHFROMBUFFERID, bufferID, filePath.data());
-    const string name = fromWchar(filePath.data());
 
-    if (name.find_first_of("/\\") != string::npos) {
-        return false;
+namespace {
+UINT_PTR startupIdleTimer = 0;
+bool startupTabRestored = false;
+
+void advanceStartup(bool idle);
+
+void CALLBACK startupIdleTimerProc(HWND, UINT, UINT_PTR timerID, DWORD) {
+    KillTimer(nullptr, timerID);
+    startupIdleTimer = 0;
+
+    try {
+        // Notifications queued during start-up come first; if one is still
+        // being handled, try again on the next idle turn.
+        if (!processQueuedNotifications()) {
+            startupIdleTimer = SetTimer(nullptr, 0, USER_TIMER_MINIMUM, startupIdleTimerProc);
+            return;
+        }
+        advanceStartup(true);
+    }
+    catch (const std::exception& e) {
+        const std::string message = std::string("VirtualFolders startup error: ") + e.what() + "\n";
+        OutputDebugStringA(message.c_str());
     }
+}
+
+// WM_TIMER is only generated when the message queue is otherwise empty, so a
+// thread timer is an idle callback that works with or without the panel.
+void continueStartupWhenIdle() {
+    if (!startupIdleTimer) {
+        startupIdleTimer = SetTimer(nullptr, 0, USER_TIMER_MINIMUM, startupIdleTimerProc);
+    }
+}
 
-    return commonData.rootVFolder.findFileByName(name, SUB_VIEW) == nullptr;
+bool buffersEnumerable() {
+    HostBridge& host = hostBridge();
+    return host.currentBufferID() != 0 && host.openFileCount(MAIN_VIEW) + host.openFileCount(SUB_VIEW) > 0;
 }
 
-void updateActiveFileState(UINT_PTR bufferID, int view) {
-    for (VFile* file : commonData.rootVFolder.getAllFiles()) {
-        file->isActive = file->bufferID == bufferID && file->view == view;
+void restoreSelectedTab() {
+    // NPPM_DMMVIEWOTHERTAB only works once the panel is registered with the
+    // docking manager, which can happen before or after NPPN_READY.
+    if (startupTabRestored || !startupSequence.reached(StartupPhase::PanelDocked)) {
+        return;
     }
+    startupTabRestored = true;
+
+    // Restore tab selection if Virtual Folders tab was selected last time
+    if (commonData.virtualFoldersTabSelected.get()) {
+        npp(NPPM_DMMVIEWOTHERTAB, 0, reinterpret_cast<LPARAM>(L"Virtual Folders"));
+    }
+}
+
+void syncStartupBuffers() {
+    syncVDataWithBufferIDs();
+
+    NMHDR nmhdr{};
+    nmhdr.hwndFrom = commonData.hTree; // source window (tree)
+    nmhdr.idFrom = hostBridge().currentBufferID();
+    nmhdr.code = 0;
+
+    bufferActivated(&nmhdr);
+    flushQueuedNotifications();   // The tree items must exist before the folders are expanded
+}
+
+void applyFolderExpansion() {
+    if (!commonData.hTree) {
+        return;
+    }
+
+    // Now we have to collapse the folders manually.
+    for (VFolder* folder : commonData.rootVFolder.getAllFolders()) {
+        if (!folder->hTreeItem) {
+            continue;
+        }
+        treeControl().expand(folder->hTreeItem, folder->isExpanded);
+    }
+}
+
+// Moves start-up forward as far as the readiness signals allow. Binding the
+// buffers happens as soon as they can be enumerated; the localization
+// refresh and the folder expansion pass wait until the UI is idle.
+void advanceStartup(bool idle) {
+    if (startupSequence.finished() || !startupSequence.reached(StartupPhase::SessionLoaded)) {
+        return;
+    }
+
+    restoreSelectedTab();
+
+    if (!startupSequence.reached(StartupPhase::BuffersSynced)) {
+        if (!buffersEnumerable()) {
+            continueStartupWhenIdle();
+            return;
+        }
+        syncStartupBuffers();
+        startupSequence.reach(StartupPhase::BuffersSynced);
+    }
+
+    if (!idle) {
+        continueStartupWhenIdle();
+        return;
+    }
+
+    loadLocalization();
+    applyFolderExpansion();
+    startupSequence.reach(StartupPhase::IdleWorkDone);
+
+    LOG("Startup phases: {}", startupSequence.timingSummary());
 }
 }
 
@@ -113,22 +261,19 @@ void scnModified(const Scintilla::NotificationData* scnp) {
 void scnSavePointEvent(UINT_PTR bufferID, bool isSavePoint) {
     if (!commonData.isNppReady) return;
     if (bufferID == 0) {
-        bufferID = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+        bufferID = hostBridge().currentBufferID();
     }
-    if (commonData.bufferStates.find(bufferID) == commonData.bufferStates.end()) {
-        commonData.bufferStates[bufferID] = isSavePoint;
+    // Icons only change when the buffer crosses its save point. The record
+    // is shared by both views, so only the views showing it have items.
+    if (!bufferStates.setSavePoint(bufferID, isSavePoint)) {
+        return;
     }
-    
-    if (isSavePoint && !commonData.bufferStates[bufferID]) {
-        // Document has been saved update icon
-        commonData.bufferStates[bufferID] = true;
-    } else if(!isSavePoint && commonData.bufferStates[bufferID]){
-        // Document has been modified since last save
-        commonData.bufferStates[bufferID] = false;
+    const BufferState* state = bufferStates.find(bufferID);
+    for (int view = MAIN_VIEW; view <= SUB_VIEW; ++view) {
+        if (state->views == 0 || state->showsView(view)) {
+            changeTreeItemIcon(bufferID, view);
+        }
     }
-
-    changeTreeItemIcon(bufferID, MAIN_VIEW);
-    changeTreeItemIcon(bufferID, SUB_VIEW);
 }
 
 
@@ -144,24 +289,8 @@ void bufferActivated(const NMHDR* nmhdr) {
     UINT_PTR bufferID = nmhdr->idFrom;
 	commonData.activeBufferID = bufferID;
 
-    long whichScintilla = 0;
-    npp(NPPM_GETCURRENTSCINTILLA, 0, (LPARAM)&whichScintilla);
-    const int reportedView = (whichScintilla == 0) ? MAIN_VIEW : SUB_VIEW;
-
-    // When the final document leaves the secondary view, Notepad++ can still
-    // report that Scintilla as current while it is being torn down. The
-    // buffer position already contains its real destination view.
-    const int view = resolveBufferView(bufferID, reportedView);
-
-    if (isTransientSecondaryPlaceholder(bufferID, view)) {
-        return;
-    }
-
-    // isActive represents a single TreeView item, not every clone of a
-    // buffer. Keep it synchronized whenever Notepad++ activates a document.
-    updateActiveFileState(bufferID, view);
-
-    updateVirtualPanel(bufferID, view);
+    // The view has to be captured now; it is applied with the rest of the burst.
+    queueNotification(QueuedNotificationKind::Activated, bufferID, currentScintillaView());
 
 	/*static int bufferActivatedCounter = 0;
     LOG("Buffer activated: {}", bufferActivatedCounter);
@@ -181,43 +310,25 @@ void fileClosed(const NMHDR* nmhdr) {
     if (!commonData.isNppReady) return;
     if (plugin.startupOrShutdown) return;
 
-
-    // If the file (buffer) is closed in one view but remains open in the other, or is moved from one view to the other,
-    // we still get this notification. So we have to check to see if the buffer is still open in either view.
-    auto position = npp(NPPM_GETPOSFROMBUFFERID, nmhdr->idFrom, 0);
-    if (position == -1) /* file is no longer open in either view */ {
-
-        onFileClosed(nmhdr->idFrom, MAIN_VIEW);
-        onFileClosed(nmhdr->idFrom, SUB_VIEW);
-
-        return;
-    }
-    
-
-    toggleViewOfVFile(nmhdr->idFrom);
+    // The ID can be reused by an open queued after this close.
+    queueNotification(QueuedNotificationKind::Closed, nmhdr->idFrom, MAIN_VIEW, openViewsOfBuffer(hostBridge(), nmhdr->idFrom));
 }
 
 
 void fileOpened(const NMHDR* nmhdr) {
 	//if (!commonData.isNppReady) return; // Commented out to handle file opened during startup
-    UINT_PTR bufferID = nmhdr->idFrom;
-    std::wstring filepath = getFilePath(bufferID);
-
-    bufferActivated(nmhdr);
+    commonData.activeBufferID = nmhdr->idFrom;
+    queueNotification(QueuedNotificationKind::Opened, nmhdr->idFrom, currentScintillaView());
 }
 
 void fileRenamed(const NMHDR* nmhdr) {
     if (!commonData.isNppReady) return; // Ensure Notepad++ is ready before showing message
     UINT_PTR bufferID = nmhdr->idFrom;
-    std::wstring filepath = getFilePath(bufferID);
-	wchar_t* fullpathPtr = getFullPathFromBufferID(bufferID);
-    if (!fullpathPtr) {
+    if (hostBridge().positionOfBuffer(bufferID, 0) == -1) {
         return;
     }
-    std::wstring fullpath(fullpathPtr);
-    delete[] fullpathPtr; // Clean up the allocated memory
-
-    onFileRenamed(nmhdr->idFrom, filepath, fullpath);
+    const string fullPath = hostPathToUtf8(hostBridge().fullPathOfBuffer(bufferID));
+    handleBufferRenamed(commonData.rootVFolder, bufferID, fullPath, panelBufferHooks());
 }
 
 void fileSaved(const NMHDR* nmhdr) 
@@ -227,35 +338,35 @@ void fileSaved(const NMHDR* nmhdr)
 	//onFileSaved(bufferID);
 
 
-    for (int view = MAIN_VIEW; view <= SUB_VIEW; ++view) {
-        optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByBufferID(bufferID, view);
-        if (vFileOpt) {
-
-            wstring wFullPath = getFilePath(bufferID);
-            int len = WideCharToMultiByte(CP_UTF8, 0,
-                wFullPath.c_str(), -1,
-                nullptr, 0, nullptr, nullptr);
-            std::string fullPath(len - 1, 0); // exclude the null terminator
-            WideCharToMultiByte(CP_UTF8, 0,
-                wFullPath.c_str(), -1,
-                &fullPath[0], len, nullptr, nullptr);
-
+    const string fullPath = hostPathToUtf8(hostBridge().fullPathOfBuffer(bufferID));
+    handleBufferSaved(commonData.rootVFolder, hostBridge(), bufferID, fullPath, panelBufferHooks());
+	
 
-            vFileOpt.value()->path = fullPath;
+}
 
-            std::filesystem::path file(fullPath);
-            vFileOpt.value()->name = file.filename().string();
+// Notepad++ closes the buffer before NPPN_FILEDELETED, so its path is taken
+// when the deletion is announced.
+namespace {
+string pathBeingDeleted;
+}
 
+void fileBeforeDelete(const NMHDR* nmhdr) {
+    pathBeingDeleted = hostPathToUtf8(hostBridge().fullPathOfBuffer(nmhdr->idFrom));
+}
 
-            vFileOpt.value()->isReadOnly = false; // After saving, the file is no longer read-only
-            vFileOpt.value()->isEdited = false;   // After saving, the file is no longer edited
-            vFileOpt.value()->backupFilePath = ""; // Clear backup path after saving
-            changeTreeItemIcon(bufferID, view);
-        }
-	}
-	writeJsonFile();
-	
+void fileDeleted(const NMHDR*) {
+    // The next check of the session must not answer from the cache that the
+    // file is still there.
+    if (!pathBeingDeleted.empty()) {
+        fileStatService.invalidatePath(pathBeingDeleted);
+        pathBeingDeleted.clear();
+    }
+}
 
+// NPPN_FILEBEFORELOAD names no file, and one that failed to load may be gone
+// from disk; the cached answers may be out of date either way.
+void fileLoading(const NMHDR*) {
+    fileStatService.invalidate();
 }
 
 void readOnlyChanged(const NMHDR* nmhdr) {
@@ -277,53 +388,17 @@ void sessionLoaded() {
 }
 
 void nppReady() {
-    // This gets called when Notepad++ is fully ready
-    // Wait a bit for files to be loaded, then sync
-    Sleep(100); // Small delay to ensure files are loaded
-    //syncVDataWithOpenFilesNotification(); Buna gerek yok gibi
-
+    // Notepad++ sends this once the session is loaded; the rest of start-up
+    // follows the readiness signals in advanceStartup().
+    startupSequence.reach(StartupPhase::SessionLoaded);
     commonData.isNppReady = true;
-    
-    // Small delay to ensure docking system is ready
-    Sleep(200);
 
-    // Restore tab selection if Virtual Folders tab was selected last time
-    if (commonData.virtualFoldersTabSelected.get()) {
-        // Switch to Virtual Folders tab
-        npp(NPPM_DMMVIEWOTHERTAB, 0, reinterpret_cast<LPARAM>(L"Virtual Folders"));
-    }
-    
-    syncVDataWithBufferIDs();
-    loadLocalization();
-
-    
-    
-    
-    LRESULT bufID = npp(NPPM_GETCURRENTBUFFERID, 0, 0);
-    UINT_PTR bufferID = static_cast<UINT_PTR>(bufID);
-
-    NMHDR nmhdr{};
-    nmhdr.hwndFrom = commonData.hTree; // source window (tree)
-    nmhdr.idFrom = bufferID;         // the buffer id you wanted
-    nmhdr.code = 0;
-
-    bufferActivated(&nmhdr);
-    
-
-
-
-    // Now we have to collapse the folders manually.
-	vector<VFolder*> allFolders = commonData.rootVFolder.getAllFolders();
-	for (VFolder* folder : allFolders) {
-		if (folder->isExpanded && folder->hTreeItem) {
-			TreeView_Expand(commonData.hTree, folder->hTreeItem, TVE_EXPAND);
-        }
-        else {
-            TreeView_Expand(commonData.hTree, folder->hTreeItem, TVE_COLLAPSE);
-        }
-	}
+    advanceStartup(false);
+}
 
-    //SetTimer(virtualPanel, TREEVIEW_TIMER_ID, 3000, nullptr); // 3-second interval
+void panelDocked() {
+    startupSequence.reach(StartupPhase::PanelDocked);
+    advanceStartup(false);
 }
 
 
@@ -342,16 +417,20 @@ void nppShutdown() {
         commonData.virtualFoldersTabSelected = false;
     }
 
+    traceRecorder.stop();
+    taskScheduler.shutdown();
+
 }
 
 
 void modifyAll(const NMHDR* nmhdr) {
     // This message is sent once for each buffer ID in which text is modified; the same buffer could be visible in both views
     UINT_PTR bufferID = reinterpret_cast<UINT_PTR>(nmhdr->hwndFrom);
-    intptr_t cdi1 = npp(NPPM_GETCURRENTDOCINDEX, 0, 0);
-    intptr_t cdi2 = npp(NPPM_GETCURRENTDOCINDEX, 0, 1);
-    bool visible1 = cdi1 < 0 ? false : bufferID == static_cast<UINT_PTR>(npp(NPPM_GETBUFFERIDFROMPOS, cdi1, 0));
-    bool visible2 = cdi2 < 0 ? false : bufferID == static_cast<UINT_PTR>(npp(NPPM_GETBUFFERIDFROMPOS, cdi2, 1));
+    HostBridge& host = hostBridge();
+    intptr_t cdi1 = host.currentDocIndex(0);
+    intptr_t cdi2 = host.currentDocIndex(1);
+    bool visible1 = cdi1 < 0 ? false : bufferID == host.bufferIDAt(static_cast<int>(cdi1), 0);
+    bool visible2 = cdi2 < 0 ? false : bufferID == host.bufferIDAt(static_cast<int>(cdi2), 1);
     if (visible1) {
         plugin.getScintillaPointers(plugin.nppData._scintillaMainHandle);
         // process changed visible main view
@@ -363,13 +442,12 @@ void modifyAll(const NMHDR* nmhdr) {
 }
 
 wchar_t* getFullPathFromBufferID(UINT_PTR bufferID) {
-    LRESULT posId = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETPOSFROMBUFFERID, bufferID, 0);
-    if (posId == -1) {
+    if (hostBridge().positionOfBuffer(bufferID, 0) == -1) {
         return nullptr;
     }
-    int len = (int)::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, 0);
-    wchar_t* filePath = new wchar_t[len + 1];
-    ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (LPARAM)filePath);
+    const wstring path = hostBridge().fullPathOfBuffer(bufferID);
+    wchar_t* filePath = new wchar_t[path.size() + 1];
+    wcscpy_s(filePath, path.size() + 1, path.c_str());
 
     return filePath;
 }
@@ -383,10 +461,10 @@ int GetActiveViewForBuffer(UINT_PTR bufferID)
 {
     for (int view = SUB_VIEW; view >= MAIN_VIEW; --view)
     {
-        int activeIndex = (int)npp(NPPM_GETCURRENTDOCINDEX, 0, (LPARAM)view);
+        int activeIndex = (int)hostBridge().currentDocIndex(view);
         if (activeIndex != -1)
         {
-            UINT_PTR activeBufID = (int)npp(NPPM_GETBUFFERIDFROMPOS, (WPARAM)activeIndex, (LPARAM)view);
+            UINT_PTR activeBufID = (int)hostBridge().bufferIDAt(activeIndex, view);
             if (activeBufID == bufferID)
                 return view; // this view has the active buffer
         }
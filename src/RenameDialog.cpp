@@ -1,4 +1,6 @@
 #include "CommonData.h"
+#include "model/TreeJournal.h"
+#include "Bridge/TreeControl.h"
 #include "resource.h"
 #include "Shlwapi.h"
 #include <CommCtrl.h>
@@ -74,15 +76,14 @@ namespace {
                 
                 // Update the item's name
                 if (itemToRename) {
+                    ScopedJournalEntry journalEntry(commonData.rootVFolder);
                     itemToRename->name = newName;
                     
                     // Update the tree item text
                     if (treeItemToRename && hTreeToUpdate) {
-                        TVITEM tvi = { 0 };
-                        tvi.mask = TVIF_TEXT;
-                        tvi.hItem = treeItemToRename;
-                        tvi.pszText = newNameBuffer; // Use the wide string version
-                        TreeView_SetItem(hTreeToUpdate, &tvi);
+                        TreeItemChange change;
+                        change.text = newNameBuffer; // Use the wide string version
+                        treeControl().setItem(treeItemToRename, change);
 
                         VFolder* vFolder = dynamic_cast<VFolder*>(itemToRename);
                         if (vFolder) {
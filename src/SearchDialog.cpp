@@ -0,0 +1,252 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SearchDialog.h"
+#include "CommonData.h"
+#include "Bridge/HostBridge.h"
+#include "Services/ContentSearch.h"
+#include "resource.h"
+#include <CommCtrl.h>
+#include <iterator>
+#include <string>
+#include "Host/Notepad_plus_msgs.h"
+
+namespace {
+
+    // Posted by the search workers; the matches are collected on the UI thread.
+    constexpr UINT WM_SEARCH_PROGRESS = WM_APP + 1;
+
+    static DialogStretch searchStretch;
+    config_rect placement("Folder search dialog placement");
+
+    HWND searchDialog = nullptr;
+    ContentSearch search;
+    std::vector<ContentSearchTarget> folderFiles;   // Of the folder the dialog was shown for
+    std::vector<ContentMatch> results;              // Shown by the list view, which owns no data
+    std::wstring displayText;                       // Handed to LVN_GETDISPINFO
+
+    void updateStatus(HWND hwndDlg) {
+        std::wstring status = std::to_wstring(results.size()) + L" " + commonData.translator->getTextW("SEARCH_LINES")
+            + L", " + std::to_wstring(search.filesSearched()) + L"/" + std::to_wstring(search.fileCount())
+            + L" " + commonData.translator->getTextW("SEARCH_FILES");
+        SetDlgItemText(hwndDlg, IDC_SEARCH_STATUS, status.c_str());
+        EnableWindow(GetDlgItem(hwndDlg, IDC_SEARCH_STOP), search.running());
+    }
+
+    void startSearch(HWND hwndDlg) {
+        const HWND list = GetDlgItem(hwndDlg, IDC_SEARCH_RESULTS);
+        search.cancel();
+        results.clear();
+        ListView_SetItemCount(list, 0);
+
+        wchar_t textBuffer[1024];
+        GetDlgItemText(hwndDlg, IDC_SEARCH_TEXT, textBuffer, static_cast<int>(std::size(textBuffer)));
+        ContentSearchOptions options;
+        options.text = fromWchar(textBuffer);
+        options.matchCase = IsDlgButtonChecked(hwndDlg, IDC_SEARCH_MATCHCASE) == BST_CHECKED;
+        options.regex = IsDlgButtonChecked(hwndDlg, IDC_SEARCH_REGEX) == BST_CHECKED;
+        if (options.text.empty()) {
+            return;
+        }
+
+        if (!search.start(folderFiles, options, [hwndDlg]() { PostMessage(hwndDlg, WM_SEARCH_PROGRESS, 0, 0); })) {
+            SetDlgItemText(hwndDlg, IDC_SEARCH_STATUS, commonData.translator->getTextW("SEARCH_INVALID_REGEX").c_str());
+            return;
+        }
+        updateStatus(hwndDlg);
+    }
+
+    void collectMatches(HWND hwndDlg) {
+        std::vector<ContentMatch> taken = search.takeMatches();
+        if (!taken.empty()) {
+            results.insert(results.end(), std::make_move_iterator(taken.begin()), std::make_move_iterator(taken.end()));
+            ListView_SetItemCountEx(GetDlgItem(hwndDlg, IDC_SEARCH_RESULTS), static_cast<int>(results.size()),
+                LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+        }
+        updateStatus(hwndDlg);
+    }
+
+    void openResult(size_t index) {
+        if (index >= results.size()) {
+            return;
+        }
+        const ContentMatch& match = results[index];
+        const ContentSearchTarget& target = search.target(match.target);
+
+        const intptr_t position = hostBridge().positionOfBuffer(target.bufferID, target.view);
+        if (position != -1) {
+            hostBridge().activateDocument(positionView(position), positionIndex(position));
+        }
+        else {
+            const std::wstring path = utf8ToHostPath(target.path);
+            if (!npp(NPPM_DOOPEN, 0, reinterpret_cast<LPARAM>(path.c_str()))) {
+                return;
+            }
+        }
+
+        plugin.getScintillaPointers();
+        const Scintilla::Line line = static_cast<Scintilla::Line>(match.line) - 1;
+        const Scintilla::Position start = plugin.sci.PositionFromLine(line) + static_cast<Scintilla::Position>(match.column);
+        plugin.sci.EnsureVisibleEnforcePolicy(line);
+        plugin.sci.GotoLine(line);
+        plugin.sci.SetSel(start, start + static_cast<Scintilla::Position>(match.length));
+    }
+
+    void addColumns(HWND list) {
+        ListView_SetExtendedListViewStyle(list, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER);
+        const char* const titles[] = { "SEARCH_COLUMN_FILE", "SEARCH_COLUMN_LINE", "SEARCH_COLUMN_TEXT" };
+        const int widths[] = { 160, 50, 400 };
+        for (int i = 0; i < 3; ++i) {
+            std::wstring title = commonData.translator->getTextW(titles[i]);
+            LVCOLUMN column = {};
+            column.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
+            column.pszText = title.data();
+            column.cx = widths[i];
+            column.iSubItem = i;
+            ListView_InsertColumn(list, i, &column);
+        }
+    }
+
+    INT_PTR CALLBACK searchDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+
+        switch (uMsg) {
+
+        case WM_DESTROY:
+            search.cancel();
+            results.clear();
+            folderFiles.clear();
+            npp(NPPM_MODELESSDIALOG, MODELESSDIALOGREMOVE, hwndDlg);
+            searchDialog = nullptr;
+            return TRUE;
+
+        case WM_INITDIALOG:
+        {
+            searchStretch.setup(hwndDlg);
+            placement.put(hwndDlg);
+
+            SetDlgItemText(hwndDlg, IDC_SEARCH_MATCHCASE, commonData.translator->getTextW("IDC_SEARCH_MATCHCASE").c_str());
+            SetDlgItemText(hwndDlg, IDC_SEARCH_REGEX, commonData.translator->getTextW("IDC_SEARCH_REGEX").c_str());
+            SetDlgItemText(hwndDlg, IDOK, commonData.translator->getTextW("IDC_SEARCH_START").c_str());
+            SetDlgItemText(hwndDlg, IDC_SEARCH_STOP, commonData.translator->getTextW("IDC_SEARCH_STOP").c_str());
+            SetDlgItemText(hwndDlg, IDCANCEL, commonData.translator->getTextW("ID_CLOSE").c_str());
+            addColumns(GetDlgItem(hwndDlg, IDC_SEARCH_RESULTS));
+            EnableWindow(GetDlgItem(hwndDlg, IDC_SEARCH_STOP), FALSE);
+
+            npp(NPPM_MODELESSDIALOG, MODELESSDIALOGADD, hwndDlg);
+            npp(NPPM_DARKMODESUBCLASSANDTHEME, NPP::NppDarkMode::dmfInit, hwndDlg);  // Include to support dark mode
+
+            return TRUE;
+        }
+
+        case WM_SEARCH_PROGRESS:
+            collectMatches(hwndDlg);
+            return TRUE;
+
+        case WM_COMMAND:
+            switch (LOWORD(wParam)) {
+            case IDOK:
+                startSearch(hwndDlg);
+                return TRUE;
+            case IDC_SEARCH_STOP:
+                search.cancel();
+                updateStatus(hwndDlg);
+                EnableWindow(GetDlgItem(hwndDlg, IDC_SEARCH_STOP), FALSE);  // Workers may take a moment to notice
+                return TRUE;
+            case IDCANCEL:
+                placement.get(hwndDlg);
+                DestroyWindow(hwndDlg);
+                return TRUE;
+            }
+            return FALSE;
+
+        case WM_NOTIFY:
+        {
+            const NMHDR* header = reinterpret_cast<const NMHDR*>(lParam);
+            if (header->idFrom != IDC_SEARCH_RESULTS) {
+                return FALSE;
+            }
+            if (header->code == LVN_GETDISPINFO) {
+                LVITEM& item = reinterpret_cast<NMLVDISPINFO*>(lParam)->item;
+                if (!(item.mask & LVIF_TEXT) || item.iItem < 0 || static_cast<size_t>(item.iItem) >= results.size()) {
+                    return TRUE;
+                }
+                const ContentMatch& match = results[item.iItem];
+                displayText = item.iSubItem == 0 ? toWstring(search.target(match.target).path)
+                    : item.iSubItem == 1 ? std::to_wstring(match.line)
+                    : toWstring(match.excerpt);
+                item.pszText = displayText.data();
+                return TRUE;
+            }
+            if (header->code == LVN_ITEMACTIVATE) {
+                openResult(static_cast<size_t>(reinterpret_cast<const NMITEMACTIVATE*>(lParam)->iItem));
+                return TRUE;
+            }
+            return FALSE;
+        }
+
+        case WM_GETMINMAXINFO:
+        {
+            MINMAXINFO& mmi = *reinterpret_cast<MINMAXINFO*>(lParam);
+            mmi.ptMinTrackSize.x = searchStretch.originalWidth();
+            mmi.ptMinTrackSize.y = searchStretch.originalHeight();
+            return FALSE;
+        }
+
+        case WM_SIZE:
+            searchStretch.adjust(IDC_SEARCH_TEXT, 1)
+                   .adjust(IDOK, 0, 0, 1)
+                   .adjust(IDC_SEARCH_STOP, 0, 0, 1)
+                   .adjust(IDC_SEARCH_STATUS, 1)
+                   .adjust(IDC_SEARCH_RESULTS, 1, 1)
+                   .adjust(IDCANCEL, 0, 0, 1, 1);
+            return FALSE;
+
+        }
+
+        return FALSE;
+    }
+
+}
+
+void showFolderSearchDialog(const VFolder& folder) {
+    if (!searchDialog) {
+        searchDialog = CreateDialog(plugin.dllInstance, MAKEINTRESOURCE(IDD_FOLDER_SEARCH), plugin.nppData._nppHandle, searchDialogProc);
+        if (!searchDialog) {
+            return;
+        }
+    }
+
+    // The targets are copies; the model can change while the search runs.
+    search.cancel();
+    results.clear();
+    ListView_SetItemCount(GetDlgItem(searchDialog, IDC_SEARCH_RESULTS), 0);
+    folderFiles.clear();
+    for (const VFile* file : folder.getAllFiles()) {
+        ContentSearchTarget target;
+        target.path = file->path;
+        target.readFrom = file->backupFilePath.empty() ? file->path : file->backupFilePath;
+        target.bufferID = file->bufferID;
+        target.view = file->view;
+        folderFiles.push_back(std::move(target));
+    }
+
+    const std::wstring title = commonData.translator->getTextW("IDD_FOLDER_SEARCH") + L" - " + toWstring(folder.name);
+    SetWindowText(searchDialog, title.c_str());
+    SetDlgItemText(searchDialog, IDC_SEARCH_STATUS, L"");
+    ShowWindow(searchDialog, SW_SHOW);
+    SetFocus(GetDlgItem(searchDialog, IDC_SEARCH_TEXT));
+    SendDlgItemMessage(searchDialog, IDC_SEARCH_TEXT, EM_SETSEL, 0, -1);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "model/VData.h"
+#include <windows.h>
+
+// Shows the "Find in this folder" dialog for the files under folder. The
+// dialog is modeless; showing it again for another folder stops the search
+// that is running and keeps the window where it is.
+void showFolderSearchDialog(const VFolder& folder);
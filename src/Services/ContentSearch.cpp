@@ -0,0 +1,370 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ContentSearch.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <regex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+using std::string;
+using std::vector;
+
+
+namespace {
+
+constexpr size_t binarySniff = 8192;	// A NUL byte this early means a binary file
+
+// Read-only view of a whole file; empty if it cannot be opened or is empty.
+class MappedFile {
+public:
+	explicit MappedFile(const string& utf8Path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return view; }
+	size_t size() const { return length; }
+
+private:
+	const char* view = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& utf8Path) {
+	const int wideLength = MultiByteToWideChar(CP_UTF8, 0, utf8Path.data(), static_cast<int>(utf8Path.size()), nullptr, 0);
+	std::wstring widePath(wideLength, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, utf8Path.data(), static_cast<int>(utf8Path.size()), widePath.data(), wideLength);
+
+	file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX) {
+		return;
+	}
+	mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		return;
+	}
+	view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (view) {
+		length = static_cast<size_t>(fileSize.QuadPart);
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (view) UnmapViewOfFile(view);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const string& utf8Path) {
+	const int descriptor = open(utf8Path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+		void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (mapped != MAP_FAILED) {
+			view = static_cast<const char*>(mapped);
+			length = static_cast<size_t>(status.st_size);
+		}
+	}
+	close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+	if (view) munmap(const_cast<char*>(view), length);
+}
+
+#endif
+
+char lowerAscii(char c) {
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+char upperAscii(char c) {
+	return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+bool equalsFolded(const char* text, const string& folded) {
+	for (size_t i = 0; i < folded.size(); ++i) {
+		if (lowerAscii(text[i]) != folded[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Finds the search text from a position on. The first byte is located with
+// memchr, in both cases when the search ignores case, and only those
+// positions are compared in full.
+class LiteralFinder {
+public:
+	LiteralFinder(const char* data, size_t size, const string& text, bool matchCase)
+		: data(data), size(size), text(matchCase ? text : string()), folded(matchCase ? string() : text) {
+		for (char& c : folded) c = lowerAscii(c);
+		const char first = matchCase ? text.front() : folded.front();
+		lower = first;
+		upper = matchCase ? first : upperAscii(first);
+	}
+
+	// Offset of the next occurrence at or after from, or size if none.
+	size_t next(size_t from) {
+		const size_t length = text.empty() ? folded.size() : text.size();
+		while (from + length <= size) {
+			const size_t at = nextFirstByte(from);
+			if (at + length > size) {
+				break;
+			}
+			if (text.empty() ? equalsFolded(data + at, folded) : std::memcmp(data + at, text.data(), length) == 0) {
+				return at;
+			}
+			from = at + 1;
+		}
+		return size;
+	}
+
+private:
+	size_t nextFirstByte(size_t from) {
+		// Each case keeps the last position it found, so neither is rescanned.
+		if (lowerAt < from || lowerAt == unknown) lowerAt = scan(lower, from);
+		if (lower == upper) return lowerAt;
+		if (upperAt < from || upperAt == unknown) upperAt = scan(upper, from);
+		return std::min(lowerAt, upperAt);
+	}
+
+	size_t scan(char c, size_t from) const {
+		const void* found = std::memchr(data + from, c, size - from);
+		return found ? static_cast<size_t>(static_cast<const char*>(found) - data) : size;
+	}
+
+	static constexpr size_t unknown = SIZE_MAX;
+	const char* data;
+	size_t size;
+	string text;			// Set when matching case
+	string folded;			// Set when ignoring it
+	char lower = 0;
+	char upper = 0;
+	size_t lowerAt = unknown;
+	size_t upperAt = unknown;
+};
+
+}
+
+
+struct ContentSearch::State {
+	vector<ContentSearchTarget> targets;
+	ContentSearchOptions options;
+	std::regex pattern;
+	Progress onProgress;
+
+	std::atomic<size_t> searched{ 0 };
+	std::atomic<size_t> remaining{ 0 };	// Files whose task has not finished
+	std::atomic<bool> cancelled{ false };
+	std::atomic<bool> notified{ false };	// onProgress called, takeMatches() not yet
+
+	std::mutex mutex;
+	vector<ContentMatch> matches;
+
+	void publish(vector<ContentMatch>& found) {
+		// Matches of a cancelled search are still queued but nobody is told.
+		if (!found.empty()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::move(found.begin(), found.end(), std::back_inserter(matches));
+			found.clear();
+		}
+		if (!cancelled && !notified.exchange(true) && onProgress) {
+			onProgress();
+		}
+	}
+
+	void searchFile(size_t index, vector<ContentMatch>& found) const;
+	void run(size_t index);
+};
+
+void ContentSearch::State::searchFile(size_t index, vector<ContentMatch>& found) const {
+	const ContentSearchTarget& target = targets[index];
+	const MappedFile file(target.readFrom.empty() ? target.path : target.readFrom);
+	const char* data = file.data();
+	const size_t size = file.size();
+	if (!data || std::memchr(data, '\0', std::min(size, binarySniff))) {
+		return;
+	}
+
+	size_t line = 1;
+	size_t counted = 0;		// Lines are counted up to here
+	size_t reported = 0;
+	const auto report = [&](size_t lineStart, size_t lineEnd, size_t at, size_t length) {
+		line += std::count(data + counted, data + lineStart, '\n');
+		counted = lineStart;
+		if (lineEnd > lineStart && data[lineEnd - 1] == '\r') {
+			--lineEnd;
+		}
+		ContentMatch match;
+		match.target = index;
+		match.line = line;
+		match.column = at - lineStart;
+		match.length = length;
+		match.excerpt.assign(data + lineStart, std::min(lineEnd - lineStart, options.maxExcerpt));
+		found.push_back(std::move(match));
+		return ++reported < options.maxMatchesPerFile && !cancelled.load(std::memory_order_relaxed);
+	};
+	const auto endOfLine = [&](size_t from) {
+		const void* newline = std::memchr(data + from, '\n', size - from);
+		return newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : size;
+	};
+
+	if (!options.regex) {
+		LiteralFinder finder(data, size, options.text, options.matchCase);
+		for (size_t at = finder.next(0); at < size; ) {
+			size_t lineStart = at;
+			while (lineStart > counted && data[lineStart - 1] != '\n') --lineStart;
+			const size_t lineEnd = endOfLine(at);
+			if (!report(lineStart, lineEnd, at, options.text.size()) || lineEnd >= size) {
+				break;
+			}
+			at = finder.next(lineEnd + 1);
+		}
+		return;
+	}
+
+	std::cmatch result;
+	for (size_t lineStart = 0; lineStart < size && !cancelled.load(std::memory_order_relaxed); ) {
+		const size_t lineEnd = endOfLine(lineStart);
+		size_t textEnd = lineEnd;
+		if (textEnd > lineStart && data[textEnd - 1] == '\r') --textEnd;
+		if (std::regex_search(data + lineStart, data + textEnd, result, pattern)) {
+			if (!report(lineStart, lineEnd, lineStart + result.position(0), result.length(0))) {
+				break;
+			}
+		}
+		lineStart = lineEnd + 1;
+	}
+}
+
+void ContentSearch::State::run(size_t index) {
+	vector<ContentMatch> found;
+	if (!cancelled.load(std::memory_order_relaxed)) {
+		searchFile(index, found);
+		searched.fetch_add(1);
+		if (!found.empty()) {
+			publish(found);
+		}
+	}
+	if (remaining.fetch_sub(1) == 1) {
+		notified = false;		// The last word always gets through
+		publish(found);
+	}
+}
+
+
+bool ContentSearch::start(vector<ContentSearchTarget> targets, const ContentSearchOptions& options, Progress onProgress) {
+	cancel();
+	if (options.text.empty()) {
+		return false;
+	}
+
+	auto next = std::make_shared<State>();
+	if (options.regex) {
+		auto flags = std::regex::ECMAScript | std::regex::optimize;
+		if (!options.matchCase) flags |= std::regex::icase;
+		try {
+			next->pattern = std::regex(options.text, flags);
+		}
+		catch (const std::regex_error&) {
+			return false;
+		}
+	}
+	next->targets = std::move(targets);
+	next->options = options;
+	next->onProgress = std::move(onProgress);
+
+	// One task per file; the scheduler's workers steal them from each other,
+	// so a few large files do not hold up the rest.
+	state = next;
+	if (next->targets.empty()) {
+		vector<ContentMatch> none;
+		next->publish(none);
+		return true;
+	}
+	next->remaining = next->targets.size();
+	for (size_t i = 0; i < next->targets.size(); ++i) {
+		taskScheduler.submit([next, i]() { next->run(i); }, TaskPriority::High);
+	}
+	return true;
+}
+
+void ContentSearch::cancel() {
+	if (state) {
+		state->cancelled = true;
+	}
+}
+
+vector<ContentMatch> ContentSearch::takeMatches() {
+	if (!state) {
+		return {};
+	}
+	vector<ContentMatch> taken;
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		taken.swap(state->matches);
+	}
+	state->notified = false;
+	return taken;
+}
+
+bool ContentSearch::running() const {
+	return state && state->remaining.load() > 0;
+}
+
+size_t ContentSearch::filesSearched() const {
+	return state ? state->searched.load() : 0;
+}
+
+size_t ContentSearch::fileCount() const {
+	return state ? state->targets.size() : 0;
+}
+
+const ContentSearchTarget& ContentSearch::target(size_t index) const {
+	return state->targets[index];
+}
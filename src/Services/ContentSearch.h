@@ -0,0 +1,82 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Searches the contents of a set of files on the taskScheduler workers.
+//
+// Each file is memory-mapped and scanned for the search text; literal
+// searches skip ahead with memchr on the first byte of the text and only
+// compare at those positions, regular expressions are tried line by line.
+// Every matching line is reported once. Each file is a task of its own, so a
+// few large files do not hold up the rest, and matches are queued as they are
+// found: the UI thread is told through the progress callback and collects
+// them with takeMatches(). Nothing here ever waits for the workers; cancel()
+// only asks them to stop.
+
+struct ContentSearchOptions {
+	std::string text;					// UTF-8
+	bool matchCase = false;
+	bool regex = false;					// ECMAScript syntax, one line at a time
+	size_t maxMatchesPerFile = 1000;
+	size_t maxExcerpt = 200;			// Bytes of the matching line kept
+};
+
+struct ContentSearchTarget {
+	std::string path;					// As shown to the user
+	std::string readFrom;				// Backup of an unsaved buffer, or path
+	uintptr_t bufferID = 0;
+	int view = 0;
+};
+
+struct ContentMatch {
+	size_t target = 0;					// Index into the targets given to start()
+	size_t line = 0;					// 1-based
+	size_t column = 0;					// 0-based byte offset in the line
+	size_t length = 0;					// Bytes matched
+	std::string excerpt;
+};
+
+class ContentSearch {
+public:
+	using Progress = std::function<void()>;
+
+	~ContentSearch() { cancel(); }
+
+	// Cancels a running search first. Returns false, and starts nothing, if
+	// the text is empty or is not a valid regular expression. onProgress is
+	// called from a worker thread when matches are waiting and the previous
+	// call has not been answered by takeMatches() yet, and once at the end.
+	bool start(std::vector<ContentSearchTarget> targets, const ContentSearchOptions& options, Progress onProgress);
+	void cancel();
+
+	std::vector<ContentMatch> takeMatches();
+	bool running() const;
+	size_t filesSearched() const;
+	size_t fileCount() const;
+	const ContentSearchTarget& target(size_t index) const;
+
+private:
+	struct State;
+	std::shared_ptr<State> state;		// Workers hold on to it until they return
+};
@@ -0,0 +1,449 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "FileStatService.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+
+using std::string;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+
+namespace {
+
+constexpr uint8_t pendingState = 0xFF;
+constexpr size_t maxCacheEntries = 16384;
+
+struct DirectoryJob {
+	string directory;
+	vector<size_t> pathIndexes;
+};
+
+// One checkPaths() call.
+struct Batch {
+	vector<string> paths;
+	vector<DirectoryJob> jobs;
+	vector<uint8_t> states;
+	vector<uint8_t> directoryStates;
+	size_t pending = 0;
+	size_t cacheHits = 0;
+	FileStatCompletion completion;
+};
+
+struct Job {
+	std::shared_ptr<Batch> batch;
+	size_t index = 0;
+};
+
+struct CacheEntry {
+	FileStatState state = FileStatState::Missing;
+	Clock::time_point checkedAt;
+};
+
+}
+
+
+struct FileStatService::Core : std::enable_shared_from_this<FileStatService::Core> {
+	struct Worker {
+		Job job;
+		Clock::time_point busySince;
+		bool busy = false;		// In a call to the probe
+		bool stuck = false;		// The call timed out; its answer is ignored
+	};
+
+	explicit Core(FileStatOptions options);
+
+	bool lookup(const string& key, FileStatState& state);
+	void remember(const string& key, FileStatState state);
+
+	// These run with mutex held.
+	void startThreads();
+	void runJob(size_t self, std::unique_lock<std::mutex>& lock);
+	bool resolveJob(Batch& batch, size_t jobIndex, FileStatState state);
+	std::function<void()> finish(Batch& batch);
+
+	void runWorker(size_t self);
+	void watch();
+
+	FileStatOptions options;
+	std::function<bool(const string&, bool&)> probe;
+	std::function<void(std::function<void()>)> post;
+
+	std::mutex cacheMutex;
+	std::unordered_map<string, CacheEntry> cache;
+
+	std::mutex mutex;
+	std::condition_variable work;
+	std::condition_variable watchdog;
+	std::deque<Job> queue;
+	std::deque<Worker> workers;		// By thread; a deque keeps them in place as it grows
+	size_t stuckWorkers = 0;
+	bool watching = false;
+	bool watchIdle = false;			// No call to time; the next one has to wake it
+	bool stopping = false;
+};
+
+FileStatService::Core::Core(FileStatOptions statOptions) : options(std::move(statOptions)) {
+	options.maxWorkers = std::max<size_t>(1, options.maxWorkers);
+	probe = options.probe ? options.probe : pathExistsOnDisk;
+	post = options.post ? options.post : [](std::function<void()> completion) { taskScheduler.postToUi(std::move(completion)); };
+}
+
+bool FileStatService::Core::lookup(const string& key, FileStatState& state) {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto it = cache.find(key);
+	if (it == cache.end()) {
+		return false;
+	}
+	if (Clock::now() - it->second.checkedAt > options.cacheLifetime) {
+		cache.erase(it);
+		return false;
+	}
+	state = it->second.state;
+	return true;
+}
+
+void FileStatService::Core::remember(const string& key, FileStatState state) {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	const Clock::time_point now = Clock::now();
+	if (cache.size() >= maxCacheEntries) {
+		std::erase_if(cache, [&](const auto& entry) {
+			return now - entry.second.checkedAt > options.cacheLifetime;
+		});
+		if (cache.size() >= maxCacheEntries) {
+			cache.clear();
+		}
+	}
+	cache[key] = { state, now };
+}
+
+// Enough threads that are not stuck for the waiting jobs, up to maxWorkers,
+// and never more than twice that in all.
+void FileStatService::Core::startThreads() {
+	const size_t limit = options.maxWorkers * 2;
+	while (workers.size() < limit && workers.size() - stuckWorkers < std::min(options.maxWorkers, queue.size())) {
+		const size_t self = workers.size();
+		workers.emplace_back();
+		std::thread([shared = shared_from_this(), self]() { shared->runWorker(self); }).detach();
+	}
+	if (!watching) {
+		watching = true;
+		std::thread([shared = shared_from_this()]() { shared->watch(); }).detach();
+	}
+}
+
+// True if that answered the last path of the batch.
+bool FileStatService::Core::resolveJob(Batch& batch, size_t jobIndex, FileStatState state) {
+	bool resolved = false;
+	for (size_t pathIndex : batch.jobs[jobIndex].pathIndexes) {
+		if (batch.states[pathIndex] == pendingState) {
+			batch.states[pathIndex] = static_cast<uint8_t>(state);
+			--batch.pending;
+			resolved = true;
+		}
+	}
+	return resolved && batch.pending == 0;
+}
+
+// Caches the definite answers and returns the call that posts the result.
+std::function<void()> FileStatService::Core::finish(Batch& batch) {
+	for (size_t jobIndex = 0; jobIndex < batch.jobs.size(); ++jobIndex) {
+		const DirectoryJob& job = batch.jobs[jobIndex];
+		const auto directoryState = static_cast<FileStatState>(batch.directoryStates[jobIndex]);
+		if (!job.directory.empty() && (directoryState == FileStatState::Missing || directoryState == FileStatState::Exists)) {
+			remember(job.directory, directoryState);
+		}
+		for (size_t pathIndex : job.pathIndexes) {
+			if (batch.states[pathIndex] != static_cast<uint8_t>(FileStatState::TimedOut)) {
+				remember(batch.paths[pathIndex], static_cast<FileStatState>(batch.states[pathIndex]));
+			}
+		}
+	}
+
+	FileStatBatchResult result;
+	result.states.resize(batch.paths.size());
+	result.exists.resize(batch.paths.size());
+	result.cacheHits = batch.cacheHits;
+	for (size_t i = 0; i < batch.paths.size(); ++i) {
+		const FileStatState state = static_cast<FileStatState>(batch.states[i]);
+		result.states[i] = state;
+		result.exists[i] = state != FileStatState::Missing;
+		if (state == FileStatState::TimedOut) {
+			++result.timedOutCount;
+		}
+	}
+	return [this, completion = std::move(batch.completion), result = std::move(result)]() mutable {
+		post([completion = std::move(completion), result = std::move(result)]() mutable {
+			completion(std::move(result));
+		});
+	};
+}
+
+void FileStatService::Core::runWorker(size_t self) {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		work.wait(lock, [this]() { return stopping || !queue.empty(); });
+		if (stopping) {
+			return;
+		}
+		workers[self].job = std::move(queue.front());
+		queue.pop_front();
+		runJob(self, lock);
+		workers[self].job = {};
+	}
+}
+
+void FileStatService::Core::runJob(size_t self, std::unique_lock<std::mutex>& lock) {
+	const std::shared_ptr<Batch> batch = workers[self].job.batch;
+	const size_t jobIndex = workers[self].job.index;
+	const DirectoryJob& job = batch->jobs[jobIndex];
+
+	// False if the call timed out meanwhile; the watch thread has answered
+	// for the whole job then.
+	auto check = [&](const string& path, bool& found, bool& failed) {
+		Worker& worker = workers[self];
+		worker.busy = true;
+		worker.busySince = Clock::now();
+		if (watchIdle) {
+			watchdog.notify_one();
+		}
+		lock.unlock();
+		failed = false;
+		found = probe(path, failed);
+		lock.lock();
+		worker.busy = false;
+		if (worker.stuck) {
+			worker.stuck = false;
+			--stuckWorkers;
+			return false;
+		}
+		return true;
+	};
+	auto finishIfDone = [&](bool done) {
+		if (done) {
+			const std::function<void()> postResult = finish(*batch);
+			lock.unlock();
+			postResult();
+			lock.lock();
+		}
+	};
+
+	bool found = false;
+	bool failed = false;
+	if (!job.directory.empty()) {
+		if (!check(job.directory, found, failed)) {
+			return;
+		}
+		// An inaccessible directory is not proof that its files are gone;
+		// fall through and let every file answer for itself.
+		const bool directoryMissing = !found && !failed;
+		batch->directoryStates[jobIndex] = static_cast<uint8_t>(directoryMissing ? FileStatState::Missing : FileStatState::Exists);
+		if (directoryMissing) {
+			finishIfDone(resolveJob(*batch, jobIndex, FileStatState::Missing));
+			return;
+		}
+	}
+
+	for (size_t pathIndex : job.pathIndexes) {
+		if (!check(batch->paths[pathIndex], found, failed)) {
+			return;
+		}
+		// Keep entries we cannot inspect (e.g. access denied) instead of
+		// dropping them from the tree.
+		batch->states[pathIndex] = static_cast<uint8_t>((found || failed) ? FileStatState::Exists : FileStatState::Missing);
+		finishIfDone(--batch->pending == 0);
+	}
+}
+
+void FileStatService::Core::watch() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		Clock::time_point deadline = Clock::time_point::max();
+		for (const Worker& worker : workers) {
+			if (worker.busy && !worker.stuck) {
+				deadline = std::min(deadline, worker.busySince + options.perPathTimeout);
+			}
+		}
+		if (deadline == Clock::time_point::max()) {
+			watchIdle = true;
+			watchdog.wait(lock);
+			watchIdle = false;
+		}
+		else {
+			watchdog.wait_until(lock, deadline);
+		}
+
+		vector<std::function<void()>> finished;
+		const Clock::time_point now = Clock::now();
+		for (Worker& worker : workers) {
+			if (!worker.busy || worker.stuck || now - worker.busySince < options.perPathTimeout) {
+				continue;
+			}
+			worker.stuck = true;
+			++stuckWorkers;
+			Batch& batch = *worker.job.batch;
+			if (batch.directoryStates[worker.job.index] == pendingState) {
+				batch.directoryStates[worker.job.index] = static_cast<uint8_t>(FileStatState::TimedOut);
+			}
+			if (resolveJob(batch, worker.job.index, FileStatState::TimedOut)) {
+				finished.push_back(finish(batch));
+			}
+		}
+		startThreads();
+		if (workers.size() == stuckWorkers) {
+			// No thread to take them and no room for another.
+			for (; !queue.empty(); queue.pop_front()) {
+				Batch& batch = *queue.front().batch;
+				batch.directoryStates[queue.front().index] = static_cast<uint8_t>(FileStatState::TimedOut);
+				if (resolveJob(batch, queue.front().index, FileStatState::TimedOut)) {
+					finished.push_back(finish(batch));
+				}
+			}
+		}
+		else {
+			work.notify_all();
+		}
+
+		lock.unlock();
+		for (const std::function<void()>& postResult : finished) {
+			postResult();
+		}
+		lock.lock();
+	}
+}
+
+
+string parentDirectoryOf(const string& path) {
+	const size_t lastSlash = path.find_last_of("/\\");
+	if (lastSlash == string::npos) {
+		return {};
+	}
+	if (lastSlash == 0) {
+		return path.substr(0, 1);
+	}
+	string parent = path.substr(0, lastSlash);
+	if (parent.back() == ':') {
+		parent += path[lastSlash];	// "C:" alone means the current directory of drive C
+	}
+	return parent;
+}
+
+bool pathExistsOnDisk(const string& utf8Path, bool& failed) {
+	std::error_code ec;
+	const std::filesystem::path path(std::u8string(utf8Path.begin(), utf8Path.end()));
+	const bool found = std::filesystem::exists(path, ec);
+	failed = static_cast<bool>(ec);
+	return found;
+}
+
+
+FileStatService::FileStatService(FileStatOptions options) : core(std::make_shared<Core>(std::move(options))) {}
+
+FileStatService::~FileStatService() {
+	{
+		std::lock_guard<std::mutex> lock(core->mutex);
+		core->stopping = true;
+	}
+	core->work.notify_all();
+	core->watchdog.notify_all();
+}
+
+const FileStatOptions& FileStatService::options() const {
+	return core->options;
+}
+
+size_t FileStatService::threadCount() const {
+	std::lock_guard<std::mutex> lock(core->mutex);
+	return core->workers.size();
+}
+
+void FileStatService::invalidate() {
+	std::lock_guard<std::mutex> lock(core->cacheMutex);
+	core->cache.clear();
+}
+
+void FileStatService::invalidatePath(const string& path) {
+	std::lock_guard<std::mutex> lock(core->cacheMutex);
+	core->cache.erase(path);
+	core->cache.erase(parentDirectoryOf(path));
+}
+
+void FileStatService::checkPaths(vector<string> paths, FileStatCompletion completion) {
+	auto batch = std::make_shared<Batch>();
+	batch->paths = std::move(paths);
+	batch->completion = std::move(completion);
+	batch->states.assign(batch->paths.size(), pendingState);
+
+	// Answer what we can from the cache and group the rest by directory.
+	std::unordered_map<string, size_t> jobByDirectory;
+	for (size_t i = 0; i < batch->paths.size(); ++i) {
+		const string& path = batch->paths[i];
+		FileStatState cached;
+		if (path.empty()) {
+			batch->states[i] = static_cast<uint8_t>(FileStatState::Missing);
+			continue;
+		}
+		if (core->lookup(path, cached)) {
+			batch->states[i] = static_cast<uint8_t>(cached);
+			++batch->cacheHits;
+			continue;
+		}
+
+		const string directory = parentDirectoryOf(path);
+		if (!directory.empty() && core->lookup(directory, cached) && cached == FileStatState::Missing) {
+			batch->states[i] = static_cast<uint8_t>(cached);
+			++batch->cacheHits;
+			continue;
+		}
+
+		auto [it, inserted] = jobByDirectory.try_emplace(directory, batch->jobs.size());
+		if (inserted) {
+			batch->jobs.push_back({ directory, {} });
+		}
+		batch->jobs[it->second].pathIndexes.push_back(i);
+		++batch->pending;
+	}
+	batch->directoryStates.assign(batch->jobs.size(), pendingState);
+
+	std::function<void()> postResult;
+	{
+		std::lock_guard<std::mutex> lock(core->mutex);
+		if (batch->jobs.empty()) {
+			postResult = core->finish(*batch);
+		}
+		else {
+			for (size_t jobIndex = 0; jobIndex < batch->jobs.size(); ++jobIndex) {
+				core->queue.push_back({ batch, jobIndex });
+			}
+			core->startThreads();
+		}
+	}
+	if (postResult) {
+		postResult();
+		return;
+	}
+	core->work.notify_all();
+	core->watchdog.notify_one();		// Every thread may be stuck
+}
@@ -0,0 +1,96 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Existence check for files listed in session.xml and in the storage file.
+//
+// Paths are grouped by their parent directory and checked concurrently on
+// stat threads that start with the first check and live as long as the
+// process, so a 1,000-tab session on a network share does not stall the
+// Notepad++ UI thread one stat() at a time. checkPaths() returns at once; the
+// answers come to its completion on the UI thread, through
+// TaskScheduler::postToUi(), when every path has one.
+//
+// A watch thread gives up on a check that has been blocked for
+// perPathTimeout: its directory times out, and another thread takes the
+// place of the stuck one, up to twice maxWorkers. The stuck thread is ready
+// again once its call returns. With every thread stuck and no room for
+// another, the directories still waiting time out as well.
+//
+// A missing directory answers for every file below it. Definite answers are
+// cached for a short time, so repeated checks of the same directories are
+// free; a directory or file that timed out is checked again next time.
+
+enum class FileStatState : uint8_t {
+	Missing,
+	Exists,
+	TimedOut	// The check did not finish in time (e.g. an unreachable share)
+};
+
+struct FileStatOptions {
+	size_t maxWorkers = 8;
+	std::chrono::milliseconds perPathTimeout{ 750 };
+	std::chrono::milliseconds cacheLifetime{ 2000 };
+	// Answers for one path; pathExistsOnDisk() when empty. The host simulator
+	// passes a slow one to stand for an unreachable share.
+	std::function<bool(const std::string& path, bool& failed)> probe;
+	// Hands a completion to the UI thread; taskScheduler.postToUi() when empty.
+	std::function<void(std::function<void()>)> post;
+};
+
+struct FileStatBatchResult {
+	std::vector<FileStatState> states;	// Same order as the requested paths
+	std::vector<bool> exists;			// Bitmap; a timed out path counts as existing
+	size_t timedOutCount = 0;
+	size_t cacheHits = 0;
+
+	bool existsAt(size_t index) const { return index < exists.size() && exists[index]; }
+};
+
+using FileStatCompletion = std::function<void(FileStatBatchResult result)>;
+
+class FileStatService {
+public:
+	explicit FileStatService(FileStatOptions options = {});
+	~FileStatService();	// Lets the threads go; a stuck one leaves when its call returns
+
+	void checkPaths(std::vector<std::string> paths, FileStatCompletion completion);
+
+	void invalidate();
+	void invalidatePath(const std::string& path);
+
+	const FileStatOptions& options() const;
+	size_t threadCount() const;		// Stat threads started, stuck ones included
+
+private:
+	struct Core;
+	std::shared_ptr<Core> core;		// Threads hold on to it until they return
+};
+
+// Paths in the model are UTF-8; this keeps non-ASCII names intact on Windows.
+std::string parentDirectoryOf(const std::string& path);
+bool pathExistsOnDisk(const std::string& utf8Path, bool& failed);
+
+inline FileStatService fileStatService;
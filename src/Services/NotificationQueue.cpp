@@ -0,0 +1,54 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "NotificationQueue.h"
+
+#include <utility>
+
+
+bool NotificationQueue::push(QueuedNotificationKind kind, uintptr_t bufferID, int view, unsigned openViews) {
+	const bool first = pending.empty();
+
+	if (kind == QueuedNotificationKind::Closed) {
+		pending.push_back({ kind, bufferID, view, false, static_cast<uint8_t>(openViews) });
+		return first;
+	}
+
+	// NPPN_FILEOPENED is followed by NPPN_BUFFERACTIVATED for the same tab,
+	// and a tab can be activated several times in a row while Notepad++
+	// rearranges its views.
+	if (kind == QueuedNotificationKind::Activated && selecting != noSelection && selecting == pending.size() - 1) {
+		const QueuedNotification& last = pending.back();
+		if (last.bufferID == bufferID && last.view == view) {
+			++coalesced;
+			return false;
+		}
+	}
+
+	if (selecting != noSelection) {
+		pending[selecting].selectItem = false;
+	}
+	selecting = pending.size();
+	pending.push_back({ kind, bufferID, view, true, 0 });
+	return first;
+}
+
+std::vector<QueuedNotification> NotificationQueue::take() {
+	std::vector<QueuedNotification> batch;
+	batch.swap(pending);
+	selecting = noSelection;
+	return batch;
+}
@@ -0,0 +1,71 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Notifications that arrive in bursts (a session restore or reload, Close All)
+// are queued here and applied together: beNotified only records them and the
+// panel applies the batch on its next message, or right before any other
+// notification is handled. The tree and the storage file are then updated once
+// per burst instead of once per file.
+//
+// Opens and closes are kept in order, since each changes the model. Of the
+// opens and activations only the last one selects its tree item; the earlier
+// ones still bind their buffer to the model (an activation can be a clone into
+// the other view). Repeated activations of the same tab are dropped. A close
+// carries the views its buffer was still open in when it arrived: Notepad++
+// reuses buffer IDs, and by the time the burst is applied the ID can belong
+// to a buffer opened after it.
+
+enum class QueuedNotificationKind : uint8_t {
+	Opened,
+	Activated,
+	Closed
+};
+
+struct QueuedNotification {
+	QueuedNotificationKind kind = QueuedNotificationKind::Activated;
+	uintptr_t bufferID = 0;
+	int view = 0;				// View Notepad++ reported when the notification arrived
+	bool selectItem = true;		// Cleared once a later open or activation supersedes it
+	uint8_t openViews = 0;		// Closes: openViewsOfBuffer() when it arrived
+};
+
+class NotificationQueue {
+public:
+	// Returns true for the first notification since the last take(); that is
+	// when the caller has to schedule a flush.
+	bool push(QueuedNotificationKind kind, uintptr_t bufferID, int view, unsigned openViews = 0);
+	std::vector<QueuedNotification> take();
+
+	bool empty() const { return pending.empty(); }
+	size_t size() const { return pending.size(); }
+	size_t coalescedCount() const { return coalesced; }	// Dropped as duplicates since start-up
+
+private:
+	static constexpr size_t noSelection = static_cast<size_t>(-1);
+
+	std::vector<QueuedNotification> pending;
+	size_t selecting = noSelection;	// Index of the entry that currently selects
+	size_t coalesced = 0;
+};
+
+inline NotificationQueue notificationQueue;
@@ -0,0 +1,60 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "StartupSequence.h"
+
+#include <algorithm>
+#include <vector>
+
+
+const char* startupPhaseName(StartupPhase phase) {
+	switch (phase) {
+	case StartupPhase::Loaded:			return "Loaded";
+	case StartupPhase::PanelDocked:		return "PanelDocked";
+	case StartupPhase::SessionLoaded:	return "SessionLoaded";
+	case StartupPhase::BuffersSynced:	return "BuffersSynced";
+	case StartupPhase::IdleWorkDone:	return "IdleWorkDone";
+	default:							return "?";
+	}
+}
+
+void StartupSequence::reach(StartupPhase phase) {
+	if (!reached(phase)) {
+		reachedAt[index(phase)] = std::chrono::steady_clock::now();
+	}
+}
+
+std::string StartupSequence::timingSummary() const {
+	// The panel can be docked before or after the session is loaded, so list
+	// the phases in the order they were reached.
+	std::vector<StartupPhase> phases;
+	for (size_t i = 0; i < reachedAt.size(); ++i) {
+		if (reachedAt[i]) phases.push_back(static_cast<StartupPhase>(i));
+	}
+	std::stable_sort(phases.begin(), phases.end(), [this](StartupPhase a, StartupPhase b) {
+		return *reachedAt[index(a)] < *reachedAt[index(b)];
+	});
+
+	std::string summary;
+	for (size_t i = 0; i < phases.size(); ++i) {
+		const auto since = i == 0 ? *reachedAt[index(phases[i])] : *reachedAt[index(phases[i - 1])];
+		const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(*reachedAt[index(phases[i])] - since).count();
+		if (!summary.empty()) summary += ", ";
+		summary += startupPhaseName(phases[i]);
+		summary += i == 0 ? " 0 ms" : " +" + std::to_string(millis) + " ms";
+	}
+	return summary;
+}
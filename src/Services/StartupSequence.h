@@ -0,0 +1,59 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+
+// Plugin start-up as a sequence of phases, each reached on a real readiness
+// signal from Notepad++ instead of after a fixed delay. Reaching a phase only
+// records when it happened; ProcessNotifications.cpp decides what runs at
+// each step. The recorded times are logged once start-up has finished.
+
+enum class StartupPhase : uint8_t {
+	Loaded,			// getFuncsArray: configuration and localization read
+	PanelDocked,	// Panel created and registered with the docking manager
+	SessionLoaded,	// NPPN_READY: Notepad++ opened every file of the session
+	BuffersSynced,	// Buffer IDs bound to the model, current buffer selected
+	IdleWorkDone,	// Deferred work (localization refresh, folder expansion) ran
+	Count
+};
+
+class StartupSequence {
+public:
+	// Records the first time a phase is reached; later calls are ignored.
+	void reach(StartupPhase phase);
+	bool reached(StartupPhase phase) const { return reachedAt[index(phase)].has_value(); }
+	bool finished() const { return reached(StartupPhase::IdleWorkDone); }
+
+	// E.g. "Loaded 0 ms, SessionLoaded +812 ms, BuffersSynced +3 ms, ..."
+	// with each phase relative to the one reached before it.
+	std::string timingSummary() const;
+
+private:
+	static constexpr size_t index(StartupPhase phase) { return static_cast<size_t>(phase); }
+
+	std::array<std::optional<std::chrono::steady_clock::time_point>, static_cast<size_t>(StartupPhase::Count)> reachedAt;
+};
+
+const char* startupPhaseName(StartupPhase phase);
+
+inline StartupSequence startupSequence;
@@ -0,0 +1,241 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using std::vector;
+
+
+namespace {
+
+constexpr size_t priorityCount = 3;
+
+// Set on the workers, so a task submitted from a task stays on its worker.
+thread_local const void* currentCore = nullptr;
+thread_local size_t currentWorker = 0;
+
+}
+
+
+struct TaskScheduler::Core {
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Task> tasks[priorityCount];	// By TaskPriority
+	};
+
+	explicit Core(size_t count) : workerCount(count), workers(new Worker[count]) {}
+
+	bool take(size_t self, Task& task);
+	void run(size_t self);
+
+	const size_t workerCount;
+	std::unique_ptr<Worker[]> workers;
+
+	std::mutex startMutex;
+	vector<std::thread> threads;				// Empty until the first task
+	std::atomic<bool> stopping{ false };
+
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<size_t> queued{ 0 };
+	std::atomic<size_t> nextWorker{ 0 };
+
+	std::atomic<uint64_t> executed{ 0 };
+	std::atomic<uint64_t> stolen{ 0 };
+
+	std::mutex completionMutex;
+	vector<Task> completions;
+	std::function<void()> uiWaker;
+};
+
+bool TaskScheduler::Core::take(size_t self, Task& task) {
+	for (size_t priority = 0; priority < priorityCount; ++priority) {
+		{
+			Worker& own = workers[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks[priority].empty()) {
+				task = std::move(own.tasks[priority].back());
+				own.tasks[priority].pop_back();
+				return true;
+			}
+		}
+		for (size_t i = 1; i < workerCount; ++i) {
+			Worker& victim = workers[(self + i) % workerCount];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks[priority].empty()) {
+				task = std::move(victim.tasks[priority].front());
+				victim.tasks[priority].pop_front();
+				stolen.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::Core::run(size_t self) {
+	currentCore = this;
+	currentWorker = self;
+	while (!stopping) {
+		Task task;
+		if (take(self, task)) {
+			queued.fetch_sub(1);
+			try {
+				task();
+			}
+			catch (...) {
+				// A task has nobody to report to; it must not take the host down.
+			}
+			executed.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return stopping || queued > 0; });
+	}
+	currentCore = nullptr;
+}
+
+
+TaskScheduler::TaskScheduler(size_t workerCount) {
+	if (workerCount == 0) {
+		workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+	}
+	core = std::make_shared<Core>(workerCount);
+}
+
+TaskScheduler::~TaskScheduler() {
+	core->stopping = true;
+	{
+		std::lock_guard<std::mutex> lock(core->sleepMutex);
+	}
+	core->wake.notify_all();
+	std::lock_guard<std::mutex> lock(core->startMutex);
+	for (std::thread& thread : core->threads) {
+		if (thread.joinable()) thread.detach();
+	}
+}
+
+void TaskScheduler::submit(Task task, TaskPriority priority) {
+	{
+		std::lock_guard<std::mutex> lock(core->startMutex);
+		if (core->stopping) {
+			return;
+		}
+		if (core->threads.empty()) {
+			for (size_t i = 0; i < core->workerCount; ++i) {
+				core->threads.emplace_back([shared = core, i]() { shared->run(i); });
+			}
+		}
+	}
+
+	const size_t target = currentCore == core.get() ? currentWorker : core->nextWorker.fetch_add(1) % core->workerCount;
+	{
+		Core::Worker& worker = core->workers[target];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(core->sleepMutex);
+		core->queued.fetch_add(1);
+	}
+	core->wake.notify_one();
+}
+
+void TaskScheduler::postToUi(Task completion) {
+	std::function<void()> wake;
+	{
+		std::lock_guard<std::mutex> lock(core->completionMutex);
+		if (core->completions.empty()) {
+			wake = core->uiWaker;			// The first of a batch wakes the UI
+		}
+		core->completions.push_back(std::move(completion));
+	}
+	if (wake) {
+		wake();
+	}
+}
+
+size_t TaskScheduler::runCompletions() {
+	vector<Task> ready;
+	{
+		std::lock_guard<std::mutex> lock(core->completionMutex);
+		ready.swap(core->completions);
+	}
+	for (Task& completion : ready) {
+		completion();
+	}
+	return ready.size();
+}
+
+void TaskScheduler::setUiWaker(std::function<void()> wake) {
+	bool pending = false;
+	{
+		std::lock_guard<std::mutex> lock(core->completionMutex);
+		core->uiWaker = wake;
+		pending = !core->completions.empty();
+	}
+	if (pending && wake) {
+		wake();
+	}
+}
+
+void TaskScheduler::shutdown() {
+	vector<std::thread> threads;
+	{
+		std::lock_guard<std::mutex> lock(core->startMutex);
+		core->stopping = true;
+		threads.swap(core->threads);
+	}
+	{
+		std::lock_guard<std::mutex> lock(core->sleepMutex);
+	}
+	core->wake.notify_all();
+	for (std::thread& thread : threads) {
+		if (thread.get_id() == std::this_thread::get_id()) {
+			thread.detach();				// Called from a task
+		}
+		else if (thread.joinable()) {
+			thread.join();
+		}
+	}
+	for (size_t i = 0; i < core->workerCount; ++i) {
+		std::lock_guard<std::mutex> lock(core->workers[i].mutex);
+		for (std::deque<Task>& tasks : core->workers[i].tasks) {
+			tasks.clear();
+		}
+	}
+	core->queued = 0;
+}
+
+size_t TaskScheduler::workerCount() const {
+	return core->workerCount;
+}
+
+TaskSchedulerStats TaskScheduler::stats() const {
+	TaskSchedulerStats stats;
+	stats.executed = core->executed.load();
+	stats.stolen = core->stolen.load();
+	return stats;
+}
@@ -0,0 +1,78 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+
+// Fixed pool of worker threads for the plugin's background work. Kept free of
+// Win32, so the host simulator runs it on Linux.
+//
+// Every worker has a deque per priority. A task submitted from a worker goes
+// to the back of that worker's own deque and is taken from there again (the
+// newest first, while its data is still in the cache); a task submitted from
+// any other thread goes to the workers in turn. A worker with nothing of its
+// own steals the oldest task of another worker. Higher priorities are always
+// taken first, also when stealing.
+//
+// Tasks never touch the UI. They hand their results to postToUi(), which
+// queues a completion and wakes the UI thread once per batch; the panel posts
+// itself WM_VF_TASK_COMPLETIONS for that and calls runCompletions().
+
+enum class TaskPriority : uint8_t {
+	High,		// The user is waiting for it
+	Normal,
+	Low			// Housekeeping
+};
+
+struct TaskSchedulerStats {
+	uint64_t executed = 0;
+	uint64_t stolen = 0;
+};
+
+class TaskScheduler {
+public:
+	using Task = std::function<void()>;
+
+	explicit TaskScheduler(size_t workerCount = 0);	// 0 picks one per core, between 2 and 8
+	~TaskScheduler();
+
+	// The workers start with the first task. Tasks submitted after shutdown()
+	// are dropped.
+	void submit(Task task, TaskPriority priority = TaskPriority::Normal);
+
+	void postToUi(Task completion);
+	size_t runCompletions();						// On the UI thread; returns how many ran
+	void setUiWaker(std::function<void()> wake);	// Called from any thread, nullptr while there is no UI
+
+	// Drops the queued tasks and waits for the running ones. The destructor
+	// only lets the workers go: it can run where joining threads deadlocks
+	// (DLL unload).
+	void shutdown();
+
+	size_t workerCount() const;
+	TaskSchedulerStats stats() const;
+
+private:
+	struct Core;
+	std::shared_ptr<Core> core;						// Workers hold on to it until they return
+};
+
+inline TaskScheduler taskScheduler;
@@ -0,0 +1,89 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TraceRecorder.h"
+
+
+bool TraceRecorder::start(const std::filesystem::path& traceFile) {
+	stop();
+
+	out.open(traceFile, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		return false;
+	}
+
+	ring = std::make_unique<NotificationRecord[]>(capacity);
+	writeIndex.store(0, std::memory_order_relaxed);
+	readIndex.store(0, std::memory_order_relaxed);
+	dropped.store(0, std::memory_order_relaxed);
+	startedAt = std::chrono::steady_clock::now();
+
+	const auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+	writeNotificationTraceHeader(out, static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count()));
+
+	stopping = false;
+	flusher = std::thread(&TraceRecorder::flushLoop, this);
+	traceRecorderEnabled = true;
+	return true;
+}
+
+void TraceRecorder::stop() {
+	if (!flusher.joinable()) {
+		return;
+	}
+
+	traceRecorderEnabled = false;
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	flusher.join();
+
+	drain();
+	out.close();
+}
+
+void TraceRecorder::flushLoop() {
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	while (!stopping) {
+		wake.wait_for(lock, flushInterval, [this]() { return stopping; });
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+void TraceRecorder::drain() {
+	const uint64_t tail = readIndex.load(std::memory_order_relaxed);
+	const uint64_t head = writeIndex.load(std::memory_order_acquire);
+	if (head == tail) {
+		return;
+	}
+
+	// At most two contiguous pieces of the ring.
+	const uint64_t first = tail & (capacity - 1);
+	const uint64_t count = head - tail;
+	const uint64_t untilEnd = std::min(count, capacity - first);
+	out.write(reinterpret_cast<const char*>(&ring[first]), static_cast<std::streamsize>(untilEnd * sizeof(NotificationRecord)));
+	if (count > untilEnd) {
+		out.write(reinterpret_cast<const char*>(&ring[0]), static_cast<std::streamsize>((count - untilEnd) * sizeof(NotificationRecord)));
+	}
+	out.flush();
+
+	readIndex.store(head, std::memory_order_release);
+}
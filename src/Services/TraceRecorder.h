@@ -0,0 +1,90 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../model/NotificationTrace.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+// Opt-in recorder for the notifications beNotified receives ("traceNotifications"
+// in the configuration file). beNotified is the only producer and a background
+// thread the only consumer of a fixed size lock-free ring, so recording never
+// blocks or allocates on the UI thread; when the ring is full the record is
+// counted as dropped. The flush thread appends the records to a binary trace
+// (see NotificationTrace.h) a few times per second.
+//
+// When recording is off, beNotified pays for a single test of
+// traceRecorderEnabled.
+
+class TraceRecorder {
+public:
+	// stop() must run before the DLL unloads; joining a thread from a static
+	// destructor can hang under the loader lock.
+	~TraceRecorder() { if (flusher.joinable()) flusher.detach(); }
+
+	bool start(const std::filesystem::path& traceFile);
+	void stop();
+
+	void record(uint32_t code, uint64_t bufferID, int view, NotificationSource source) noexcept {
+		const uint64_t head = writeIndex.load(std::memory_order_relaxed);
+		if (head - readIndex.load(std::memory_order_acquire) >= capacity) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		NotificationRecord& slot = ring[head & (capacity - 1)];
+		slot.timestampMicros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - startedAt).count());
+		slot.bufferID = bufferID;
+		slot.code = code;
+		slot.view = static_cast<int8_t>(view);
+		slot.source = source;
+		writeIndex.store(head + 1, std::memory_order_release);
+	}
+
+	uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr uint64_t capacity = 1 << 14;	// Power of two
+	static constexpr std::chrono::milliseconds flushInterval{ 200 };
+
+	void flushLoop();
+	void drain();
+
+	std::unique_ptr<NotificationRecord[]> ring;
+	alignas(64) std::atomic<uint64_t> writeIndex{ 0 };
+	alignas(64) std::atomic<uint64_t> readIndex{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+
+	std::chrono::steady_clock::time_point startedAt;
+	std::ofstream out;
+	std::thread flusher;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+inline bool traceRecorderEnabled = false;
+inline TraceRecorder traceRecorder;
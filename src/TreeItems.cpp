@@ -0,0 +1,204 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreeItems.h"
+#include "Bridge/HostBridge.h"
+
+
+std::unordered_map<IconType, int> iconIndex;
+
+
+FileIcon resolveFileIcon(bool readOnly, bool edited, int view, bool darkMode) {
+    FileIcon icon;
+    if (view == 1) {
+        icon.stateImage = ICON_FILE_SECONDARY_VIEW;
+    }
+
+    if (readOnly) {
+        icon.image = iconIndex[darkMode ? ICON_FILE_READONLY_DARK : ICON_FILE_READONLY_LIGHT];
+    }
+    else if (edited) {
+        icon.image = iconIndex[ICON_FILE_EDITED];
+    }
+    else {
+        icon.image = iconIndex[darkMode ? ICON_FILE_DARK : ICON_FILE_LIGHT];
+    }
+    return icon;
+}
+
+FileIcon fileIconOf(const VFile* vFile, bool darkMode) {
+    return resolveFileIcon(vFile->readOnly(), vFile->hasUnsavedChanges(), vFile->view, darkMode);
+}
+
+void applyFileIcon(const VFile* vFile, const FileIcon& icon) {
+    if (!vFile->hTreeItem) {
+        return;  // Inside a collapsed folder; the item gets the icon when it is created
+    }
+    const auto [applied, inserted] = appliedFileIcons.try_emplace(vFile->hTreeItem, icon);
+    if (!inserted && applied->second == icon) {
+        return;
+    }
+    applied->second = icon;
+
+    TreeItemChange change;
+    change.image = icon.image;
+    change.selectedImage = icon.image;
+    change.stateImage = icon.stateImage;
+    treeControl().setItem(vFile->hTreeItem, change);
+}
+
+void treeItemDeleted(HTREEITEM item) {
+    ++deletedTreeItems;
+    lazyFolderItems.erase(item);
+    appliedFileIcons.erase(item);
+}
+
+void forgetTreeItems() {
+    lazyFolderItems.clear();
+    appliedFileIcons.clear();
+}
+
+TreeItemSpec fileItemSpec(const VFile* vFile, bool darkMode) {
+    const FileIcon icon = resolveFileIcon(vFile->readOnly(), vFile->hasUnsavedChanges(), vFile->view, darkMode);
+    TreeItemSpec item;
+    item.text = utf8ToHostPath(vFile->name);
+    item.image = icon.image;
+    item.selectedImage = icon.image;
+    item.stateImage = icon.stateImage;
+	item.param = vFile->getOrder(); // Store the order/index directly in lparam
+    return item;
+}
+
+TreeItemSpec folderItemSpec(const VFolder* vFolder) {
+    TreeItemSpec item;
+    item.text = utf8ToHostPath(vFolder->name);
+    item.image = iconIndex[ICON_FOLDER];
+    item.selectedImage = iconIndex[ICON_FOLDER];
+    item.childrenOnDemand = true; // Answered from the model in TVN_GETDISPINFO
+    item.param = vFolder->getOrder(); // Store the order/index directly in lparam
+    return item;
+}
+
+void updateTreeItemLParam(VBase* vBase) {
+    if (vBase->hTreeItem && deferredTreeRenders == 0) {
+        TreeItemChange change;
+        change.param = vBase->order;
+        treeControl().setItem(vBase->hTreeItem, change);
+    }
+}
+
+HTREEITEM addFileToTree(VFile* vFile, HTREEITEM hParent, bool darkMode, HTREEITEM hPrevItem) {
+    // Children of a lazy folder are created when it is expanded.
+    if (hParent && lazyFolderItems.contains(hParent)) {
+        vFile->hTreeItem = nullptr;
+        return nullptr;
+    }
+
+    const TreeItemSpec item = fileItemSpec(vFile, darkMode);
+    HTREEITEM hItem = treeControl().insertItem(hParent, hPrevItem, item);
+    ++insertedTreeItems;
+    if (hItem) {
+        appliedFileIcons[hItem] = FileIcon{ item.image, item.stateImage };
+    }
+	vFile->hTreeItem = hItem; // Store the HTREEITEM in the VFile for later reference
+
+    if (vFile->isActive) {
+        treeControl().selectItem(hItem);
+        treeControl().ensureVisible(hItem);
+    }
+
+	return hItem;
+}
+
+HTREEITEM insertFolderItem(VFolder* vFolder, HTREEITEM hParent, HTREEITEM prevItem) {
+    vFolder->hTreeItem = treeControl().insertItem(hParent, prevItem, folderItemSpec(vFolder));
+    ++insertedTreeItems;
+    return vFolder->hTreeItem;
+}
+
+HTREEITEM addFolderToTree(VFolder* vFolder, HTREEITEM hParent, HTREEITEM prevItem) {
+    if (hParent && lazyFolderItems.contains(hParent)) {
+        vFolder->hTreeItem = nullptr;
+        for (VFile* file : vFolder->getAllFiles()) file->hTreeItem = nullptr;
+        for (VFolder* folder : vFolder->getAllFolders()) folder->hTreeItem = nullptr;
+        return nullptr;
+    }
+
+    const bool shouldExpand = vFolder->isExpanded;
+    HTREEITEM hFolder = insertFolderItem(vFolder, hParent, prevItem);
+	prevItem = hFolder;
+
+    if (insertsLazily(vFolder)) {
+        for (VFile* file : vFolder->getAllFiles()) file->hTreeItem = nullptr;
+        for (VFolder* folder : vFolder->getAllFolders()) folder->hTreeItem = nullptr;
+        lazyFolderItems.insert(hFolder);
+        return hFolder;
+    }
+
+    const bool isDarkMode = hostBridge().isDarkModeEnabled();
+    for (VBase* child : vFolder->getAllDirectChildren()) {
+        if (VFolder* vSubFolder = dynamic_cast<VFolder*>(child)) {
+            prevItem = addFolderToTree(vSubFolder, hFolder, prevItem);
+        }
+        else {
+            prevItem = addFileToTree(static_cast<VFile*>(child), hFolder, isDarkMode, prevItem);
+        }
+    }
+
+    // Apply the saved state after inserting the children. Expanding an empty
+    // TreeView item has no effect, which made moved folders appear collapsed.
+    treeControl().expand(hFolder, shouldExpand);
+
+    return vFolder->hTreeItem;
+}
+
+bool insertsLazily(const VFolder* vFolder) {
+    return !vFolder->isExpanded && (!vFolder->fileList.empty() || !vFolder->folderList.empty());
+}
+
+// Inserts the direct children of a lazy folder. Collapsed subfolders stay lazy.
+void materializeFolder(VFolder* vFolder) {
+    if (!vFolder->hTreeItem || lazyFolderItems.erase(vFolder->hTreeItem) == 0) {
+        return;
+    }
+
+    const bool isDarkMode = hostBridge().isDarkModeEnabled();
+    HTREEITEM prevItem = TVI_FIRST;
+    for (VBase* child : vFolder->getAllDirectChildren()) {
+        if (VFolder* vSubFolder = dynamic_cast<VFolder*>(child)) {
+            prevItem = addFolderToTree(vSubFolder, vFolder->hTreeItem, prevItem);
+        }
+        else {
+            prevItem = addFileToTree(static_cast<VFile*>(child), vFolder->hTreeItem, isDarkMode, prevItem);
+        }
+    }
+}
+
+bool materializeAncestors(VFolder& root, VBase* vBase) {
+    // findParentFolder() reports the root itself as the parent of top-level folders.
+    vector<VFolder*> ancestors;
+    for (VFolder* parent = root.findParentFolder(vBase->getOrder()); parent && parent != &root;
+            parent = root.findParentFolder(parent->getOrder())) {
+        ancestors.push_back(parent);
+    }
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+        if (!(*it)->hTreeItem) {
+            return false;
+        }
+        materializeFolder(*it);
+    }
+    return vBase->hTreeItem != nullptr;
+}
@@ -0,0 +1,82 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "model/VData.h"
+#include "Bridge/TreeControl.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+
+// Mirrors model entries as tree items through treeControl(). Free of Win32,
+// so tools/HostSimulator runs the same code against HeadlessTreeControl.
+
+enum IconType {
+    ICON_APP,
+    ICON_FOLDER,
+    ICON_FILE_LIGHT,
+    ICON_FILE_DARK,
+    ICON_FILE_EDITED,
+	ICON_FILE_READONLY_DARK,
+	ICON_FILE_READONLY_LIGHT,
+    ICON_FILE_SECONDARY_VIEW
+};
+
+extern std::unordered_map<IconType, int> iconIndex;
+
+// Collapsed folders whose children are not in the tree yet. Their items report
+// children through TVN_GETDISPINFO and get them on TVN_ITEMEXPANDING.
+inline std::unordered_set<HTREEITEM> lazyFolderItems;
+
+// What a file item shows besides its name. Equal icons look the same.
+struct FileIcon {
+    int image = 0;
+    unsigned stateImage = 0;    // 1-based index in the state image list, 0 for none
+
+    bool operator==(const FileIcon&) const = default;
+};
+
+// The icon last sent to each file item, so an unchanged icon is not sent again.
+inline std::unordered_map<HTREEITEM, FileIcon> appliedFileIcons;
+
+// Items inserted through this file and deleted as treeItemDeleted() hears of
+// them, children included. TreeRenderer reports what a render added to them.
+inline size_t insertedTreeItems = 0;
+inline size_t deletedTreeItems = 0;
+
+// While above zero, order changes leave lParam alone; the pending
+// ScopedTreeRender rewrites the ones that changed.
+inline int deferredTreeRenders = 0;
+
+// Pure: the icon of a file that is read-only and/or edited, in a view and theme.
+FileIcon resolveFileIcon(bool readOnly, bool edited, int view, bool darkMode);
+// The icon for a file, counting a buffer that is not at its save point as edited.
+FileIcon fileIconOf(const VFile* vFile, bool darkMode);
+void applyFileIcon(const VFile* vFile, const FileIcon& icon);  // Skipped if the item shows it already
+void treeItemDeleted(HTREEITEM item);
+void forgetTreeItems();  // After the control was emptied
+
+TreeItemSpec fileItemSpec(const VFile* vFile, bool darkMode);
+TreeItemSpec folderItemSpec(const VFolder* vFolder);
+void updateTreeItemLParam(VBase* vBase);
+HTREEITEM addFileToTree(VFile* vFile, HTREEITEM hParent, bool darkMode, HTREEITEM hPrevItem);
+HTREEITEM addFolderToTree(VFolder* vFolder, HTREEITEM hParent, HTREEITEM hPrevItem);
+HTREEITEM insertFolderItem(VFolder* vFolder, HTREEITEM hParent, HTREEITEM hPrevItem);  // The folder alone
+bool insertsLazily(const VFolder* vFolder);
+void materializeFolder(VFolder* vFolder);
+bool materializeAncestors(VFolder& root, VBase* vBase);  // False if an ancestor has no item
@@ -0,0 +1,64 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreePalette.h"
+#include "Framework/PluginFramework.h"
+
+#include <initializer_list>
+
+
+const TreePalette& TreePaletteCache::get() {
+    if (!stale) {
+        return palette;
+    }
+
+    const HWND scintilla = plugin.currentScintilla();
+    const COLORREF text = (COLORREF)::SendMessage(scintilla, SCI_STYLEGETFORE, STYLE_DEFAULT, 0);
+    const COLORREF background = (COLORREF)::SendMessage(scintilla, SCI_STYLEGETBACK, STYLE_DEFAULT, 0);
+    if (palette.backgroundBrush && text == palette.text && background == palette.background) {
+        stale = false;
+        return palette;
+    }
+
+    release();
+    palette.text = text;
+    palette.background = background;
+    palette.hoverBackground = RGB(200, 220, 255);
+    palette.selectedText = RGB(255, 255, 255);
+    palette.selectedBackground = RGB(152, 178, 227);
+    palette.backgroundBrush = CreateSolidBrush(palette.background);
+    palette.hoverBrush = CreateSolidBrush(palette.hoverBackground);
+    palette.selectedBrush = CreateSolidBrush(palette.selectedBackground);
+    stale = false;
+    return palette;
+}
+
+void TreePaletteCache::bufferLanguage(int langType) {
+    if (langType != lastLangType) {
+        lastLangType = langType;
+        stale = true;
+    }
+}
+
+void TreePaletteCache::release() {
+    for (HBRUSH* brush : { &palette.backgroundBrush, &palette.hoverBrush, &palette.selectedBrush }) {
+        if (*brush) {
+            DeleteObject(*brush);
+            *brush = nullptr;
+        }
+    }
+    stale = true;
+}
@@ -0,0 +1,53 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#define NOMINMAX
+#include <windows.h>
+
+
+// Colors and brushes the tree paints its rows with. The editor colors only
+// come out of Scintilla through SendMessage, so they are read once and the
+// brushes created once, then reused for every row of every frame until
+// invalidate(): on NPPN_DARKMODECHANGED, NPPN_WORDSTYLESUPDATED,
+// NPPN_LANGCHANGED and when the activated buffer has another language.
+
+struct TreePalette {
+    COLORREF text = 0;
+    COLORREF background = 0;
+    COLORREF hoverBackground = 0;
+    COLORREF selectedText = 0;
+    COLORREF selectedBackground = 0;
+    HBRUSH backgroundBrush = nullptr;
+    HBRUSH hoverBrush = nullptr;
+    HBRUSH selectedBrush = nullptr;
+};
+
+class TreePaletteCache {
+public:
+    const TreePalette& get();               // Reads the editor colors again if invalidated
+    void invalidate() { stale = true; }
+    void bufferLanguage(int langType);      // Invalidates when it differs from the last buffer's
+    void release();                         // Deletes the brushes; the panel calls it on WM_DESTROY
+
+private:
+    TreePalette palette;
+    bool stale = true;
+    int lastLangType = -1;
+};
+
+inline TreePaletteCache treePalette;
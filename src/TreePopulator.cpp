@@ -0,0 +1,197 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreePopulator.h"
+#include "TreeViewManager.h"
+
+#include <algorithm>
+
+
+namespace {
+// Work done per idle tick; short enough that input stays responsive.
+constexpr std::chrono::milliseconds tickBudget{ 8 };
+constexpr size_t minimumFirstScreen = 32;
+}
+
+
+void TreePopulator::start(HWND tree, HWND timerWindow, VFolder& model) {
+    cancel();
+    hTree = tree;
+    hTimerWindow = timerWindow;
+    root = &model;
+    darkMode = hostBridge().isDarkModeEnabled();
+    inserted = 0;
+    startedAt = std::chrono::steady_clock::now();
+
+    // Items of an earlier tree are gone; only what gets inserted now counts.
+    for (VFile* file : model.getAllFiles()) file->hTreeItem = nullptr;
+    for (VFolder* folder : model.getAllFolders()) folder->hTreeItem = nullptr;
+    forgetTreeItems();
+
+    pushFrame(nullptr, TVI_ROOT);
+
+    // The first screen: every inserted item takes at most one visible row.
+    const size_t firstScreen = std::max<size_t>(minimumFirstScreen, TreeView_GetVisibleCount(hTree) + 1);
+    while (inserted < firstScreen && insertNext()) {}
+
+    for (VFile* file : model.getAllFiles()) {
+        if (file->isActive) {
+            reveal(file);
+            break;
+        }
+    }
+
+    if (active()) {
+        SetTimer(hTimerWindow, TREEVIEW_TIMER_ID, USER_TIMER_MINIMUM, nullptr);
+    }
+    else {
+        logCompletion();
+    }
+}
+
+void TreePopulator::onTimer() {
+    if (!active()) {
+        stopTimer();
+        return;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + tickBudget;
+    size_t count = 0;
+    while (insertNext()) {
+        // Reading the clock costs more than inserting an item or two.
+        if (++count % 16 == 0 && std::chrono::steady_clock::now() >= deadline) {
+            return;
+        }
+    }
+    stopTimer();
+    logCompletion();
+}
+
+void TreePopulator::finish() {
+    if (!active()) {
+        return;
+    }
+
+    treeControl().setRedraw(false);
+    while (insertNext()) {}
+    treeControl().setRedraw(true);
+
+    stopTimer();
+    logCompletion();
+}
+
+void TreePopulator::cancel() {
+    stack.clear();
+    stopTimer();
+}
+
+void TreePopulator::reveal(VFile* vFile) {
+    if (!active() || vFile->hTreeItem) {
+        return;
+    }
+
+    // findParentFolder() reports the root itself as the parent of top-level folders.
+    vector<VFolder*> ancestors;
+    for (VFolder* parent = root->findParentFolder(vFile->getOrder()); parent && parent != root; parent = root->findParentFolder(parent->getOrder())) {
+        if (!parent->isExpanded) {
+            return;     // Hidden; ensureTreeItem() creates it when needed
+        }
+        ancestors.push_back(parent);
+    }
+
+    // Everything the stream inserted so far comes earlier in the model, so
+    // appending keeps the siblings in order; the stream later inserts the
+    // missing ones in front of these items.
+    HTREEITEM hParent = TVI_ROOT;
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+        if (!(*it)->hTreeItem) {
+            insertFolderItem(*it, hParent, TVI_LAST);
+            ++inserted;
+        }
+        hParent = (*it)->hTreeItem;
+    }
+    addFileToTree(vFile, hParent, darkMode, TVI_LAST);
+    ++inserted;
+}
+
+void TreePopulator::pushFrame(VFolder* folder, HTREEITEM hItem) {
+    Frame frame;
+    frame.folder = folder;
+    frame.hItem = hItem;
+
+    const VFolder& source = folder ? *folder : *root;
+    frame.children.reserve(source.fileList.size() + source.folderList.size());
+    for (const VFile& file : source.fileList) frame.children.push_back(const_cast<VFile*>(&file));
+    for (const VFolder& subFolder : source.folderList) frame.children.push_back(const_cast<VFolder*>(&subFolder));
+    std::sort(frame.children.begin(), frame.children.end(), [](const VBase* a, const VBase* b) {
+        return a->getOrder() < b->getOrder();
+    });
+
+    stack.push_back(std::move(frame));
+}
+
+bool TreePopulator::insertNext() {
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next == frame.children.size()) {
+            // Expanding an empty TreeView item has no effect, so the saved
+            // state is applied once every child is in.
+            if (frame.folder) {
+                treeControl().expand(frame.folder->hTreeItem, frame.folder->isExpanded);
+            }
+            stack.pop_back();
+            continue;
+        }
+
+        VBase* child = frame.children[frame.next++];
+        const HTREEITEM hAfter = frame.hLastInserted ? frame.hLastInserted : TVI_FIRST;
+
+        if (VFile* file = dynamic_cast<VFile*>(child)) {
+            if (!file->hTreeItem) {
+                addFileToTree(file, frame.hItem, darkMode, hAfter);
+                ++inserted;
+            }
+            frame.hLastInserted = file->hTreeItem;
+            return true;
+        }
+
+        VFolder* folder = static_cast<VFolder*>(child);
+        if (!folder->hTreeItem) {
+            insertFolderItem(folder, frame.hItem, hAfter);
+            ++inserted;
+        }
+        frame.hLastInserted = folder->hTreeItem;
+        if (insertsLazily(folder)) {
+            lazyFolderItems.insert(folder->hTreeItem);  // Children come on TVN_ITEMEXPANDING
+        }
+        else {
+            pushFrame(folder, folder->hTreeItem);   // Invalidates frame
+        }
+        return true;
+    }
+    return false;
+}
+
+void TreePopulator::stopTimer() {
+    if (hTimerWindow) {
+        KillTimer(hTimerWindow, TREEVIEW_TIMER_ID);
+    }
+}
+
+void TreePopulator::logCompletion() const {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt);
+    LOG("Tree populated: {} items in {} ms", inserted, elapsed.count());
+}
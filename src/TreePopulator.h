@@ -0,0 +1,75 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "model/VData.h"
+
+#include <windows.h>
+#include <commctrl.h>
+#include <chrono>
+#include <vector>
+
+
+// Fills the panel's TreeView from the model in time-sliced chunks, so a tree
+// with thousands of entries does not freeze Notepad++ while the panel
+// appears. start() inserts the first screen of items and the active file with
+// its parent folders right away; the rest is inserted in model order on
+// TREEVIEW_TIMER_ID ticks, which Windows only delivers when the message queue
+// is idle. Collapsed folders are inserted without their children, which are
+// created when the folder is first expanded (see materializeFolder()).
+//
+// The model must not change structurally while items are pending, since the
+// populator walks it through pointers. Anything that adds, removes or moves
+// entries calls finish() first, which inserts the remaining items at once.
+
+class TreePopulator {
+public:
+    void start(HWND hTree, HWND hTimerWindow, VFolder& root);
+    void onTimer();     // WM_TIMER with TREEVIEW_TIMER_ID
+    void finish();
+    void cancel();      // The tree is being destroyed
+
+    // Inserts a file that the stream has not reached yet, with its folders.
+    // Files inside collapsed folders are left alone.
+    void reveal(VFile* vFile);
+
+    bool active() const { return !stack.empty(); }
+
+private:
+    struct Frame {
+        VFolder* folder = nullptr;          // The root has no tree item of its own
+        HTREEITEM hItem = TVI_ROOT;
+        HTREEITEM hLastInserted = nullptr;  // Last child inserted by the stream
+        std::vector<VBase*> children;       // Direct children in order
+        size_t next = 0;
+    };
+
+    void pushFrame(VFolder* folder, HTREEITEM hItem);
+    bool insertNext();
+    void stopTimer();
+    void logCompletion() const;
+
+    HWND hTree = nullptr;
+    HWND hTimerWindow = nullptr;
+    VFolder* root = nullptr;
+    bool darkMode = false;
+    std::vector<Frame> stack;
+    size_t inserted = 0;
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+inline TreePopulator treePopulator;
@@ -0,0 +1,263 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreeRenderer.h"
+#include "Bridge/HostBridge.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+
+namespace {
+
+vector<VBase*> childrenInOrder(VFolder& folder) {
+    vector<VBase*> children;
+    children.reserve(folder.fileList.size() + folder.folderList.size());
+    for (VFile& file : folder.fileList) children.push_back(&file);
+    for (VFolder& subFolder : folder.folderList) children.push_back(&subFolder);
+    std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) {
+        return a->getOrder() < b->getOrder();
+    });
+    return children;
+}
+
+void forgetItems(VFolder& folder) {
+    for (VFile* file : folder.getAllFiles()) file->hTreeItem = nullptr;
+    for (VFolder* subFolder : folder.getAllFolders()) subFolder->hTreeItem = nullptr;
+}
+
+// Whether the last render was filtered, so the next one without a filter
+// restores the expansion the filter overrode.
+bool renderedFiltered = false;
+
+class Renderer {
+public:
+    Renderer(TreeControl& tree, bool darkMode, const FuzzyFilter* filter, bool restoreExpansion)
+        : tree(tree), darkMode(darkMode), filter(filter), restoreExpansion(restoreExpansion),
+          insertedBefore(insertedTreeItems), deletedBefore(deletedTreeItems) {}
+
+    void reconcile(HTREEITEM parent, VFolder& folder);
+    void finish() {
+        if (redrawSuspended) tree.setRedraw(true);
+        stats.inserted = insertedTreeItems - insertedBefore;
+        stats.deleted = deletedTreeItems - deletedBefore;
+    }
+
+    TreeRenderStats stats;
+
+private:
+    void update(VBase* entry, const TreeItemSpec& desired);
+    void reconcileFolder(VFolder& folder);
+    void beginChange() {
+        if (!redrawSuspended) {
+            tree.setRedraw(false);
+            redrawSuspended = true;
+        }
+    }
+
+    TreeControl& tree;
+    const bool darkMode;
+    const FuzzyFilter* filter;      // nullptr renders every entry
+    const bool restoreExpansion;
+    const size_t insertedBefore;
+    const size_t deletedBefore;
+    bool redrawSuspended = false;
+};
+
+void Renderer::reconcile(HTREEITEM parent, VFolder& folder) {
+    vector<VBase*> desired = childrenInOrder(folder);
+    vector<VBase*> hidden;
+    if (filter) {
+        const auto firstHidden = std::stable_partition(desired.begin(), desired.end(),
+            [this](const VBase* entry) { return filter->shows(entry); });
+        hidden.assign(firstHidden, desired.end());
+        desired.erase(firstHidden, desired.end());
+    }
+    const vector<HTREEITEM> current = tree.childrenOf(parent);
+
+    std::unordered_map<HTREEITEM, size_t> positionOf;
+    positionOf.reserve(current.size());
+    for (size_t i = 0; i < current.size(); ++i) {
+        positionOf[current[i]] = i;
+    }
+
+    // Entries whose item is already a child of this parent keep it, in
+    // whatever order; items of entries that left are deleted.
+    vector<bool> keepEntry(desired.size()), keepItem(current.size());
+    bool inOrder = true;
+    size_t lastPosition = 0;
+    for (size_t i = 0; i < desired.size(); ++i) {
+        const auto found = desired[i]->hTreeItem ? positionOf.find(desired[i]->hTreeItem) : positionOf.end();
+        if (found == positionOf.end()) {
+            continue;
+        }
+        keepEntry[i] = true;
+        keepItem[found->second] = true;
+        if (found->second < lastPosition) {
+            inOrder = false;
+        }
+        lastPosition = found->second;
+    }
+
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (!keepItem[i]) {
+            beginChange();
+            tree.deleteItem(current[i]);
+        }
+    }
+    for (VBase* entry : hidden) {
+        entry->hTreeItem = nullptr;
+        if (VFolder* subFolder = dynamic_cast<VFolder*>(entry)) {
+            forgetItems(*subFolder);
+        }
+    }
+
+    // Sorting by lParam moves kept items, and the subtrees under them, into
+    // place without recreating them.
+    for (size_t i = 0; i < desired.size(); ++i) {
+        if (!keepEntry[i]) {
+            continue;
+        }
+        VFolder* subFolder = dynamic_cast<VFolder*>(desired[i]);
+        update(desired[i], subFolder ? folderItemSpec(subFolder) : fileItemSpec(static_cast<VFile*>(desired[i]), darkMode));
+    }
+    if (!inOrder) {
+        beginChange();
+        tree.sortChildren(parent);
+        stats.sorted++;
+    }
+
+    HTREEITEM prevItem = TVI_FIRST;
+    for (size_t i = 0; i < desired.size(); ++i) {
+        VBase* entry = desired[i];
+        VFolder* subFolder = dynamic_cast<VFolder*>(entry);
+
+        if (keepEntry[i]) {
+            stats.kept++;
+            if (subFolder) {
+                reconcileFolder(*subFolder);
+            }
+            prevItem = entry->hTreeItem;
+            continue;
+        }
+
+        beginChange();
+        if (entry->hTreeItem) {
+            stats.recreated++;
+        }
+        if (subFolder && filter) {
+            // Filtered folders get only their shown children, expanded.
+            prevItem = insertFolderItem(subFolder, parent, prevItem);
+            reconcile(subFolder->hTreeItem, *subFolder);
+            tree.expand(subFolder->hTreeItem, true);
+        }
+        else if (subFolder) {
+            prevItem = addFolderToTree(subFolder, parent, prevItem);
+        }
+        else {
+            prevItem = addFileToTree(static_cast<VFile*>(entry), parent, darkMode, prevItem);
+        }
+    }
+}
+
+void Renderer::reconcileFolder(VFolder& folder) {
+    const bool lazy = lazyFolderItems.contains(folder.hTreeItem);
+    if (filter) {
+        if (lazy) {
+            forgetItems(folder);
+            lazyFolderItems.erase(folder.hTreeItem);
+        }
+        reconcile(folder.hTreeItem, folder);
+        beginChange();
+        tree.expand(folder.hTreeItem, true);
+        return;
+    }
+
+    if (lazy) {
+        forgetItems(folder);    // Entries moved in keep a stale item
+        return;
+    }
+    reconcile(folder.hTreeItem, folder);
+    if (restoreExpansion) {
+        beginChange();
+        tree.expand(folder.hTreeItem, folder.isExpanded);
+    }
+}
+
+void Renderer::update(VBase* entry, const TreeItemSpec& desired) {
+    TreeItemSpec current;
+    if (!tree.getItem(entry->hTreeItem, current)) {
+        return;
+    }
+
+    // File icons also depend on the buffer's save state, which the model does
+    // not carry; changeTreeItemIcon() keeps them up to date.
+    TreeItemChange change;
+    if (current.text != desired.text) change.text = desired.text;
+    if (current.param != desired.param) change.param = desired.param;
+
+    if (change.text || change.param) {
+        beginChange();
+        tree.setItem(entry->hTreeItem, change);
+        stats.updated++;
+    }
+}
+
+} // namespace
+
+
+TreeRenderStats renderTree(VFolder& root) {
+    treeFilter.refresh(root);
+    const bool filtered = treeFilter.active();
+    Renderer renderer(treeControl(), hostBridge().isDarkModeEnabled(),
+        filtered ? &treeFilter : nullptr, renderedFiltered && !filtered);
+    renderedFiltered = filtered;
+
+    renderer.reconcile(TVI_ROOT, root);
+    renderer.finish();
+    return renderer.stats;
+}
+
+TreeRenderStats filterTree(VFolder& root, const string& query) {
+    treeFilter.setQuery(root, query);
+    const TreeRenderStats stats = renderTree(root);
+
+    if (VFile* best = treeFilter.bestMatch(); best && best->hTreeItem) {
+        treeControl().selectItem(best->hTreeItem);
+        treeControl().ensureVisible(best->hTreeItem);
+    }
+    return stats;
+}
+
+ScopedTreeRender::~ScopedTreeRender() {
+    if (--deferredTreeRenders > 0) {
+        return;
+    }
+    // Destructors must not throw. Each render diffs the whole tree, so the
+    // next one repairs whatever a failed one left behind.
+    try {
+        renderTree(root_);
+    }
+    catch (const std::exception& e) {
+        const std::string message = std::string("VirtualFolders tree render error: ") + e.what() + "\n";
+#ifdef _WIN32
+        OutputDebugStringA(message.c_str());
+#else
+        std::fputs(message.c_str(), stderr);
+#endif
+    }
+}
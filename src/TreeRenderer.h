@@ -0,0 +1,69 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "model/VData.h"
+#include "model/FuzzyFilter.h"
+#include "TreeItems.h"
+
+
+// Brings the tree in line with the model by diffing the two instead of
+// rebuilding it. Structural edits change the model only and leave the tree to
+// a ScopedTreeRender.
+//
+// Entries are matched to items by the hTreeItem they carry, which survives
+// fileCopy/folderCopy. Under each parent, items whose entry is still a child
+// are kept and only get a new text or lParam where it differs; if they are
+// out of order the parent's children are sorted by lParam, which moves them
+// with their subtrees. The rest are deleted or inserted. A TreeView item
+// cannot change parent, so an entry moved into another folder is recreated
+// there: its old item goes with every item under it, and the new one gets
+// the items of its expanded folders again. A collapsed folder comes back as a
+// single lazy item, and an entry moved into a lazy folder is just dropped.
+//
+// While treeFilter is active only the entries it shows are rendered, and
+// their folders are expanded without touching VFolder::isExpanded. Hidden
+// entries lose their hTreeItem. The first render without a filter puts the
+// saved expansion back.
+
+struct TreeRenderStats {
+    size_t kept = 0;
+    size_t inserted = 0;    // Items, children of inserted folders included
+    size_t deleted = 0;     // Items, children of deleted items included
+    size_t updated = 0;
+    size_t sorted = 0;      // Parents whose children were reordered
+    size_t recreated = 0;   // Entries that had an item under another parent
+};
+
+// Narrowed by the panel's filter box.
+inline FuzzyFilter treeFilter;
+
+TreeRenderStats renderTree(VFolder& root);
+TreeRenderStats filterTree(VFolder& root, const string& query);  // Selects the best match
+
+// Defers lParam updates while the model is edited and renders on exit.
+class ScopedTreeRender final {
+public:
+    explicit ScopedTreeRender(VFolder& root) : root_(root) { ++deferredTreeRenders; }
+    ~ScopedTreeRender();
+
+    ScopedTreeRender(const ScopedTreeRender&) = delete;
+    ScopedTreeRender& operator=(const ScopedTreeRender&) = delete;
+
+private:
+    VFolder& root_;
+};
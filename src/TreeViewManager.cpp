@@ -15,10 +15,20 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "TreeViewManager.h"
+#include "TreePopulator.h"
+#include "TreeRenderer.h"
+#include "TreePalette.h"
+#include "BufferHandlers.h"
 #include "CommonData.h"
 #include "resource.h"
 #include "Shlwapi.h"
 #include "RenameDialog.h"
+#include "SearchDialog.h"
+#include "Services/TaskScheduler.h"
+#include "Services/FileStatService.h"
+#include "model/TreeJournal.h"
+#include "model/BufferStates.h"
+#include "model/FileTable.h"
 
 #include <fstream>
 #include <iostream>
@@ -63,7 +73,6 @@ HMENU folderContextMenu = nullptr;
 
 
 
-std::unordered_map<IconType, int> iconIndex;
 
 DialogStretch stretch;
 
@@ -145,7 +154,9 @@ void treeItemSelected(HTREEITEM selectedTreeItem);
 void moveFileIntoFolder(int dragOrder, int targetOrder);
 bool moveFolderIntoFolder(int dragOrder, int targetOrder);
 void unwrapFolder(HTREEITEM selectedTreeItem);
+void saveEditedFiles(const VFolder& folder);
 void wrapFileInFolder(HTREEITEM selectedTreeItem);
+void undoTreeChange(bool redo);
 
 
 namespace {
@@ -168,6 +179,17 @@ private:
     bool previousValue_;
 };
 
+// Narrows the tree to what the filter box matches. Runs on every keystroke,
+// so it must not activate the best match it selects.
+void applyTreeFilter(HWND hEdit) {
+    const int length = GetWindowTextLengthW(hEdit);
+    wstring text(length, L'\0');
+    GetWindowTextW(hEdit, text.data(), length + 1);
+
+    ScopedSelectionChangeIgnore guard(ignoreSelectionChange);
+    filterTree(commonData.rootVFolder, hostPathToUtf8(text));
+}
+
 bool isInvalidFolderMoveTarget(VFolder* movedFolder, int targetOrder) {
     return movedFolder &&
         (movedFolder->getOrder() == targetOrder ||
@@ -192,22 +214,13 @@ extern HWND virtualPanelWnd;
 
 
 // TreeView management functions
-void updateTreeItemLParam(VBase* vBase) {
-    if (vBase->hTreeItem) {
-        TVITEM tvi = { 0 };
-        tvi.mask = TVIF_PARAM;
-        tvi.hItem = (vBase->hTreeItem);
-        tvi.lParam = vBase->order;
-        TreeView_SetItem(commonData.hTree, &tvi);
-    }
-}
-
+// The order of the entry the dropped one goes before, as its sibling.
 int calculateNewOrder(int targetOrder, const InsertionMark& mark) {
     if (mark.above) {
         return targetOrder;  // Insert at target position
     }
     else {
-        return targetOrder + 1;  // Insert after target
+        return commonData.rootVFolder.orderAbove(targetOrder);  // Insert after target
     }
 }
 
@@ -244,6 +257,9 @@ void loadMenus() {
     std::wstring fontDecreaseLabel = commonData.translator->getTextW("IDM_FONT_DECREASE") + std::to_wstring(commonData.fontSize) + L" px";
     AppendMenu(fontSizeSubMenu, MF_STRING, MENU_ID_DECREASEFONT, fontDecreaseLabel.c_str());
     AppendMenu(hContextMenu, MF_POPUP, (UINT_PTR)fontSizeSubMenu, L"Font Size");
+    AppendMenu(hContextMenu, MF_SEPARATOR, 0, NULL);
+    AppendMenu(hContextMenu, MF_STRING, MENU_ID_TREE_UNDO, commonData.translator->getTextW("MENU_ID_TREE_UNDO").c_str());
+    AppendMenu(hContextMenu, MF_STRING, MENU_ID_TREE_REDO, commonData.translator->getTextW("MENU_ID_TREE_REDO").c_str());
 
 
     if (fileContextMenu) {
@@ -307,6 +323,9 @@ void loadMenus() {
     folderContextMenu = CreatePopupMenu();
     AppendMenu(folderContextMenu, MF_STRING, MENU_ID_FOLDER_UNWRAP, commonData.translator->getTextW("MENU_ID_FOLDER_UNWRAP").c_str());
     AppendMenu(folderContextMenu, MF_STRING, MENU_ID_FOLDER_RENAME, commonData.translator->getTextW("MENU_ID_FOLDER_RENAME").c_str());
+    AppendMenu(folderContextMenu, MF_SEPARATOR, 0, NULL);
+    AppendMenu(folderContextMenu, MF_STRING, MENU_ID_FOLDER_FIND, commonData.translator->getTextW("MENU_ID_FOLDER_FIND").c_str());
+    AppendMenu(folderContextMenu, MF_STRING, MENU_ID_FOLDER_SAVE_EDITED, commonData.translator->getTextW("MENU_ID_FOLDER_SAVE_EDITED").c_str());
 
 
 
@@ -378,16 +397,46 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
 
     try {
 
+        // Tree commands work on the whole tree and may restructure the model.
+        if (treePopulator.active()) {
+            const UINT code = uMsg == WM_NOTIFY ? reinterpret_cast<LPNMHDR>(lParam)->code : 0;
+            if (uMsg == WM_COMMAND || uMsg == WM_CONTEXTMENU
+                || code == TVN_BEGINDRAG || code == TVN_BEGINLABELEDIT || code == TVN_KEYDOWN) {
+                treePopulator.finish();
+            }
+        }
+
         switch (uMsg) {
         case WM_TIMER:
-
+            if (wParam == TREEVIEW_TIMER_ID) {
+                treePopulator.onTimer();
+            }
+            else if (wParam == NOTIFICATION_FLUSH_TIMER_ID && processQueuedNotifications()) {
+                KillTimer(hwndDlg, NOTIFICATION_FLUSH_TIMER_ID);
+            }
             break;
+        case WM_VF_FLUSH_NOTIFICATIONS:
+            if (!processQueuedNotifications()) {
+                SetTimer(hwndDlg, NOTIFICATION_FLUSH_TIMER_ID, 10, nullptr);
+            }
+            return TRUE;
+        case WM_VF_TASK_COMPLETIONS:
+            taskScheduler.runCompletions();
+            return TRUE;
         case WM_DESTROY:
+            treePopulator.cancel();
+            treePalette.release();
+            // Nothing will be posted here anymore; apply what is still queued.
+            processQueuedNotifications();
+            taskScheduler.setUiWaker(nullptr);
+            taskScheduler.runCompletions();
             KillTimer(hwndDlg, 1); // clean up timer
+            KillTimer(hwndDlg, NOTIFICATION_FLUSH_TIMER_ID);
             break;
         case WM_INITDIALOG: {
             stretch.setup(hwndDlg);
             hTree = GetDlgItem(hwndDlg, IDC_TREE1);
+            taskScheduler.setUiWaker([hwndDlg]() { PostMessage(hwndDlg, WM_VF_TASK_COMPLETIONS, 0, 0); });
 
             oldTreeProc = (WNDPROC)SetWindowLongPtr(hTree, GWLP_WNDPROC, (LONG_PTR)TreeView_SubclassProc);
             SetWindowTheme(hTree, L"", L"");
@@ -402,6 +451,8 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
 
 
             loadMenus();
+            SendDlgItemMessageW(hwndDlg, IDC_FILTER_EDIT, EM_SETCUEBANNER, TRUE,
+                reinterpret_cast<LPARAM>(commonData.translator->getTextW("FILTER_CUE").c_str()));
 
 
 
@@ -468,10 +519,9 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                     }
 
 
-                    COLORREF editorBg = (COLORREF)::SendMessage(plugin.currentScintilla(), SCI_STYLEGETBACK, STYLE_DEFAULT, 0);
-                    COLORREF editorFg = (COLORREF)::SendMessage(plugin.currentScintilla(), SCI_STYLEGETFORE, STYLE_DEFAULT, 0);
-                    TreeView_SetBkColor(hTree, editorBg);
-                    TreeView_SetTextColor(hTree, editorFg);
+                    const TreePalette& palette = treePalette.get();
+                    TreeView_SetBkColor(hTree, palette.background);
+                    TreeView_SetTextColor(hTree, palette.text);
                     //TreeView_SetLineColor(hTree, 0x99FF0000);
 
 
@@ -480,6 +530,37 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                     treeItemSelected(selectedTreeItem);
                     return TRUE;
                 }
+                case TVN_GETDISPINFO: {
+                    LPNMTVDISPINFO dispInfo = (LPNMTVDISPINFO)lParam;
+                    if (dispInfo->item.mask & TVIF_CHILDREN) {
+                        optional<VFolder*> vFolderOpt = commonData.rootVFolder.findFolderByOrder((int)dispInfo->item.lParam);
+                        dispInfo->item.cChildren = vFolderOpt
+                            && (!vFolderOpt.value()->fileList.empty() || !vFolderOpt.value()->folderList.empty()) ? 1 : 0;
+                    }
+                    return TRUE;
+                }
+                case TVN_ITEMEXPANDING: {
+                    if ((pnmtv->action & TVE_EXPAND) && lazyFolderItems.contains(pnmtv->itemNew.hItem)) {
+                        optional<VFolder*> vFolderOpt = commonData.rootVFolder.findFolderByOrder((int)pnmtv->itemNew.lParam);
+                        if (vFolderOpt) {
+                            materializeFolder(vFolderOpt.value());
+                        }
+                    }
+                    return FALSE;  // Allow the expansion
+                }
+                case TVN_DELETEITEM:
+                    treeItemDeleted(pnmtv->itemOld.hItem);
+                    return TRUE;
+                case TVN_KEYDOWN: {
+                    // Ctrl+Z and Ctrl+Y (or Ctrl+Shift+Z) step through treeJournal.
+                    const WORD key = reinterpret_cast<LPNMTVKEYDOWN>(lParam)->wVKey;
+                    if (GetKeyState(VK_CONTROL) < 0 && (key == 'Z' || key == 'Y')) {
+                        undoTreeChange(key == 'Y' || GetKeyState(VK_SHIFT) < 0);
+                        SetWindowLongPtr(hwndDlg, DWLP_MSGRESULT, TRUE);  // Not part of an incremental search
+                        return TRUE;
+                    }
+                    break;
+                }
                 case TVN_BEGINDRAG: {
                     std::cout << "TVN_BEGINDRAG" << std::endl;
                     hDragItem = pnmtv->itemNew.hItem;
@@ -546,7 +627,7 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                                         EnableMenuItem(fileContextMenu, IDM_FILE_PRINT, MF_BYCOMMAND | MF_DISABLED);
                                     }
 
-                                    CheckMenuItem(fileContextMenu, IDM_EDIT_TOGGLEREADONLY, MF_BYCOMMAND | (vFile->isReadOnly ? MF_CHECKED : MF_UNCHECKED));
+                                    CheckMenuItem(fileContextMenu, IDM_EDIT_TOGGLEREADONLY, MF_BYCOMMAND | (vFile->readOnly() ? MF_CHECKED : MF_UNCHECKED));
                                 }
                                 TrackPopupMenu(fileContextMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwndDlg, NULL);
                             }
@@ -558,26 +639,19 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 }
                 case NM_CUSTOMDRAW: {
                     LPNMTVCUSTOMDRAW tvcd = (LPNMTVCUSTOMDRAW)lParam;
-                    static int hoverItemIndex = 0;
+                    // Rows span the client width, which is read once per frame.
+                    static RECT client;
 
                     switch (tvcd->nmcd.dwDrawStage) {
                     case CDDS_PREPAINT:
+                        GetClientRect(hTree, &client);
                         return CDRF_NOTIFYITEMDRAW;
 
                     case CDDS_ITEMPREPAINT: {
                         HTREEITEM hItem = (HTREEITEM)tvcd->nmcd.dwItemSpec;
-                        COLORREF editorFg = (COLORREF)::SendMessage(plugin.currentScintilla(), SCI_STYLEGETFORE, STYLE_DEFAULT, 0);
-                        COLORREF editorBg = (COLORREF)::SendMessage(plugin.currentScintilla(), SCI_STYLEGETBACK, STYLE_DEFAULT, 0);
-
-                        //LOG("EditorBg: [{}]", editorBg);
-
-                        COLORREF highlightBg = RGB(200, 220, 255);
-
+                        const TreePalette& palette = treePalette.get();
 
-                        RECT client;
-                        GetClientRect(hTree, &client);
-                        RECT rc;
-                        TreeView_GetItemRect(hTree, hItem, &rc, FALSE);
+                        RECT rc = tvcd->nmcd.rc;
                         rc.left = client.left;
                         rc.right = client.right;
 
@@ -585,23 +659,21 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
 
 
                         if (tvcd->nmcd.uItemState & CDIS_SELECTED) {
-                            hBrush = CreateSolidBrush(RGB(152, 178, 227));
-                            tvcd->clrText = RGB(255, 255, 255);
-                            tvcd->clrTextBk = RGB(152, 178, 227);
+                            hBrush = palette.selectedBrush;
+                            tvcd->clrText = palette.selectedText;
+                            tvcd->clrTextBk = palette.selectedBackground;
                         }
                         else if (hItem == hHoveredItem) {
-                            hBrush = CreateSolidBrush(highlightBg);
-                            tvcd->clrText = editorFg;
-                            tvcd->clrTextBk = highlightBg;
+                            hBrush = palette.hoverBrush;
+                            tvcd->clrText = palette.text;
+                            tvcd->clrTextBk = palette.hoverBackground;
                         }
                         else {
-                            hBrush = CreateSolidBrush(editorBg);
-                            tvcd->clrText = editorFg;
-                            tvcd->clrTextBk = editorBg;
+                            hBrush = palette.backgroundBrush;
+                            tvcd->clrText = palette.text;
+                            tvcd->clrTextBk = palette.background;
                         }
-                        ++hoverItemIndex;
                         FillRect(tvcd->nmcd.hdc, &rc, hBrush);
-                        DeleteObject(hBrush);
 
                         SetBkMode(tvcd->nmcd.hdc, TRANSPARENT);
 
@@ -619,6 +691,9 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 TVITEM item = { 0 };
                 item.mask = TVIF_PARAM;
                 item.hItem = hItem;
+                if (treeFilter.active()) {
+                    return TRUE;  // The filter expands folders; the saved state is put back after it
+                }
                 if (TreeView_GetItem(hTree, &item)) {
                     optional<VFolder*> vFolderOpt = commonData.rootVFolder.findFolderByOrder((int)item.lParam);
                     if (vFolderOpt) {
@@ -666,6 +741,8 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 std::wstring fontDecreaseLabel = commonData.translator->getTextW("IDM_FONT_DECREASE") + std::to_wstring(commonData.fontSize) + L" px";
                 ModifyMenuW(fontSizeSubMenu, 1, MF_BYPOSITION | MF_STRING, MENU_ID_DECREASEFONT, (LPCWSTR)(fontDecreaseLabel.c_str()));
 
+                EnableMenuItem(hContextMenu, MENU_ID_TREE_UNDO, MF_BYCOMMAND | (treeJournal.canUndo() ? MF_ENABLED : MF_DISABLED));
+                EnableMenuItem(hContextMenu, MENU_ID_TREE_REDO, MF_BYCOMMAND | (treeJournal.canRedo() ? MF_ENABLED : MF_DISABLED));
 
                 // Show context menu
                 TrackPopupMenu(hContextMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwndDlg, NULL);
@@ -674,6 +751,30 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
             break;
         }
         case WM_COMMAND: {
+            if (LOWORD(wParam) == IDC_FILTER_EDIT) {
+                if (HIWORD(wParam) == EN_CHANGE) {
+                    applyTreeFilter(reinterpret_cast<HWND>(lParam));
+                }
+                else if (HIWORD(wParam) == EN_SETFOCUS && !treeFilter.active()) {
+                    treeFilter.setQuery(commonData.rootVFolder, "");  // Builds the candidates before the first keystroke
+                }
+                return TRUE;
+            }
+            // Enter in the filter box opens the selected match, Escape clears it.
+            if (HWND hFilter = GetDlgItem(hwndDlg, IDC_FILTER_EDIT); hFilter && GetFocus() == hFilter) {
+                if (LOWORD(wParam) == IDOK && TreeView_GetSelection(hTree)) {
+                    treeItemSelected(TreeView_GetSelection(hTree));
+                    return TRUE;
+                }
+                if (LOWORD(wParam) == IDCANCEL) {
+                    SetWindowTextW(hFilter, L"");
+                    return TRUE;
+                }
+            }
+            if (LOWORD(wParam) == MENU_ID_TREE_UNDO || LOWORD(wParam) == MENU_ID_TREE_REDO) {
+                undoTreeChange(LOWORD(wParam) == MENU_ID_TREE_REDO);
+                return TRUE;
+            }
             HTREEITEM selectedTreeItem = TreeView_GetSelection(hTree);
             if (!selectedTreeItem) {
                 break;
@@ -687,14 +788,14 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 break;
             }
             else if (LOWORD(wParam) == MENU_ID_TREE_DELETE) {
-                //TreeView_DeleteItem(hTree, selectedTreeItem);
+                //treeControl().deleteItem(selectedTreeItem);
                 return TRUE;
             }
             else if (LOWORD(wParam) == MENU_ID_FILE_CLOSE) {
                 TVITEM item = getTreeItem(hTree, selectedTreeItem);
                 optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByOrder((int)item.lParam);
                 if (vFileOpt) {
-                    npp(NPPM_MENUCOMMAND, vFileOpt.value()->bufferID, IDM_FILE_CLOSE);
+                    hostBridge().runMenuCommand(IDM_FILE_CLOSE);
                 }
                 return TRUE;
             }
@@ -714,6 +815,22 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 showRenameDialog(vFolder, selectedTreeItem, hTree);
                 return TRUE;
             }
+            else if (LOWORD(wParam) == MENU_ID_FOLDER_FIND) {
+                TVITEM tvItem = getTreeItem(hTree, selectedTreeItem);
+                optional<VFolder*> vFolderOpt = commonData.rootVFolder.findFolderByOrder((int)tvItem.lParam);
+                if (vFolderOpt) {
+                    showFolderSearchDialog(*vFolderOpt.value());
+                }
+                return TRUE;
+            }
+            else if (LOWORD(wParam) == MENU_ID_FOLDER_SAVE_EDITED) {
+                TVITEM tvItem = getTreeItem(hTree, selectedTreeItem);
+                optional<VFolder*> vFolderOpt = commonData.rootVFolder.findFolderByOrder((int)tvItem.lParam);
+                if (vFolderOpt) {
+                    saveEditedFiles(*vFolderOpt.value());
+                }
+                return TRUE;
+            }
             else if (LOWORD(wParam) == IDM_FILE_RENAME)
             {
                 nppMenuCall(selectedTreeItem, IDM_FILE_RENAME);
@@ -758,6 +875,11 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
             }
             else if (LOWORD(wParam) == IDM_FILE_RELOAD)
             {
+                // Reloading is for a file that changed on disk; it may be gone.
+                const TVITEM item = getTreeItem(commonData.hTree, selectedTreeItem);
+                if (optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByOrder((int)item.lParam)) {
+                    fileStatService.invalidatePath(vFileOpt.value()->path.str());
+                }
                 nppMenuCall(selectedTreeItem, IDM_FILE_RELOAD);
                 return TRUE;
             }
@@ -772,14 +894,14 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 if (result) {
                     TVITEM item = getTreeItem(hTree, selectedTreeItem);
                     optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByOrder((int)item.lParam);
-                    vFileOpt.value()->isReadOnly = !vFileOpt.value()->isReadOnly;
-                    changeTreeItemIcon(vFileOpt.value()->bufferID, vFileOpt.value()->view);
-
-
-                    vFileOpt = commonData.rootVFolder.findFileByBufferID(vFileOpt.value()->bufferID, vFileOpt.value()->view == 0 ? 1 : 0); // If this bufferID exist in the other view
-                    if (vFileOpt) {
-                        vFileOpt.value()->isReadOnly = !vFileOpt.value()->isReadOnly;
-                        changeTreeItemIcon(vFileOpt.value()->bufferID, vFileOpt.value()->view);
+                    VFile* vFile = vFileOpt.value();
+                    vFile->setReadOnly(!vFile->readOnly());    // Both views read the buffer's record
+                    changeTreeItemIcon(vFile->bufferID, vFile->view);
+
+                    const int otherView = vFile->view == 0 ? 1 : 0;
+                    const BufferState* state = bufferStates.find(vFile->bufferID);
+                    if (state && state->showsView(otherView)) {
+                        changeTreeItemIcon(vFile->bufferID, otherView);
                     }
                 }
                 return TRUE;
@@ -807,11 +929,11 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                     return false;
                 }
 
-                auto position = npp(NPPM_GETPOSFROMBUFFERID, vFileOpt.value()->bufferID, vFileOpt.value()->view);
+                auto position = hostBridge().positionOfBuffer(vFileOpt.value()->bufferID, vFileOpt.value()->view);
                 //int docView = (position >> 30) & 0x3;   // 0 = MAIN_VIEW, 1 = SUB_VIEW
                 int docIndex = position & 0x3FFFFFFF;    // 0-based index
 
-                npp(NPPM_ACTIVATEDOC, vFileOpt.value()->view, docIndex);
+                hostBridge().activateDocument(vFileOpt.value()->view, docIndex);
 
                 nppMenuCall(selectedTreeItem, IDM_VIEW_GOTO_ANOTHER_VIEW);
                 return TRUE;
@@ -826,16 +948,7 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
         case WM_SIZE: {
             // When the dialog is resized, resize the tree control to fill it
             if (hTree) {
-                RECT rcClient;
-                GetClientRect(hwndDlg, &rcClient);
-                SetWindowPos(hTree, nullptr, 0, 0,
-                    rcClient.right - rcClient.left,
-                    rcClient.bottom - rcClient.top,
-                    SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-
-                // Force the tree control to update its scrollbars
-                InvalidateRect(hTree, nullptr, TRUE);
-                UpdateWindow(hTree);
+                layoutFileView(hwndDlg);
             }
             return TRUE;
         }
@@ -1040,8 +1153,9 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                 // Clear drop target selection and restore normal selection
                 TreeView_SelectDropTarget(hTree, nullptr);
 
-                // current rootFolder to base64 before move
-                VFolder oldRoot = commonData.rootVFolder;
+                // current rootFolder to base64 before move; only copied if the tree turns out corrupt
+                commonData.rootVFolder.vFolderSort();
+                const auto oldRoot = modelSnapshots.publish(commonData.rootVFolder);
                 int oldOrder = -1, newOrder = -1;
 
                 if (hDragItem && hDropTarget && hDragItem != hDropTarget) {
@@ -1104,12 +1218,16 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
                     }
                     commonData.rootVFolder.vFolderSort();
 
-                    VFolder newRoot = commonData.rootVFolder;
+                    const auto newRoot = modelSnapshots.publish(commonData.rootVFolder);
                     if (checkRootVFolderJSON()) {
                         checkRootVFolderJSON();
                         LOG("Root is corrupted!!!!!!!!!!!!");
-                        showCorruptionDialog(oldRoot, newRoot, oldOrder, newOrder);
+                        showCorruptionDialog(oldRoot->toVFolder(), newRoot->toVFolder(), oldOrder, newOrder);
                         fixRootVFolderJSON();
+                        treeJournal.clear();  // The fixed model is not what the journal recorded
+                    }
+                    else {
+                        treeJournal.record(oldRoot, newRoot);
                     }
 
 
@@ -1184,8 +1302,40 @@ LRESULT nppMenuCall(HTREEITEM selectedTreeItem, int MENU_ID)
     if (vFileOpt.value()->bufferID == -1) {
         return false;
 	}
-    return npp(NPPM_MENUCOMMAND, vFileOpt.value()->bufferID, MENU_ID);
+    hostBridge().runMenuCommand(MENU_ID);
+    return TRUE;
+
+}
 
+// Saves every buffer below the folder that has unsaved changes, a cloned one
+// once, then goes back to the document that was active.
+void saveEditedFiles(const VFolder& folder)
+{
+    // Saving can rename the entries, so take the buffers first.
+    vector<UINT_PTR> bufferIDs;
+    for (const VFile* vFile : fileTable.select(commonData.rootVFolder, FileTable::Unsaved, 0, &folder)) {
+        if (vFile->bufferID != 0 && std::find(bufferIDs.begin(), bufferIDs.end(), vFile->bufferID) == bufferIDs.end()) {
+            bufferIDs.push_back(vFile->bufferID);
+        }
+    }
+    if (bufferIDs.empty()) {
+        return;
+    }
+
+    HostBridge& host = hostBridge();
+    const vector<VFile*> active = fileTable.select(commonData.rootVFolder, FileTable::Active);
+    const intptr_t activePosition = active.empty() ? -1 : host.positionOfBuffer(active.front()->bufferID, active.front()->view);
+    for (UINT_PTR bufferID : bufferIDs) {
+        const intptr_t position = host.positionOfBuffer(bufferID, MAIN_VIEW);
+        if (position == -1) {
+            continue;
+        }
+        host.activateDocument(positionView(position), positionIndex(position));
+        host.runMenuCommand(IDM_FILE_SAVE);
+    }
+    if (activePosition != -1) {
+        host.activateDocument(positionView(activePosition), positionIndex(activePosition));
+    }
 }
 
 void unwrapFolder(HTREEITEM selectedTreeItem)
@@ -1196,28 +1346,13 @@ void unwrapFolder(HTREEITEM selectedTreeItem)
     if (!vFolderOpt) {
         return;
     }
+    ScopedJournalEntry journalEntry(commonData.rootVFolder);
+    ScopedTreeRender render(commonData.rootVFolder);
     VFolder* vFolder = vFolderOpt.value();
 	VFolder folderCopy = *vFolder;
-    HTREEITEM folderItemToDelete = folderCopy.hTreeItem;
     VFolder* parentFolder = commonData.rootVFolder.findParentFolder(vFolder->getOrder());
 	int folderOrder = folderCopy.getOrder();
-	int lastOrder = commonData.rootVFolder.getLastOrder();
-
-    ssize_t pos = folderCopy.getOrder();
-    HTREEITEM fileTreeItem = nullptr;
-    optional<VBase*> aboveSibling = parentFolder ? parentFolder->findAboveSibling(pos) : commonData.rootVFolder.findAboveSibling(pos);
-    if (aboveSibling) {
-        fileTreeItem = aboveSibling.value()->hTreeItem;
-    }
-    else {
-        fileTreeItem = TVI_FIRST;
-    }
-
-    TreeView_DeleteItem(hTree, folderItemToDelete);
 
-    // Detach the folder before shifting later items. Otherwise, a following
-    // sibling folder temporarily receives the same order and removeFolder()
-    // removes both folders.
     if (parentFolder && parentFolder->getOrder() != -1) {
         parentFolder->removeFolder(folderOrder);
     }
@@ -1225,24 +1360,10 @@ void unwrapFolder(HTREEITEM selectedTreeItem)
         commonData.rootVFolder.removeFolder(folderOrder);
     }
 
-    adjustGlobalOrdersForFileMove(folderOrder, lastOrder + 1);
-
-
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-    folderCopy.move(-1);
     vector<VBase*> allChildren = folderCopy.getAllDirectChildren();
-    for (const auto& child : allChildren) {
-        if (!child) continue;
-        if (auto file = dynamic_cast<VFile*>(child)) {
-            fileTreeItem = addFileToTree(file, hTree, parentFolder ? parentFolder->hTreeItem : nullptr, isDarkMode, fileTreeItem);
-            pos++;
-        }
-        else if (auto folder = dynamic_cast<VFolder*>(child)) {
-            fileTreeItem = addFolderToTree(folder, hTree, parentFolder ? parentFolder->hTreeItem : nullptr, pos, fileTreeItem);
-        }
-    }
 
-    // Add the unwrapped folder's children to its former parent.
+    // Add the unwrapped folder's children to its former parent. Their orders
+    // already lie between the folder's and the next entry's, so none changes.
     if (parentFolder && parentFolder->getOrder() != -1) {
         parentFolder->addChildren(allChildren);
     }
@@ -1264,11 +1385,13 @@ void wrapFileInFolder(HTREEITEM selectedTreeItem)
         return;
     }
 
+    ScopedJournalEntry journalEntry(commonData.rootVFolder);
+    ScopedTreeRender render(commonData.rootVFolder);
     VFile* vFile = vFileOpt.value();
     VFile fileCopy = *vFile; // Create a copy of VFile*
 
     int oldOrder = vFile->getOrder();
-    int lastOrder = commonData.rootVFolder.getLastOrder();
+    int nextOrder = commonData.rootVFolder.orderAbove(oldOrder);
 
     VFolder* parentFolder = commonData.rootVFolder.findParentFolder(vFile->getOrder());
     if (parentFolder) {
@@ -1277,47 +1400,32 @@ void wrapFileInFolder(HTREEITEM selectedTreeItem)
     else {
         commonData.rootVFolder.removeFile(vFile->getOrder());
     }
-    TreeView_DeleteItem(hTree, selectedTreeItem);
-    commonData.rootVFolder.adjustOrders(oldOrder, INT_MAX, 1);
-
 
-    // Create new folder
+    // Create new folder in the file's place; only the two get new orders.
     VFolder newFolder;
     newFolder.name = commonData.translator->getText("NEW_FOLDER");
-    newFolder.setOrder(oldOrder);
+    newFolder.isExpanded = true;
+    newFolder.fileList.push_back(fileCopy);
+    commonData.rootVFolder.orderBefore(newFolder, nextOrder);
     if (parentFolder) {
         parentFolder->folderList.push_back(newFolder);
     }
     else {
         commonData.rootVFolder.folderList.push_back(newFolder);
     }
-    optional<VFolder*> newFolderOpt = commonData.rootVFolder.findFolderByOrder(oldOrder);
-
-    newFolderOpt.value()->addFile(&fileCopy);
-    newFolderOpt.value()->isExpanded = true;
-    ssize_t pos = oldOrder;
-
-    /*HTREEITEM folderTreeItem = addFolderToTree(newFolderOpt.value(), hTree, parentFolder ? parentFolder->hTreeItem : nullptr, pos, TVI_LAST);
-    TreeView_DeleteItem(hTree, folderTreeItem);*/
-    HTREEITEM folderTreeItem = nullptr;
-    pos = oldOrder;
-    optional<VBase*> aboveSiblingOpt = parentFolder ? parentFolder->findAboveSibling(oldOrder) : commonData.rootVFolder.findAboveSibling(oldOrder);
-    if (aboveSiblingOpt) {
-        folderTreeItem = addFolderToTree(
-            newFolderOpt.value(),
-            hTree,
-            parentFolder ? parentFolder->hTreeItem : nullptr,
-            pos,
-            aboveSiblingOpt.value()->hTreeItem
-        );
-    }
-    else {
-        folderTreeItem = addFolderToTree(newFolderOpt.value(), hTree, parentFolder ? parentFolder->hTreeItem : nullptr, pos, TVI_FIRST);
-    }
 
     writeJsonFile();
 }
 
+void undoTreeChange(bool redo)
+{
+    ScopedTreeRender render(commonData.rootVFolder);
+    const bool applied = redo ? treeJournal.redo(commonData.rootVFolder) : treeJournal.undo(commonData.rootVFolder);
+    if (applied) {
+        writeJsonFile();
+    }
+}
+
 void treeItemSelected(HTREEITEM selectedTreeItem)
 {
     HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
@@ -1346,10 +1454,11 @@ void treeItemSelected(HTREEITEM selectedTreeItem)
     if (selectedFileOpt && !selectedFileOpt.value()->path.empty()) {
 		VFile* selectedFile = selectedFileOpt.value();
 
+        const std::string path = selectedFile->path.str();
         std::wstring wideName(selectedFile->name.begin(), selectedFile->name.end()); // opens by name. not path. With path it opens as a new file
-        std::wstring widePath = std::wstring(selectedFile->path.begin(), selectedFile->path.end()); // opens by path.
+        std::wstring widePath = std::wstring(path.begin(), path.end()); // opens by path.
         if (selectedFile->backupFilePath.empty()) {
-            wideName = std::wstring(selectedFile->path.begin(), selectedFile->path.end()); // opens by path.
+            wideName = std::wstring(path.begin(), path.end()); // opens by path.
         }
 
         LOG("Opening file: [{}]", selectedFile->path);
@@ -1357,7 +1466,7 @@ void treeItemSelected(HTREEITEM selectedTreeItem)
         // First, try to switch to the file if it's already open
         //ignoreSelectionChange = true;
 
-        intptr_t docOrder = SendMessage(plugin.nppData._nppHandle, NPPM_GETPOSFROMBUFFERID, (WPARAM)selectedFile->bufferID, (LPARAM)selectedFile->view);
+        intptr_t docOrder = hostBridge().positionOfBuffer(selectedFile->bufferID, selectedFile->view);
         if (docOrder == -1) {
             LOG("docOrder is -1");
             // TODO: bulamadysa ne yapmali
@@ -1371,7 +1480,7 @@ void treeItemSelected(HTREEITEM selectedTreeItem)
         selectedFile->view = docView;
 
 
-        npp(NPPM_ACTIVATEDOC, selectedFile->view, docIndex);
+        hostBridge().activateDocument(selectedFile->view, docIndex);
         currentView = selectedFile->view;
 
         // move focus to the right editor
@@ -1394,10 +1503,10 @@ void checkReadOnlyStatus(VFile* selectedFile) {
     if (!selectedFile->backupFilePath.empty()) return;
 
     if (selectedFile->view == 0) {
-        selectedFile->isReadOnly = SendMessage(plugin.nppData._scintillaMainHandle, SCI_GETREADONLY, 0, 0);
+        selectedFile->setReadOnly(SendMessage(plugin.nppData._scintillaMainHandle, SCI_GETREADONLY, 0, 0));
     }
     else {
-        selectedFile->isReadOnly = SendMessage(plugin.nppData._scintillaSecondHandle, SCI_GETREADONLY, 0, 0);
+        selectedFile->setReadOnly(SendMessage(plugin.nppData._scintillaSecondHandle, SCI_GETREADONLY, 0, 0));
     }
 
     changeTreeItemIcon(selectedFile->bufferID, selectedFile->view);
@@ -1410,15 +1519,7 @@ void moveFileIntoFolder(int dragOrder, int targetOrder) {
     VFolder* folder = targetFolderOpt.value();
     VFolder* parentFolder = commonData.rootVFolder.findParentFolder(file->getOrder());
     VFile fileCopy = *file; // Create a copy of VFile*
-
-
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-
-    // Remove dragged item from tree
-    TreeView_DeleteItem(hTree, hDragItem);
-    // Add dragged item as child of target folder in tree
-    addFileToTree(&fileCopy, hTree, hDropTarget, npp(NPPM_ISDARKMODEENABLED, 0, 0), TVI_LAST);
-
+    ScopedTreeRender render(commonData.rootVFolder);
 
     if (parentFolder) {
         parentFolder->removeFile(file->getOrder());
@@ -1426,19 +1527,14 @@ void moveFileIntoFolder(int dragOrder, int targetOrder) {
     else {
         commonData.rootVFolder.removeFile(file->getOrder());
     }
-    commonData.rootVFolder.adjustOrders(fileCopy.getOrder(), INT_MAX, -1);
-    // 
-    folder->addFile(&fileCopy);
-    int tempOrder = fileCopy.getOrder();
-    commonData.rootVFolder.adjustOrders(fileCopy.getOrder(), INT_MAX, 1);
-    // Update the file's order to match the folder's order
-    file = commonData.rootVFolder.findFileByPath(fileCopy.path, fileCopy.view);
-    file->setOrder(tempOrder);
-    
+
+    // After the folder's last entry; nothing else is renumbered.
+    commonData.rootVFolder.orderBefore(fileCopy, commonData.rootVFolder.orderAbove(folder->getLastOrder()));
+    folder->fileList.push_back(fileCopy);
 
     writeJsonFile();
 
-    LOG("[{}] moved into folder [{}]'s end", file->name, folder->name);
+    LOG("[{}] moved into folder [{}]'s end", fileCopy.name, folder->name);
 }
 
 bool moveFolderIntoFolder(int dragOrder, int targetOrder) {
@@ -1457,14 +1553,11 @@ bool moveFolderIntoFolder(int dragOrder, int targetOrder) {
     }
 
 
-    int folderItemCount = movedFolder->countItemsInFolder();
-    int insertionOrder = targetFolder->getLastOrder() + 1;
-    int destinationOrder = insertionOrder;
-    if (dragOrder < insertionOrder) {
-        destinationOrder -= folderItemCount;
-    }
-    int step = destinationOrder - dragOrder;
     VFolder movedFolderCopy = *movedFolder;
+
+    // The render re-inserts the active file, which must not reopen it.
+    ScopedSelectionChangeIgnore guard(ignoreSelectionChange);
+    ScopedTreeRender render(commonData.rootVFolder);
 	
     
     optional<VFolder*> sourceParentFolder = commonData.rootVFolder.findParentFolder(dragOrder);
@@ -1477,140 +1570,51 @@ bool moveFolderIntoFolder(int dragOrder, int targetOrder) {
     targetFolderOpt = commonData.rootVFolder.findFolderByOrder(targetOrder); // removeChild operation somehow effected targetFolder
     targetFolder = targetFolderOpt.value();
 
-    adjustGlobalOrdersForFolderMove(movedFolderCopy.getOrder(), insertionOrder, folderItemCount);
-    movedFolderCopy.move(step);
+    // After the target's last entry; only the moved folder and its contents
+    // are renumbered.
+    commonData.rootVFolder.orderBefore(movedFolderCopy, commonData.rootVFolder.orderAbove(targetFolder->getLastOrder()));
     targetFolder->folderList.push_back(movedFolderCopy);
-    movedFolder = commonData.rootVFolder.findFolderByOrder(movedFolderCopy.getOrder()).value();
-    
-    ssize_t pos = movedFolder->getOrder();
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-
-    {
-        ScopedSelectionChangeIgnore guard(ignoreSelectionChange);
-        addFolderToTree(movedFolder, hTree, targetFolder->hTreeItem, pos, TVI_LAST);
-        TreeView_DeleteItem(hTree, hDragItem);
-    }
 
     return true;
 }
 
-HTREEITEM addFileToTree(VFile* vFile, HWND hTree, HTREEITEM hParent, bool darkMode, HTREEITEM hPrevItem) {
-    if (vFile->name.find("\\") != std::string::npos) {
-		LOG("Invalid file name: [{}]", vFile->name);
-    }
-
-    std::wstring displayName = toWstring(vFile->name);
-
-    TVINSERTSTRUCT tvis = { 0 };
-    tvis.hParent = hParent;
-    tvis.hInsertAfter = hPrevItem;
-    tvis.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_PARAM | TVIF_STATE;
-    tvis.item.pszText = displayName.data();
-
-    
-    
-    if (vFile->view == 1) {
-        tvis.item.stateMask = TVIS_STATEIMAGEMASK;
-        tvis.item.state = INDEXTOSTATEIMAGEMASK(ICON_FILE_SECONDARY_VIEW); // 1-based index in state image list
-    }
-
-    if (vFile->isReadOnly) {
-        if (darkMode) {
-            tvis.item.iImage = iconIndex[ICON_FILE_READONLY_DARK]; // Use read-only icon
-            tvis.item.iSelectedImage = iconIndex[ICON_FILE_READONLY_DARK]; // Use read-only icon        
-        }
-        else {
-            tvis.item.iImage = iconIndex[ICON_FILE_READONLY_LIGHT]; // Use read-only icon
-            tvis.item.iSelectedImage = iconIndex[ICON_FILE_READONLY_LIGHT]; // Use read-only icon
-        }
-    }
-	else if (vFile->isEdited) {
-        tvis.item.iImage = iconIndex[ICON_FILE_EDITED]; // Use edited icon
-        tvis.item.iSelectedImage = iconIndex[ICON_FILE_EDITED]; // Use edited icon
-    }
-    else if (darkMode){
-        tvis.item.iImage = iconIndex[ICON_FILE_DARK];
-        tvis.item.iSelectedImage = iconIndex[ICON_FILE_DARK];
-    }
-    else {
-        tvis.item.iImage = iconIndex[ICON_FILE_LIGHT]; // Use light file icon
-        tvis.item.iSelectedImage = iconIndex[ICON_FILE_LIGHT]; // Use light file icon
-    }
-	tvis.item.lParam = vFile->getOrder(); // Store the order/index directly in lparam
-
-    HTREEITEM hItem = TreeView_InsertItem(hTree, &tvis);
-	vFile->hTreeItem = hItem; // Store the HTREEITEM in the VFile for later reference
-
-    if (vFile->isActive) {
-        TreeView_SelectItem(hTree, hItem);
-        TreeView_EnsureVisible(hTree, hItem);
+bool ensureTreeItem(VBase* vBase) {
+    if (vBase->hTreeItem) {
+        return true;
     }
-
-	return hItem;
+    treePopulator.finish();  // The ancestors may still be pending
+    return vBase->hTreeItem || materializeAncestors(commonData.rootVFolder, vBase);
 }
 
-HTREEITEM addFolderToTree(VFolder* vFolder, HWND hTree, HTREEITEM hParent, ssize_t& pos, HTREEITEM prevItem) {
-    const bool shouldExpand = vFolder->isExpanded;
-    std::wstring displayName = toWstring(vFolder->name);
-
-    TVINSERTSTRUCT tvis = { 0 };
-    tvis.hParent = hParent;
-    tvis.hInsertAfter = prevItem;
-    tvis.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_PARAM;
-    tvis.item.pszText = displayName.data();
-    tvis.item.iImage = iconIndex[ICON_FOLDER]; // or idxFile
-    tvis.item.iSelectedImage = iconIndex[ICON_FOLDER]; // or idxFile
-    tvis.item.lParam = vFolder->getOrder(); // Store the order/index directly in lparam
-
-    // Free previous hTreeItem if it exists
-    if (vFolder->hTreeItem) {
-        // No explicit free needed for HTREEITEM, but we can clear it to avoid dangling references
-        vFolder->hTreeItem = nullptr;
+void layoutFileView(HWND hwndDlg) {
+    HWND hTree = GetDlgItem(hwndDlg, IDC_TREE1);
+    HWND hFilter = GetDlgItem(hwndDlg, IDC_FILTER_EDIT);
+    if (!hTree) {
+        return;
     }
 
-    HTREEITEM hFolder = TreeView_InsertItem(hTree, &tvis);
-
-    vFolder->hTreeItem = hFolder; // Store the HTREEITEM in the VFolder for later reference
-
-	prevItem = hFolder;
-
-    pos++;
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-
-    /*int lastOrder = vFolder->fileList.empty() ? 0 : vFolder->fileList.back().getOrder();
-    lastOrder = std::max(lastOrder, vFolder->folderList.empty() ? 0 : vFolder->folderList.back().getOrder());*/
-
-	int lastOrder = vFolder->getLastOrder();
-    for (pos; pos <= lastOrder; pos) {
-        optional<VFile*> vFile = vFolder->findFileByOrder(pos);
-        if (vFile) {
-            prevItem = addFileToTree(*vFile, hTree, hFolder, isDarkMode, prevItem);
-            pos++;
-        }
-        else {
-            auto vSubFolder = vFolder->findFolderByOrder(pos);
-            if (vSubFolder) {
-                prevItem = addFolderToTree(*vSubFolder, hTree, hFolder, pos, prevItem);
-            }
-            else {
-                // This should not happen, but if it does, we skip the order. 
-                pos++;
-            }
-        }
+    RECT rcClient;
+    GetClientRect(hwndDlg, &rcClient);
+    const int width = rcClient.right - rcClient.left;
+    int filterHeight = 0;
+    if (hFilter) {
+        RECT rcFilter;
+        GetWindowRect(hFilter, &rcFilter);
+        filterHeight = rcFilter.bottom - rcFilter.top;
+        SetWindowPos(hFilter, nullptr, 0, 0, width, filterHeight, SWP_NOZORDER | SWP_NOACTIVATE);
     }
+    SetWindowPos(hTree, nullptr, 0, filterHeight, width, std::max<LONG>(0, rcClient.bottom - rcClient.top - filterHeight),
+        SWP_NOZORDER | SWP_NOACTIVATE);
 
-    // Apply the saved state after inserting the children. Expanding an empty
-    // TreeView item has no effect, which made moved folders appear collapsed.
-    TreeView_Expand(hTree, hFolder, shouldExpand ? TVE_EXPAND : TVE_COLLAPSE);
-
-    
-    return vFolder->hTreeItem;
+    // Force the tree control to update its scrollbars
+    InvalidateRect(hTree, nullptr, TRUE);
+    UpdateWindow(hTree);
 }
 
 void updateTreeColors(HWND hTree) {
     if (1 == 1) return;
     // Check if dark mode is enabled
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
+    BOOL isDarkMode = hostBridge().isDarkModeEnabled();
     
     if (isDarkMode) {
         // Dark mode colors
@@ -1621,9 +1625,8 @@ void updateTreeColors(HWND hTree) {
         TreeView_SetBkColor(hTree, RGB(255, 255, 255));  // White background
         TreeView_SetTextColor(hTree, RGB(0, 0, 0));  // Black text
     }
-    vector<VFile*> allFiles = commonData.rootVFolder.getAllFiles();
-    for (VFile* file : allFiles) {
-        changeTreeItemIcon(file->bufferID, file->view);
+    for (VFile* file : commonData.rootVFolder.getAllFiles()) {
+        applyFileIcon(file, fileIconOf(file, isDarkMode));
     }
 }
 
@@ -1675,172 +1678,37 @@ HTREEITEM FindItemByLParam(HWND hTree, HTREEITEM hParent, LPARAM lParam) {
     return nullptr;
 }
 
+// newOrder is the order of the entry the moved one goes before, as that
+// entry's sibling, or endOrder for the end of the root. Only the moved entry
+// gets new orders.
 void reorderItems(int oldOrder, int newOrder) {
     // Find the file to move (could be in root or any folder)
     FileLocation sourceLocation = findFileLocation(oldOrder);
-    if (!sourceLocation.found || !sourceLocation.file) {
-        return; // File not found
+    if (!sourceLocation.found || !sourceLocation.file || newOrder == oldOrder) {
+        return; // File not found, or dropped onto its own place
     }
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-
-    
-    VFile* movedFile = sourceLocation.file;
-    VFolder* sourceFolder = sourceLocation.parentFolder;
-    
-    // Determine if we're moving to root level or staying in a folder
-    bool movingToRoot = false;
-    VFolder* targetFolder = nullptr;
-    
-    // Count items at root level to determine if target is root
-    int rootItemCount = commonData.rootVFolder.fileList.size() + commonData.rootVFolder.folderList.size();
-    
-    if (commonData.rootVFolder.isInRoot(newOrder)) {
-        movingToRoot = true;
-        targetFolder = nullptr;
-    } else {
-        FileLocation targetLocation = findFileLocation(newOrder);
-		targetFolder = targetLocation.parentFolder;
-    }
-    
-    // If moving to a different container, we need to handle the move
-    if (movingToRoot && sourceFolder) {
-        // Moving from folder to root
-        // Store the file data before removing
-        VFile fileData = *movedFile;
-        
-        // First, adjust global orders to make space for the move
-        adjustGlobalOrdersForFileMove(oldOrder, newOrder);
-        
-        // Remove from source folder
-        auto& sourceFileList = sourceFolder->fileList;
-        sourceFileList.erase(std::remove_if(sourceFileList.begin(), sourceFileList.end(),
-            [movedFile](const VFile& file) { return &file == movedFile; }), sourceFileList.end());
-        
-        // Set new order and add to root
-		if (newOrder > oldOrder) newOrder--;
-		fileData.setOrder(newOrder);
-        commonData.rootVFolder.fileList.push_back(fileData);
-        movedFile = commonData.rootVFolder.findFileByOrder(newOrder).value();
-
-        HTREEITEM oldItem = fileData.hTreeItem;
-        HTREEITEM prevItem = nullptr;
-        optional<VBase*> aboveSibling = commonData.rootVFolder.findAboveSibling(newOrder);
-        if (aboveSibling) {
-            prevItem = aboveSibling.value()->hTreeItem;
-            LOG("[{}] moved into root after [{}]", movedFile->name, aboveSibling.value()->name);
-        }
-        else {
-            prevItem = TVI_FIRST;
-            LOG("[{}] moved into root to first place", movedFile->name);
-        }
-
-        TreeView_DeleteItem(commonData.hTree, fileData.hTreeItem);
-        addFileToTree(movedFile, commonData.hTree, nullptr, isDarkMode, prevItem);
-        
-        
-    } else if (!movingToRoot && !sourceFolder) {
-        if (targetFolder == nullptr) {
-            // TODO: exception
-            return;
-        }
-        // Moving from root to folder
-        // Store the file data before removing
-        VFile fileData = *movedFile;
-        
-        // First, adjust global orders to make space for the move
-        adjustGlobalOrdersForFileMove(oldOrder, newOrder);
-        
-        // Remove from root
-        auto& rootFileList = commonData.rootVFolder.fileList;
-        rootFileList.erase(std::remove_if(rootFileList.begin(), rootFileList.end(),
-            [movedFile](const VFile& file) { return &file == movedFile; }), rootFileList.end());
-
-		if (newOrder > oldOrder) newOrder--;
-        // Find the target folder (simplified - would need proper logic)
-        // For now, we'll assume the first folder
-        if (!commonData.rootVFolder.folderList.empty()) {
-            // Set new order and add to folder
-			fileData.setOrder(newOrder);
-            targetFolder->fileList.push_back(fileData);
-            movedFile = targetFolder->findFileByOrder(newOrder).value();
-        }
-
-        HTREEITEM oldItem = nullptr;
-        HTREEITEM parentItem = targetFolder->hTreeItem;
-        HTREEITEM prevItem = nullptr;
-        optional<VBase*> aboveSibling = targetFolder->findAboveSibling(newOrder);
-        if (aboveSibling) {
-            prevItem = aboveSibling.value()->hTreeItem;
-            LOG("[{}] moved into folder [{}] after [{}]", movedFile->name, targetFolder->name, aboveSibling.value()->name);
-        } else {
-            prevItem = TVI_FIRST;
-            LOG("[{}] moved into folder [{}]'s start", movedFile->name, targetFolder->name);
-		}
-
-        /*oldItem = FindItemByLParam(hTree, nullptr, (LPARAM)movedFile->getOrder());*/
-        TreeView_DeleteItem(commonData.hTree, fileData.hTreeItem);
-
-        addFileToTree(movedFile, commonData.hTree, parentItem, isDarkMode, prevItem);
-        
-        
-    } else {
-        // Moving folder to folder
-        if (targetFolder == nullptr) {
-            targetFolder = &commonData.rootVFolder;
-        }
+    ScopedTreeRender render(commonData.rootVFolder);
 
-        if (sourceFolder == nullptr) {
-            sourceFolder = &commonData.rootVFolder;
-        }
-        
-        // Set the new order for the moved file
-        if (newOrder > oldOrder) newOrder--;
-        //newOrder--;
-        if (newOrder == oldOrder) return;
-        
-        HTREEITEM oldItem = nullptr;
-        HTREEITEM hParent = nullptr;
-		HTREEITEM prevItem = nullptr;
+    VFolder* sourceFolder = sourceLocation.parentFolder ? sourceLocation.parentFolder : &commonData.rootVFolder;
+    VFile fileData = *sourceLocation.file;
+    sourceFolder->removeFile(oldOrder);
 
-        int firstOrderOfFolder = 0; // first order of root
-        if (targetFolder) {
-			firstOrderOfFolder = targetFolder->getOrder() + 1;
-        }
-        
-		// What if newOrder is the first item in the folder?
-        oldItem = FindItemByLParam(commonData.hTree, hParent, (LPARAM)movedFile->getOrder());
-		hParent = targetFolder ? targetFolder->hTreeItem : nullptr;
-        if ((newOrder < oldOrder && newOrder == firstOrderOfFolder) || 
-            (newOrder > oldOrder && newOrder == firstOrderOfFolder - 1)) {  // If moving forward firstOrder is going to decrease
-			prevItem = TVI_FIRST;
-        } else {
-            optional<VBase*> targetBelowSibling;
-            if (newOrder < oldOrder) {
-                targetBelowSibling = targetFolder->getChildByOrder(newOrder);
-            }
-            else {
-                targetBelowSibling = targetFolder->getChildByOrder(newOrder + 1);
-            }
-            HTREEITEM targetNextItem = targetBelowSibling ? targetBelowSibling.value()->hTreeItem : nullptr;
-            prevItem = TreeView_GetPrevSibling(commonData.hTree, targetNextItem);
-
-		}
-        TreeView_DeleteItem(commonData.hTree, oldItem);
-
-        if (sourceFolder != targetFolder) {
-            VFile movedFileCopy = *movedFile;
-            sourceFolder->removeChild(oldOrder);
-            targetFolder->fileList.push_back(movedFileCopy);
-            movedFile = targetFolder->findFileByOrder(oldOrder).value();
-        }
-
-        adjustGlobalOrdersForFileMove(oldOrder, newOrder > oldOrder ? newOrder+1 : newOrder);
-		movedFile->setOrder(newOrder);
-
-		addFileToTree(movedFile, commonData.hTree, hParent, isDarkMode, prevItem);
+    // findParentFolder() has no parent for root-level files.
+    VFolder* targetFolder = newOrder == endOrder ? nullptr : commonData.rootVFolder.findParentFolder(newOrder);
+    if (targetFolder == nullptr) {
+        targetFolder = &commonData.rootVFolder;
+    }
 
-        LOG("[{}] moved to order [{}]", movedFile->name, newOrder);
+    commonData.rootVFolder.orderBefore(fileData, newOrder);
+    targetFolder->fileList.push_back(fileData);
+    targetFolder->vFolderSort();
 
+    optional<VBase*> aboveSibling = targetFolder->findAboveSibling(fileData.getOrder());
+    if (aboveSibling) {
+        LOG("[{}] moved into folder [{}] after [{}]", fileData.name, targetFolder->name, aboveSibling.value()->name);
+    }
+    else {
+        LOG("[{}] moved into folder [{}]'s start", fileData.name, targetFolder->name);
     }
 }
 
@@ -1848,97 +1716,24 @@ void reorderFolders(int oldOrder, int newOrder) {
     // Find the folder to move using recursive search
     FolderLocation moveLocation = findFolderLocation(oldOrder);
 
-    if (!moveLocation.found) {
-        return;  // Folder not found
-    }
-
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-    optional<VFolder*> movedFolderOpt = commonData.rootVFolder.findFolderByOrder(oldOrder);
-	VFolder* movedFolder = movedFolderOpt.value();
-    VFolder* sourceParentFolder = moveLocation.parentFolder;
-    VFolder* targetParentFolder = commonData.rootVFolder.findParentFolder(newOrder);
-
-
-    // Count total items in the folder (folder itself + all contents recursively)
-    int folderItemCount = (*movedFolder).countItemsInFolder();
-       
-
-    // Tree manipulation - similar to reorderItems
-    HTREEITEM oldItem = movedFolder->hTreeItem;
-    HTREEITEM sourceParentItem = nullptr;
-    HTREEITEM targetParentItem = nullptr;
-    HTREEITEM prevItem = nullptr;
-
-    
-    sourceParentItem = sourceParentFolder ? sourceParentFolder->hTreeItem : nullptr;
-    targetParentItem = targetParentFolder ? targetParentFolder->hTreeItem : nullptr;
-
-    // Find the insertion point
-    int firstOrderOfFolder = -1;
-    if (targetParentFolder) {
-        firstOrderOfFolder = targetParentFolder->getOrder() + 1;
-    } else {
-        // Find first order at root level
-        int firstFileOrder = -1, firstFolderOrder = -1;
-        if (!commonData.rootVFolder.fileList.empty()) {
-            firstFileOrder = commonData.rootVFolder.fileList[0].getOrder();
-        }
-        if (!commonData.rootVFolder.folderList.empty()) {
-            firstFolderOrder = commonData.rootVFolder.folderList[0].getOrder();
-        }
-        firstOrderOfFolder = min(firstFileOrder, firstFolderOrder);
+    if (!moveLocation.found || newOrder == oldOrder) {
+        return;  // Folder not found, or dropped onto its own place
     }
 
-    if (newOrder == firstOrderOfFolder) {
-        prevItem = TVI_FIRST;
-    } else {
-        // Find the item that should come before the moved folder
-        VFolder* parentFolder = commonData.rootVFolder.findParentFolder(newOrder);
-        optional<VBase*> aboveSibling = parentFolder ? parentFolder->findAboveSibling(newOrder) : commonData.rootVFolder.findAboveSibling(newOrder);
-        if (aboveSibling) {
-            prevItem = aboveSibling.value()->hTreeItem;
-        } else {
-            prevItem = TVI_FIRST;
-        }
-    }
+    ScopedTreeRender render(commonData.rootVFolder);
+    VFolder* sourceParentFolder = moveLocation.parentFolder ? moveLocation.parentFolder : &commonData.rootVFolder;
 
-    TreeView_DeleteItem(hTree, oldItem);
+    VFolder movedFolderCopy = *moveLocation.folder;
+    sourceParentFolder->removeFolder(oldOrder);
 
-    
-	VFolder movedFolderCopy = *movedFolder;
-    if (sourceParentFolder) {
-        sourceParentFolder->removeChild(oldOrder);
+    VFolder* targetParentFolder = newOrder == endOrder ? nullptr : commonData.rootVFolder.findParentFolder(newOrder);
+    if (targetParentFolder == nullptr) {
+        targetParentFolder = &commonData.rootVFolder;
     }
-    else {
-        commonData.rootVFolder.removeChild(oldOrder);
-	}
 
-    targetParentFolder = commonData.rootVFolder.findParentFolder(newOrder);
-    targetParentItem = targetParentFolder ? targetParentFolder->hTreeItem : nullptr;
-
-    if (targetParentFolder) {
-        targetParentFolder->folderList.push_back(movedFolderCopy);
-    }
-    else {
-        commonData.rootVFolder.folderList.push_back(movedFolderCopy);
-	}
-	movedFolder = commonData.rootVFolder.findFolderByOrder(movedFolderCopy.getOrder()).value();
-
-    // Adjust global orders to make space for the moved folder and its contents
-    adjustGlobalOrdersForFolderMove(oldOrder, newOrder, folderItemCount);
-
-    if (newOrder > oldOrder) {
-        newOrder = newOrder - movedFolder->countItemsInFolder();
-    }
-
-    // Set the new order for the moved folder
-    movedFolder->move(newOrder - oldOrder);
-
-
-    // Re-insert the folder in the new position
-    // addFolderToTree will recursively add all files and subfolders
-    ssize_t pos = newOrder;
-    HTREEITEM newItem = addFolderToTree(movedFolder, hTree, targetParentItem, pos, prevItem);
+    // The folder and its contents get orders right before newOrder.
+    commonData.rootVFolder.orderBefore(movedFolderCopy, newOrder);
+    targetParentFolder->folderList.push_back(movedFolderCopy);
 
     // After reordering, recursively sort the entire data structure to ensure consistency
     commonData.rootVFolder.vFolderSort();
@@ -1998,99 +1793,21 @@ FileLocation findFileLocation(int order) {
 
 void changeTreeItemIcon(UINT_PTR bufferID, int view) 
 {
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-	optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByBufferID(bufferID, view);
-    if (!vFileOpt) {
-        return;
-	}
-
-    TVITEM item = { 0 };
-    item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_STATE;
-    item.hItem = vFileOpt.value()->hTreeItem;
-
-    std::wstring displayName = toWstring(vFileOpt.value()->name);
-    item.pszText = displayName.data();
-
-
-    VFile* vFile = vFileOpt.value();
-
-    
-
-    if (vFile->view == 1) {
-        item.stateMask = TVIS_STATEIMAGEMASK;
-        item.state = INDEXTOSTATEIMAGEMASK(ICON_FILE_SECONDARY_VIEW); // 1-based index in state image list
-    }
-    else {
-        item.stateMask = TVIS_STATEIMAGEMASK;
-        item.state = 0;   // no state image
-    }
-
-    if (vFile->isReadOnly && isDarkMode) 
-    {
-        item.iImage = iconIndex[ICON_FILE_READONLY_DARK]; // Use read-only icon
-        item.iSelectedImage = iconIndex[ICON_FILE_READONLY_DARK]; // Use read-only icon
-
-        TreeView_SetItem(commonData.hTree, &item);
-        return;
-    } else if (vFile->isReadOnly && !isDarkMode) 
-    {
-        item.iImage = iconIndex[ICON_FILE_READONLY_LIGHT]; // Use read-only icon
-        item.iSelectedImage = iconIndex[ICON_FILE_READONLY_LIGHT]; // Use read-only icon
-    
-        TreeView_SetItem(commonData.hTree, &item);
-        return;
-	}
-
-	if (vFile->isEdited || (commonData.bufferStates.find(bufferID) != commonData.bufferStates.end() && !commonData.bufferStates[bufferID])) {
-        item.iImage = iconIndex[ICON_FILE_EDITED]; // Use edited icon
-        item.iSelectedImage = iconIndex[ICON_FILE_EDITED]; // Use edited icon
-    }
-    else if (isDarkMode) {
-        item.iImage = iconIndex[ICON_FILE_DARK];
-        item.iSelectedImage = iconIndex[ICON_FILE_DARK];
-    }
-    else {
-        item.iImage = iconIndex[ICON_FILE_LIGHT]; // Use light file icon
-        item.iSelectedImage = iconIndex[ICON_FILE_LIGHT]; // Use light file icon
-    }
-
-
-    TreeView_SetItem(commonData.hTree, &item);
+    refreshFileIcon(commonData.rootVFolder, hostBridge(), bufferID, view);
 }
 
 void activateSibling(bool aboveSibling) 
 {
-    UINT_PTR bufferID = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+    UINT_PTR bufferID = hostBridge().currentBufferID();
     optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByBufferID(bufferID, currentView);
     if (!vFileOpt) {
         return;
 	}
-	VFile* vFile = vFileOpt.value();
-	int currentOrder = vFile->getOrder();
-    do {
-        if (aboveSibling) {
-            currentOrder--;
-        }
-        else {
-            currentOrder++;
-        }
 
-	    optional<VBase*> sibling = commonData.rootVFolder.getChildByOrder(currentOrder);
-        if (!sibling) {
-            if (aboveSibling) {
-                currentOrder = commonData.rootVFolder.getLastOrder() + 1;
-            }
-            else {
-				currentOrder = -1;
-            }
-            continue;
-		}
-        if (auto file = dynamic_cast<VFile*>(sibling.value())) {
-			treeItemSelected(file->hTreeItem);
-			return;
-        }
-		currentOrder = sibling.value()->getOrder();
-    } while (true);
+    VFile* sibling = fileSequence.step(commonData.rootVFolder, vFileOpt.value(), !aboveSibling, commonData.siblingNavigation.get());
+    if (sibling && ensureTreeItem(sibling)) {
+        treeItemSelected(sibling->hTreeItem);
+    }
 }
 
 extern void increaseFontSize() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "model/VData.h"
+#include "TreeItems.h"
 #define NOMINMAX
 #include <windows.h>
 #include <commctrl.h>
@@ -21,6 +22,7 @@ using json = nlohmann::json;
 
 #include <commctrl.h>
 #include "model/VData.h"
+#include "TreeItems.h"
 #pragma comment(lib, "comctl32.lib")
 
 #define NOMINMAX
@@ -33,6 +35,12 @@ using json = nlohmann::json;
 
 
 #define TREEVIEW_TIMER_ID 1
+#define NOTIFICATION_FLUSH_TIMER_ID 2
+
+// Posted to the panel to apply queued notifications (see Services/NotificationQueue.h)
+#define WM_VF_FLUSH_NOTIFICATIONS (WM_APP + 1)
+// Posted to the panel to run what background tasks handed back (see Services/TaskScheduler.h)
+#define WM_VF_TASK_COMPLETIONS (WM_APP + 2)
 
 
 
@@ -64,28 +72,20 @@ struct FolderLocation {
 };
 
 
-enum IconType {
-    ICON_APP,
-    ICON_FOLDER,
-    ICON_FILE_LIGHT,
-    ICON_FILE_DARK,
-    ICON_FILE_EDITED,
-	ICON_FILE_READONLY_DARK,
-	ICON_FILE_READONLY_LIGHT,
-    ICON_FILE_SECONDARY_VIEW
-};
-
-extern std::unordered_map<IconType, int> iconIndex;
 
 
 // Menu command IDs
 #define MENU_ID_TREE_DELETE 40001
 #define MENU_ID_INCREASEFONT 40002
 #define MENU_ID_DECREASEFONT 40003
+#define MENU_ID_TREE_UNDO 40004
+#define MENU_ID_TREE_REDO 40005
 #define MENU_ID_FILE_CLOSE 40100
 #define MENU_ID_FILE_WRAP_IN_FOLDER 40101
 #define MENU_ID_FOLDER_RENAME 40103
 #define MENU_ID_FOLDER_UNWRAP 40104
+#define MENU_ID_FOLDER_FIND 40105
+#define MENU_ID_FOLDER_SAVE_EDITED 40106
 
 
 
@@ -105,16 +105,13 @@ static INT_PTR fileViewDialogProc_impl(HWND hwndDlg, UINT uMsg, WPARAM wParam, L
 INT_PTR CALLBACK fileViewDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
 // TreeView management functions
-void updateTreeItemLParam(VBase* vBase);
-HTREEITEM addFileToTree(VFile* vFile, HWND hTree, HTREEITEM hParent, bool darkMode, HTREEITEM hPrevItem);
-HTREEITEM addFolderToTree(VFolder* vFolder, HWND hTree, HTREEITEM hParent, ssize_t& pos, HTREEITEM hPrevItem);
+bool ensureTreeItem(VBase* vBase);  // Creates the items of collapsed ancestors
 void updateTreeColorsExternal(HWND hTree);
+void layoutFileView(HWND hwndDlg);  // Filter box on top, the tree below it
 
 // Drag & Drop and Reordering functions
 void reorderItems(int oldOrder, int newOrder);
 void reorderFolders(int oldOrder, int newOrder);
-void adjustGlobalOrdersForFileMove(int oldOrder, int newOrder);
-void adjustOrdersInContainer(vector<VFolder>& folders, vector<VFile>& files, int oldOrder, int newOrder);
 void checkReadOnlyStatus(VFile* selectedFile);
 
 
@@ -127,9 +124,11 @@ HTREEITEM FindItemByLParam(HWND hTree, HTREEITEM hParent, LPARAM lParam);
 
 void changeTreeItemIcon(UINT_PTR bufferID, int view);
 FolderLocation findFolderLocation(int order);
-void adjustGlobalOrdersForFolderMove(int oldOrder, int newOrder, int folderItemCount);
 
 void activateSibling(bool aboveSibling);
+void flushQueuedNotifications();    // Defined in ProcessNotifications.cpp
+bool processQueuedNotifications();  // Defined in Plugin.cpp
+void panelDocked();                 // Defined in ProcessNotifications.cpp
 extern void increaseFontSize();
 extern void decreaseFontSize();
 extern void setFontSize();
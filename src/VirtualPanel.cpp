@@ -16,6 +16,13 @@
 
 
 #include "TreeViewManager.h"
+#include "TreePopulator.h"
+#include "BufferHandlers.h"
+#include "model/FileIndex.h"
+#include "model/BufferStates.h"
+#include "model/FileTable.h"
+#include "model/FileSequence.h"
+#include "Bridge/Win32TreeControl.h"
 
 // External variables
 extern CommonData commonData;
@@ -36,6 +43,7 @@ extern void showCorruptionDialog(VFolder hOldFolder, VFolder hNewFolder, int hOl
 void writeJsonFile();
 void resizeVirtualPanel();
 void syncVDataWithOpenFiles(std::vector<VFile>& openFiles);
+void checkOpenFilesOnDisk(const std::vector<VFile>& openFiles);
 void fixRootVFolderJSON();
 bool checkRootVFolderJSON();
 
@@ -49,138 +57,6 @@ Scintilla::Position terminal = -1;
 
 
 
-// Helper function to adjust global orders when moving a folder with all its contents
-void adjustGlobalOrdersForFolderMove(int oldOrder, int newOrder, int folderItemCount) {
-    // Get all files across the entire hierarchy
-    vector<VFile*> allFiles = commonData.rootVFolder.getAllFiles();
-    
-    // Helper lambda to get all folders recursively
-    std::function<void(vector<VFolder>&, vector<VFolder*>&)> getAllFolders = 
-        [&](vector<VFolder>& folders, vector<VFolder*>& result) {
-            for (auto& folder : folders) {
-                result.push_back(&folder);
-                getAllFolders(folder.folderList, result);
-            }
-        };
-    
-    vector<VFolder*> allFolders;
-    getAllFolders(commonData.rootVFolder.folderList, allFolders);
-    
-    if (oldOrder < newOrder) {
-        // Moving down - shift items in between to the left
-        int posShiftAmount = newOrder - folderItemCount;
-		int negShiftAmount = folderItemCount;
-		int startOrder = oldOrder + folderItemCount; // Start from the next item
-
-        
-        // Adjust files
-        for (auto* file : allFiles) {
-            if (file->getOrder() >= startOrder && file->getOrder() < newOrder) {
-				file->setOrder(file->getOrder() - negShiftAmount);
-            }
-        }
-        
-        // Adjust folders
-        for (auto* folder : allFolders) {
-            if (folder->getOrder() >= startOrder && folder->getOrder() < newOrder) {
-                folder->setOrder(folder->getOrder() - negShiftAmount);
-            }
-        }
-    } else {
-        // Moving up - shift items in between to the right
-        int shiftAmount = folderItemCount;
-        
-        // Adjust files
-        for (auto* file : allFiles) {
-            if (file->getOrder() >= newOrder && file->getOrder() < oldOrder) {
-                file->setOrder(file->getOrder() + shiftAmount);
-            }
-        }
-        
-        // Adjust folders
-        for (auto* folder : allFolders) {
-            if (folder->getOrder() >= newOrder && folder->getOrder() < oldOrder) {
-				folder->setOrder(folder->getOrder() + shiftAmount);
-            }
-        }
-    }
-}
-
-// Helper function to adjust global orders for a single file move
-void adjustGlobalOrdersForFileMove(int oldOrder, int newOrder) {
-    // Get all files across the entire hierarchy
-    vector<VFile*> allFiles = commonData.rootVFolder.getAllFiles();
-    
-    // Helper lambda to get all folders recursively
-    std::function<void(vector<VFolder>&, vector<VFolder*>&)> getAllFolders = 
-        [&](vector<VFolder>& folders, vector<VFolder*>& result) {
-            for (auto& folder : folders) {
-                result.push_back(&folder);
-                getAllFolders(folder.folderList, result);
-            }
-        };
-    
-    vector<VFolder*> allFolders;
-    getAllFolders(commonData.rootVFolder.folderList, allFolders);
-    
-    if (oldOrder < newOrder) {
-        // Moving down - decrease orders of items in between
-        for (auto* file : allFiles) {
-            if (file->getOrder() > oldOrder && file->getOrder() < newOrder) {
-				file->decrementOrder();
-            }
-        }
-        for (auto* folder : allFolders) {
-            if (folder->getOrder() > oldOrder && folder->getOrder() < newOrder) {
-				folder->decrementOrder();
-            }
-        }
-    } else {
-        // Moving up - increase orders of items in between
-        for (auto* file : allFiles) {
-            if (file->getOrder() >= newOrder && file->getOrder() < oldOrder) {
-				file->incrementOrder();
-            }
-        }
-        for (auto* folder : allFolders) {
-            if (folder->getOrder() >= newOrder && folder->getOrder() < oldOrder) {
-                folder->incrementOrder();
-            }
-        }
-    }
-}
-
-// Helper function to recursively adjust orders within a container
-void adjustOrdersInContainer(vector<VFolder>& folders, vector<VFile>& files, int oldOrder, int newOrder) {
-    if (oldOrder < newOrder) {
-        // Moving down - decrease orders of items in between
-        for (auto& folder : folders) {
-            if (folder.getOrder() > oldOrder && folder.getOrder() < newOrder) {
-                folder.decrementOrder();
-            }
-        }
-        for (auto& file : files) {
-            if (file.getOrder() > oldOrder && file.getOrder() < newOrder) {
-				file.decrementOrder();
-            }
-        }
-    } else {
-        // Moving up - increase orders of items in between
-        for (auto& folder : folders) {
-            if (folder.getOrder() >= newOrder && folder.getOrder() < oldOrder) {
-				folder.incrementOrder();
-            }
-        }
-        for (auto& file : files) {
-            if (file.getOrder() >= newOrder && file.getOrder() < oldOrder) {
-				file.incrementOrder();
-            }
-        }
-    }
-}
-
-
-
 FolderLocation findFolderLocation(int order) {
     FolderLocation location;
     
@@ -221,131 +97,39 @@ FolderLocation findFolderLocation(int order) {
     return location;
 }
 
-void updateVirtualPanel(UINT_PTR bufferID, int activeView) {
-    currentView = activeView;
-
-    if(!commonData.isNppReady && commonData.rootVFolder.getLastOrder() >= 0) {  // if there is no buffer a default one comes. We should show that in the tree
-		//return; // Commented out to handle initial buffer activation. Will remove in future if not needed.
-    }
-
-    if (ignoreSelectionChange) {
-        ignoreSelectionChange = false;
-		return; // Ignore this update
-    }
-
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-
-    
-    // Get current buffer ID. This is for if I lost the bufferID or could not get at the start
-    if (bufferID <= 0) {
-        bufferID = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0); // does not take view as param
-    }
-    // Prefer the entry from the view that raised the notification. A cloned
-    // buffer has the same buffer ID in both views, so a view-agnostic lookup
-    // can select the wrong tree item.
-    optional<VFile*> vFileOption = commonData.rootVFolder.findFileByBufferID(bufferID, currentView);
-    VFile* vFile = nullptr;
-    if (!vFileOption) {
-        auto position = npp(NPPM_GETPOSFROMBUFFERID, bufferID, currentView);
-        if (position == -1) {
-            return;
-        }
-
-        // NPPM_GETPOSFROMBUFFERID encodes the view in the upper bits. A valid
-        // secondary-view position is therefore much larger than a document
-        // index and must not be treated as an invalid position.
-        int len = (int)::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, 0);
-        if (len < 0) {
-            return;
-        }
-        vector<wchar_t> filePath(static_cast<size_t>(len) + 1);
-        ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (LPARAM)filePath.data());
-
-		// Check if file already exists in vData by path or name
-        string nppFileName = fromWchar(filePath.data());
-        if (nppFileName.find_first_of("\\\\") != string::npos) {
-            vFile = commonData.rootVFolder.findFileByPath(nppFileName, currentView);
-        }
-        else {
-            vFile = commonData.rootVFolder.findFileByName(nppFileName, currentView);
-        }
-
-        if (vFile) {
-            // Session entries are loaded before Notepad++ buffer IDs are
-            // available. Bind the existing entry instead of appending a
-            // second tree row during startup.
-            vFile->bufferID = bufferID;
-            vFile->isActive = true;
-        }
-
-        if (!vFile) {
-            optional<VFile*> otherViewFile = commonData.rootVFolder.findFileByBufferID(bufferID);
-            if (otherViewFile) {
-                // The same buffer has just appeared in the other view. This
-                // covers both clone and move; NPPN_FILECLOSED removes the old
-                // entry in the move case.
-                VFolder* parentFolder = commonData.rootVFolder.findParentFolder(otherViewFile.value()->getOrder());
-
-                VFile fileCopy = *otherViewFile.value();
-                fileCopy.hTreeItem = nullptr;
-                fileCopy.view = currentView;
-                fileCopy.incrementOrder();
-
-                adjustGlobalOrdersForFileMove(INT_MAX, fileCopy.getOrder());
-                addFileToTree(&fileCopy, hTree, parentFolder ? parentFolder->hTreeItem : nullptr,
-                    isDarkMode, otherViewFile.value()->hTreeItem);
-
-                if (parentFolder) parentFolder->fileList.push_back(fileCopy);
-                else commonData.rootVFolder.fileList.push_back(fileCopy);
-
-                vFileOption = commonData.rootVFolder.findFileByBufferID(bufferID, currentView);
-                vFile = vFileOption.value();
-                writeJsonFile();
-            }
-        }
-
-        if (!vFile) {
-            // create vFile
-            VFile newFile;
-            newFile.bufferID = bufferID;
-            newFile.setOrder(commonData.rootVFolder.getLastOrder() + 1);
-
-            string filePathString = fromWchar(filePath.data());
-            size_t lastSlash = filePathString.find_last_of("/\\");
-            newFile.name = lastSlash != string::npos ? filePathString.substr(lastSlash + 1) : filePathString;
-
-            newFile.path = filePathString;
-            newFile.view = currentView;
-            newFile.session = 0;
-            newFile.backupFilePath = "";
-            newFile.isActive = true;
-            commonData.rootVFolder.fileList.push_back(newFile);
-
-            vFileOption = commonData.rootVFolder.findFileByBufferID(bufferID);
-            vFile = vFileOption.value();
-
-
-            // create treeItem
-            addFileToTree(vFile, hTree, TVI_ROOT, isDarkMode, TVI_LAST);
-
-            writeJsonFile();
+// The panel's side of the buffer handlers (BufferHandlers.h).
+const BufferHandlerHooks& panelBufferHooks() {
+    static const BufferHandlerHooks hooks{
+        [] { writeJsonFile(); },
+        [](UINT_PTR bufferID, int view) {
+            currentView = view;
+            if (ignoreSelectionChange) {
+                ignoreSelectionChange = false;
+                return false; // Ignore this update
+            }
+            // Binding may append or clone an entry, which the tree population cannot
+            // follow; a buffer already known in this view only selects its item.
+            if (treePopulator.active() && !commonData.rootVFolder.findFileByBufferID(bufferID, view)) {
+                treePopulator.finish();
+            }
+            return true;
+        },
+        [](VFile* vFile) {
+            currentView = vFile->view;
+            treePopulator.reveal(vFile);
+        },
+        [](VFile* vFile) { return ensureTreeItem(vFile); },
+        [](HTREEITEM item) {
+            ignoreSelectionChange = true;
+            treeControl().selectItem(item);
+            ignoreSelectionChange = false;
         }
-    }
-    else {
-		vFile = vFileOption.value();
-    }
-    
-    currentView = vFile->view;
-
-    if (TreeView_GetSelection(hTree) != vFile->hTreeItem) {
-        ignoreSelectionChange = true;
-        HTREEITEM selectedItem = vFile->hTreeItem;
-        TreeView_SelectItem(hTree, selectedItem);
-        ignoreSelectionChange = false;
-    }
-
+    };
+    return hooks;
+}
 
+void updateVirtualPanel(UINT_PTR bufferID, int activeView, bool selectItem = true) {
+    mirrorBufferActivation(commonData.rootVFolder, hostBridge(), bufferID, activeView, selectItem, panelBufferHooks());
 }
 
 
@@ -382,197 +166,32 @@ void resizeVirtualPanel() {
                 SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
     
     // Resize the tree control to fill the dialog
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-    if (hTree) {
-        RECT rcClient;
-        GetClientRect(virtualPanelWnd, &rcClient);
-        SetWindowPos(hTree, nullptr, 0, 0, 
-                    rcClient.right - rcClient.left, 
-                    rcClient.bottom - rcClient.top, 
-                    SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-        
-        // Force the tree control to update its scrollbars
-        InvalidateRect(hTree, nullptr, TRUE);
-        UpdateWindow(hTree);
-    }
-}
-
-void onFileClosed(UINT_PTR bufferID, int view) {
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-    BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
-
-    optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByBufferID(bufferID, view);
-    if (!vFileOpt) {
-        OutputDebugStringA("File not found in vData\n");
-        return;
-	}
-
-    
-    HTREEITEM hSelectedItem = vFileOpt.value()->hTreeItem;
-    if (hSelectedItem) {
-        // Remove the item from the tree
-        TreeView_DeleteItem(hTree, hSelectedItem);
-        
-		VFile fileCopy = *(vFileOpt.value());
-        VFolder* parentFolder = commonData.rootVFolder.findParentFolder(fileCopy.getOrder());
-        if (parentFolder) {
-            parentFolder->removeFile(fileCopy.getOrder());
-        }
-        else {
-            commonData.rootVFolder.removeFile(fileCopy.getOrder());
-        }
-
-		adjustGlobalOrdersForFileMove(fileCopy.getOrder(), INT_MAX);
-
-        
-        // Write updated vData to JSON file
-        writeJsonFile();
-        
-        
-        LOG("File closed and removed from tree panel");
-
-		
-	}
-}
-
-void onFileRenamed(UINT_PTR bufferID, wstring filepath, wstring fullpath) {
-    HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
-    optional<VFile*> vFileOpt = commonData.rootVFolder.findFileByBufferID(bufferID);
-    if (!vFileOpt) {
-        LOG("File not found in vData");
-        return;
-    }
-	string oldName = vFileOpt.value()->name;
-        
-	// Extract filename from filepath
-	wstring fileName = filepath;
-    // if file is saved extract filename
-    if (vFileOpt.value()->backupFilePath.empty()) {
-        size_t lastSlash = filepath.find_last_of(L"/\\");
-        fileName = lastSlash != string::npos ? filepath.substr(lastSlash + 1) : filepath;
-    }
-	vFileOpt.value()->name = fromWchar(fileName.c_str());
-	vFileOpt.value()->path = fromWchar(fullpath.c_str());
-
-
-	HTREEITEM hSelectedItem = FindItemByLParam(hTree, TVI_ROOT, (LPARAM)(vFileOpt.value()->getOrder()));
-    if (hSelectedItem) {
-        // Update the item's text in the tree
-        //std::wstring wideName(vFile.value()->name.begin(), vFile.value()->name.end());
-        TVITEM tvi = { 0 };
-        tvi.mask = TVIF_TEXT;
-        tvi.hItem = hSelectedItem;
-        tvi.pszText = const_cast<LPWSTR>(fileName.c_str());
-        TreeView_SetItem(hTree, &tvi);
-        
-        // Write updated vData to JSON file
-        writeJsonFile();
-        
-        OutputDebugStringA("File renamed and tree panel updated\n");
-	}
-}
-
-void toggleViewOfVFile(UINT_PTR bufferID)
-{
-    auto position1 = npp(NPPM_GETPOSFROMBUFFERID, bufferID, 0);
-    int docView1 = (position1 >> 30) & 0x3;   // 0 = MAIN_VIEW, 1 = SUB_VIEW
-    int docIndex1 = position1 & 0x3FFFFFFF;    // 0-based index
-
-    auto position2 = npp(NPPM_GETPOSFROMBUFFERID, bufferID, 1);
-    int docView2 = (position2 >> 30) & 0x3;   // 0 = MAIN_VIEW, 1 = SUB_VIEW
-    int docIndex2 = position2 & 0x3FFFFFFF;    // 0-based index
-
-
-    optional<VFile*> vFileMainOpt = commonData.rootVFolder.findFileByBufferID(bufferID, MAIN_VIEW);
-    optional<VFile*> vFileSubOpt = commonData.rootVFolder.findFileByBufferID(bufferID, SUB_VIEW);
-
-    if (docView1 == 0 && docView2 == 0) {
-		// Main'de var sub'da yok
-        if (!vFileMainOpt && vFileSubOpt) {
-            LOG("TOGGLE sub to main");
-            vFileSubOpt.value()->view = 0;
-			currentView = 0;
-		} else if (vFileMainOpt && vFileSubOpt) {
-            LOG("REMOVE sub");
-			onFileClosed(bufferID, 1);
-            currentView = 0;
-        } else {
-            LOG("IMPOSSIBLE situation 1");
-        }
-    }
-    else if (docView1 == 0 && docView2 == 1) {
-		// Main'de var sub'da var
-        LOG("IMPOSSIBLE situation 2");
-    }
-    else if (docView1 == 1 && docView2 == 1) {
-        // Main'de yok sub'da var
-        if (vFileMainOpt && !vFileSubOpt) {
-            LOG("TOGGLE main to sub");
-			vFileMainOpt.value()->view = 1;
-            currentView = 1;
-        }
-        else if (vFileMainOpt && vFileSubOpt) {
-            LOG("REMOVE main");
-			onFileClosed(bufferID, 0);
-            currentView = 1;
-        }
-        else {
-            LOG("IMPOSSIBLE situation 3");
-		}
-    }
-    
-
-    // 1. Buffer moved
-	//      position is from view=1. Main one closed already    view=0 var  view=1 yok
-    //      -> toggle
-    // 2. Clone moved
-	//      position is from view=0. Sub one closed already     view=0 var  view=1 var
-    //      -> remove view=1
-    // 3. Clone closed
-	//      position is from view=0. Sub one closed already     view=0 var  view=1 var
-	//      -> remove view=1
-    // 4. Cloned original moved
-	//      position is from view=1. Main one closed already    view=0 var view=1 var
-	//      -> remove view=0
-    // 5. Cloned Original closed
-    //      position is from view=1. Main one closed already
-	//      -> remove view=0
-
-
-    changeTreeItemIcon(bufferID, MAIN_VIEW);
-    changeTreeItemIcon(bufferID, SUB_VIEW);
-
-    writeJsonFile();
+    layoutFileView(virtualPanelWnd);
 }
 
 void syncVDataWithBufferIDs()
 {
-    int nbMainViewFile = (int)::SendMessage(plugin.nppData._nppHandle, NPPM_GETNBOPENFILES, 0, PRIMARY_VIEW);
-    int nbSubViewFile = (int)::SendMessage(plugin.nppData._nppHandle, NPPM_GETNBOPENFILES, 0, SECOND_VIEW);
+    HostBridge& host = hostBridge();
+    int nbMainViewFile = host.openFileCount(MAIN_VIEW);
+    int nbSubViewFile = host.openFileCount(SUB_VIEW);
     int nbFile = nbMainViewFile + nbSubViewFile;
 
-    wchar_t** fileNames = (wchar_t**)new wchar_t* [nbFile];
+    vector<wstring> fileNames(nbFile);
     vector<UINT_PTR> bufferIDVec(nbFile);
 
     int i = 0;
     for (; i < nbMainViewFile; )
     {
-        LRESULT bufferID = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETBUFFERIDFROMPOS, i, MAIN_VIEW);
-        bufferIDVec[i] = bufferID;
-        LRESULT len = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (WPARAM)nullptr);
-        fileNames[i] = new wchar_t[len + 1];
-        ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (WPARAM)fileNames[i]);
+        bufferIDVec[i] = host.bufferIDAt(i, MAIN_VIEW);
+        fileNames[i] = host.fullPathOfBuffer(bufferIDVec[i]);
         ++i;
     }
 
 
     for (int j = 0; j < nbSubViewFile; ++j)
     {
-        LRESULT bufferID = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETBUFFERIDFROMPOS, j, SUB_VIEW);
-        bufferIDVec[i] = bufferID;
-        LRESULT len = ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (WPARAM)nullptr);
-        fileNames[i] = new wchar_t[len + 1];
-        ::SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, bufferID, (WPARAM)fileNames[i]);
+        bufferIDVec[i] = host.bufferIDAt(j, SUB_VIEW);
+        fileNames[i] = host.fullPathOfBuffer(bufferIDVec[i]);
         ++i;
     }
 
@@ -580,7 +199,7 @@ void syncVDataWithBufferIDs()
     for (int k = 0; k < nbFile; k++) {
 		if (k == nbMainViewFile) view = 1;
 
-        string nppFileName = fromWchar(fileNames[k]);
+        string nppFileName = fromWchar(fileNames[k].c_str());
         VFile* vFile = nullptr;
         if (nppFileName.find_first_of("\\\\") != string::npos) {
             vFile = commonData.rootVFolder.findFileByPath(nppFileName, view);
@@ -591,16 +210,9 @@ void syncVDataWithBufferIDs()
         if (!vFile) continue;
         if (vFile->bufferID > 0) continue;
         vFile->bufferID = bufferIDVec[k];
+        bufferStates.bind(*vFile);
     }
-
-
-
-
-    for (int k = 0; k < nbFile; k++)
-    {
-        delete[] fileNames[k];
-    }
-    delete[] fileNames;
+    ++fileStateRevision;  // Buffer IDs were set directly
 }
 
 void decodeErrorMail(string encoded_compressed) {
@@ -633,6 +245,7 @@ void toggleVirtualPanelWithList() {
             resizeVirtualPanel();
 
 		    commonData.hTree = hTree;
+		    win32TreeControl.attach(hTree);
 
             setFontSize();
 
@@ -664,6 +277,7 @@ void toggleVirtualPanelWithList() {
                 DestroyWindow(virtualPanelWnd);
                 virtualPanelWnd = nullptr;
                 commonData.hTree = nullptr;
+                win32TreeControl.attach(nullptr);
                 return;
             }
 
@@ -684,6 +298,7 @@ void toggleVirtualPanelWithList() {
                     DestroyWindow(virtualPanelWnd);
                     virtualPanelWnd = nullptr;
                     commonData.hTree = nullptr;
+                    win32TreeControl.attach(nullptr);
                     return;
                 }
             }
@@ -691,6 +306,8 @@ void toggleVirtualPanelWithList() {
                 commonData.rootVFolder = VFolder{};
                 rootVFolderJson = commonData.rootVFolder;
             }
+            ++modelRevision;  // The old model's files are gone
+            bufferStates.clear();
 
             // The synthetic root is never part of the global item ordering.
             // Set this before synchronizing open files so a newly-created tree
@@ -703,7 +320,6 @@ void toggleVirtualPanelWithList() {
             syncVDataWithOpenFiles(commonData.openFiles);
 
             commonData.rootVFolder.vFolderSort();
-            BOOL isDarkMode = npp(NPPM_ISDARKMODEENABLED, 0, 0);
             if (checkRootVFolderJSON()) {
                 checkRootVFolderJSON();
                 VFolder originalRootVFolder = rootVFolderJson.get<VFolder>();
@@ -712,25 +328,20 @@ void toggleVirtualPanelWithList() {
                 fixRootVFolderJSON(); // uncomment on production
             }
 
+            // Stores written before orders had gaps number the entries one
+            // after another; spread them once so later inserts find room.
+            if (commonData.rootVFolder.ordersAreDense()) {
+                commonData.rootVFolder.spreadOrders();
+            }
+
             writeJsonFile();
             syncVDataWithBufferIDs();
+            fileIndex.clear();  // Built again on the first search
+            fileSequence.clear();
 
-
-            int lastOrder = commonData.rootVFolder.getLastOrder();
-            for (ssize_t pos = 0; pos <= lastOrder; pos) {
-				optional<VBase*> childOpt = commonData.rootVFolder.getDirectChildByOrder(pos);
-                if (!childOpt) {
-                    // This should not happen, but just in case. 
-                    pos++;
-                }
-                else if (auto file = dynamic_cast<VFile*>(childOpt.value())) {
-                    addFileToTree(file, hTree, TVI_ROOT, isDarkMode, TVI_LAST);
-                    pos++;
-                }
-                else if (auto folder = dynamic_cast<VFolder*>(childOpt.value())) {
-                    addFolderToTree(folder, hTree, TVI_ROOT, pos, TVI_LAST);
-                }
-            }
+            // The first screen and the active file now, the rest on idle ticks.
+            treePopulator.start(hTree, virtualPanelWnd, commonData.rootVFolder);
+            checkOpenFilesOnDisk(commonData.openFiles);
 
 
             static std::wstring pluginTitleStr;
@@ -748,6 +359,7 @@ void toggleVirtualPanelWithList() {
 
 
             npp(NPPM_DMMREGASDCKDLG, 0, &dock);
+            panelDocked();
         }
         catch (const std::exception& e) {
             const std::wstring message =
@@ -759,6 +371,7 @@ void toggleVirtualPanelWithList() {
             }
             virtualPanelWnd = nullptr;
             commonData.hTree = nullptr;
+            win32TreeControl.attach(nullptr);
             return;
         }
         catch (...) {
@@ -770,6 +383,7 @@ void toggleVirtualPanelWithList() {
             }
             virtualPanelWnd = nullptr;
             commonData.hTree = nullptr;
+            win32TreeControl.attach(nullptr);
             return;
         }
 
@@ -793,6 +407,7 @@ void toggleVirtualPanelWithList() {
     }
     HWND hTree = GetDlgItem(virtualPanelWnd, IDC_TREE1);
 	commonData.hTree = hTree;
+	win32TreeControl.attach(hTree);
 }
 
 
@@ -826,9 +441,7 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
 
     }
 
-    // Removing from highest to lowest keeps the remaining collected orders
-    // stable while each deletion closes the global order gap.
-    std::sort(staleOrders.begin(), staleOrders.end(), std::greater<int>());
+    // Removing leaves the other orders as they are; the gaps stay free.
     for (int staleOrder : staleOrders) {
         optional<VFile*> staleFileOpt = commonData.rootVFolder.findFileByOrder(staleOrder);
         if (!staleFileOpt) {
@@ -842,7 +455,6 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
         else {
             commonData.rootVFolder.removeFile(staleOrder);
         }
-        adjustGlobalOrdersForFileMove(staleOrder, INT_MAX);
     }
 
 
@@ -854,8 +466,7 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
 
             }
             else {
-                int lastOrder = commonData.rootVFolder.getLastOrder();
-                openFiles[i].setOrder(lastOrder + 1);   // append to the end
+                commonData.rootVFolder.orderBefore(openFiles[i], endOrder);   // append to the end
                 commonData.rootVFolder.fileList.push_back(openFiles[i]);
                 continue;
             }
@@ -869,10 +480,10 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
             else {
                 jsonVFile->isActive = openFiles[i].isActive;
             }
-            jsonVFile->isEdited = openFiles[i].isEdited;
+            jsonVFile->setEdited(openFiles[i].edited());
             jsonVFile->view = openFiles[i].view;
             jsonVFile->session = openFiles[i].session;
-            jsonVFile->isReadOnly = openFiles[i].isReadOnly;
+            jsonVFile->setReadOnly(openFiles[i].readOnly());
             jsonVFile->isActive = openFiles[i].isActive;
         }
         else {
@@ -912,8 +523,6 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
                 else {
                     commonData.rootVFolder.removeFile(fileCopy.getOrder());
                 }
-
-                adjustGlobalOrdersForFileMove(fileCopy.getOrder(), INT_MAX);
                 break;
             }
         }
@@ -922,14 +531,45 @@ void syncVDataWithOpenFiles(vector<VFile>& openFiles) {
         }
 
     }
+    ++fileStateRevision;  // Views and active flags were copied in directly
+}
+
+// Checks the saved files of the session on the stat threads, so a session on
+// an unreachable share does not hold up the panel. Files that are gone from
+// disk leave the tree when the answer comes in.
+void checkOpenFilesOnDisk(const vector<VFile>& openFiles) {
+    static uint64_t latestCheck = 0;
+    vector<string> savedPaths;
+    for (const VFile& openFile : openFiles) {
+        if (openFile.backupFilePath.empty()) {
+            savedPaths.push_back(openFile.path.str());
+        }
+    }
+    if (savedPaths.empty()) {
+        return;
+    }
 
+    const uint64_t check = ++latestCheck;
+    fileStatService.checkPaths(savedPaths, [savedPaths, check](FileStatBatchResult result) {
+        // A panel created since has a model of its own.
+        if (check != latestCheck || !virtualPanelWnd || !IsWindow(virtualPanelWnd)) {
+            return;
+        }
+        if (result.timedOutCount > 0) {
+            LOG("checkOpenFilesOnDisk: [{}] of [{}] files could not be checked in time, keeping them", result.timedOutCount, savedPaths.size());
+        }
+        if (std::all_of(result.exists.begin(), result.exists.end(), [](bool exists) { return exists; })) {
+            return;
+        }
+        treePopulator.finish();
+        handleSessionFilesChecked(commonData.rootVFolder, savedPaths, result, panelBufferHooks());
+    });
 }
 
 bool checkRootVFolderJSON() {
     // Corruptions in json
     // 1. Two items with same order
     //  Fix: check if any gap above or below. If not, assign new order to one of them.
-    int lastOrder = commonData.rootVFolder.getLastOrder();
     vector<VBase*> allChildren = commonData.rootVFolder.getAllChildren();
     for (int i = 0; i < allChildren.size(); i++) {
         for (int j = i + 1; j < allChildren.size(); j++) {
@@ -944,7 +584,6 @@ bool checkRootVFolderJSON() {
 
 
 
-    lastOrder = commonData.rootVFolder.getLastOrder();
     // 4. Negative orders except root folder (-1)
     //  Fix: If positive order exists, assign new order with lastOrder+1
     allChildren = commonData.rootVFolder.getAllChildren();
@@ -956,42 +595,8 @@ bool checkRootVFolderJSON() {
         return true;
     }
 
-    // 2. Gaps in orders
-    for (int i = 0; i < lastOrder; i++) {
-        optional<VBase*> child = commonData.rootVFolder.getChildByOrder(i);
-        if (child) continue;
-
-        LOG("checkRootVFolderJSON: Gaps in orders");
-        return true;
-    }
-
-
-    // 3. Order not sequential in a folder
-
-    commonData.rootVFolder.vFolderSort();
-    std::function<bool(VFolder*, ssize_t&)> isTheTreeCorrupt =
-        [&](VFolder* folder, ssize_t& startPos) -> bool {
-
-        int lastOrder = folder->getLastOrder();
-
-        while (startPos <= lastOrder) {
-            optional<VBase*> childOpt = folder->getDirectChildByOrder(startPos);
-            if (!childOpt) {
-                return true;
-            }
-            startPos++;
-            if (auto subFolder = dynamic_cast<VFolder*>(childOpt.value())) {
-                bool isCorrupt = isTheTreeCorrupt(subFolder, startPos);
-                if (isCorrupt) {
-                    return true;
-                }
-            }
-        }
-        return false;
-        };
-
-    ssize_t startPos = 0;
-    bool treeIsCorrupt = isTheTreeCorrupt(&commonData.rootVFolder, startPos);
+    // 2. Orders out of tree order. Gaps between orders are expected.
+    bool treeIsCorrupt = !commonData.rootVFolder.ordersFollowTree();
 
     LOG("Finished checking rootVFolder JSON: [{}]", treeIsCorrupt);
     
@@ -1050,47 +655,9 @@ void fixRootVFolderJSON() {
 		}
 	}
 
-    // 2. Gaps in orders
-    for (int i = 0; i < lastOrder; i++) {
-        optional<VBase*> child = commonData.rootVFolder.getChildByOrder(i);
-        if (child) continue;
-
-        adjustGlobalOrdersForFileMove(i, lastOrder + 1);
-        lastOrder--;
-        i--;
-    }
-
-
-    // 3. Order not sequential in a folder
-
-	commonData.rootVFolder.vFolderSort();
-    std::function<bool(VFolder*, ssize_t)> isTheTreeCorrupt =
-        [&](VFolder* folder, ssize_t startPos) -> bool {
-        int lastOrder = folder->fileList.empty() ? 0 : folder->fileList.back().getOrder();
-        lastOrder = std::max(lastOrder, folder->folderList.empty() ? 0 : folder->folderList.back().getOrder());
-
-        while (startPos <= lastOrder) {
-            optional<VBase*> childOpt = commonData.rootVFolder.getDirectChildByOrder(startPos);
-            if (!childOpt) {
-                return true;
-            }
-            startPos++;
-            if (auto subFolder = dynamic_cast<VFolder*>(childOpt.value())) {
-                bool isCorrupt = isTheTreeCorrupt(subFolder, startPos);
-                if (isCorrupt) return true;
-            }
-        }
-        return false;
-        };
-
-    ssize_t startPos = 0;
-    bool treeIsCorrupt = isTheTreeCorrupt(&commonData.rootVFolder, startPos);
-
-
-    // Nuclear option
-    if (treeIsCorrupt) {
-        startPos = 0;
-        commonData.rootVFolder.resetOrders(startPos);
+    // 2. Orders out of tree order: number the tree again as it is laid out
+    if (!commonData.rootVFolder.ordersFollowTree()) {
+        commonData.rootVFolder.spreadOrders();
     }
 
 
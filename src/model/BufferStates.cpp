@@ -0,0 +1,133 @@
+#include "BufferStates.h"
+#include "FileTable.h"
+
+
+namespace {
+
+BufferState* boundState(const VFile& file) {
+	return file.sharesBufferState ? bufferStates.find(file.bufferID) : nullptr;
+}
+
+}  // namespace
+
+
+bool VFile::edited() const {
+	const BufferState* state = boundState(*this);
+	return state ? state->isEdited : isEdited;
+}
+
+bool VFile::readOnly() const {
+	const BufferState* state = boundState(*this);
+	return state ? state->isReadOnly : isReadOnly;
+}
+
+bool VFile::hasUnsavedChanges() const {
+	const BufferState* state = boundState(*this);
+	return state ? state->hasUnsavedChanges() : isEdited;
+}
+
+void VFile::setEdited(bool edited) {
+	isEdited = edited;
+	if (BufferState* state = boundState(*this)) {
+		state->isEdited = edited;
+		fileTable.refreshBuffer(bufferID);
+	}
+	else {
+		++fileStateRevision;	// No record to find the file's row by
+	}
+}
+
+void VFile::setReadOnly(bool readOnly) {
+	isReadOnly = readOnly;
+	if (BufferState* state = boundState(*this)) {
+		state->isReadOnly = readOnly;
+		fileTable.refreshBuffer(bufferID);
+	}
+	else {
+		++fileStateRevision;
+	}
+}
+
+VFile VFile::detached() const {
+	VFile copy = *this;
+	copy.hTreeItem = nullptr;
+	copy.isEdited = edited();
+	copy.isReadOnly = readOnly();
+	copy.sharesBufferState = false;
+	return copy;
+}
+
+
+BufferState* BufferStateTable::find(UINT_PTR bufferID) {
+	const auto found = slots.find(bufferID);
+	return found != slots.end() ? &records[found->second] : nullptr;
+}
+
+const BufferState* BufferStateTable::find(UINT_PTR bufferID) const {
+	const auto found = slots.find(bufferID);
+	return found != slots.end() ? &records[found->second] : nullptr;
+}
+
+BufferState& BufferStateTable::bind(VFile& file) {
+	BufferState* state = find(file.bufferID);
+	if (!state) {
+		state = &add(file.bufferID);
+	}
+	if (state->views == 0) {
+		// The first view: the entry knows the buffer's stored state.
+		state->path = file.path;
+		state->isEdited = file.isEdited;
+		state->isReadOnly = file.isReadOnly;
+	}
+	state->views |= static_cast<uint8_t>(1 << file.view);
+	file.sharesBufferState = true;
+	return *state;
+}
+
+void BufferStateTable::unbind(UINT_PTR bufferID, int view) {
+	const auto found = slots.find(bufferID);
+	if (found == slots.end()) {
+		return;
+	}
+	BufferState& state = records[found->second];
+	state.views &= static_cast<uint8_t>(~(1 << view));
+	if (state.views == 0) {
+		state = BufferState{};
+		freeSlots.push_back(found->second);
+		slots.erase(found);
+	}
+}
+
+bool BufferStateTable::setSavePoint(UINT_PTR bufferID, bool atSavePoint) {
+	BufferState* state = find(bufferID);
+	if (!state) {
+		state = &add(bufferID);
+	}
+	else if (state->atSavePoint == atSavePoint) {
+		return false;
+	}
+	state->atSavePoint = atSavePoint;
+	fileTable.refreshBuffer(bufferID);
+	return true;
+}
+
+void BufferStateTable::clear() {
+	records.clear();
+	freeSlots.clear();
+	slots.clear();
+}
+
+BufferState& BufferStateTable::add(UINT_PTR bufferID) {
+	uint32_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = static_cast<uint32_t>(records.size());
+		records.emplace_back();
+	}
+	slots.emplace(bufferID, slot);
+	records[slot].bufferID = bufferID;
+	return records[slot];
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "VData.h"
+#include <unordered_map>
+
+
+// State of every open Notepad++ buffer, kept once for the entries of both
+// views. Kept free of Win32.
+//
+// A buffer cloned to the other view has an entry in each view with the same
+// bufferID. What belongs to the buffer rather than to an entry (its path,
+// whether it is edited, read-only or at its save point) lives in one record,
+// so a save, a save point or a read-only toggle is a single update, and the
+// icons of both entries are worked out from it. bind() makes the record from
+// the entry's own fields the first time a view shows the buffer; from then
+// on VFile::edited() and readOnly() read it. Entries that are not bound, and
+// the copies in snapshots, keep using their own fields.
+//
+// Records sit in one vector and are found through a map by bufferID. The slot
+// of a buffer that was closed in both views is used again.
+
+struct BufferState {
+	UINT_PTR bufferID = 0;
+	PooledPath path;
+	bool isEdited = false;			// Restored from a backup, or changed and not saved since
+	bool isReadOnly = false;
+	bool atSavePoint = true;		// As Scintilla last reported it
+	uint8_t views = 0;				// A bit per view showing the buffer
+
+	bool showsView(int view) const { return (views >> view) & 1; }
+	bool hasUnsavedChanges() const { return isEdited || !atSavePoint; }
+};
+
+class BufferStateTable {
+public:
+	BufferState* find(UINT_PTR bufferID);
+	const BufferState* find(UINT_PTR bufferID) const;
+
+	// The record of the entry's buffer, with the entry's view marked.
+	BufferState& bind(VFile& file);
+	// Unmarks the view; the record goes once no view shows the buffer.
+	void unbind(UINT_PTR bufferID, int view);
+
+	// False if the buffer was at that save point already. A buffer no entry
+	// is bound to yet gets a record without views.
+	bool setSavePoint(UINT_PTR bufferID, bool atSavePoint);
+
+	void clear();
+	size_t size() const { return slots.size(); }
+
+private:
+	BufferState& add(UINT_PTR bufferID);
+
+	vector<BufferState> records;
+	vector<uint32_t> freeSlots;
+	std::unordered_map<UINT_PTR, uint32_t> slots;
+};
+
+// The buffers of commonData.rootVFolder.
+inline BufferStateTable bufferStates;
@@ -0,0 +1,166 @@
+#include "BufferSync.h"
+#include "BufferStates.h"
+#include "FileIndex.h"
+#include "FileTable.h"
+
+
+string fileNameOfPath(const string& path) {
+	const size_t lastSlash = path.find_last_of("/\\");
+	return lastSlash != string::npos ? path.substr(lastSlash + 1) : path;
+}
+
+BufferActivation bindActivatedBuffer(VFolder& root, HostBridge& host, UINT_PTR bufferID, int view) {
+	BufferActivation activation;
+
+	// Prefer the entry from the view that raised the notification. A cloned
+	// buffer has the same buffer ID in both views.
+	optional<VFile*> known = root.findFileByBufferID(bufferID, view);
+	if (known) {
+		activation.binding = BufferBinding::Existing;
+		activation.file = known.value();
+		bufferStates.bind(*activation.file);
+		return activation;
+	}
+
+	if (host.positionOfBuffer(bufferID, view) == -1) {
+		return activation;
+	}
+
+	const string nppFileName = hostPathToUtf8(host.fullPathOfBuffer(bufferID));
+	VFile* vFile = nppFileName.find_first_of("/\\") != string::npos
+		? root.findFileByPath(nppFileName, view)
+		: root.findFileByName(nppFileName, view);
+	if (vFile) {
+		// Session entries are loaded before Notepad++ buffer IDs are
+		// available. Bind the existing entry instead of appending a second one.
+		vFile->bufferID = bufferID;
+		vFile->isActive = true;
+		activation.binding = BufferBinding::Bound;
+		activation.file = vFile;
+		bufferStates.bind(*vFile);
+		fileTable.refreshFile(*vFile);
+		return activation;
+	}
+
+	optional<VFile*> otherViewFile = root.findFileByBufferID(bufferID);
+	if (otherViewFile) {
+		// The same buffer has just appeared in the other view. This covers
+		// both clone and move; NPPN_FILECLOSED removes the old entry in the
+		// move case.
+		VFolder* parentFolder = root.findParentFolder(otherViewFile.value()->getOrder());
+		activation.insertAfter = otherViewFile.value()->hTreeItem;
+
+		VFile fileCopy = *otherViewFile.value();
+		fileCopy.hTreeItem = nullptr;
+		fileCopy.indexId = 0;
+		fileCopy.view = view;
+		root.orderBefore(fileCopy, root.orderAbove(otherViewFile.value()->getOrder()));
+
+		if (parentFolder) parentFolder->fileList.push_back(fileCopy);
+		else root.fileList.push_back(fileCopy);
+
+		activation.binding = BufferBinding::Cloned;
+		activation.parentFolder = parentFolder;
+		activation.file = root.findFileByBufferID(bufferID, view).value();
+		bufferStates.bind(*activation.file);	// Shares the original's record
+		fileIndex.add(*activation.file);
+		return activation;
+	}
+
+	VFile newFile;
+	newFile.bufferID = bufferID;
+	root.orderBefore(newFile, endOrder);
+	newFile.name = fileNameOfPath(nppFileName);
+	newFile.path = nppFileName;
+	newFile.view = view;
+	newFile.session = 0;
+	newFile.backupFilePath = "";
+	newFile.isActive = true;
+	root.fileList.push_back(newFile);
+
+	activation.binding = BufferBinding::Appended;
+	activation.file = &root.fileList.back();
+	bufferStates.bind(*activation.file);
+	fileIndex.add(*activation.file);
+	return activation;
+}
+
+bool removeClosedBuffer(VFolder& root, UINT_PTR bufferID, int view) {
+	bufferStates.unbind(bufferID, view);
+	optional<VFile*> vFileOpt = root.findFileByBufferID(bufferID, view);
+	if (!vFileOpt) {
+		return false;
+	}
+
+	const int order = vFileOpt.value()->getOrder();
+	fileIndex.remove(*vFileOpt.value());
+	VFolder* parentFolder = root.findParentFolder(order);
+	if (parentFolder) {
+		parentFolder->removeFile(order);
+	}
+	else {
+		root.removeFile(order);
+	}
+	return true;
+}
+
+VFile* renameBufferFile(VFolder& root, UINT_PTR bufferID, const string& fullPath) {
+	optional<VFile*> vFileOpt = root.findFileByBufferID(bufferID);
+	if (!vFileOpt) {
+		return nullptr;
+	}
+
+	VFile* vFile = vFileOpt.value();
+	vFile->name = vFile->backupFilePath.empty() ? fileNameOfPath(fullPath) : fullPath;
+	vFile->path = fullPath;
+	if (BufferState* state = bufferStates.find(bufferID)) {
+		state->path = vFile->path;
+	}
+	fileIndex.update(*vFile);
+	fileTable.refreshFile(*vFile);
+	return vFile;
+}
+
+vector<VFile*> markBufferSaved(VFolder& root, UINT_PTR bufferID, const string& fullPath) {
+	// After saving, the buffer is neither edited nor read-only, in every view.
+	const PooledPath savedPath = fullPath;
+	BufferState* state = bufferStates.find(bufferID);
+	if (state) {
+		state->path = savedPath;
+		state->isEdited = false;
+		state->isReadOnly = false;
+		state->atSavePoint = true;
+	}
+
+	const vector<VFile*> savedFiles = fileTable.withBuffer(root, bufferID);
+	for (VFile* vFile : savedFiles) {
+		vFile->path = savedPath;
+		vFile->name = fileNameOfPath(fullPath);
+		vFile->backupFilePath = "";	// Clear backup path after saving
+		vFile->setReadOnly(false);		// The fields of entries that are not bound
+		vFile->setEdited(false);
+		fileIndex.update(*vFile);
+	}
+	return savedFiles;
+}
+
+vector<VFile*> renameDirectory(VFolder& root, const string& oldDirectory, const string& newDirectory) {
+	const PooledPath from = oldDirectory;
+	const PooledPath to = newDirectory;
+	vector<VFile*> movedFiles = fileTable.under(root, from);
+	for (VFile* vFile : movedFiles) {
+		const bool namedByPath = vFile->path == vFile->name;	// As renameBufferFile() names unsaved buffers
+		vFile->path = vFile->path.rebased(from, to);
+		if (namedByPath) {
+			vFile->name = vFile->path.str();
+		}
+		if (BufferState* state = bufferStates.find(vFile->bufferID)) {
+			state->path = vFile->path;
+		}
+		fileIndex.update(*vFile);
+	}
+	if (!movedFiles.empty()) {
+		++fileStateRevision;	// The paths of the table's rows
+	}
+	return movedFiles;
+}
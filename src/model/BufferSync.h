@@ -0,0 +1,44 @@
+#pragma once
+#include "VData.h"
+#include "../Bridge/HostBridge.h"
+
+
+// Model side of the Notepad++ buffer notifications. Each function only
+// changes the VFolder tree and reports what changed; the notification
+// handlers then update the TreeView and the storage file. Kept free of Win32
+// so the same code runs in tools/HostSimulator.
+
+enum class BufferBinding {
+	Ignored,	// Buffer is not open in any view
+	Existing,	// Already known by buffer ID
+	Bound,		// Session entry matched by path or name, buffer ID attached
+	Cloned,		// Buffer appeared in the other view; entry copied next to the original
+	Appended	// New entry at the end of the root folder
+};
+
+struct BufferActivation {
+	BufferBinding binding = BufferBinding::Ignored;
+	VFile* file = nullptr;
+	VFolder* parentFolder = nullptr;		// Folder that received a cloned entry, nullptr for the root
+	HTREEITEM insertAfter = nullptr;		// Tree item of the clone source
+
+	bool modelChanged() const { return binding == BufferBinding::Cloned || binding == BufferBinding::Appended; }
+};
+
+BufferActivation bindActivatedBuffer(VFolder& root, HostBridge& host, UINT_PTR bufferID, int view);
+
+// Removes the entry of a closed buffer; the other orders stay as they are.
+bool removeClosedBuffer(VFolder& root, UINT_PTR bufferID, int view);
+
+// Applies a new path after NPPN_FILERENAMED; unsaved buffers keep the path as
+// their name. Returns the renamed entry.
+VFile* renameBufferFile(VFolder& root, UINT_PTR bufferID, const string& fullPath);
+
+// Applies the saved path to every view showing the buffer.
+vector<VFile*> markBufferSaved(VFolder& root, UINT_PTR bufferID, const string& fullPath);
+
+// Moves the entries below a directory that was renamed on disk below its new
+// path, in every view. Returns the moved entries.
+vector<VFile*> renameDirectory(VFolder& root, const string& oldDirectory, const string& newDirectory);
+
+string fileNameOfPath(const string& path);
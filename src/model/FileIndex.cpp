@@ -0,0 +1,397 @@
+#include "FileIndex.h"
+#include "FuzzyFilter.h"
+#include <functional>
+#include <iterator>
+
+
+namespace {
+
+uint32_t trigramAt(std::string_view text, size_t pos) {
+	return static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16
+		| static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8
+		| static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+void appendTrigrams(std::string_view text, vector<uint32_t>& trigrams) {
+	for (size_t pos = 0; pos + 3 <= text.size(); ++pos) {
+		trigrams.push_back(trigramAt(text, pos));
+	}
+}
+
+// Keeps the IDs that are also in list. Both are ascending; a much longer list
+// is searched, one of similar length is merged.
+void intersect(vector<uint32_t>& ids, const vector<uint32_t>& list) {
+	if (list.size() > ids.size() * 16) {
+		auto from = list.begin();
+		std::erase_if(ids, [&](uint32_t id) {
+			from = std::lower_bound(from, list.end(), id);
+			return from == list.end() || *from != id;
+		});
+		return;
+	}
+	vector<uint32_t> both;
+	both.reserve(std::min(ids.size(), list.size()));
+	std::set_intersection(ids.begin(), ids.end(), list.begin(), list.end(), std::back_inserter(both));
+	ids = std::move(both);
+}
+
+// Sorts (order, ID) keys. Orders are unique, so a radix sort on the order
+// bytes alone gives the same result as sorting whole keys; it is only worth
+// its passes and buffer for long result lists.
+void sortKeys(vector<uint64_t>& keys) {
+	if (keys.size() < 2048) {
+		std::sort(keys.begin(), keys.end());
+		return;
+	}
+	vector<uint64_t> sorted(keys.size());
+	for (int shift = 32; shift < 64; shift += 8) {
+		size_t counts[257] = {};
+		for (const uint64_t key : keys) {
+			counts[((key >> shift) & 0xFF) + 1]++;
+		}
+		for (size_t digit = 1; digit < 257; ++digit) {
+			counts[digit] += counts[digit - 1];
+		}
+		for (const uint64_t key : keys) {
+			sorted[counts[(key >> shift) & 0xFF]++] = key;
+		}
+		keys.swap(sorted);
+	}
+}
+
+}  // namespace
+
+
+void FileIndex::build(const VFolder& root) {
+	clear();
+	resolvedFor = &root;
+	resolve(root);
+}
+
+void FileIndex::clear() {
+	documents.clear();
+	texts.clear();
+	staleText = 0;
+	postings.clear();
+	ranges.clear();
+	rangeIds.clear();
+	addedSince.clear();
+	liveDocuments = 0;
+	resolvedFor = nullptr;
+}
+
+void FileIndex::add(VFile& file) {
+	if (!resolvedFor) {
+		return;		// Not built yet
+	}
+	Document document;
+	setText(document, file);
+	document.file = &file;
+	document.round = round;
+	document.live = true;
+	documents.push_back(std::move(document));
+	file.indexId = static_cast<uint32_t>(documents.size());
+	index(file.indexId);
+	addedSince.push_back(file.indexId);
+	liveDocuments++;
+}
+
+void FileIndex::remove(const VFile& file) {
+	uint32_t id = file.indexId;
+	if (id == 0 || id > documents.size() || !documents[id - 1].live) {
+		return;
+	}
+	if (documents[id - 1].file != &file && resolvedRevision != modelRevision) {
+		resolve(*resolvedFor);
+		id = file.indexId;
+	}
+	if (documents[id - 1].file != &file) {
+		return;		// A clone that shares the document of another file
+	}
+	drop(id);
+}
+
+void FileIndex::update(VFile& file) {
+	uint32_t id = file.indexId;
+	if (id == 0 || id > documents.size() || !documents[id - 1].live) {
+		add(file);
+		return;
+	}
+	if (documents[id - 1].file != &file && resolvedRevision != modelRevision) {
+		resolve(*resolvedFor);		// Gives a clone that shares the ID one of its own
+		id = file.indexId;
+	}
+	Document& document = documents[id - 1];
+	if (nameOf(document) == foldCase(file.name) && pathOf(document) == foldCase(file.path.str())) {
+		return;
+	}
+	unindex(id);
+	staleText += document.nameLength + document.pathLength;
+	setText(document, file);
+	index(id);
+}
+
+vector<VFile*> FileIndex::find(const VFolder& root, std::string_view text, size_t limit) {
+	if (resolvedFor != &root || resolvedRevision != modelRevision) {
+		resolve(root);
+	}
+	const string folded = foldCase(text);
+
+	vector<uint32_t> candidates;
+	if (folded.size() < 3) {
+		for (uint32_t id = 1; id <= documents.size(); ++id) {
+			if (documents[id - 1].live) candidates.push_back(id);
+		}
+	}
+	else {
+		vector<uint32_t> trigrams;
+		appendTrigrams(folded, trigrams);
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+		vector<const vector<uint32_t>*> lists;
+		for (const uint32_t trigram : trigrams) {
+			const auto found = postings.find(trigram);
+			if (found == postings.end()) {
+				return {};
+			}
+			lists.push_back(&found->second);
+		}
+		std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+		candidates = *lists.front();
+		for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+			intersect(candidates, *lists[i]);
+		}
+	}
+
+	// Trigrams can come from the name and the path, or be out of sequence;
+	// a single trigram is the whole query. Candidates are in ID order, which
+	// reads texts from front to back, so when all of them are wanted they are
+	// checked before sorting; with a limit only as many as it takes.
+	const bool exact = folded.size() == 3;
+	const auto matches = [&](uint32_t id) {
+		const Document& document = documents[id - 1];
+		return exact || nameOf(document).find(folded) != string::npos || pathOf(document).find(folded) != string::npos;
+	};
+	if (candidates.size() <= limit) {
+		std::erase_if(candidates, [&](uint32_t id) { return !matches(id); });
+	}
+
+	// Orders are read from the files, which moves and renumbering change
+	// without telling the index; the sign bit is flipped so negative orders
+	// come first.
+	vector<uint64_t> keys;
+	keys.reserve(candidates.size());
+	for (const uint32_t id : candidates) {
+		const VFile* file = documents[id - 1].file;
+		if (file->indexId != id) {
+			build(root);		// A fileList sorted in place got past resolve()
+			return find(root, text, limit);
+		}
+		const uint32_t order = static_cast<uint32_t>(file->getOrder()) ^ 0x80000000u;
+		keys.push_back(static_cast<uint64_t>(order) << 32 | id);
+	}
+
+	vector<VFile*> files;
+	if (keys.size() <= limit) {
+		sortKeys(keys);
+		files.reserve(keys.size());
+		for (const uint64_t key : keys) {
+			files.push_back(documents[static_cast<uint32_t>(key) - 1].file);
+		}
+		return files;
+	}
+
+	size_t batch = std::max<size_t>(limit * 2, 64);
+	for (auto from = keys.begin(); from != keys.end() && files.size() < limit; batch *= 2) {
+		const auto to = keys.end() - from > static_cast<std::ptrdiff_t>(batch) ? from + batch : keys.end();
+		if (to != keys.end()) {
+			std::nth_element(from, to, keys.end());
+		}
+		std::sort(from, to);
+		for (; from != to && files.size() < limit; ++from) {
+			const uint32_t id = static_cast<uint32_t>(*from);
+			if (matches(id)) {
+				files.push_back(documents[id - 1].file);
+			}
+		}
+	}
+	return files;
+}
+
+void FileIndex::index(uint32_t id) {
+	for (const uint32_t trigram : trigramsOf(documents[id - 1])) {
+		vector<uint32_t>& list = postings[trigram];
+		if (list.empty() || list.back() < id) {
+			list.push_back(id);		// New documents have the highest ID
+		}
+		else {
+			list.insert(std::lower_bound(list.begin(), list.end(), id), id);
+		}
+	}
+}
+
+void FileIndex::unindex(uint32_t id) {
+	for (const uint32_t trigram : trigramsOf(documents[id - 1])) {
+		const auto found = postings.find(trigram);
+		if (found == postings.end()) {
+			continue;
+		}
+		vector<uint32_t>& list = found->second;
+		const auto at = std::lower_bound(list.begin(), list.end(), id);
+		if (at != list.end() && *at == id) {
+			list.erase(at);
+		}
+		if (list.empty()) {
+			postings.erase(found);
+		}
+	}
+}
+
+void FileIndex::drop(uint32_t id) {
+	unindex(id);
+	staleText += documents[id - 1].nameLength + documents[id - 1].pathLength;
+	documents[id - 1] = Document{};
+	liveDocuments--;
+}
+
+void FileIndex::setText(Document& document, const VFile& file) {
+	const string name = foldCase(file.name);
+	const string path = foldCase(file.path.str());
+	document.textAt = texts.size();
+	document.nameLength = static_cast<uint32_t>(name.size());
+	document.pathLength = static_cast<uint32_t>(path.size());
+	texts += name;
+	texts += path;
+}
+
+// Once most of texts is left over from removed and renamed documents.
+void FileIndex::compactTexts() {
+	if (staleText < 4096 || staleText * 2 < texts.size()) {
+		return;
+	}
+	string kept;
+	kept.reserve(texts.size() - staleText);
+	for (Document& document : documents) {
+		if (document.live) {
+			const size_t textAt = kept.size();
+			kept.append(texts, document.textAt, document.nameLength + document.pathLength);
+			document.textAt = textAt;
+		}
+	}
+	texts = std::move(kept);
+	staleText = 0;
+}
+
+void FileIndex::resolve(const VFolder& root) {
+	if (resolvedFor != &root) {
+		build(root);
+		return;
+	}
+	++round;
+
+	vector<FileRange> found;
+	collectRanges(root, found);
+	const auto byAddress = [](const FileRange& a, const FileRange& b) {
+		return std::less<const VFile*>()(a.begin, b.begin);
+	};
+	std::sort(found.begin(), found.end(), byAddress);
+
+	// Lists that are as they were keep their documents.
+	vector<size_t> previous(found.size(), SIZE_MAX);
+	vector<bool> kept(ranges.size());
+	vector<const FileRange*> unchanged;
+	for (size_t i = 0; i < found.size(); ++i) {
+		FileRange& range = found[i];
+		const auto at = std::lower_bound(ranges.begin(), ranges.end(), range, byAddress);
+		if (at != ranges.end() && at->begin == range.begin && at->folder == range.folder && at->count == range.count
+			&& at->firstId == range.firstId && at->lastId == range.lastId) {
+			previous[i] = at->firstIndex;
+			kept[at - ranges.begin()] = true;
+			unchanged.push_back(&range);
+		}
+	}
+
+	vector<uint32_t> ids;
+	ids.reserve(rangeIds.size() + addedSince.size());
+	for (size_t i = 0; i < found.size(); ++i) {
+		FileRange& range = found[i];
+		const size_t firstIndex = ids.size();
+		if (previous[i] != SIZE_MAX) {
+			ids.insert(ids.end(), rangeIds.begin() + previous[i], rangeIds.begin() + previous[i] + range.count);
+		}
+		else {
+			VFile* files = const_cast<VFile*>(range.begin);
+			for (size_t j = 0; j < range.count; ++j) {
+				ids.push_back(claim(files[j], unchanged));
+			}
+			range.firstId = files[0].indexId;
+			range.lastId = files[range.count - 1].indexId;
+		}
+		range.firstIndex = firstIndex;
+	}
+
+	// Documents of changed lists, or added since, that no list has now were
+	// removed without a hook.
+	const auto dropIfGone = [this](uint32_t id) {
+		if (id <= documents.size() && documents[id - 1].live && documents[id - 1].round != round) {
+			drop(id);
+		}
+	};
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		if (!kept[i]) {
+			for (size_t j = 0; j < ranges[i].count; ++j) {
+				dropIfGone(rangeIds[ranges[i].firstIndex + j]);
+			}
+		}
+	}
+	for (const uint32_t id : addedSince) {
+		dropIfGone(id);
+	}
+
+	ranges = std::move(found);
+	rangeIds = std::move(ids);
+	addedSince.clear();
+	compactTexts();
+	resolvedRevision = modelRevision;
+}
+
+void FileIndex::collectRanges(const VFolder& folder, vector<FileRange>& found) const {
+	if (!folder.fileList.empty()) {
+		found.push_back({ &folder, folder.fileList.data(), folder.fileList.size(),
+			folder.fileList.front().indexId, folder.fileList.back().indexId, 0 });
+	}
+	for (const VFolder& subFolder : folder.folderList) {
+		collectRanges(subFolder, found);
+	}
+}
+
+// The document of a file in a changed list. A file added without a hook, or
+// a clone whose ID was taken by another file, gets a new one.
+uint32_t FileIndex::claim(VFile& file, const vector<const FileRange*>& unchanged) {
+	const uint32_t id = file.indexId;
+	const auto inUnchanged = [&](const VFile* other) {
+		const auto after = std::upper_bound(unchanged.begin(), unchanged.end(), other, [](const VFile* at, const FileRange* range) {
+			return std::less<const VFile*>()(at, range->begin);
+		});
+		return after != unchanged.begin() && std::less<const VFile*>()(other, (*std::prev(after))->begin + (*std::prev(after))->count);
+	};
+	if (id == 0 || id > documents.size() || !documents[id - 1].live || documents[id - 1].round == round
+		|| (documents[id - 1].file != &file && inUnchanged(documents[id - 1].file))) {
+		add(file);
+		return file.indexId;
+	}
+	documents[id - 1].file = &file;
+	documents[id - 1].round = round;
+	return id;
+}
+
+vector<uint32_t> FileIndex::trigramsOf(const Document& document) const {
+	vector<uint32_t> trigrams;
+	appendTrigrams(nameOf(document), trigrams);
+	appendTrigrams(pathOf(document), trigrams);
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	return trigrams;
+}
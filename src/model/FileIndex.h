@@ -0,0 +1,96 @@
+#pragma once
+#include "VData.h"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+
+// Trigram index over the names and paths of a VFolder model, for exact,
+// case-insensitive substring search. Kept free of Win32.
+//
+// Every file is a document under VFile::indexId, which copies keep, so moving
+// an entry between folders does not touch the index. Each trigram of a
+// document's folded name and path has a posting list of document IDs in
+// ascending order; a query intersects the lists of its own trigrams, shortest
+// first, and checks the remaining documents against the text. Queries under
+// three characters have no trigram and check every document.
+//
+// The first query after clear() indexes the whole model, so loading the panel
+// does not pay for it. After that add(), remove() and update() keep it
+// current; the BufferSync functions call them for opened, closed, renamed and
+// saved buffers, and a clone that shares an indexId gets one of its own.
+//
+// Each document points at its file. Moves copy the file, so when
+// modelRevision has moved on the pointers are made current again, but only
+// for folders whose fileList changed: a list that kept its address, length
+// and first and last document is passed over. That walk is over the folders,
+// not the files, and it also picks up files added or dropped without a hook.
+// A list sorted in place with the same two ends gets past it; the result
+// check sees the document of a file no longer match and indexes anew.
+//
+// Results are ordered by (order, ID) keys; with a limit only the smallest
+// keys are sorted and checked against the text, a batch at a time.
+
+class FileIndex {
+public:
+	void build(const VFolder& root);
+	void clear();
+
+	void add(VFile& file);
+	void remove(const VFile& file);
+	void update(VFile& file);			// After its name or path changed
+
+	// Files whose name or path contains the text, in model order; the first
+	// limit of them.
+	vector<VFile*> find(const VFolder& root, std::string_view text, size_t limit = SIZE_MAX);
+	size_t documentCount() const { return liveDocuments; }
+
+private:
+	// The folded name and path are in texts, one after the other, so that
+	// checking the candidates of a query reads along one string.
+	struct Document {
+		VFile* file = nullptr;				// Valid for resolvedRevision
+		size_t textAt = 0;
+		uint32_t nameLength = 0;
+		uint32_t pathLength = 0;
+		uint32_t round = 0;					// The resolve() that last found the file
+		bool live = false;
+	};
+
+	// One non-empty fileList, with the documents of its files in rangeIds.
+	struct FileRange {
+		const VFolder* folder;
+		const VFile* begin;
+		size_t count;
+		uint32_t firstId;
+		uint32_t lastId;
+		size_t firstIndex;
+	};
+
+	void index(uint32_t id);
+	void unindex(uint32_t id);
+	void drop(uint32_t id);
+	void setText(Document& document, const VFile& file);
+	void compactTexts();
+	std::string_view nameOf(const Document& document) const { return { texts.data() + document.textAt, document.nameLength }; }
+	std::string_view pathOf(const Document& document) const { return { texts.data() + document.textAt + document.nameLength, document.pathLength }; }
+	void resolve(const VFolder& root);
+	void collectRanges(const VFolder& folder, vector<FileRange>& found) const;
+	uint32_t claim(VFile& file, const vector<const FileRange*>& unchanged);
+	vector<uint32_t> trigramsOf(const Document& document) const;
+
+	vector<Document> documents;						// By indexId - 1
+	string texts;
+	size_t staleText = 0;							// Of removed and renamed documents
+	std::unordered_map<uint32_t, vector<uint32_t>> postings;
+	vector<FileRange> ranges;						// By address, for resolvedRevision
+	vector<uint32_t> rangeIds;
+	vector<uint32_t> addedSince;					// Since the last resolve()
+	uint32_t round = 0;
+	size_t liveDocuments = 0;
+	const VFolder* resolvedFor = nullptr;
+	uint64_t resolvedRevision = 0;
+};
+
+// The index of commonData.rootVFolder.
+inline FileIndex fileIndex;
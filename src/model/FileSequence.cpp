@@ -0,0 +1,147 @@
+#include "FileSequence.h"
+#include <algorithm>
+#include <functional>
+
+
+VFile* FileSequence::step(const VFolder& root, const VFile* from, bool forward, SiblingScope scope) {
+	if (builtFor != &root || builtRevision != modelRevision) {
+		build(root);
+	}
+	const size_t start = indexOf(from);
+	if (start == none) {
+		return nullptr;
+	}
+	const size_t count = entries.size();
+
+	if (scope == SiblingScope::CurrentFolder) {
+		const Entry& entry = entries[start];
+		const size_t next = forward ? entry.nextInFolder : entry.previousInFolder;
+		return next != start ? entries[next].file : nullptr;
+	}
+
+	// A file hidden in a collapsed folder steps out of the whole folder, and
+	// coming back around to it means no other file is in scope.
+	size_t index = start;
+	size_t stopFirst = start;
+	size_t stopEnd = start + 1;
+	if (scope == SiblingScope::VisibleFiles) {
+		if (const size_t collapsed = outermostCollapsed(start); collapsed != none) {
+			stopFirst = folders[collapsed].firstFile;
+			stopEnd = folders[collapsed].endFile;
+			index = forward ? stopEnd - 1 : stopFirst;
+		}
+	}
+	for (size_t visited = 0; visited < count; ++visited) {
+		index = forward ? (index + 1) % count : (index + count - 1) % count;
+		if (index >= stopFirst && index < stopEnd) {
+			return nullptr;
+		}
+		if (scope == SiblingScope::AllFiles) {
+			return entries[index].file;
+		}
+
+		// Land behind, or in front of, the whole collapsed folder.
+		const size_t collapsed = outermostCollapsed(index);
+		if (collapsed == none) {
+			return entries[index].file;
+		}
+		index = forward ? folders[collapsed].endFile - 1 : folders[collapsed].firstFile;
+	}
+	return nullptr;
+}
+
+void FileSequence::clear() {
+	entries.clear();
+	folders.clear();
+	fileRanges.clear();
+	entryOfSlot.clear();
+	builtFor = nullptr;
+}
+
+void FileSequence::build(const VFolder& root) {
+	clear();
+	append(root, none);
+	std::sort(fileRanges.begin(), fileRanges.end(), [](const FileRange& a, const FileRange& b) {
+		return std::less<const VFile*>()(a.begin, b.begin);
+	});
+
+	builtFor = &root;
+	builtRevision = modelRevision;
+}
+
+void FileSequence::append(const VFolder& folder, size_t folderIndex) {
+	// Children as (order, position), files before folders in position.
+	const size_t fileCount = folder.fileList.size();
+	vector<std::pair<int, size_t>> children;
+	children.reserve(fileCount + folder.folderList.size());
+	for (size_t i = 0; i < fileCount; ++i) children.emplace_back(folder.fileList[i].getOrder(), i);
+	for (size_t i = 0; i < folder.folderList.size(); ++i) children.emplace_back(folder.folderList[i].getOrder(), fileCount + i);
+	std::sort(children.begin(), children.end());
+
+	const size_t firstSlot = entryOfSlot.size();
+	if (fileCount > 0) {
+		fileRanges.push_back({ folder.fileList.data(), fileCount, firstSlot });
+		entryOfSlot.resize(firstSlot + fileCount);
+	}
+
+	// The folder's own files are linked in a ring as they are appended.
+	size_t firstInFolder = none;
+	size_t lastInFolder = none;
+	for (const auto& [order, position] : children) {
+		if (position < fileCount) {
+			const size_t index = entries.size();
+			entryOfSlot[firstSlot + position] = index;
+			Entry entry;
+			entry.file = const_cast<VFile*>(&folder.fileList[position]);
+			entry.folder = folderIndex;
+			if (lastInFolder == none) {
+				firstInFolder = index;
+			}
+			else {
+				entries[lastInFolder].nextInFolder = index;
+				entry.previousInFolder = lastInFolder;
+			}
+			lastInFolder = index;
+			entries.push_back(entry);
+			continue;
+		}
+
+		const size_t subFolderIndex = folders.size();
+		Folder subFolder;
+		subFolder.folder = &folder.folderList[position - fileCount];
+		subFolder.parent = folderIndex;
+		subFolder.firstFile = entries.size();
+		folders.push_back(subFolder);
+		append(*subFolder.folder, subFolderIndex);
+		folders[subFolderIndex].endFile = entries.size();
+	}
+	if (firstInFolder != none) {
+		entries[lastInFolder].nextInFolder = firstInFolder;
+		entries[firstInFolder].previousInFolder = lastInFolder;
+	}
+}
+
+size_t FileSequence::indexOf(const VFile* file) const {
+	// The last range starting at or before the file.
+	auto range = std::upper_bound(fileRanges.begin(), fileRanges.end(), file, [](const VFile* file, const FileRange& range) {
+		return std::less<const VFile*>()(file, range.begin);
+	});
+	if (range == fileRanges.begin()) {
+		return none;
+	}
+	--range;
+	if (!std::less<const VFile*>()(file, range->begin + range->count)) {
+		return none;
+	}
+	return entryOfSlot[range->firstSlot + static_cast<size_t>(file - range->begin)];
+}
+
+size_t FileSequence::outermostCollapsed(size_t entry) const {
+	size_t collapsed = none;
+	for (size_t folder = entries[entry].folder; folder != none; folder = folders[folder].parent) {
+		if (!folders[folder].folder->isExpanded) {
+			collapsed = folder;
+		}
+	}
+	return collapsed;
+}
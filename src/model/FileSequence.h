@@ -0,0 +1,75 @@
+#pragma once
+#include "VData.h"
+#include <cstdint>
+
+
+// Which files Ctrl+PgUp/PgDn steps through.
+enum class SiblingScope {
+	AllFiles,
+	VisibleFiles,		// Skips files inside collapsed folders
+	CurrentFolder		// Files directly in the same folder
+};
+
+// Files of a VFolder model in display order, linked to their neighbours so
+// stepping to the next or previous file is O(1). Files live by value in
+// their folder's fileList and move whenever a vector does, so the links are
+// kept here rather than in the nodes: the sequence is rebuilt in O(n) when
+// modelRevision has moved on and is reused for every step after that. It is
+// not patched from the edit hooks, since an insert into a fileList moves the
+// files behind it and every pointer to them would have to be found again.
+// The rebuild is a few flat vectors instead: a file is found from its address
+// through the address range of its folder's fileList.
+// VisibleFiles reads VFolder::isExpanded when stepping and jumps over a
+// collapsed folder's files at once, the one holding the current file too, so
+// expanding needs no rebuild and a step visits one entry per folder skipped.
+//
+// Only the first step after a change pays for the rebuild. A sequence holds
+// pointers into the model it was built for; fileSequence is the one of
+// commonData.rootVFolder, cleared with the other caches when it is loaded.
+
+class FileSequence {
+public:
+	// The file before or after `from`, wrapping around. nullptr if `from` is
+	// not in the model or no other file is in scope.
+	VFile* step(const VFolder& root, const VFile* from, bool forward, SiblingScope scope);
+	void clear();
+
+private:
+	static constexpr size_t none = SIZE_MAX;
+
+	struct Entry {
+		VFile* file = nullptr;
+		size_t folder = none;			// Index into folders, none at the top level
+		size_t previousInFolder = 0;
+		size_t nextInFolder = 0;
+	};
+
+	struct Folder {
+		const VFolder* folder = nullptr;
+		size_t parent = none;
+		size_t firstFile = 0;			// Files of the folder and its subfolders
+		size_t endFile = 0;
+	};
+
+	// A folder's fileList; the entries of its files are at firstSlot on in
+	// entryOfSlot, in fileList order.
+	struct FileRange {
+		const VFile* begin = nullptr;
+		size_t count = 0;
+		size_t firstSlot = 0;
+	};
+
+	void build(const VFolder& root);
+	void append(const VFolder& folder, size_t folderIndex);
+	size_t indexOf(const VFile* file) const;
+	size_t outermostCollapsed(size_t entry) const;
+
+	vector<Entry> entries;
+	vector<Folder> folders;
+	vector<FileRange> fileRanges;		// By address
+	vector<size_t> entryOfSlot;
+	const VFolder* builtFor = nullptr;
+	uint64_t builtRevision = 0;
+};
+
+inline FileSequence fileSequence;
@@ -0,0 +1,247 @@
+#include "FileTable.h"
+#include "BufferStates.h"
+#include <algorithm>
+#include <bit>
+
+
+vector<VFile*> FileTable::select(const VFolder& root, unsigned states, unsigned without, const VFolder* folder) {
+	update(root);
+	vector<VFile*> selected;
+	size_t firstWord = 0;
+	if (!match(states, without, folder, firstWord)) {
+		return selected;
+	}
+	for (size_t word = 0; word < matches.size(); ++word) {
+		for (uint64_t rows = matches[word]; rows; rows &= rows - 1) {
+			selected.push_back(files[(firstWord + word) * 64 + std::countr_zero(rows)]);
+		}
+	}
+	return selected;
+}
+
+size_t FileTable::count(const VFolder& root, unsigned states, unsigned without, const VFolder* folder) {
+	update(root);
+	size_t firstWord = 0;
+	if (!match(states, without, folder, firstWord)) {
+		return 0;
+	}
+	size_t count = 0;
+	for (const uint64_t rows : matches) {
+		count += std::popcount(rows);
+	}
+	return count;
+}
+
+vector<VFile*> FileTable::withBuffer(const VFolder& root, UINT_PTR bufferID) {
+	update(root);
+	vector<VFile*> entries;
+	forEachRowOf(bufferID, [&](size_t row) { entries.push_back(files[row]); });
+	return entries;
+}
+
+vector<VFile*> FileTable::under(const VFolder& root, const PooledPath& directory) {
+	update(root);
+	if (paths.size() != files.size()) {
+		paths.resize(files.size());
+		for (size_t row = 0; row < files.size(); ++row) {
+			readPath(row);
+		}
+	}
+	vector<uint32_t> rows;
+	for (const PooledPath& path : directory.pathsBelow()) {
+		const auto found = rowsByPath.find(path);
+		if (found != rowsByPath.end()) {
+			rows.insert(rows.end(), found->second.begin(), found->second.end());
+		}
+	}
+	std::sort(rows.begin(), rows.end());
+	vector<VFile*> entries;
+	entries.reserve(rows.size());
+	for (const uint32_t row : rows) {
+		entries.push_back(files[row]);
+	}
+	return entries;
+}
+
+void FileTable::refreshBuffer(UINT_PTR bufferID) {
+	// A table that is out of date reads every row on the next query anyway.
+	if (!builtFor || !isBuiltFor(*builtFor) || readStateRevision != fileStateRevision) {
+		return;
+	}
+	forEachRowOf(bufferID, [this](size_t row) { readRow(row); });
+}
+
+void FileTable::refreshFile(const VFile& file) {
+	if (!builtFor || !isBuiltFor(*builtFor) || readStateRevision != fileStateRevision) {
+		return;
+	}
+	const auto row = std::find(files.begin(), files.end(), &file);
+	if (row != files.end()) {
+		readRow(row - files.begin());
+	}
+}
+
+void FileTable::clear() {
+	files.clear();
+	bufferIDs.clear();
+	paths.clear();
+	rowsByPath.clear();
+	for (vector<uint64_t>& column : bits) {
+		column.clear();
+	}
+	folderRows.clear();
+	builtFor = nullptr;
+}
+
+void FileTable::update(const VFolder& root) {
+	if (builtFor != &root || builtRevision != modelRevision) {
+		clear();
+		append(root);
+		bufferIDs.resize(files.size());
+		for (vector<uint64_t>& column : bits) {
+			column.assign((files.size() + 63) / 64, 0);
+		}
+		builtFor = &root;
+		builtRevision = modelRevision;
+		readStateRevision = fileStateRevision + 1;
+	}
+	if (readStateRevision != fileStateRevision) {
+		// The paths are taken again by the next under().
+		paths.clear();
+		rowsByPath.clear();
+		for (size_t row = 0; row < files.size(); ++row) {
+			readRow(row);
+		}
+		readStateRevision = fileStateRevision;
+	}
+}
+
+void FileTable::append(const VFolder& folder) {
+	const uint32_t first = static_cast<uint32_t>(files.size());
+	for (const VFile& file : folder.fileList) {
+		files.push_back(const_cast<VFile*>(&file));
+	}
+	for (const VFolder& subFolder : folder.folderList) {
+		append(subFolder);
+	}
+	folderRows[&folder] = { first, static_cast<uint32_t>(files.size()) };
+}
+
+void FileTable::readRow(size_t row) {
+	const VFile& file = *files[row];
+	bufferIDs[row] = file.bufferID;
+	// The accessors of VFile, with the buffer's record looked up once.
+	const BufferState* record = file.sharesBufferState ? bufferStates.find(file.bufferID) : nullptr;
+	const bool unsaved = record ? record->hasUnsavedChanges() : file.hasUnsavedChanges();
+	const bool readOnly = record ? record->isReadOnly : file.readOnly();
+	const unsigned states = (unsaved ? unsigned{ Unsaved } : 0u) | (readOnly ? unsigned{ ReadOnly } : 0u)
+		| (file.isActive ? unsigned{ Active } : 0u) | (file.view == 0 ? unsigned{ MainView } : unsigned{ SubView });
+	const uint64_t bit = uint64_t{ 1 } << (row % 64);
+	for (size_t state = 0; state < stateCount; ++state) {
+		uint64_t& word = bits[state][row / 64];
+		word = states & (1u << state) ? word | bit : word & ~bit;
+	}
+	if (!paths.empty()) {
+		readPath(row);
+	}
+}
+
+void FileTable::readPath(size_t row) {
+	const PooledPath& path = files[row]->path;
+	if (paths[row] == path) {
+		return;
+	}
+	if (!paths[row].empty()) {
+		vector<uint32_t>& rows = rowsByPath[paths[row]];
+		rows.erase(std::find(rows.begin(), rows.end(), static_cast<uint32_t>(row)));
+		if (rows.empty()) {
+			rowsByPath.erase(paths[row]);
+		}
+	}
+	paths[row] = path;
+	if (!path.empty()) {
+		rowsByPath[path].push_back(static_cast<uint32_t>(row));
+	}
+}
+
+bool FileTable::match(unsigned states, unsigned without, const VFolder* folder, size_t& firstWord) {
+	size_t first = 0;
+	size_t end = files.size();
+	if (folder && folder != builtFor) {
+		const auto found = folderRows.find(folder);
+		if (found == folderRows.end()) {
+			return false;
+		}
+		first = found->second.first;
+		end = found->second.second;
+	}
+	if (first == end) {
+		return false;
+	}
+
+	// One bitset at a time, so each pass is a loop over two word arrays.
+	firstWord = first / 64;
+	matches.assign((end + 63) / 64 - firstWord, ~uint64_t{ 0 });
+	uint64_t* const words = matches.data();
+	const size_t wordCount = matches.size();
+	for (size_t state = 0; state < stateCount; ++state) {
+		const uint64_t* const column = bits[state].data() + firstWord;
+		if (states & (1u << state)) {
+			for (size_t word = 0; word < wordCount; ++word) words[word] &= column[word];
+		}
+		else if (without & (1u << state)) {
+			for (size_t word = 0; word < wordCount; ++word) words[word] &= ~column[word];
+		}
+	}
+	// The rows of the first and last word that are not the folder's.
+	words[0] &= ~uint64_t{ 0 } << (first % 64);
+	if (end % 64) {
+		words[wordCount - 1] &= ~uint64_t{ 0 } >> (64 - end % 64);
+	}
+	return true;
+}
+
+template <typename Visit>
+void FileTable::forEachRowOf(UINT_PTR bufferID, Visit visit) const {
+	// A branch-free compare over each block of rows finds the blocks to look into.
+	const UINT_PTR* const ids = bufferIDs.data();
+	const size_t rows = bufferIDs.size();
+	for (size_t start = 0; start < rows; start += 64) {
+		const size_t end = std::min(start + 64, rows);
+		bool found = false;
+		for (size_t row = start; row < end; ++row) {
+			found |= ids[row] == bufferID;
+		}
+		if (!found) {
+			continue;
+		}
+		for (size_t row = start; row < end; ++row) {
+			if (ids[row] == bufferID) visit(row);
+		}
+	}
+}
+
+
+void markActiveFile(VFolder& root, UINT_PTR bufferID, int view) {
+	// While files are being opened each one changes the model, and a walk is
+	// cheaper than taking the rows again for every file. The table is built
+	// once the model stays the same from one activation to the next.
+	static uint64_t revisionAtLastCall = 0;
+	const bool modelSettled = revisionAtLastCall == modelRevision;
+	revisionAtLastCall = modelRevision;
+	if (!fileTable.isBuiltFor(root) && !modelSettled) {
+		for (VFile* file : root.getAllFiles()) {
+			file->isActive = file->bufferID == bufferID && file->view == view;
+		}
+		return;
+	}
+	// Only the entries that were active and the buffer's own can change.
+	for (VFile* file : fileTable.select(root, FileTable::Active)) {
+		file->isActive = false;
+		fileTable.refreshBuffer(file->bufferID);
+	}
+	for (VFile* file : fileTable.withBuffer(root, bufferID)) {
+		file->isActive = file->view == view;
+	}
+	fileTable.refreshBuffer(bufferID);
+}
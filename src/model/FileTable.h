@@ -0,0 +1,89 @@
+#pragma once
+#include "VData.h"
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+
+// The files of a VFolder model as columns, for finding them by state: which
+// have unsaved changes, are read-only or active, are in a view, or show a
+// buffer. Kept free of Win32.
+//
+// Row i is the i-th file of getAllFiles(), so the files below a folder are
+// one run of rows. Buffer IDs are a column of their own and each state is a
+// bitset with a bit per row. A query ANDs the words of the bitsets it asks
+// for, one bitset at a time, over the rows of a folder; a buffer is found by
+// comparing its ID with the column 64 rows at a time. Both are plain loops
+// over contiguous arrays that the compiler vectorizes, and no VFile is read
+// until the matching rows are turned into pointers.
+//
+// Paths are a column too, taken on the first under() after the rows were, and
+// the rows of each path are kept in a map. under() lists the paths below the
+// directory from the path trie and looks up their rows, so it costs as much
+// as the part of the trie below the directory rather than the whole model.
+//
+// The rows are taken again in one walk when modelRevision has moved on. The
+// states of a buffer's rows are read again through refreshBuffer(), which
+// the VFile setters, the buffer table and markBufferSaved() call, and for a
+// file that was given a buffer or a path through refreshFile(). The setters
+// of a file bound to no buffer bump fileStateRevision instead. Code that
+// sets buffer IDs, paths or the active flag of many files directly bumps
+// fileStateRevision, and the next query reads every row again.
+
+inline uint64_t fileStateRevision = 0;
+
+class FileTable {
+public:
+	// States a query asks for, combined with |.
+	enum State : unsigned {
+		Unsaved = 1 << 0,		// VFile::hasUnsavedChanges()
+		ReadOnly = 1 << 1,
+		Active = 1 << 2,
+		MainView = 1 << 3,
+		SubView = 1 << 4
+	};
+
+	// Files with all of the states and none of without, below folder (the
+	// whole model if it is null), in getAllFiles() order.
+	vector<VFile*> select(const VFolder& root, unsigned states, unsigned without = 0, const VFolder* folder = nullptr);
+	size_t count(const VFolder& root, unsigned states, unsigned without = 0, const VFolder* folder = nullptr);
+	// The entries of a buffer, one per view showing it.
+	vector<VFile*> withBuffer(const VFolder& root, UINT_PTR bufferID);
+	// Files whose path is below directory on disk, in getAllFiles() order.
+	vector<VFile*> under(const VFolder& root, const PooledPath& directory);
+
+	void refreshBuffer(UINT_PTR bufferID);	// After the state of its entries changed
+	void refreshFile(const VFile& file);	// After its buffer ID or path changed
+	bool isBuiltFor(const VFolder& root) const { return builtFor == &root && builtRevision == modelRevision; }
+	void clear();
+	size_t rowCount() const { return files.size(); }
+
+private:
+	static constexpr size_t stateCount = 5;
+
+	void update(const VFolder& root);
+	void append(const VFolder& folder);
+	void readRow(size_t row);
+	void readPath(size_t row);
+	// Sets matches to the words of the rows of folder that have the states.
+	bool match(unsigned states, unsigned without, const VFolder* folder, size_t& firstWord);
+	template <typename Visit> void forEachRowOf(UINT_PTR bufferID, Visit visit) const;
+
+	vector<VFile*> files;
+	vector<UINT_PTR> bufferIDs;
+	vector<PooledPath> paths;				// Empty until the first under()
+	std::unordered_map<PooledPath, vector<uint32_t>> rowsByPath;
+	vector<uint64_t> bits[stateCount];		// Row r is bit r % 64 of word r / 64
+	vector<uint64_t> matches;				// Scratch for match()
+	std::unordered_map<const VFolder*, std::pair<uint32_t, uint32_t>> folderRows;	// First and end row
+	const VFolder* builtFor = nullptr;
+	uint64_t builtRevision = 0;
+	uint64_t readStateRevision = 0;
+};
+
+// The entry of the buffer in the view becomes the active file; every other
+// entry stops being it.
+void markActiveFile(VFolder& root, UINT_PTR bufferID, int view);
+
+// The table of commonData.rootVFolder.
+inline FileTable fileTable;
@@ -0,0 +1,244 @@
+#include "FuzzyFilter.h"
+#include "FileIndex.h"
+#include <algorithm>
+
+
+namespace {
+
+bool startsWord(std::string_view text, size_t pos) {
+	if (pos == 0) {
+		return true;
+	}
+	switch (text[pos - 1]) {
+	case '/': case '\\': case '.': case '_': case '-': case ' ':
+		return true;
+	default:
+		return false;
+	}
+}
+
+}  // namespace
+
+
+int fuzzyScore(std::string_view query, std::string_view text) {
+	int score = 0;
+	size_t pos = 0;
+	size_t previous = std::string_view::npos;
+	for (const char c : query) {
+		const size_t found = text.find(c, pos);
+		if (found == std::string_view::npos) {
+			return -1;
+		}
+		score += 1;
+		if (previous != std::string_view::npos && found == previous + 1) {
+			score += 4;
+		}
+		else if (previous != std::string_view::npos) {
+			score -= static_cast<int>(std::min<size_t>(found - previous - 1, 3));
+		}
+		if (startsWord(text, found)) {
+			score += 3;
+		}
+		previous = found;
+		pos = found + 1;
+	}
+	return std::max(score, 0);
+}
+
+string foldCase(std::string_view text) {
+	string folded(text);
+	for (char& c : folded) {
+		if (c >= 'A' && c <= 'Z') {
+			c = static_cast<char>(c - 'A' + 'a');
+		}
+	}
+	return folded;
+}
+
+size_t FuzzyFilter::setQuery(const VFolder& root, const string& query) {
+	size_t scored = 0;
+	if (builtFor != &root || builtRevision != modelRevision) {
+		build(root);
+		levels.clear();
+	}
+	typed = query;
+	const string folded = foldCase(query);
+
+	if (folded.starts_with('"')) {
+		levels.clear();
+		scored = exactMatches(root, folded);
+		markShown();
+		return scored;
+	}
+
+	while (!levels.empty() && !folded.starts_with(levels.back().query)) {
+		levels.pop_back();
+	}
+	if (!folded.empty() && (levels.empty() || levels.back().query != folded)) {
+		scored = narrow(folded);
+	}
+	markShown();
+	return scored;
+}
+
+size_t FuzzyFilter::refresh(const VFolder& root) {
+	if (!active() || (builtFor == &root && builtRevision == modelRevision)) {
+		return 0;
+	}
+	return setQuery(root, typed);
+}
+
+void FuzzyFilter::clear() {
+	candidates.clear();
+	text.clear();
+	folders.clear();
+	folderParents.clear();
+	indexOf.clear();
+	levels.clear();
+	shown.clear();
+	typed.clear();
+	builtFor = nullptr;
+}
+
+const string& FuzzyFilter::query() const {
+	return typed;
+}
+
+size_t FuzzyFilter::matchCount() const {
+	return levels.empty() ? 0 : levels.back().matches.size();
+}
+
+VFile* FuzzyFilter::bestMatch() const {
+	if (levels.empty()) {
+		return nullptr;
+	}
+	const Match* best = nullptr;
+	for (const Match& match : levels.back().matches) {
+		if (!best || match.score > best->score) {
+			best = &match;
+		}
+	}
+	return best ? candidates[best->candidate].file : nullptr;
+}
+
+bool FuzzyFilter::shows(const VBase* entry) const {
+	if (!active()) {
+		return true;
+	}
+	const auto found = indexOf.find(entry);
+	return found != indexOf.end() && shown[found->second];
+}
+
+void FuzzyFilter::build(const VFolder& root) {
+	candidates.clear();
+	text.clear();
+	folders.clear();
+	folderParents.clear();
+	indexOf.clear();
+	append(root, none);
+	text = foldCase(text);
+
+	// Folder indices follow the candidates in indexOf and shown.
+	for (size_t i = 0; i < folders.size(); ++i) {
+		indexOf[folders[i]] = candidates.size() + i;
+	}
+	builtFor = &root;
+	builtRevision = modelRevision;
+}
+
+void FuzzyFilter::append(const VFolder& folder, size_t folderIndex) {
+	vector<const VBase*> children;
+	children.reserve(folder.fileList.size() + folder.folderList.size());
+	for (const VFile& file : folder.fileList) children.push_back(&file);
+	for (const VFolder& subFolder : folder.folderList) children.push_back(&subFolder);
+	std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) {
+		return a->getOrder() < b->getOrder();
+	});
+
+	for (const VBase* child : children) {
+		if (const VFile* file = dynamic_cast<const VFile*>(child)) {
+			indexOf[file] = candidates.size();
+			Candidate candidate;
+			candidate.file = const_cast<VFile*>(file);
+			candidate.folder = folderIndex;
+			candidate.name = static_cast<uint32_t>(text.size());
+			candidate.nameLength = static_cast<uint32_t>(file->name.size());
+			text += file->name;
+			candidate.path = static_cast<uint32_t>(text.size());
+			candidate.pathLength = static_cast<uint32_t>(file->path.size());
+			text += file->path;
+			candidates.push_back(candidate);
+			continue;
+		}
+
+		const size_t subFolderIndex = folders.size();
+		folders.push_back(static_cast<const VFolder*>(child));
+		folderParents.push_back(folderIndex);
+		append(*static_cast<const VFolder*>(child), subFolderIndex);
+	}
+}
+
+size_t FuzzyFilter::narrow(const string& folded) {
+	// Only the matches of the longest prefix still typed can match.
+	vector<Match> previous;
+	if (levels.empty()) {
+		previous.resize(candidates.size());
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			previous[i].candidate = static_cast<uint32_t>(i);
+		}
+	}
+	const vector<Match>& from = levels.empty() ? previous : levels.back().matches;
+
+	Level level;
+	level.query = folded;
+	for (const Match& match : from) {
+		const Candidate& candidate = candidates[match.candidate];
+		// A hit in the name outranks any hit that needs the directories.
+		const std::string_view all(text);
+		const int nameScore = fuzzyScore(folded, all.substr(candidate.name, candidate.nameLength));
+		const int score = nameScore >= 0 ? nameScore + 1000
+			: fuzzyScore(folded, all.substr(candidate.path, candidate.pathLength));
+		if (score >= 0) {
+			level.matches.push_back({ match.candidate, score });
+		}
+	}
+	const size_t scored = from.size();
+	levels.push_back(std::move(level));
+	return scored;
+}
+
+size_t FuzzyFilter::exactMatches(const VFolder& root, const string& folded) {
+	std::string_view text(folded);
+	text.remove_prefix(1);
+	if (text.ends_with('"')) {
+		text.remove_suffix(1);
+	}
+
+	Level level;
+	level.query = folded;
+	for (const VFile* file : fileIndex.find(root, text)) {
+		const auto found = indexOf.find(file);
+		if (found != indexOf.end()) {
+			level.matches.push_back({ static_cast<uint32_t>(found->second), 0 });
+		}
+	}
+	const size_t matched = level.matches.size();
+	levels.push_back(std::move(level));
+	return matched;
+}
+
+void FuzzyFilter::markShown() {
+	shown.assign(candidates.size() + folderParents.size(), false);
+	if (levels.empty()) {
+		return;
+	}
+	for (const Match& match : levels.back().matches) {
+		shown[match.candidate] = true;
+		for (size_t folder = candidates[match.candidate].folder; folder != none; folder = folderParents[folder]) {
+			if (shown[candidates.size() + folder]) {
+				break;	// Marked by an earlier match, and so are the folders above it
+			}
+			shown[candidates.size() + folder] = true;
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "VData.h"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+
+// How well a query matches a text as a subsequence, or -1 if it does not.
+// Both must be lowercase already. Consecutive characters and characters that
+// start a word (after / \ . _ - or a space) score higher, gaps score lower.
+int fuzzyScore(std::string_view query, std::string_view text);
+string foldCase(std::string_view text);	// ASCII only; other UTF-8 bytes stay as they are
+
+// Narrows a VFolder model to the files whose name or path fuzzy-matches a
+// query, together with the folders above them. Kept free of Win32.
+//
+// A query that extends the previous one can only match fewer files, so each
+// keystroke rescores the previous matches instead of the whole model. The
+// matches of every prefix typed so far stay on a stack, and deleting
+// characters pops back to them without scoring anything. The candidates hold
+// pointers into the model and are rebuilt, with the query run again from
+// scratch, when modelRevision has moved on.
+//
+// A query that starts with a double quote is an exact substring instead,
+// answered by fileIndex; a closing quote is optional.
+
+class FuzzyFilter {
+public:
+	// Returns how many files were scored, or found by fileIndex, to answer it.
+	size_t setQuery(const VFolder& root, const string& query);
+	size_t refresh(const VFolder& root);	// Runs the query again if the model changed
+	void clear();
+
+	bool active() const { return !levels.empty(); }
+	const string& query() const;
+	size_t matchCount() const;
+	VFile* bestMatch() const;				// First of the highest scores, nullptr if none
+
+	// Matching files and the folders above them. Everything while inactive.
+	bool shows(const VBase* entry) const;
+
+private:
+	static constexpr size_t none = SIZE_MAX;
+
+	struct Candidate {
+		VFile* file = nullptr;
+		size_t folder = none;				// Index into folderParents, none at the top level
+		uint32_t name = 0;					// Folded name and path, as offsets into text
+		uint32_t nameLength = 0;
+		uint32_t path = 0;
+		uint32_t pathLength = 0;
+	};
+
+	struct Match {
+		uint32_t candidate = 0;
+		int score = 0;
+	};
+
+	struct Level {
+		string query;						// Folded
+		vector<Match> matches;				// In model order
+	};
+
+	void build(const VFolder& root);
+	void append(const VFolder& folder, size_t folderIndex);
+	size_t narrow(const string& folded);
+	size_t exactMatches(const VFolder& root, const string& folded);
+	void markShown();
+
+	vector<Candidate> candidates;
+	string text;										// Folded names and paths, back to back
+	vector<const VFolder*> folders;						// In model order
+	vector<size_t> folderParents;
+	std::unordered_map<const VBase*, size_t> indexOf;	// Folders are offset by candidates.size()
+	vector<Level> levels;								// One per prefix of the query
+	vector<bool> shown;									// Candidates, then folders
+	string typed;										// As given, for query()
+	const VFolder* builtFor = nullptr;
+	uint64_t builtRevision = 0;
+};
@@ -0,0 +1,124 @@
+#include "ModelSnapshot.h"
+
+
+namespace {
+
+bool sameFile(const VFile& a, const VFile& b) {
+	return a.getOrder() == b.getOrder() && a.name == b.name && a.path == b.path && a.view == b.view
+		&& a.session == b.session && a.backupFilePath == b.backupFilePath && a.bufferID == b.bufferID
+		&& a.isActive == b.isActive && a.edited() == b.edited() && a.readOnly() == b.readOnly();
+}
+
+bool sameHeader(const VFolder& folder, const SnapshotFolder& node) {
+	return folder.getOrder() == node.order && folder.name == node.name && folder.path == node.path
+		&& folder.isExpanded == node.isExpanded;
+}
+
+void appendFiles(const SnapshotFolder& folder, vector<const VFile*>& files) {
+	for (const auto& file : folder.files) files.push_back(file.get());
+	for (const auto& subFolder : folder.folders) appendFiles(*subFolder, files);
+}
+
+}  // namespace
+
+
+void to_json(json& j, const SnapshotFolder& folder) {
+	json files = json::array();
+	for (const auto& file : folder.files) files.push_back(*file);
+	json folders = json::array();
+	for (const auto& subFolder : folder.folders) folders.push_back(*subFolder);
+	j = json{
+		{"order", folder.order},
+		{"name", folder.name},
+		{"path", folder.path},
+		{"isExpanded", folder.isExpanded},
+		{"folderList", std::move(folders)},
+		{"fileList", std::move(files)}
+	};
+}
+
+vector<const VFile*> ModelSnapshot::allFiles() const {
+	vector<const VFile*> files;
+	appendFiles(*top, files);
+	return files;
+}
+
+VFolder ModelSnapshot::toVFolder() const {
+	// from_json sets the orders without touching modelRevision or the tree.
+	return json(*top).get<VFolder>();
+}
+
+std::shared_ptr<const ModelSnapshot> SnapshotPublisher::publish(const VFolder& root) {
+	stats = {};
+	const std::shared_ptr<const ModelSnapshot> last = published.load();
+	std::shared_ptr<const SnapshotFolder> top = last ? share(root, &last->top) : share(root, nullptr);
+	if (last && top == last->top) {
+		return last;
+	}
+	auto snapshot = std::make_shared<const ModelSnapshot>(std::move(top), ++sequence);
+	published.store(snapshot);
+	return snapshot;
+}
+
+std::shared_ptr<const SnapshotFolder> SnapshotPublisher::share(const VFolder& folder, const std::shared_ptr<const SnapshotFolder>* previous) {
+	const SnapshotFolder* before = previous ? previous->get() : nullptr;
+	bool changed = !before || !sameHeader(folder, *before)
+		|| before->files.size() != folder.fileList.size() || before->folders.size() != folder.folderList.size();
+
+	vector<std::shared_ptr<const VFile>> files;
+	files.reserve(folder.fileList.size());
+	for (size_t i = 0; i < folder.fileList.size(); ++i) {
+		files.push_back(share(folder.fileList[i], before ? &before->files : nullptr, i));
+		changed = changed || files.back() != before->files[i];
+	}
+
+	// Subfolders are matched by position, then by name, so that one inserted
+	// or removed folder does not make copies of all that follow it; a renamed
+	// folder is still matched by its position and keeps its files.
+	vector<std::shared_ptr<const SnapshotFolder>> folders;
+	folders.reserve(folder.folderList.size());
+	for (size_t i = 0; i < folder.folderList.size(); ++i) {
+		const VFolder& subFolder = folder.folderList[i];
+		const std::shared_ptr<const SnapshotFolder>* match = nullptr;
+		if (before && i < before->folders.size() && before->folders[i]->name == subFolder.name) {
+			match = &before->folders[i];
+		}
+		else if (before) {
+			for (const auto& candidate : before->folders) {
+				if (candidate->name == subFolder.name) {
+					match = &candidate;
+					break;
+				}
+			}
+			if (!match && i < before->folders.size()) {
+				match = &before->folders[i];
+			}
+		}
+		folders.push_back(share(subFolder, match));
+		changed = changed || folders.back() != before->folders[i];
+	}
+
+	if (!changed) {
+		stats.reused++;
+		return *previous;
+	}
+	auto node = std::make_shared<SnapshotFolder>();
+	node->order = folder.getOrder();
+	node->name = folder.name;
+	node->path = folder.path;
+	node->isExpanded = folder.isExpanded;
+	node->files = std::move(files);
+	node->folders = std::move(folders);
+	stats.created++;
+	return node;
+}
+
+std::shared_ptr<const VFile> SnapshotPublisher::share(const VFile& file, const vector<std::shared_ptr<const VFile>>* previous, size_t index) {
+	if (previous && index < previous->size() && sameFile(file, *(*previous)[index])) {
+		stats.reused++;
+		return (*previous)[index];
+	}
+	auto copy = std::make_shared<VFile>(file.detached());
+	stats.created++;
+	return copy;
+}
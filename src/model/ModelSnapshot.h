@@ -0,0 +1,77 @@
+#pragma once
+#include "VData.h"
+#include <atomic>
+#include <memory>
+
+
+// Immutable copies of a VFolder model for code that reads it on another
+// thread while the UI thread goes on changing it. Kept free of Win32.
+//
+// A snapshot is a tree of immutable nodes held by shared pointers, and a new
+// snapshot shares every node of the previous one whose contents are still
+// the same. publish() walks the model next to the last snapshot and allocates
+// only the files that changed and the folders above them, up to the root; a
+// model that did not change at all gives back the same root. Orders are part
+// of a node, but an edit sets only the orders of the entries it places, so
+// adding, removing or moving an entry copies the paths to the places it left
+// and went to, as a rename, a save or a state change copies its own path;
+// only spreading the orders copies everything. Readers get the last published snapshot with a single atomic
+// load and keep it alive for as long as they hold it, so they never wait for
+// the UI thread and it never waits for them.
+//
+// Copies of files have no tree item: a snapshot is read away from the tree.
+// They hold the state of their buffer (BufferStates.h) as it was, in their
+// own fields.
+
+struct SnapshotFolder {
+	int order = -1;
+	PooledString name;
+	PooledPath path;
+	bool isExpanded = false;
+	vector<std::shared_ptr<const VFile>> files;
+	vector<std::shared_ptr<const SnapshotFolder>> folders;
+};
+
+void to_json(json& j, const SnapshotFolder& folder);	// Same format as a VFolder
+
+class ModelSnapshot {
+public:
+	ModelSnapshot(std::shared_ptr<const SnapshotFolder> root, uint64_t sequence) : top(std::move(root)), number(sequence) {}
+
+	const SnapshotFolder& root() const { return *top; }
+	uint64_t sequence() const { return number; }			// Counts publish() calls that changed something
+	vector<const VFile*> allFiles() const;					// Files first, then subfolders, as getAllFiles()
+	VFolder toVFolder() const;								// A model of its own, without tree items
+
+private:
+	friend class SnapshotPublisher;
+	std::shared_ptr<const SnapshotFolder> top;
+	uint64_t number;
+};
+
+struct SnapshotPublishStats {
+	size_t created = 0;			// Nodes allocated by the last publish()
+	size_t reused = 0;			// Nodes taken over from the snapshot before
+};
+
+class SnapshotPublisher {
+public:
+	// On the UI thread, with the model in a consistent state.
+	std::shared_ptr<const ModelSnapshot> publish(const VFolder& root);
+
+	// From any thread; nullptr before the first publish().
+	std::shared_ptr<const ModelSnapshot> current() const { return published.load(); }
+
+	const SnapshotPublishStats& lastPublish() const { return stats; }
+
+private:
+	std::shared_ptr<const SnapshotFolder> share(const VFolder& folder, const std::shared_ptr<const SnapshotFolder>* previous);
+	std::shared_ptr<const VFile> share(const VFile& file, const vector<std::shared_ptr<const VFile>>* previous, size_t index);
+
+	std::atomic<std::shared_ptr<const ModelSnapshot>> published;
+	SnapshotPublishStats stats;
+	uint64_t sequence = 0;
+};
+
+// Snapshots of commonData.rootVFolder.
+inline SnapshotPublisher modelSnapshots;
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Binary notification trace written by TraceRecorder and replayed by
+// tools/HostSimulator. A 16 byte header followed by fixed size records,
+// little endian, in the order beNotified received them.
+
+enum class NotificationSource : uint8_t {
+	Notepad,		// NPPN_* from the Notepad++ window
+	MainScintilla,	// SCN_* from the main view
+	SubScintilla	// SCN_* from the sub view
+};
+
+struct NotificationTraceHeader {
+	char magic[4] = { 'V', 'F', 'N', 'T' };
+	uint16_t version = 1;
+	uint16_t recordSize = 0;
+	uint64_t startedAtMicros = 0;	// Wall clock, microseconds since the Unix epoch
+};
+
+struct NotificationRecord {
+	uint64_t timestampMicros = 0;	// Since the trace started
+	uint64_t bufferID = 0;
+	uint32_t code = 0;
+	int8_t view = -1;				// 0 main, 1 sub, -1 unknown
+	NotificationSource source = NotificationSource::Notepad;
+	uint16_t reserved = 0;
+};
+
+static_assert(sizeof(NotificationTraceHeader) == 16, "trace header layout changed");
+static_assert(sizeof(NotificationRecord) == 24, "trace record layout changed");
+
+// Notepad++ notification codes the replay understands (Notepad_plus_msgs.h).
+constexpr uint32_t TRACE_NPPN_READY = 1001;
+constexpr uint32_t TRACE_NPPN_FILEOPENED = 1004;
+constexpr uint32_t TRACE_NPPN_FILECLOSED = 1005;
+constexpr uint32_t TRACE_NPPN_FILESAVED = 1008;
+constexpr uint32_t TRACE_NPPN_BUFFERACTIVATED = 1010;
+constexpr uint32_t TRACE_NPPN_FILERENAMED = 1023;
+
+inline void writeNotificationTraceHeader(std::ostream& out, uint64_t startedAtMicros) {
+	NotificationTraceHeader header;
+	header.recordSize = sizeof(NotificationRecord);
+	header.startedAtMicros = startedAtMicros;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+inline bool readNotificationTrace(std::istream& in, std::vector<NotificationRecord>& records, std::string& error) {
+	NotificationTraceHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "VFNT", 4) != 0) {
+		error = "not a notification trace";
+		return false;
+	}
+	if (header.version != 1 || header.recordSize != sizeof(NotificationRecord)) {
+		error = "unsupported trace version " + std::to_string(header.version);
+		return false;
+	}
+
+	NotificationRecord record;
+	while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+		records.push_back(record);
+	}
+	if (in.gcount() != 0) {
+		error = "trace ends with a partial record";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,255 @@
+#include "PathTrie.h"
+#include <vector>
+
+
+namespace {
+
+bool isSeparator(char c) {
+	return c == '\\' || c == '/';
+}
+
+const PooledString emptyComponent;
+
+}  // namespace
+
+
+PooledPath::PooledPath(std::string_view text) {
+	if (text.empty()) {
+		return;
+	}
+	char separator = 0;
+	size_t start = 0;
+	while (true) {
+		size_t end = start;
+		while (end < text.size() && !isSeparator(text[end])) {
+			++end;
+		}
+		Node* next = pathTrie().child(node, separator, text.substr(start, end - start));
+		release();
+		node = next;
+		if (end == text.size()) {
+			break;
+		}
+		separator = text[end];
+		start = end + 1;
+	}
+}
+
+PooledPath& PooledPath::operator=(const PooledPath& other) noexcept {
+	if (node != other.node) {
+		other.retain();
+		release();
+		node = other.node;
+	}
+	return *this;
+}
+
+PooledPath& PooledPath::operator=(PooledPath&& other) noexcept {
+	if (this != &other) {
+		release();
+		node = other.node;
+		other.node = nullptr;
+	}
+	return *this;
+}
+
+std::string PooledPath::str() const {
+	// Filled from the end, as the parents are walked.
+	std::string text(size(), '\0');
+	size_t end = text.size();
+	for (const Node* at = node; at; at = at->parent) {
+		const std::string_view component = at->component.view();
+		end -= component.size();
+		component.copy(text.data() + end, component.size());
+		if (at->separator) {
+			text[--end] = at->separator;
+		}
+	}
+	return text;
+}
+
+size_t PooledPath::size() const {
+	size_t size = 0;
+	for (const Node* at = node; at; at = at->parent) {
+		size += at->component.size() + (at->separator != 0);
+	}
+	return size;
+}
+
+PooledPath PooledPath::parent() const {
+	if (!node || !node->parent) {
+		return {};
+	}
+	PooledPath parent(node->parent);
+	parent.retain();
+	return parent;
+}
+
+const PooledString& PooledPath::leaf() const {
+	return node ? node->component : emptyComponent;
+}
+
+const PooledPath::Node* PooledPath::directoryNode() const {
+	if (node && node->component.empty() && node->separator) {
+		return node->parent;
+	}
+	return node;
+}
+
+bool PooledPath::isUnder(const PooledPath& directory) const {
+	const Node* above = directory.directoryNode();
+	if (!above || !node || node->depth <= above->depth) {
+		return false;
+	}
+	const Node* at = node;
+	while (at->depth > above->depth) {
+		at = at->parent;
+	}
+	return at == above;
+}
+
+PooledPath PooledPath::rebased(const PooledPath& from, const PooledPath& to) const {
+	if (!isUnder(from)) {
+		return *this;
+	}
+	const Node* above = from.directoryNode();
+	std::vector<const Node*> below;
+	for (const Node* at = node; at != above; at = at->parent) {
+		below.push_back(at);
+	}
+	PooledPath path = to;
+	if (path.node && path.node->component.empty() && path.node->separator) {
+		path = path.parent();
+	}
+	for (auto at = below.rbegin(); at != below.rend(); ++at) {
+		const char separator = path.node ? (*at)->separator : 0;
+		path = PooledPath(pathTrie().child(path.node, separator, (*at)->component.view()));
+	}
+	return path;
+}
+
+std::vector<PooledPath> PooledPath::pathsBelow() const {
+	std::vector<PooledPath> paths;
+	if (const Node* above = directoryNode()) {
+		pathTrie().collectBelow(above, paths);
+	}
+	return paths;
+}
+
+bool PooledPath::matches(std::string_view text) const {
+	for (const Node* at = node; at; at = at->parent) {
+		const std::string_view component = at->component.view();
+		if (!text.ends_with(component)) {
+			return false;
+		}
+		text.remove_suffix(component.size());
+		if (at->separator) {
+			if (text.empty() || text.back() != at->separator) {
+				return false;
+			}
+			text.remove_suffix(1);
+		}
+	}
+	return text.empty();
+}
+
+void PooledPath::retain() const {
+	if (node) {
+		node->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void PooledPath::release() {
+	if (!node) {
+		return;
+	}
+	// As for PooledString, only the trie takes the last reference.
+	size_t references = node->references.load(std::memory_order_relaxed);
+	while (references > 1) {
+		if (node->references.compare_exchange_weak(references, references - 1, std::memory_order_acq_rel)) {
+			node = nullptr;
+			return;
+		}
+	}
+	pathTrie().remove(node);
+	node = nullptr;
+}
+
+
+PathTrie::Node* PathTrie::child(Node* parent, char separator, std::string_view component) {
+	PooledString text(component);		// Interned outside the trie's lock
+	std::lock_guard guard(lock);
+	const auto found = nodes.find(Key{ parent, &text.str(), separator });
+	if (found != nodes.end()) {
+		(*found)->references.fetch_add(1, std::memory_order_relaxed);
+		return *found;
+	}
+	auto* node = new Node;
+	node->parent = parent;
+	node->component = std::move(text);
+	node->separator = separator;
+	node->depth = parent ? parent->depth + 1 : 0;
+	if (parent) {
+		parent->references.fetch_add(1, std::memory_order_relaxed);
+		node->nextSibling = parent->firstChild;
+		if (parent->firstChild) {
+			parent->firstChild->previousSibling = node;
+		}
+		parent->firstChild = node;
+	}
+	nodes.insert(node);
+	return node;
+}
+
+void PathTrie::remove(Node* node) {
+	std::lock_guard guard(lock);
+	// A node that goes lets go of its parent, which may go with it.
+	while (node && node->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		nodes.erase(node);
+		Node* parent = node->parent;
+		if (node->previousSibling) {
+			node->previousSibling->nextSibling = node->nextSibling;
+		}
+		else if (parent) {
+			parent->firstChild = node->nextSibling;
+		}
+		if (node->nextSibling) {
+			node->nextSibling->previousSibling = node->previousSibling;
+		}
+		delete node;
+		node = parent;
+	}
+}
+
+void PathTrie::collectBelow(const Node* above, std::vector<PooledPath>& paths) {
+	std::lock_guard guard(lock);
+	// Down to the first child, else on to the next sibling of the node or of
+	// the nearest node above it that has one.
+	for (Node* at = above->firstChild; at; ) {
+		at->references.fetch_add(1, std::memory_order_relaxed);
+		paths.push_back(PooledPath(at));
+		if (at->firstChild) {
+			at = at->firstChild;
+			continue;
+		}
+		while (!at->nextSibling && at->parent != above) {
+			at = at->parent;
+		}
+		at = at->nextSibling;
+	}
+}
+
+PathTrieStats PathTrie::stats() const {
+	std::lock_guard guard(lock);
+	PathTrieStats stats;
+	stats.nodes = nodes.size();
+	for (const Node* node : nodes) {
+		stats.references += node->references.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+PathTrie& pathTrie() {
+	static PathTrie* trie = new PathTrie;
+	return *trie;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "StringPool.h"
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+
+// Paths of the model, stored as the last of their components in a trie of
+// the directories above them. Kept free of Win32.
+//
+// A path is split at every separator, '\\' or '/'. Each component is a node
+// with its text in the string pool, the separator before it and its parent,
+// so the directories files share are stored once and a file costs one node
+// whose text is usually its name. A PooledPath points to the node of its last
+// component, or is null for the empty path; copying one counts a reference,
+// and every node holds one on its parent. As in the string pool, nodes are
+// looked up and the last reference to one is dropped under the trie's lock.
+//
+// str() puts the text back together. Two paths are equal exactly when they
+// point to the same node; comparing with a text walks the components back
+// from the end. isUnder() and rebased() only follow parents, so moving files
+// below another directory after it was renamed compares pointers instead of
+// texts. Every node also links the nodes below it, so pathsBelow() lists the
+// paths under a directory by walking only that part of the trie; FileTable
+// finds the files of the model under it from there. Components are compared
+// as they are, case included.
+
+class PooledPath {
+public:
+	PooledPath() = default;
+	PooledPath(std::string_view text);
+	PooledPath(const std::string& text) : PooledPath(std::string_view(text)) {}
+	PooledPath(const char* text) : PooledPath(std::string_view(text)) {}
+	PooledPath(const PooledPath& other) noexcept : node(other.node) { retain(); }
+	PooledPath(PooledPath&& other) noexcept : node(other.node) { other.node = nullptr; }
+	PooledPath& operator=(const PooledPath& other) noexcept;
+	PooledPath& operator=(PooledPath&& other) noexcept;
+	~PooledPath() { release(); }
+
+	std::string str() const;
+	operator std::string() const { return str(); }
+	bool empty() const { return node == nullptr; }
+	size_t size() const;
+
+	PooledPath parent() const;							// Empty for a path of one component
+	const PooledString& leaf() const;					// The last component
+	bool isUnder(const PooledPath& directory) const;	// Below it, not the directory itself
+	// The same path below to instead of from; a copy of itself if it is not
+	// below from.
+	PooledPath rebased(const PooledPath& from, const PooledPath& to) const;
+	std::vector<PooledPath> pathsBelow() const;			// Every path under it, in no particular order
+
+	friend bool operator==(const PooledPath& a, const PooledPath& b) { return a.node == b.node; }
+	friend bool operator==(const PooledPath& a, std::string_view b) { return a.matches(b); }
+	friend bool operator==(const PooledPath& a, const std::string& b) { return a.matches(b); }
+	friend bool operator==(const PooledPath& a, const char* b) { return a.matches(b); }
+	friend bool operator==(const PooledPath& a, const PooledString& b) { return a.matches(b.view()); }
+
+	friend std::string operator+(const PooledPath& a, const std::string& b) { return a.str() + b; }
+	friend std::string operator+(const std::string& a, const PooledPath& b) { return a + b.str(); }
+	friend std::string operator+(const PooledPath& a, const char* b) { return a.str() + b; }
+	friend std::string operator+(const char* a, const PooledPath& b) { return a + b.str(); }
+
+private:
+	friend class PathTrie;
+	friend struct std::hash<PooledPath>;
+	struct Node {
+		std::atomic<size_t> references{ 1 };
+		Node* parent = nullptr;			// Holds a reference on it
+		Node* firstChild = nullptr;		// The nodes below it, linked through their siblings
+		Node* nextSibling = nullptr;
+		Node* previousSibling = nullptr;
+		PooledString component;
+		char separator = 0;				// Before the component; 0 for the first one
+		uint16_t depth = 0;				// Components above it
+	};
+
+	explicit PooledPath(Node* adopted) : node(adopted) {}
+	const Node* directoryNode() const;	// Its node, or the parent if written with a separator at the end
+	bool matches(std::string_view text) const;
+	void retain() const;
+	void release();
+
+	Node* node = nullptr;
+};
+
+struct PathTrieStats {
+	size_t nodes = 0;
+	size_t references = 0;		// From paths and from the nodes below
+};
+
+class PathTrie {
+public:
+	PathTrieStats stats() const;
+
+private:
+	friend class PooledPath;
+	using Node = PooledPath::Node;
+
+	// The node of component below parent, with a reference taken on it.
+	Node* child(Node* parent, char separator, std::string_view component);
+	void remove(Node* node);
+	void collectBelow(const Node* above, std::vector<PooledPath>& paths);
+
+	// A node by its parent, its separator and the pool entry of its text.
+	struct Key {
+		const Node* parent;
+		const std::string* component;
+		char separator;
+	};
+	static Key keyOf(const Node* node) { return { node->parent, &node->component.str(), node->separator }; }
+	struct KeyHash {
+		using is_transparent = void;
+		size_t operator()(const Key& key) const {
+			const size_t parent = std::hash<const void*>()(key.parent);
+			return (parent * 31 + std::hash<const void*>()(key.component)) * 31 + static_cast<unsigned char>(key.separator);
+		}
+		size_t operator()(const Node* node) const { return (*this)(keyOf(node)); }
+	};
+	struct SameKey {
+		using is_transparent = void;
+		static Key keyOf(const Key& key) { return key; }
+		static Key keyOf(const Node* node) { return PathTrie::keyOf(node); }
+		template <typename A, typename B> bool operator()(const A& a, const B& b) const {
+			const Key x = keyOf(a), y = keyOf(b);
+			return x.parent == y.parent && x.component == y.component && x.separator == y.separator;
+		}
+	};
+
+	mutable std::mutex lock;
+	std::unordered_set<Node*, KeyHash, SameKey> nodes;
+};
+
+// Never destroyed, as the string pool.
+PathTrie& pathTrie();
+
+template <>
+struct std::hash<PooledPath> {
+	size_t operator()(const PooledPath& path) const noexcept { return std::hash<const void*>()(path.node); }
+};
+
+#ifdef __cpp_lib_format
+template <>
+struct std::formatter<PooledPath> : std::formatter<std::string_view> {
+	auto format(const PooledPath& path, std::format_context& context) const {
+		return std::formatter<std::string_view>::format(path.str(), context);
+	}
+};
+#endif
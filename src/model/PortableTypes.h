@@ -0,0 +1,24 @@
+#pragma once
+
+// Win32 types the model refers to. The model itself never calls Win32, so
+// outside Windows (tools/HostSimulator) plain equivalents are enough.
+
+#ifdef _WIN32
+#include <windows.h>
+#include "DateUtil.h"
+#include <CommCtrl.h>
+#else
+#include <cstdint>
+
+using UINT_PTR = uintptr_t;
+using LPARAM = intptr_t;
+using ULONGLONG = unsigned long long;
+
+struct _TREEITEM;
+using HTREEITEM = _TREEITEM*;
+
+// Insert positions with the values commctrl.h gives them.
+#define TVI_ROOT  ((HTREEITEM)(uintptr_t)-0x10000)
+#define TVI_FIRST ((HTREEITEM)(uintptr_t)-0x0FFFF)
+#define TVI_LAST  ((HTREEITEM)(uintptr_t)-0x0FFFE)
+#endif
@@ -6,8 +6,8 @@
 #include <map>
 #include <set>
 #include <algorithm>
-#include <windows.h>
-#include "DateUtil.h"
+#include <filesystem>
+#include "PortableTypes.h"
 
 using namespace std;
 
@@ -388,7 +388,7 @@ inline SessionView parseView(const string& xml, const string& viewName, size_t&
 }
 
 // XML parsing functions
-inline Session loadSessionFromXMLFile(const std::wstring& filePath) {
+inline Session loadSessionFromXMLFile(const std::filesystem::path& filePath) {
     Session session;
     
     std::ifstream file(filePath);
@@ -418,7 +418,7 @@ inline Session loadSessionFromXMLFile(const std::wstring& filePath) {
     return session;
 }
 
-inline bool saveSessionToXMLFile(const Session& session, const std::wstring& filePath) {
+inline bool saveSessionToXMLFile(const Session& session, const std::filesystem::path& filePath) {
     std::ofstream file(filePath);
     if (!file.is_open()) return false;
     
@@ -0,0 +1,99 @@
+#include "StringPool.h"
+
+
+namespace {
+
+const std::string emptyText;
+
+}  // namespace
+
+
+PooledString::PooledString(std::string_view text) {
+	if (!text.empty()) {
+		entry = stringPool().intern(text);
+	}
+}
+
+PooledString& PooledString::operator=(const PooledString& other) noexcept {
+	if (entry != other.entry) {
+		other.retain();
+		release();
+		entry = other.entry;
+	}
+	return *this;
+}
+
+PooledString& PooledString::operator=(PooledString&& other) noexcept {
+	if (this != &other) {
+		release();
+		entry = other.entry;
+		other.entry = nullptr;
+	}
+	return *this;
+}
+
+const std::string& PooledString::str() const {
+	return entry ? entry->text : emptyText;
+}
+
+void PooledString::retain() const {
+	if (entry) {
+		entry->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void PooledString::release() {
+	if (!entry) {
+		return;
+	}
+	// Only the pool, under its lock, takes the last reference, so intern()
+	// never finds an entry that is about to go.
+	size_t references = entry->references.load(std::memory_order_relaxed);
+	while (references > 1) {
+		if (entry->references.compare_exchange_weak(references, references - 1, std::memory_order_acq_rel)) {
+			entry = nullptr;
+			return;
+		}
+	}
+	stringPool().remove(entry);
+	entry = nullptr;
+}
+
+
+PooledString::Entry* StringPool::intern(std::string_view text) {
+	std::lock_guard guard(lock);
+	const auto found = entries.find(text);
+	if (found != entries.end()) {
+		(*found)->references.fetch_add(1, std::memory_order_relaxed);
+		return *found;
+	}
+	auto* entry = new PooledString::Entry;
+	entry->text = text;
+	entries.insert(entry);
+	return entry;
+}
+
+void StringPool::remove(PooledString::Entry* entry) {
+	std::lock_guard guard(lock);
+	if (entry->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		return;		// Interned again in the meantime
+	}
+	entries.erase(entry);
+	delete entry;
+}
+
+StringPoolStats StringPool::stats() const {
+	std::lock_guard guard(lock);
+	StringPoolStats stats;
+	stats.strings = entries.size();
+	for (const PooledString::Entry* entry : entries) {
+		stats.bytes += entry->text.size();
+		stats.references += entry->references.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+StringPool& stringPool() {
+	static StringPool* pool = new StringPool;
+	return *pool;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#if __has_include(<format>)
+#include <format>
+#endif
+
+
+// Names of the model and the components of its paths (see PathTrie.h), each
+// distinct text stored once. Kept free of Win32.
+//
+// A PooledString is a pointer to a reference-counted entry of the pool, or
+// null for the empty string. Copying one, as copies of files and folders do,
+// only counts a reference; two are equal exactly when they point to the same
+// entry. Giving one a new text looks the text up under the pool's lock, and
+// the last handle to let go of an entry removes it under the same lock, so
+// handles can be copied and dropped on any thread (snapshots hold copies of
+// files). Everything else reads the text through a const std::string&.
+
+class PooledString {
+public:
+	PooledString() = default;
+	PooledString(std::string_view text);
+	PooledString(const std::string& text) : PooledString(std::string_view(text)) {}
+	PooledString(const char* text) : PooledString(std::string_view(text)) {}
+	PooledString(const PooledString& other) noexcept : entry(other.entry) { retain(); }
+	PooledString(PooledString&& other) noexcept : entry(other.entry) { other.entry = nullptr; }
+	PooledString& operator=(const PooledString& other) noexcept;
+	PooledString& operator=(PooledString&& other) noexcept;
+	~PooledString() { release(); }
+
+	const std::string& str() const;
+	std::string_view view() const { return str(); }
+	operator const std::string&() const { return str(); }
+	operator std::string_view() const { return str(); }
+
+	bool empty() const { return entry == nullptr; }
+	size_t size() const { return str().size(); }
+	size_t length() const { return str().size(); }
+	const char* c_str() const { return str().c_str(); }
+	const char* data() const { return str().data(); }
+	std::string::const_iterator begin() const { return str().begin(); }
+	std::string::const_iterator end() const { return str().end(); }
+	template <typename... Args> size_t find(Args&&... args) const { return str().find(std::forward<Args>(args)...); }
+	template <typename... Args> size_t find_first_of(Args&&... args) const { return str().find_first_of(std::forward<Args>(args)...); }
+	template <typename... Args> size_t find_last_of(Args&&... args) const { return str().find_last_of(std::forward<Args>(args)...); }
+	std::string substr(size_t pos = 0, size_t count = std::string::npos) const { return str().substr(pos, count); }
+
+	friend bool operator==(const PooledString& a, const PooledString& b) { return a.entry == b.entry; }
+	friend bool operator==(const PooledString& a, const std::string& b) { return a.view() == b; }
+	friend bool operator==(const PooledString& a, std::string_view b) { return a.view() == b; }
+	friend bool operator==(const PooledString& a, const char* b) { return a.view() == b; }
+	friend bool operator<(const PooledString& a, const PooledString& b) { return a.view() < b.view(); }
+
+	friend std::string operator+(const PooledString& a, const std::string& b) { return a.str() + b; }
+	friend std::string operator+(const std::string& a, const PooledString& b) { return a + b.str(); }
+	friend std::string operator+(const PooledString& a, const char* b) { return a.str() + b; }
+	friend std::string operator+(const char* a, const PooledString& b) { return a + b.str(); }
+	friend std::string operator+(const PooledString& a, char b) { return a.str() + b; }
+
+private:
+	friend class StringPool;
+	struct Entry {
+		std::atomic<size_t> references{ 1 };
+		std::string text;
+	};
+
+	void retain() const;
+	void release();
+
+	Entry* entry = nullptr;
+};
+
+struct StringPoolStats {
+	size_t strings = 0;			// Distinct texts
+	size_t bytes = 0;			// Their characters
+	size_t references = 0;		// Handles to them
+};
+
+class StringPool {
+public:
+	StringPoolStats stats() const;
+
+private:
+	friend class PooledString;
+	PooledString::Entry* intern(std::string_view text);
+	void remove(PooledString::Entry* entry);
+
+	// Looked up by text, so a set node is no more than the entry pointer.
+	struct TextHash {
+		using is_transparent = void;
+		size_t operator()(std::string_view text) const { return std::hash<std::string_view>()(text); }
+		size_t operator()(const PooledString::Entry* entry) const { return (*this)(entry->text); }
+	};
+	struct SameText {
+		using is_transparent = void;
+		static std::string_view textOf(std::string_view text) { return text; }
+		static std::string_view textOf(const PooledString::Entry* entry) { return entry->text; }
+		template <typename A, typename B> bool operator()(const A& a, const B& b) const { return textOf(a) == textOf(b); }
+	};
+
+	mutable std::mutex lock;
+	std::unordered_set<PooledString::Entry*, TextHash, SameText> entries;
+};
+
+// Never destroyed, so handles in static objects can let go of it at exit.
+StringPool& stringPool();
+
+#ifdef __cpp_lib_format
+template <>
+struct std::formatter<PooledString> : std::formatter<std::string_view> {
+	auto format(const PooledString& text, std::format_context& context) const {
+		return std::formatter<std::string_view>::format(text.view(), context);
+	}
+};
+#endif
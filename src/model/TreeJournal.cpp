@@ -0,0 +1,470 @@
+#include "TreeJournal.h"
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace {
+
+// A file by what identifies it across snapshots; its name can be renamed.
+using FileKey = std::tuple<UINT_PTR, int, string>;
+
+FileKey keyOf(const VFile& file) {
+	return { file.bufferID, file.view, file.path };
+}
+
+size_t fileBytes(const VFile& file) {
+	return sizeof(VFile) + file.name.size() + file.path.size() + file.backupFilePath.size();
+}
+
+// The layout hash of a model is the XOR of one hash per entry, so an edit
+// changes it by the hashes of the places its entries left and went to.
+uint64_t mix(uint64_t value) {
+	value += 0x9e3779b97f4a7c15;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+	return value ^ (value >> 31);
+}
+
+uint64_t placeHash(int parent, int order, std::string_view name) {
+	return mix(mix(mix(static_cast<uint32_t>(parent)) ^ static_cast<uint32_t>(order)) ^ std::hash<std::string_view>()(name));
+}
+
+uint64_t fileHash(int parent, int order, std::string_view name, int view, const string& path) {
+	return mix(placeHash(parent, order, name) ^ mix(static_cast<uint32_t>(view) ^ std::hash<string>()(path)));
+}
+
+uint64_t layoutHash(const VFolder& folder) {
+	uint64_t hash = 0;
+	for (const VFile& file : folder.fileList) {
+		hash ^= fileHash(folder.getOrder(), file.getOrder(), file.name, file.view, file.path);
+	}
+	for (const VFolder& subFolder : folder.folderList) {
+		hash ^= placeHash(folder.getOrder(), subFolder.getOrder(), subFolder.name) ^ layoutHash(subFolder);
+	}
+	return hash;
+}
+
+uint64_t layoutHash(const SnapshotFolder& folder) {
+	uint64_t hash = 0;
+	for (const auto& file : folder.files) {
+		hash ^= fileHash(folder.order, file->getOrder(), file->name, file->view, file->path);
+	}
+	for (const auto& subFolder : folder.folders) {
+		hash ^= placeHash(folder.order, subFolder->order, subFolder->name) ^ layoutHash(*subFolder);
+	}
+	return hash;
+}
+
+struct PlacedFile {
+	std::shared_ptr<const VFile> file;
+	int parent = 0;
+};
+
+struct PlacedFolder {
+	const SnapshotFolder* folder = nullptr;
+	int parent = 0;
+	size_t depth = 0;
+};
+
+void collectNodes(const SnapshotFolder& folder, std::unordered_set<const SnapshotFolder*>& nodes) {
+	nodes.insert(&folder);
+	for (const auto& subFolder : folder.folders) {
+		collectNodes(*subFolder, nodes);
+	}
+}
+
+// The entries of one side, except those inside a folder node the other side
+// has too: everything in it is in the same place on both sides.
+void collectPlaced(const SnapshotFolder& folder, size_t depth, const std::unordered_set<const SnapshotFolder*>& shared,
+	vector<PlacedFile>& files, vector<PlacedFolder>& folders) {
+	for (const auto& file : folder.files) {
+		files.push_back({ file, folder.order });
+	}
+	for (const auto& subFolder : folder.folders) {
+		folders.push_back({ subFolder.get(), folder.order, depth + 1 });
+		if (!shared.contains(subFolder.get())) {
+			collectPlaced(*subFolder, depth + 1, shared, files, folders);
+		}
+	}
+}
+
+// Lists are kept sorted by order, so an entry is found by a binary search;
+// a list that is not falls back to a scan.
+template <typename Node>
+typename vector<Node>::iterator findByOrder(vector<Node>& list, int order) {
+	const auto found = std::lower_bound(list.begin(), list.end(), order,
+		[](const Node& node, int key) { return node.getOrder() < key; });
+	if (found != list.end() && found->getOrder() == order) {
+		return found;
+	}
+	return std::find_if(list.begin(), list.end(), [order](const Node& node) { return node.getOrder() == order; });
+}
+
+template <typename Node>
+void insertByOrder(vector<Node>& list, Node&& node) {
+	const auto at = std::upper_bound(list.begin(), list.end(), node.getOrder(),
+		[](int key, const Node& other) { return key < other.getOrder(); });
+	list.insert(at, std::move(node));
+}
+
+// The folder with the order. Orders are keys in pre-order, so it is inside
+// the last subfolder whose key is not above it, one level at a time.
+VFolder* folderAt(VFolder& root, int order) {
+	if (order == root.getOrder()) {
+		return &root;
+	}
+	VFolder* folder = &root;
+	for (;;) {
+		vector<VFolder>& list = folder->folderList;
+		const auto next = std::upper_bound(list.begin(), list.end(), order,
+			[](int key, const VFolder& other) { return key < other.getOrder(); });
+		if (next == list.begin()) {
+			break;
+		}
+		folder = &*std::prev(next);
+		if (folder->getOrder() == order) {
+			return folder;
+		}
+	}
+	const optional<VFolder*> found = root.findFolderByOrder(order);
+	return found ? found.value() : nullptr;
+}
+
+}  // namespace
+
+
+TreeJournal::Entry TreeJournal::changesBetween(const SnapshotFolder& before, const SnapshotFolder& after) {
+	std::unordered_set<const SnapshotFolder*> beforeNodes;
+	std::unordered_set<const SnapshotFolder*> afterNodes;
+	collectNodes(before, beforeNodes);
+	collectNodes(after, afterNodes);
+	vector<PlacedFile> filesBefore, filesAfter;
+	vector<PlacedFolder> foldersBefore, foldersAfter;
+	collectPlaced(before, 0, afterNodes, filesBefore, foldersBefore);
+	collectPlaced(after, 0, beforeNodes, filesAfter, foldersAfter);
+
+	Entry entry;
+	const auto placeOf = [](const PlacedFile& placed) {
+		return Place{ placed.parent, placed.file->getOrder(), placed.file->name, 0 };
+	};
+	const auto addFile = [&](const PlacedFile* was, const PlacedFile* is) {
+		const VFile& file = was ? *was->file : *is->file;
+		FileChange change;
+		change.bufferID = file.bufferID;
+		change.view = file.view;
+		change.path = file.path;
+		if (was) change.before = placeOf(*was);
+		if (is) change.after = placeOf(*is);
+		if (!was || !is) change.copy = was ? was->file : is->file;
+		entry.files.push_back(std::move(change));
+	};
+
+	// Files are paired by what identifies them; one in the same place on both
+	// sides is no change.
+	std::map<FileKey, vector<size_t>> unpaired;
+	for (size_t i = 0; i < filesBefore.size(); ++i) {
+		unpaired[keyOf(*filesBefore[i].file)].push_back(i);
+	}
+	for (const PlacedFile& placed : filesAfter) {
+		const auto found = unpaired.find(keyOf(*placed.file));
+		if (found == unpaired.end() || found->second.empty()) {
+			addFile(nullptr, &placed);
+			continue;
+		}
+		const PlacedFile& was = filesBefore[found->second.back()];
+		found->second.pop_back();
+		if (was.parent != placed.parent || was.file->getOrder() != placed.file->getOrder() || was.file->name != placed.file->name) {
+			addFile(&was, &placed);
+		}
+	}
+	for (const auto& [key, indexes] : unpaired) {
+		for (size_t i : indexes) {
+			addFile(&filesBefore[i], nullptr);
+		}
+	}
+
+	// Folders are paired by order.
+	const auto folderPlaceOf = [](const PlacedFolder& placed) {
+		FolderPlace place;
+		place.parent = placed.parent;
+		place.order = placed.folder->order;
+		place.name = placed.folder->name;
+		place.depth = placed.depth;
+		place.path = placed.folder->path;
+		place.isExpanded = placed.folder->isExpanded;
+		return place;
+	};
+	const auto addFolder = [&](const PlacedFolder* was, const PlacedFolder* is) {
+		FolderChange change;
+		if (was) change.before = folderPlaceOf(*was);
+		if (is) change.after = folderPlaceOf(*is);
+		entry.folders.push_back(std::move(change));
+	};
+	std::unordered_map<int, size_t> folderByOrder;
+	for (size_t i = 0; i < foldersBefore.size(); ++i) {
+		folderByOrder.emplace(foldersBefore[i].folder->order, i);
+	}
+	for (const PlacedFolder& placed : foldersAfter) {
+		const auto found = folderByOrder.find(placed.folder->order);
+		if (found == folderByOrder.end()) {
+			addFolder(nullptr, &placed);
+			continue;
+		}
+		const PlacedFolder& was = foldersBefore[found->second];
+		folderByOrder.erase(found);
+		if (was.parent != placed.parent || was.folder->name != placed.folder->name) {
+			addFolder(&was, &placed);
+		}
+	}
+	for (const auto& [order, index] : folderByOrder) {
+		addFolder(&foldersBefore[index], nullptr);
+	}
+
+	entry.bytes = sizeof(Entry) + entry.files.size() * sizeof(FileChange) + entry.folders.size() * sizeof(FolderChange);
+	for (const FileChange& change : entry.files) {
+		for (const Place* place : { &change.before, &change.after }) {
+			if (place->present()) {
+				entry.layoutDelta ^= fileHash(place->parent, place->order, place->name, change.view, change.path);
+			}
+		}
+		if (change.copy) {
+			entry.bytes += fileBytes(*change.copy);
+		}
+	}
+	for (const FolderChange& change : entry.folders) {
+		for (const Place* place : { &change.before, &change.after }) {
+			if (place->present()) {
+				entry.layoutDelta ^= placeHash(place->parent, place->order, place->name);
+			}
+		}
+	}
+	return entry;
+}
+
+void TreeJournal::record(std::shared_ptr<const ModelSnapshot> before, std::shared_ptr<const ModelSnapshot> after) {
+	if (!before || !after || &before->root() == &after->root()) {
+		return;
+	}
+	Entry entry = changesBetween(before->root(), after->root());
+	if (entry.files.empty() && entry.folders.empty()) {
+		// Only states changed; the entries there are still good.
+		if (recorded) {
+			recorded = std::move(after);
+			deltaSinceRecorded = 0;
+			expectedRevision = modelRevision;
+		}
+		return;
+	}
+	while (entries.size() > applied) {
+		used -= entries.back().bytes;
+		entries.pop_back();
+	}
+	used += entry.bytes;
+	entries.push_back(std::move(entry));
+	applied = entries.size();
+	recorded = std::move(after);
+	deltaSinceRecorded = 0;
+	expectedRevision = modelRevision;
+	trim();
+}
+
+bool TreeJournal::undo(VFolder& root) {
+	if (!canUndo() || !matches(root)) {
+		return false;
+	}
+	const Entry& entry = entries[applied - 1];
+	apply(root, entry, true);
+	deltaSinceRecorded ^= entry.layoutDelta;
+	--applied;
+	return true;
+}
+
+bool TreeJournal::redo(VFolder& root) {
+	if (!canRedo() || !matches(root)) {
+		return false;
+	}
+	const Entry& entry = entries[applied];
+	apply(root, entry, false);
+	deltaSinceRecorded ^= entry.layoutDelta;
+	++applied;
+	return true;
+}
+
+void TreeJournal::clear() {
+	entries.clear();
+	applied = 0;
+	used = 0;
+	recorded.reset();
+	deltaSinceRecorded = 0;
+}
+
+void TreeJournal::setBudget(size_t bytes) {
+	budget = bytes;
+	trim();
+}
+
+bool TreeJournal::matches(const VFolder& root) {
+	if (modelRevision == expectedRevision
+		|| (recorded && layoutHash(root) == (layoutHash(recorded->root()) ^ deltaSinceRecorded))) {
+		expectedRevision = modelRevision;
+		return true;
+	}
+	clear();
+	return false;
+}
+
+void TreeJournal::apply(VFolder& root, const Entry& entry, bool undo) {
+	stats = {};
+	++modelRevision;	// Folder contents are changed directly
+	const auto from = [undo](const auto& change) -> const auto& { return undo ? change.after : change.before; };
+	const auto to = [undo](const auto& change) -> const auto& { return undo ? change.before : change.after; };
+	const auto inPlace = [](const Place& was, const Place& is) {
+		return was.present() && is.present() && was.parent == is.parent && was.order == is.order;
+	};
+	std::unordered_set<int> touched;	// Folders whose lists change
+
+	// Take out what moves, the files first and then the folders from the
+	// deepest up, so each is found in the folder it is in now. A rename
+	// stays where it is.
+	std::unordered_map<int, VFile> files;
+	for (const FileChange& change : entry.files) {
+		const Place& was = from(change);
+		VFolder* parent = was.present() ? folderAt(root, was.parent) : nullptr;
+		const auto file = parent ? findByOrder(parent->fileList, was.order) : vector<VFile>::iterator();
+		if (!parent || file == parent->fileList.end()) {
+			continue;
+		}
+		if (inPlace(was, to(change))) {
+			file->name = to(change).name;
+			++stats.files;
+			continue;
+		}
+		files.emplace(was.order, std::move(*file));
+		parent->fileList.erase(file);
+		touched.insert(was.parent);
+	}
+
+	vector<const FolderChange*> folderChanges;
+	for (const FolderChange& change : entry.folders) {
+		folderChanges.push_back(&change);
+	}
+	std::sort(folderChanges.begin(), folderChanges.end(),
+		[&](const FolderChange* a, const FolderChange* b) { return from(*a).depth > from(*b).depth; });
+	std::unordered_map<int, VFolder> folders;
+	for (const FolderChange* change : folderChanges) {
+		const Place& was = from(*change);
+		VFolder* parent = was.present() ? folderAt(root, was.parent) : nullptr;
+		const auto folder = parent ? findByOrder(parent->folderList, was.order) : vector<VFolder>::iterator();
+		if (!parent || folder == parent->folderList.end()) {
+			continue;
+		}
+		if (inPlace(was, to(*change))) {
+			folder->name = to(*change).name;
+			continue;
+		}
+		folders.emplace(was.order, std::move(*folder));
+		parent->folderList.erase(folder);
+		touched.insert(was.parent);
+	}
+
+	// Put them where they go, the folders from the top down, then the files.
+	std::sort(folderChanges.begin(), folderChanges.end(),
+		[&](const FolderChange* a, const FolderChange* b) { return to(*a).depth < to(*b).depth; });
+	for (const FolderChange* change : folderChanges) {
+		const Place& was = from(*change);
+		const FolderPlace& is = to(*change);
+		if (!is.present() || inPlace(was, is)) {
+			continue;
+		}
+		VFolder folder;
+		const auto taken = was.present() ? folders.find(was.order) : folders.end();
+		if (taken != folders.end()) {
+			folder = std::move(taken->second);
+			folders.erase(taken);
+		}
+		folder.name = is.name;
+		folder.path = is.path;
+		folder.isExpanded = is.isExpanded;
+		if (folder.getOrder() != is.order) {
+			folder.setOrder(is.order);
+		}
+		VFolder* parent = folderAt(root, is.parent);
+		insertByOrder(parent ? parent->folderList : root.folderList, std::move(folder));
+		touched.insert(is.parent);
+	}
+	for (const FileChange& change : entry.files) {
+		const Place& was = from(change);
+		const Place& is = to(change);
+		if (!is.present() || inPlace(was, is)) {
+			continue;
+		}
+		const auto taken = was.present() ? files.find(was.order) : files.end();
+		if (taken == files.end() && !change.copy) {
+			continue;
+		}
+		VFile file = taken != files.end() ? std::move(taken->second) : *change.copy;	// A copy has no tree item
+		if (taken != files.end()) {
+			files.erase(taken);
+		}
+		file.name = is.name;
+		if (file.getOrder() != is.order) {
+			file.setOrder(is.order);
+		}
+		VFolder* parent = folderAt(root, is.parent);
+		insertByOrder(parent ? parent->fileList : root.fileList, std::move(file));
+		touched.insert(is.parent);
+		++stats.files;
+	}
+
+	// Edits that add no entries leave none over; never lose one that is.
+	for (auto& [order, file] : files) {
+		root.orderBefore(file, endOrder);
+		root.fileList.push_back(std::move(file));
+	}
+	for (auto& [order, folder] : folders) {
+		for (VFile& file : folder.fileList) {
+			root.orderBefore(file, endOrder);
+			root.fileList.push_back(std::move(file));
+		}
+		for (VFolder& subFolder : folder.folderList) {
+			root.orderBefore(subFolder, endOrder);
+			root.folderList.push_back(std::move(subFolder));
+		}
+	}
+	stats.folders = touched.size();
+	expectedRevision = modelRevision;
+}
+
+void TreeJournal::trim() {
+	// Undone entries go from the far end, so what is left can still be redone.
+	while (used > budget && entries.size() > 1) {
+		if (applied > 0) {
+			used -= entries.front().bytes;
+			entries.pop_front();
+			--applied;
+		}
+		else {
+			used -= entries.back().bytes;
+			entries.pop_back();
+		}
+	}
+}
+
+
+ScopedJournalEntry::ScopedJournalEntry(VFolder& root) : root_(root) {
+	root_.vFolderSort();
+	before_ = modelSnapshots.publish(root_);
+}
+
+ScopedJournalEntry::~ScopedJournalEntry() {
+	// Destructors must not throw; an edit that cannot be recorded ends the history.
+	try {
+		root_.vFolderSort();
+		treeJournal.record(before_, modelSnapshots.publish(root_));
+	}
+	catch (const std::exception&) {
+		treeJournal.clear();
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "ModelSnapshot.h"
+#include <climits>
+#include <deque>
+
+
+// Undo and redo for structural edits of a VFolder model: moves, wraps,
+// unwraps and renames. Kept free of Win32.
+//
+// An entry lists the files and folders an edit placed, each with its parent,
+// order and name before and after the edit. It is taken from the snapshots
+// published around the edit, walking only the folders whose nodes differ,
+// and keeps nothing else of them, so it costs about the entries the edit
+// moved. Undo takes those entries out of the places they went to and puts
+// them back where they were, folders above their contents; the rest of the
+// tree is not visited. Files are found by buffer, view and path and keep
+// their live state (buffer, edited, active); folders are found by order.
+// Redo is the same the other way.
+//
+// The journal trusts the model only while it looks like the state it
+// expects. modelRevision says so cheaply; when it has moved on, a hash of
+// the model's layout is compared with the one expected (that of the last
+// recorded snapshot, changed by the entries undone and redone since), and if
+// an open, a close or any edit made outside the journal changed the layout,
+// the journal is cleared instead. The oldest entries are dropped once the
+// entries take more than the budget; the newest one is always kept.
+
+struct JournalApplyStats {
+	size_t folders = 0;			// Folders whose lists changed
+	size_t files = 0;			// Files placed again or renamed
+};
+
+class TreeJournal {
+public:
+	static constexpr size_t defaultBudget = 8 * 1024 * 1024;
+
+	// Snapshots of the same root, published before and after one edit, with
+	// the model sorted. Does nothing if no entry changed its place or name.
+	void record(std::shared_ptr<const ModelSnapshot> before, std::shared_ptr<const ModelSnapshot> after);
+
+	// False, and nothing changes, if there is nothing to undo or redo or the
+	// model no longer matches the journal (which is then cleared).
+	bool undo(VFolder& root);
+	bool redo(VFolder& root);
+
+	bool canUndo() const { return applied > 0; }
+	bool canRedo() const { return applied < entries.size(); }
+	void clear();
+
+	void setBudget(size_t bytes);
+	size_t entryCount() const { return entries.size(); }
+	size_t bytesUsed() const { return used; }
+	const JournalApplyStats& lastApply() const { return stats; }
+
+private:
+	static constexpr int noOrder = INT_MIN;
+
+	// Where an entry is on one side of an edit.
+	struct Place {
+		int parent = 0;				// Order of the folder it is in
+		int order = noOrder;		// noOrder on a side that does not have it
+		PooledString name;
+		size_t depth = 0;			// Folders: levels below the root
+
+		bool present() const { return order != noOrder; }
+	};
+	struct FileChange {
+		UINT_PTR bufferID = 0;
+		int view = 0;
+		PooledPath path;
+		Place before;
+		Place after;
+		std::shared_ptr<const VFile> copy;	// Only if a side does not have it
+	};
+	// A folder that moves is set up as the other side had it.
+	struct FolderPlace : Place {
+		PooledPath path;
+		bool isExpanded = false;
+	};
+	struct FolderChange {
+		FolderPlace before;
+		FolderPlace after;
+	};
+	struct Entry {
+		vector<FileChange> files;
+		vector<FolderChange> folders;
+		uint64_t layoutDelta = 0;	// Layout hash before the edit XOR after it
+		size_t bytes = 0;
+	};
+
+	static Entry changesBetween(const SnapshotFolder& before, const SnapshotFolder& after);
+	bool matches(const VFolder& root);
+	void apply(VFolder& root, const Entry& entry, bool undo);
+	void trim();
+
+	std::deque<Entry> entries;
+	size_t applied = 0;					// Entries in effect; the rest can be redone
+	size_t used = 0;
+	size_t budget = defaultBudget;
+	uint64_t expectedRevision = 0;		// modelRevision when the journal last matched the model
+	std::shared_ptr<const ModelSnapshot> recorded;	// After the newest entry
+	uint64_t deltaSinceRecorded = 0;	// Layout deltas of the entries undone and redone since
+	JournalApplyStats stats;
+};
+
+// The journal of commonData.rootVFolder, fed from modelSnapshots.
+inline TreeJournal treeJournal;
+
+// Records the edits made while it is alive as one entry of treeJournal.
+// Declare it before a ScopedTreeRender so the model is final when it ends.
+class ScopedJournalEntry final {
+public:
+	explicit ScopedJournalEntry(VFolder& root);
+	~ScopedJournalEntry();
+
+	ScopedJournalEntry(const ScopedJournalEntry&) = delete;
+	ScopedJournalEntry& operator=(const ScopedJournalEntry&) = delete;
+
+private:
+	VFolder& root_;
+	std::shared_ptr<const ModelSnapshot> before_;
+};
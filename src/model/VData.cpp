@@ -69,12 +69,6 @@ int VFolder::getLastOrder() const {
 	return std::max(maxFileOrder, maxFolderOrder);
 }
 
-void VFolder::addFile(VFile* vFile) {
-	vFile->setOrder(getLastOrder() + 1); // Set the order to be after the last file in this folder
-	// Add file to the folder's file list
-	fileList.push_back(*vFile);
-}
-
 int VFolder::countItemsInFolder() const {
 	auto count = 1; // Count the folder itself
 	count += fileList.size();
@@ -87,14 +81,16 @@ int VFolder::countItemsInFolder() const {
 
 void VFolder::vFolderSort()
 {
-	// Sort files in the folder by order
-	std::sort(fileList.begin(), fileList.end(), [](const VFile& a, const VFile& b) {
-		return a.getOrder() < b.getOrder();
-		});
-	// Sort subfolders by order
-	std::sort(folderList.begin(), folderList.end(), [](const VFolder& a, const VFolder& b) {
-		return a.getOrder() < b.getOrder();
-		});
+	const auto byOrder = [](const VBase& a, const VBase& b) { return a.getOrder() < b.getOrder(); };
+	// Every storage write sorts; only a list that was out of order is a change.
+	if (!std::is_sorted(fileList.begin(), fileList.end(), byOrder)) {
+		++modelRevision;
+		std::sort(fileList.begin(), fileList.end(), byOrder);
+	}
+	if (!std::is_sorted(folderList.begin(), folderList.end(), byOrder)) {
+		++modelRevision;
+		std::sort(folderList.begin(), folderList.end(), byOrder);
+	}
 	// Recursively sort subfolders
 	for (auto& subFolder : folderList) {
 		subFolder.vFolderSort();
@@ -102,6 +98,10 @@ void VFolder::vFolderSort()
 }
 
 VFile* VFolder::findFileByPath(const string& path, int view) const {
+	return findFileByPath(PooledPath(path), view);
+}
+
+VFile* VFolder::findFileByPath(const PooledPath& path, int view) const {
 	for (const auto& file : fileList) {
 		if (file.path == path && file.view == view) {
 			return const_cast<VFile*>(&file); // Return a non-const pointer
@@ -280,23 +280,6 @@ optional<VFolder*> VFolder::findFolderByOrder(int order) const {
 	return std::nullopt; // Return null if not found
 }
 
-void VFolder::move(int steps) {
-	// Adjust the order of this folder
-	setOrder(getOrder() + steps); // Update the order and tree item
-	for (auto& folder: folderList) {
-		// Adjust the order of subfolders
-		folder.move(steps);
-	}
-
-	for (auto& file : fileList) {
-		// Adjust the order of files in this folder
-		file.setOrder(file.getOrder() + steps);
-	}
-
-	// Sort files and subfolders after moving
-	vFolderSort();
-}
-
 bool VFolder::isInRoot(int order) const {
 	for (const auto& file : fileList) {
 		if (file.getOrder() == order) {
@@ -337,17 +320,20 @@ VFolder* VFolder::findParentFolder(int order) const {
 }
 
 void VFolder::removeFile(int order) {
+	++modelRevision;
 	// Remove file by order
 	fileList.erase(std::remove_if(fileList.begin(), fileList.end(),
 		[order](const VFile& file) { return file.getOrder() == order; }), fileList.end());
 }
 
 void VFolder::removeFolder(int order) {
+	++modelRevision;
 	folderList.erase(std::remove_if(folderList.begin(), folderList.end(),
 		[order](const VFolder& folder) { return folder.getOrder() == order; }), folderList.end());
 }
 
 void VFolder::removeChild(int order) {
+	++modelRevision;
 	fileList.erase(std::remove_if(fileList.begin(), fileList.end(),
 		[order](const VFile& file) { return file.getOrder() == order; }), fileList.end());
 
@@ -397,6 +383,7 @@ vector<VBase*> VFolder::getAllChildren() {
 }
 
 void VFolder::addChildren(vector<VBase*>& allChildren) {
+	++modelRevision;
 	for (const auto& base : allChildren) {
 		if (auto file = dynamic_cast<VFile*>(base)) {
 			fileList.push_back(*file); // makes a copy
@@ -407,21 +394,6 @@ void VFolder::addChildren(vector<VBase*>& allChildren) {
 	}
 }
 
-void VFolder::adjustOrders(int beginOrder, int endOrder, int step) {
-	// Adjust orders of all files and folders in the range [beginOrder, endOrder]
-	for (auto& file : fileList) {
-		if (file.getOrder() >= beginOrder && file.getOrder() <= endOrder) {
-			file.setOrder(file.getOrder() + step);
-		}
-	}
-	for (auto& folder : folderList) {
-		if (folder.getOrder() >= beginOrder && folder.getOrder() <= endOrder) {
-			folder.setOrder(folder.getOrder() + step);
-		}
-		folder.adjustOrders(beginOrder, endOrder, step);
-	}
-}
-
 VDataLoadResult loadVDataFromFile(const std::wstring& filePath) {
     VDataLoadResult result;
     const std::filesystem::path path(filePath);
@@ -480,3 +452,162 @@ void VFolder::resetOrders(ssize_t& pos)
 		folder.resetOrders(pos);
 	}
 }
+
+namespace {
+
+// Numbers an entry and everything in it in pre-order, step apart from key on,
+// leaving room more steps free before the entry that had order reserveBefore.
+void renumber(VBase& entry, int64_t& key, int64_t step, int reserveBefore, int64_t room, int& reserved) {
+	if (entry.getOrder() == reserveBefore) {
+		key += room * step;
+		reserved = static_cast<int>(key);
+	}
+	if (entry.getOrder() != key) {
+		entry.setOrder(static_cast<int>(key));
+	}
+	key += step;
+	if (VFolder* folder = dynamic_cast<VFolder*>(&entry)) {
+		for (VBase* child : folder->getAllDirectChildren()) {
+			renumber(*child, key, step, reserveBefore, room, reserved);
+		}
+	}
+}
+
+// Walks the keys in pre-order, children by order, until visit returns false.
+template <typename Visit>
+bool walkOrders(const VFolder& folder, Visit&& visit) {
+	for (VBase* child : const_cast<VFolder&>(folder).getAllDirectChildren()) {
+		if (!visit(*child)) {
+			return false;
+		}
+		if (const VFolder* subFolder = dynamic_cast<const VFolder*>(child); subFolder && !walkOrders(*subFolder, visit)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}  // namespace
+
+int VFolder::orderBelow(int order) const {
+	int below = getOrder();
+	for (const auto& file : fileList) {
+		if (file.getOrder() < order && file.getOrder() > below) {
+			below = file.getOrder();
+		}
+	}
+	for (const auto& folder : folderList) {
+		if (folder.getOrder() < order) {
+			below = std::max(below, folder.orderBelow(order));
+		}
+	}
+	return below;
+}
+
+int VFolder::orderAbove(int order) const {
+	int above = endOrder;
+	for (const auto& file : fileList) {
+		if (file.getOrder() > order && file.getOrder() < above) {
+			above = file.getOrder();
+		}
+	}
+	for (const auto& folder : folderList) {
+		if (folder.getOrder() > order) {
+			above = std::min(above, folder.getOrder());
+		}
+		else {
+			above = std::min(above, folder.orderAbove(order));
+		}
+	}
+	return above;
+}
+
+void VFolder::orderBefore(VBase& entry, int nextOrder) {
+	const VFolder* folder = dynamic_cast<const VFolder*>(&entry);
+	const int size = folder ? folder->countItemsInFolder() : 1;
+	int below = orderBelow(nextOrder);
+	if (entry.getOrder() > below && (folder ? folder->getLastOrder() : entry.getOrder()) < nextOrder
+		&& (!folder || folder->ordersFollowTree())) {
+		return;		// Put back where it was
+	}
+	if (static_cast<int64_t>(nextOrder) - below <= size) {
+		nextOrder = spreadAround(nextOrder, size);
+		below = orderBelow(nextOrder);
+	}
+
+	// Spaced evenly in the gap, but no wider than a spread tree.
+	const int64_t step = std::clamp<int64_t>((static_cast<int64_t>(nextOrder) - below) / (size + 1), 1, orderGap);
+	int64_t key = below + step;
+	int reserved = endOrder;
+	renumber(entry, key, step, endOrder, 0, reserved);
+}
+
+int VFolder::spreadAround(int nextOrder, int room) {
+	vector<VBase*> entries;
+	walkOrders(*this, [&](VBase& entry) {
+		entries.push_back(&entry);
+		return true;
+	});
+	const size_t at = std::lower_bound(entries.begin(), entries.end(), nextOrder,
+		[](const VBase* entry, int order) { return entry->getOrder() < order; }) - entries.begin();
+
+	// The window doubles until the keys between its neighbours leave
+	// spreadStep per entry, so a gap that runs out again soon after takes a
+	// wider window and the next inserts there find room for longer.
+	constexpr int64_t spreadStep = orderGap / 16;
+	for (size_t reach = 1;; reach *= 2) {
+		const size_t first = at > reach ? at - reach : 0;
+		const size_t end = std::min(entries.size(), at + reach);
+		const int64_t low = first == 0 ? getOrder() : entries[first - 1]->getOrder();
+		const int64_t high = end < entries.size() ? entries[end]->getOrder() : at < entries.size() ? endOrder : nextOrder;
+		const int64_t step = std::min<int64_t>((high - low) / (static_cast<int64_t>(end - first) + room + 1), orderGap);
+		if (step < spreadStep && (first > 0 || end < entries.size())) {
+			continue;
+		}
+
+		int64_t key = low + std::max<int64_t>(step, 1);
+		for (size_t i = first; i < end; ++i) {
+			if (i == at) {
+				key += room * std::max<int64_t>(step, 1);
+			}
+			if (entries[i]->getOrder() != key) {
+				entries[i]->setOrder(static_cast<int>(key));
+			}
+			key += std::max<int64_t>(step, 1);
+		}
+		return at < entries.size() ? entries[at]->getOrder() : nextOrder;
+	}
+}
+
+int VFolder::spreadOrders(int nextOrder, int room) {
+	const int64_t count = static_cast<int64_t>(countItemsInFolder()) + room;
+	const int64_t step = std::clamp<int64_t>((static_cast<int64_t>(endOrder) - 1 - getOrder()) / count, 1, orderGap);
+	int64_t key = getOrder() + step;
+	int reserved = endOrder;
+	for (VBase* child : getAllDirectChildren()) {
+		renumber(*child, key, step, nextOrder, room, reserved);
+	}
+	return reserved;
+}
+
+bool VFolder::ordersFollowTree() const {
+	int64_t last = getOrder();
+	return walkOrders(*this, [&](const VBase& entry) {
+		if (entry.getOrder() <= last) {
+			return false;
+		}
+		last = entry.getOrder();
+		return true;
+	});
+}
+
+bool VFolder::ordersAreDense() const {
+	int64_t last = getOrder();
+	return !walkOrders(*this, [&](const VBase& entry) {
+		if (entry.getOrder() - last < 2) {
+			return false;
+		}
+		last = entry.getOrder();
+		return true;
+	});
+}
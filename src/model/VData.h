@@ -6,11 +6,14 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <cstdint>
+#include <climits>
 #include "nlohmann/json.hpp"
+#ifndef NOMINMAX
 #define NOMINMAX
-#include <windows.h>
-#include "DateUtil.h"
-#include <CommCtrl.h>
+#endif
+#include "PortableTypes.h"
+#include "PathTrie.h"
 
 
 using json = nlohmann::json;
@@ -22,13 +25,27 @@ using std::optional;
 using ssize_t = std::make_signed_t<size_t>;
 
 
+// Counts changes to orders and folder contents. Caches holding pointers into
+// the model (FileSequence) rebuild when it has moved on. Code that edits
+// fileList or folderList directly, or replaces a folder, bumps it itself.
+inline uint64_t modelRevision = 0;
+
+// Orders are keys in pre-order over the whole tree, with room between them:
+// spreadOrders() puts orderGap between neighbours, so an entry is placed
+// between two others by giving it a key in their gap and nothing else is
+// renumbered. When a gap has run out, only the entries around it are spread
+// over the keys about them; the whole tree is spread when a store is loaded.
+inline constexpr int orderGap = 1024;
+inline constexpr int endOrder = INT_MAX;	// No next entry: after everything
+
+
 class VBase {
 protected:
 	int order = -1;
 
 public:
-	string name;
-	string path;
+	PooledString name;
+	PooledPath path;
 	HTREEITEM hTreeItem = nullptr; // Pointer to the tree item in the virtualpanel
 
 	friend void updateTreeItemLParam(VBase* vBase);
@@ -37,17 +54,22 @@ public:
 
 	void setOrder(int newOrder) {
 		order = newOrder;
+		++modelRevision;
 		updateTreeItemLParam(this);
 	}
 	int getOrder() const { return order; }
-
-	void incrementOrder() { ++order; updateTreeItemLParam(this); }
-	void decrementOrder() { --order; updateTreeItemLParam(this); }
 };
 
 
 class VFile : public VBase
 {
+	// As stored; written only through setEdited() and setReadOnly(), so the
+	// file table hears of every change. The buffer table reads them on bind.
+	bool isEdited = false;
+	bool isReadOnly = false;
+
+	friend class BufferStateTable;
+
 public:
 	// Add this inside the VFile class definition, after the private section
 	friend void from_json(const json& j, VFile& f);
@@ -56,11 +78,21 @@ public:
 	
 	int view = 0;
 	int session = 0;
-	string backupFilePath;
+	PooledPath backupFilePath;
 	bool isActive = false;
-	bool isEdited = false;
-	bool isReadOnly = false;
-
+	uint32_t indexId = 0;	// Document in FileIndex, kept by copies; 0 if not indexed
+	bool sharesBufferState = false;	// Bound to the buffer's record in bufferStates (BufferStates.h)
+
+	// The buffer's state while the entry is bound to it, the entry's own
+	// fields otherwise. Setting writes both.
+	bool edited() const;
+	bool readOnly() const;
+	bool hasUnsavedChanges() const;	// Edited, or away from its save point
+	void setEdited(bool edited);
+	void setReadOnly(bool readOnly);
+	// A copy in no tree and bound to no buffer, holding the state this entry
+	// shows now.
+	VFile detached() const;
 };
 
 class VFolder : public VBase
@@ -83,15 +115,13 @@ public:
 	optional<VFile*> findFileByBufferID(UINT_PTR bufferID) const;
 	optional<VFile*> findFileByBufferID(UINT_PTR bufferID, int view) const;
 	optional<VFolder*> findFolderByOrder(int order) const;
-	void move(int steps);
 	VFolder* findParentFolder(int order) const;
 	void removeFile(int order);
 	void removeFolder(int order);
 	void removeChild(int order);
-	void adjustOrders(int beginOrder, int endOrder, int step);
-	void addFile(VFile* vFile);
 	int getLastOrder() const;
 	VFile* findFileByPath(const string& path, int view = 0) const;
+	VFile* findFileByPath(const PooledPath& path, int view = 0) const;	// Compares nodes, not texts
 	VFile* findFileByName(const string& name, int view = 0) const;
 	int countItemsInFolder() const;
 	optional<VBase*> getChildByOrder(int order) const;
@@ -104,9 +134,43 @@ public:
 
 	bool isInRoot(int order) const;
 	void resetOrders(ssize_t& pos);
+
+	// Sparse orders, called on the root. orderBelow() and orderAbove() are the
+	// neighbouring keys in use; this folder's own order and endOrder if none.
+	int orderBelow(int order) const;
+	int orderAbove(int order) const;
+	// Gives an entry that is not in the tree, and everything in it, the keys
+	// that put it right before nextOrder in pre-order. Keys it already has are
+	// kept if they fit; the neighbours are spread first if the gap is too small.
+	void orderBefore(VBase& entry, int nextOrder);
+	// Renumbers the fewest entries around nextOrder in pre-order, evenly
+	// between the keys on either side of them, with room for that many more
+	// entries before it. Returns nextOrder's new key.
+	int spreadAround(int nextOrder, int room);
+	// Renumbers everything orderGap apart, keeping the order, with room for
+	// that many more entries before nextOrder. Returns nextOrder's new key.
+	int spreadOrders(int nextOrder = endOrder, int room = 0);
+	bool ordersFollowTree() const;	// Every key above the one before it in pre-order
+	bool ordersAreDense() const;	// Some neighbours have no key left between them
 };
 
 // JSON serialization functions (must remain inline for nlohmann/json)
+inline void to_json(json& j, const PooledString& text) {
+	j = text.str();
+}
+
+inline void from_json(const json& j, PooledString& text) {
+	text = j.get_ref<const string&>();
+}
+
+inline void to_json(json& j, const PooledPath& path) {
+	j = path.str();
+}
+
+inline void from_json(const json& j, PooledPath& path) {
+	path = j.get_ref<const string&>();
+}
+
 inline void to_json(json& j, const VFile& f) {
 	j = json{ 
 		{"order", f.getOrder()},
@@ -116,8 +180,8 @@ inline void to_json(json& j, const VFile& f) {
 		{"session", f.session},
 		{"backupFilePath", f.backupFilePath},
 		{"isActive", f.isActive},
-		{"isEdited", f.isEdited},
-		{"isReadOnly", f.isReadOnly}
+		{"isEdited", f.edited()},
+		{"isReadOnly", f.readOnly()}
 	};
 }
 
@@ -141,8 +205,8 @@ inline void from_json(const json& j, VFile& f) {
 	if (j.contains("session")) j.at("session").get_to(f.session);
 	if (j.contains("backupFilePath")) j.at("backupFilePath").get_to(f.backupFilePath);
 	if (j.contains("isActive")) j.at("isActive").get_to(f.isActive);
-	if (j.contains("isEdited")) j.at("isEdited").get_to(f.isEdited);
-	if (j.contains("isReadOnly")) j.at("isReadOnly").get_to(f.isReadOnly);
+	if (j.contains("isEdited")) f.setEdited(j.at("isEdited").get<bool>());
+	if (j.contains("isReadOnly")) f.setReadOnly(j.at("isReadOnly").get<bool>());
 }
 
 inline void from_json(const json& j, VFolder& folder) {
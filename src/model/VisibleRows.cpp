@@ -0,0 +1,177 @@
+#include "VisibleRows.h"
+
+
+void VisibleRows::build(const VFolder& root) {
+	clear();
+
+	vector<int32_t> collapsedAbove;
+	append(root, 0, 0, collapsedAbove);
+	if (!entries.empty()) {
+		nodes.resize(4 * entries.size());
+		buildNode(1, 0, entries.size() - 1, collapsedAbove);
+	}
+}
+
+void VisibleRows::clear() {
+	entries.clear();
+	indexOf.clear();
+	nodes.clear();
+}
+
+size_t VisibleRows::rowCount() const {
+	if (nodes.empty() || nodes[1].minimum != 0) {
+		return 0;
+	}
+	return nodes[1].minimumCount;
+}
+
+VBase* VisibleRows::itemAt(size_t row) const {
+	if (row >= rowCount()) {
+		return nullptr;
+	}
+
+	size_t node = 1;
+	size_t first = 0;
+	size_t last = entries.size() - 1;
+	int32_t above = 0;
+	while (first != last) {
+		above += nodes[node].pending;
+		const size_t middle = first + (last - first) / 2;
+		const Node& left = nodes[2 * node];
+		const size_t visibleLeft = left.minimum + above == 0 ? left.minimumCount : 0;
+		if (row < visibleLeft) {
+			node = 2 * node;
+			last = middle;
+		}
+		else {
+			row -= visibleLeft;
+			node = 2 * node + 1;
+			first = middle + 1;
+		}
+	}
+	return entries[first].item;
+}
+
+optional<size_t> VisibleRows::rowOf(const VBase* item) const {
+	const auto found = indexOf.find(item);
+	if (found == indexOf.end()) {
+		return std::nullopt;
+	}
+	const size_t index = found->second;
+
+	// The entry is visible if its own count is zero.
+	size_t node = 1;
+	size_t first = 0;
+	size_t last = entries.size() - 1;
+	int32_t above = 0;
+	while (first != last) {
+		above += nodes[node].pending;
+		const size_t middle = first + (last - first) / 2;
+		if (index <= middle) {
+			node = 2 * node;
+			last = middle;
+		}
+		else {
+			node = 2 * node + 1;
+			first = middle + 1;
+		}
+	}
+	if (nodes[node].minimum + above != 0) {
+		return std::nullopt;
+	}
+	return countVisible(1, 0, entries.size() - 1, index, 0);
+}
+
+int VisibleRows::depthOf(const VBase* item) const {
+	const auto found = indexOf.find(item);
+	return found != indexOf.end() ? entries[found->second].depth : -1;
+}
+
+bool VisibleRows::setExpanded(VFolder* folder, bool expanded) {
+	const auto found = indexOf.find(folder);
+	if (found == indexOf.end() || folder->isExpanded == expanded) {
+		return false;
+	}
+	folder->isExpanded = expanded;
+
+	const Entry& entry = entries[found->second];
+	add(1, 0, entries.size() - 1, found->second + 1, entry.subtreeEnd, expanded ? -1 : 1);
+	return true;
+}
+
+void VisibleRows::append(const VFolder& folder, int depth, int32_t collapsedAbove, vector<int32_t>& collapsed) {
+	vector<VBase*> children;
+	children.reserve(folder.fileList.size() + folder.folderList.size());
+	for (const VFile& file : folder.fileList) children.push_back(const_cast<VFile*>(&file));
+	for (const VFolder& subFolder : folder.folderList) children.push_back(const_cast<VFolder*>(&subFolder));
+	std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) {
+		return a->getOrder() < b->getOrder();
+	});
+
+	for (VBase* child : children) {
+		const size_t index = entries.size();
+		Entry entry;
+		entry.item = child;
+		entry.folder = dynamic_cast<VFolder*>(child);
+		entry.depth = depth;
+		entries.push_back(entry);
+		indexOf[child] = index;
+		collapsed.push_back(collapsedAbove);
+
+		if (entry.folder) {
+			append(*entry.folder, depth + 1, collapsedAbove + (entry.folder->isExpanded ? 0 : 1), collapsed);
+		}
+		entries[index].subtreeEnd = entries.size();
+	}
+}
+
+void VisibleRows::buildNode(size_t node, size_t first, size_t last, const vector<int32_t>& collapsedAbove) {
+	nodes[node].pending = 0;
+	if (first == last) {
+		nodes[node].minimum = collapsedAbove[first];
+		nodes[node].minimumCount = 1;
+		return;
+	}
+	const size_t middle = first + (last - first) / 2;
+	buildNode(2 * node, first, middle, collapsedAbove);
+	buildNode(2 * node + 1, middle + 1, last, collapsedAbove);
+	pull(node);
+}
+
+void VisibleRows::add(size_t node, size_t first, size_t last, size_t from, size_t to, int32_t delta) {
+	if (to <= first || last < from || from >= to) {
+		return;
+	}
+	if (from <= first && last < to) {
+		nodes[node].minimum += delta;
+		nodes[node].pending += delta;
+		return;
+	}
+	const size_t middle = first + (last - first) / 2;
+	add(2 * node, first, middle, from, to, delta);
+	add(2 * node + 1, middle + 1, last, from, to, delta);
+	pull(node);
+}
+
+size_t VisibleRows::countVisible(size_t node, size_t first, size_t last, size_t to, int32_t above) const {
+	// Visible entries in [first, min(last + 1, to)).
+	if (to <= first) {
+		return 0;
+	}
+	if (last < to) {
+		return nodes[node].minimum + above == 0 ? nodes[node].minimumCount : 0;
+	}
+	above += nodes[node].pending;
+	const size_t middle = first + (last - first) / 2;
+	return countVisible(2 * node, first, middle, to, above) + countVisible(2 * node + 1, middle + 1, last, to, above);
+}
+
+void VisibleRows::pull(size_t node) {
+	const Node& left = nodes[2 * node];
+	const Node& right = nodes[2 * node + 1];
+	Node& parent = nodes[node];
+	parent.minimum = std::min(left.minimum, right.minimum);
+	parent.minimumCount = (left.minimum == parent.minimum ? left.minimumCount : 0)
+		+ (right.minimum == parent.minimum ? right.minimumCount : 0);
+	parent.minimum += parent.pending;
+}
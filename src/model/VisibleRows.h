@@ -0,0 +1,62 @@
+#pragma once
+#include "VData.h"
+#include <cstdint>
+#include <unordered_map>
+
+
+// Flattened list of the rows a tree view shows for a VFolder model: every
+// entry whose parent folders are all expanded, in model order. Row index and
+// entry map onto each other in O(log n), and expanding or collapsing a
+// folder is O(log n) too, so an owner-data list can render a viewport of a
+// very large tree without a native item per entry. Kept free of Win32.
+//
+// Entries are laid out once in pre-order. Each one counts how many of its
+// parent folders are collapsed; a segment tree over those counts keeps the
+// minimum and how often it occurs per range, so the visible rows of a range
+// are the entries whose count is zero. Collapsing a folder adds one to its
+// descendants, expanding subtracts one.
+//
+// build() must run again after entries are added, removed or moved, since the
+// layout holds pointers into the model. Expansion changes have to go through
+// setExpanded() to keep the counts in step with VFolder::isExpanded.
+
+class VisibleRows {
+public:
+	void build(const VFolder& root);
+	void clear();
+
+	size_t rowCount() const;
+	size_t entryCount() const { return entries.size(); }
+
+	VBase* itemAt(size_t row) const;						// nullptr past the last row
+	optional<size_t> rowOf(const VBase* item) const;		// nullopt while hidden
+	int depthOf(const VBase* item) const;					// 0 for top-level entries, -1 if unknown
+
+	// Updates folder->isExpanded and the rows below it. Returns false if the
+	// folder is unknown or already in that state.
+	bool setExpanded(VFolder* folder, bool expanded);
+
+private:
+	struct Entry {
+		VBase* item = nullptr;
+		VFolder* folder = nullptr;		// item as a folder, nullptr for files
+		int depth = 0;
+		size_t subtreeEnd = 0;			// One past the last descendant
+	};
+
+	struct Node {
+		int32_t minimum = 0;			// Including pending of this node
+		uint32_t minimumCount = 0;
+		int32_t pending = 0;			// Added to the whole range, not pushed down
+	};
+
+	void append(const VFolder& folder, int depth, int32_t collapsedAbove, vector<int32_t>& collapsed);
+	void buildNode(size_t node, size_t first, size_t last, const vector<int32_t>& collapsedAbove);
+	void add(size_t node, size_t first, size_t last, size_t from, size_t to, int32_t delta);
+	size_t countVisible(size_t node, size_t first, size_t last, size_t to, int32_t above) const;
+	void pull(size_t node);
+
+	vector<Entry> entries;
+	std::unordered_map<const VBase*, size_t> indexOf;
+	vector<Node> nodes;
+};
@@ -18,6 +18,7 @@
 #define IDI_FILE_VIEW_2_ICON            144
 #define IDI_FILE_DARK_ICON              145
 #define IDD_CORRUPTION_DIALOG           148
+#define IDD_FOLDER_SEARCH               150
 #define IDR_LANG_ENGLISH                301
 #define IDR_LANG_TURKISH                302
 #define IDC_ABOUT_VERSION               1001
@@ -43,14 +44,21 @@
 #define ID_CORRUPTION_SENDEMAIL         1037
 #define ID_CLOSE                        1038
 #define IDC_ABOUT_GITHUB_LINK           1039
+#define IDC_FILTER_EDIT                 1040
+#define IDC_SEARCH_TEXT                 1041
+#define IDC_SEARCH_MATCHCASE            1042
+#define IDC_SEARCH_REGEX                1043
+#define IDC_SEARCH_STOP                 1044
+#define IDC_SEARCH_STATUS               1045
+#define IDC_SEARCH_RESULTS              1046
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        150
+#define _APS_NEXT_RESOURCE_VALUE        151
 #define _APS_NEXT_COMMAND_VALUE         40002
-#define _APS_NEXT_CONTROL_VALUE         1040
+#define _APS_NEXT_CONTROL_VALUE         1047
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
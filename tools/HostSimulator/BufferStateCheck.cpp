@@ -0,0 +1,152 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "BufferStateCheck.h"
+#include "ModelFixture.h"
+#include "model/BufferStates.h"
+#include "model/BufferSync.h"
+#include "model/ModelSnapshot.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+
+namespace {
+
+struct Entries {
+    VFile* main = nullptr;
+    VFile* sub = nullptr;
+};
+
+Entries entriesOf(VFolder& root, UINT_PTR bufferID) {
+    return { root.findFileByBufferID(bufferID, 0).value_or(nullptr), root.findFileByBufferID(bufferID, 1).value_or(nullptr) };
+}
+
+}  // namespace
+
+
+int runBufferStateCheck(size_t fileCount) {
+    int result = 0;
+
+    // Every fourth buffer is cloned, as bindActivatedBuffer() does.
+    auto root = std::make_unique<VFolder>();
+    const vector<UINT_PTR> cloned = fillClonedFolders(*root, fileCount, 4, false);
+    bufferStates.clear();
+    for (VFile* file : root->getAllFiles()) {
+        bufferStates.bind(*file);
+    }
+    if (bufferStates.size() != fileCount) {
+        std::printf("%zu records for %zu buffers\n", bufferStates.size(), fileCount);
+        result = 1;
+    }
+
+    // One change through either entry is seen by both.
+    for (size_t i = 0; i < cloned.size() && result == 0; ++i) {
+        const Entries entries = entriesOf(*root, cloned[i]);
+        entries.main->setEdited(true);
+        entries.sub->setReadOnly(true);
+        if (!entries.sub->edited() || !entries.main->readOnly()) {
+            std::printf("buffer %zu: a change in one view is not seen in the other\n", static_cast<size_t>(cloned[i]));
+            result = 1;
+        }
+        entries.main->setEdited(false);
+        entries.main->setReadOnly(false);
+    }
+
+    // Save points cross once; a save clears the buffer in both views.
+    const UINT_PTR buffer = cloned.empty() ? firstBufferID : cloned.back();
+    const Entries entries = entriesOf(*root, buffer);
+    if (!bufferStates.setSavePoint(buffer, false) || bufferStates.setSavePoint(buffer, false)
+        || !entries.main->hasUnsavedChanges() || (entries.sub && !entries.sub->hasUnsavedChanges())) {
+        std::printf("leaving the save point is not reported once for both views\n");
+        result = 1;
+    }
+    entries.main->setReadOnly(true);
+    const string savedPath = "D:\\Saved\\Elsewhere.cpp";
+    const vector<VFile*> saved = markBufferSaved(*root, buffer, savedPath);
+    const BufferState* state = bufferStates.find(buffer);
+    if (saved.size() != (entries.sub ? 2u : 1u) || !state || !(state->path == savedPath) || state->hasUnsavedChanges()
+        || entries.main->readOnly() || entries.main->hasUnsavedChanges() || !(entries.main->path == savedPath)) {
+        std::printf("saving buffer %zu did not reach every view\n", static_cast<size_t>(buffer));
+        result = 1;
+    }
+
+    // Toggling read-only on every cloned buffer: one record each, against
+    // the two tree searches a toggle used to make.
+    auto start = Clock::now();
+    for (UINT_PTR bufferID : cloned) {
+        BufferState* record = bufferStates.find(bufferID);
+        record->isReadOnly = !record->isReadOnly;
+    }
+    const std::chrono::duration<double, std::milli> tableTime = Clock::now() - start;
+    start = Clock::now();
+    for (UINT_PTR bufferID : cloned) {
+        const Entries toggled = entriesOf(*root, bufferID);
+        toggled.main->setReadOnly(!toggled.main->readOnly());
+        toggled.sub->setReadOnly(!toggled.sub->readOnly());
+    }
+    const std::chrono::duration<double, std::milli> treeTime = Clock::now() - start;
+    size_t readOnly = 0;
+    for (const VFile* file : root->getAllFiles()) {
+        readOnly += file->readOnly();
+    }
+    if (readOnly != cloned.size() * 2) {
+        std::printf("%zu read-only entries, %zu expected\n", readOnly, cloned.size() * 2);
+        result = 1;
+    }
+    std::printf("%zu buffers, %zu cloned: read-only toggled for the clones in %.3f ms through their records, %.3f ms finding both entries\n",
+        fileCount, cloned.size(), tableTime.count(), treeTime.count());
+
+    // Snapshots keep the state they were published with.
+    SnapshotPublisher publisher;
+    const auto before = publisher.publish(*root);
+    bufferStates.find(buffer)->isEdited = true;
+    const auto after = publisher.publish(*root);
+    const auto editedIn = [buffer](const ModelSnapshot& snapshot) {
+        for (const VFile* file : snapshot.allFiles()) {
+            if (file->bufferID == buffer && file->view == 0) return file->edited();
+        }
+        return false;
+    };
+    if (editedIn(*before) || !editedIn(*after) || json(after->root()) != json(*root)) {
+        std::printf("snapshots do not keep the buffer state they were taken with\n");
+        result = 1;
+    }
+
+    // Closing a buffer in both views gives its record up.
+    const size_t records = bufferStates.size();
+    for (UINT_PTR bufferID : cloned) {
+        removeClosedBuffer(*root, bufferID, 0);
+        if (!bufferStates.find(bufferID)) {
+            std::printf("buffer %zu lost its record while open in a view\n", static_cast<size_t>(bufferID));
+            result = 1;
+            break;
+        }
+        removeClosedBuffer(*root, bufferID, 1);
+    }
+    if (bufferStates.size() != records - cloned.size() || (!cloned.empty() && bufferStates.find(cloned.front()))) {
+        std::printf("%zu records left after closing %zu of %zu buffers\n", bufferStates.size(), cloned.size(), records);
+        result = 1;
+    }
+    bufferStates.clear();
+    root.reset();
+
+    if (result == 0) {
+        std::printf("both views read one record per buffer\n");
+    }
+    return result;
+}
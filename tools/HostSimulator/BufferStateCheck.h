@@ -0,0 +1,30 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario buffers: builds a model whose buffers are partly cloned to the
+// other view, binds every entry to the buffer table of model/BufferStates and
+// checks that an edit, a read-only toggle, a save point and a save made once
+// are seen by the entries of both views. Times updating the record of every
+// cloned buffer against finding its two entries in the tree, checks that
+// published snapshots keep the state they were taken with and that closing
+// a buffer in both views gives its record up.
+// Returns the process exit code.
+int runBufferStateCheck(size_t fileCount);
@@ -0,0 +1,229 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ContentSearchCheck.h"
+#include "ModelFixture.h"
+#include "Services/ContentSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <regex>
+#include <thread>
+#include <tuple>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::string;
+using std::vector;
+
+const char* const words[] = { "alpha", "Beta", "gamma", "DELTA", "needle", "Needle", "haystack", "x", "42", "  " };
+
+string makeLine(std::mt19937& random) {
+    string line;
+    const size_t count = random() % 16;
+    for (size_t i = 0; i < count; ++i) {
+        line += words[random() % std::size(words)];
+        line += ' ';
+    }
+    return line;
+}
+
+string lower(string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return text;
+}
+
+// What ContentSearch should find, by reading each line the slow way.
+vector<ContentMatch> scanLines(const vector<ContentSearchTarget>& targets, const ContentSearchOptions& options) {
+    vector<ContentMatch> matches;
+    std::regex pattern;
+    if (options.regex) {
+        pattern = std::regex(options.text, options.matchCase ? std::regex::ECMAScript : std::regex::ECMAScript | std::regex::icase);
+    }
+    const string text = options.matchCase ? options.text : lower(options.text);
+    for (size_t index = 0; index < targets.size(); ++index) {
+        std::ifstream input(targets[index].path, std::ios::binary);
+        const string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        if (content.find('\0') != string::npos) {
+            continue;
+        }
+        size_t lineNumber = 0;
+        for (size_t start = 0; start < content.size(); ) {
+            size_t end = content.find('\n', start);
+            if (end == string::npos) end = content.size();
+            string line = content.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            ++lineNumber;
+            size_t column = string::npos;
+            size_t length = text.size();
+            if (options.regex) {
+                std::smatch result;
+                if (std::regex_search(line, result, pattern)) {
+                    column = result.position(0);
+                    length = result.length(0);
+                }
+            }
+            else {
+                column = (options.matchCase ? line : lower(line)).find(text);
+            }
+            if (column != string::npos) {
+                matches.push_back({ index, lineNumber, column, length, line.substr(0, options.maxExcerpt) });
+            }
+            start = end + 1;
+        }
+    }
+    return matches;
+}
+
+// Runs a search to the end; the progress callback comes from the workers.
+vector<ContentMatch> searchAll(ContentSearch& search, const vector<ContentSearchTarget>& targets,
+    const ContentSearchOptions& options, size_t& notifications) {
+    std::mutex mutex;
+    std::condition_variable progress;
+    bool signalled = false;
+    notifications = 0;
+    search.start(targets, options, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        signalled = true;
+        ++notifications;
+        progress.notify_all();
+    });
+
+    vector<ContentMatch> matches;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            progress.wait(lock, [&]() { return signalled; });
+            signalled = false;
+        }
+        const bool finished = !search.running();
+        vector<ContentMatch> taken = search.takeMatches();
+        std::move(taken.begin(), taken.end(), std::back_inserter(matches));
+        if (finished) {
+            break;
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const ContentMatch& a, const ContentMatch& b) {
+        return std::tie(a.target, a.line) < std::tie(b.target, b.line);
+    });
+    return matches;
+}
+
+bool sameMatches(const vector<ContentMatch>& found, const vector<ContentMatch>& expected) {
+    if (found.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < found.size(); ++i) {
+        if (found[i].target != expected[i].target || found[i].line != expected[i].line
+            || found[i].column != expected[i].column || found[i].length != expected[i].length
+            || found[i].excerpt != expected[i].excerpt) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+int runContentSearchCheck(size_t fileCount) {
+    std::mt19937 random(20255);
+    const std::filesystem::path directory = std::filesystem::temp_directory_path()
+        / ("host_simulator_search_" + std::to_string(random()));
+    std::filesystem::create_directories(directory);
+
+    vector<ContentSearchTarget> targets;
+    size_t bytes = 0;
+    for (size_t i = 0; i < fileCount; ++i) {
+        ContentSearchTarget target;
+        target.path = (directory / ("file" + std::to_string(i) + ".txt")).string();
+        std::ofstream output(target.path, std::ios::binary);
+        if (i % 50 == 7) {
+            output << string("binary\0needle\n", 14);  // Skipped as binary
+        }
+        const size_t lines = i % 97 == 0 ? 20000 : random() % 400;  // A few large files
+        const char* const newline = i % 3 ? "\n" : "\r\n";
+        for (size_t line = 0; line < lines; ++line) {
+            const string text = makeLine(random);
+            output << text << newline;
+            bytes += text.size() + std::strlen(newline);
+        }
+        targets.push_back(std::move(target));
+    }
+    const string missing = (directory / "missing.txt").string();
+    targets.push_back({ missing, missing, 0, 0 });
+    std::printf("%zu files, %.1f MB\n", fileCount, bytes / 1048576.0);
+
+    ContentSearch search;
+    ContentSearchOptions cases[4];
+    cases[0].text = "needle";
+    cases[0].matchCase = true;
+    cases[1].text = "NEEDLE";
+    cases[2].text = "delta x";
+    cases[3].text = "gam+a\\s+4\\d";
+    cases[3].regex = true;
+    int result = 0;
+    for (ContentSearchOptions& options : cases) {
+        options.maxMatchesPerFile = SIZE_MAX;
+        size_t notifications = 0;
+        const auto start = Clock::now();
+        const vector<ContentMatch> found = searchAll(search, targets, options, notifications);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        const vector<ContentMatch> expected = scanLines(targets, options);
+        std::printf("%-14s %-6s %8zu lines %8.1f ms, %zu notifications\n", options.text.c_str(),
+            options.regex ? "regex" : options.matchCase ? "case" : "nocase", found.size(), elapsed.count(), notifications);
+        if (!sameMatches(found, expected)) {
+            std::printf("\"%s\" found %zu lines, a scan %zu\n", options.text.c_str(), found.size(), expected.size());
+            result = 1;
+        }
+    }
+
+    ContentSearchOptions invalid;
+    invalid.text = "(";
+    invalid.regex = true;
+    if (search.start(targets, invalid, nullptr)) {
+        std::printf("an invalid regular expression started a search\n");
+        result = 1;
+    }
+
+    search.start(targets, cases[1], nullptr);
+    search.cancel();
+    const auto cancelStart = Clock::now();
+    while (search.running()) {
+        std::this_thread::yield();
+    }
+    const std::chrono::duration<double, std::milli> cancelTime = Clock::now() - cancelStart;
+    std::printf("cancelled after %zu of %zu files, workers gone in %.1f ms\n",
+        search.filesSearched(), search.fileCount(), cancelTime.count());
+
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    if (result == 0) {
+        std::printf("searches match a scan of every line\n");
+    }
+    return result;
+}
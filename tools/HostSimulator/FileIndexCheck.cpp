@@ -0,0 +1,188 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "FileIndexCheck.h"
+#include "ModelFixture.h"
+#include "model/FileIndex.h"
+#include "model/FuzzyFilter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+vector<VFile*> scanFor(const VFolder& root, const string& text) {
+    const string folded = foldCase(text);
+    vector<VFile*> files;
+    for (VFile* file : root.getAllFiles()) {
+        if (foldCase(file->name).find(folded) != string::npos || foldCase(file->path.str()).find(folded) != string::npos) {
+            files.push_back(file);
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const VFile* a, const VFile* b) { return a->getOrder() < b->getOrder(); });
+    return files;
+}
+
+// A piece of some file's name or path, so most queries find something.
+string pickQuery(const VFolder& root, std::mt19937& random) {
+    const vector<VFile*> files = root.getAllFiles();
+    const VFile* file = files[random() % files.size()];
+    const string text = random() % 2 ? file->name.str() : file->path.str();
+    const size_t length = std::min<size_t>(text.size(), 2 + random() % 12);
+    return text.substr(random() % (text.size() - length + 1), length);
+}
+
+bool queriesMatch(FileIndex& index, const VFolder& root, std::mt19937& random, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const string query = pickQuery(root, random);
+        if (index.find(root, query) != scanFor(root, query)) {
+            std::printf("\"%s\" does not match a scan\n", query.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+int runFileIndexCheck(size_t fileCount) {
+    std::mt19937 random(20254);
+    VFolder root;
+    root.setOrder(-1);
+    int order = 0;
+    for (size_t files = 0; files < fileCount; files += 50) {
+        VFolder folder;
+        folder.name = "folder" + std::to_string(order);
+        folder.setOrder(order++);
+        for (size_t i = 0; i < 50; ++i) {
+            folder.fileList.push_back(makeRandomFile(order, random));
+        }
+        root.folderList.push_back(std::move(folder));
+    }
+
+    FileIndex index;
+    const auto buildStart = Clock::now();
+    index.build(root);
+    const std::chrono::duration<double, std::milli> buildTime = Clock::now() - buildStart;
+    std::printf("%zu files indexed in %.1f ms\n", index.documentCount(), buildTime.count());
+
+    const char* const fixed[] = { "config.properties", "File12345", "\\docs\\", "ile9", ".json", "no such file" };
+    for (const char* query : fixed) {
+        const size_t repeats = 200;
+        size_t found = 0;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < repeats; ++i) {
+            found = index.find(root, query).size();
+        }
+        const std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+        std::printf("%-20s %7zu files %9.1f us\n", query, found, elapsed.count() / repeats);
+    }
+
+    vector<string> sampled;
+    for (size_t i = 0; i < 1000; ++i) {
+        sampled.push_back(pickQuery(root, random));
+    }
+    size_t sampledFound = 0;
+    const auto sampledStart = Clock::now();
+    for (const string& query : sampled) {
+        sampledFound += index.find(root, query, 100).size();
+    }
+    const std::chrono::duration<double, std::micro> sampledTime = Clock::now() - sampledStart;
+    std::printf("1000 sampled queries (first 100 files each): %.1f us per query, %zu files\n",
+        sampledTime.count() / sampled.size(), sampledFound);
+
+    if (!queriesMatch(index, root, random, 50)) {
+        return 1;
+    }
+
+    // The first query after a move only looks again at the two folders.
+    const size_t moves = 200;
+    size_t movedFound = 0;
+    std::chrono::duration<double, std::micro> afterMoveTime{};
+    for (size_t i = 0; i < moves; ++i) {
+        VFolder& folder = root.folderList[random() % root.folderList.size()];
+        VFolder& target = root.folderList[random() % root.folderList.size()];
+        VFile copy = folder.fileList[random() % folder.fileList.size()];
+        folder.removeFile(copy.getOrder());
+        target.fileList.push_back(copy);
+        ++modelRevision;
+        const auto start = Clock::now();
+        movedFound += index.find(root, sampled[i], 100).size();
+        afterMoveTime += Clock::now() - start;
+    }
+    std::printf("first query after each of %zu moves: %.1f us per query, %zu files\n",
+        moves, afterMoveTime.count() / moves, movedFound);
+
+    // Churn. Moves and clones copy the indexId; the index finds out on the
+    // next query that the files moved or need an ID of their own.
+    size_t hooked = 0, unhooked = 0;
+    for (size_t step = 0; step < 2000; ++step) {
+        VFolder& folder = root.folderList[random() % root.folderList.size()];
+        const int kind = static_cast<int>(random() % 6);
+        if (kind == 0 || folder.fileList.empty()) {
+            folder.fileList.push_back(makeRandomFile(order, random));
+            index.add(folder.fileList.back());
+            hooked++;
+        }
+        else if (kind == 1) {
+            const VFile& file = folder.fileList[random() % folder.fileList.size()];
+            index.remove(file);
+            folder.removeFile(file.getOrder());
+            hooked++;
+        }
+        else if (kind == 2) {
+            VFile& file = folder.fileList[random() % folder.fileList.size()];
+            file.name = "Renamed" + std::to_string(step) + ".properties";
+            file.path = "D:\\Other\\" + file.name;
+            index.update(file);
+            hooked++;
+        }
+        else if (kind == 3) {
+            VFolder& target = root.folderList[random() % root.folderList.size()];
+            const size_t at = random() % folder.fileList.size();
+            VFile copy = folder.fileList[at];
+            folder.removeFile(copy.getOrder());
+            target.fileList.push_back(copy);
+            ++modelRevision;
+            unhooked++;
+        }
+        else if (kind == 4) {
+            VFile clone = folder.fileList[random() % folder.fileList.size()];
+            clone.setOrder(order++);
+            folder.fileList.push_back(clone);
+            unhooked++;
+        }
+        else {
+            folder.fileList.push_back(makeRandomFile(order, random));
+            unhooked++;
+        }
+
+        if (step % 200 == 199 && !queriesMatch(index, root, random, 5)) {
+            return 1;
+        }
+    }
+    std::printf("%zu changes through the hooks, %zu without; %zu files indexed\n",
+        hooked, unhooked, index.documentCount());
+    if (index.documentCount() != root.getAllFiles().size() || !queriesMatch(index, root, random, 50)) {
+        std::printf("index does not match the model\n");
+        return 1;
+    }
+    std::printf("queries match a scan of every file\n");
+    return 0;
+}
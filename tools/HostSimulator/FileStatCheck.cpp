@@ -0,0 +1,286 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "FileStatCheck.h"
+#include "ModelFixture.h"
+#include "SimulatedPlugin.h"
+#include "Services/FileStatService.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <random>
+#include <thread>
+
+
+namespace {
+
+using std::string;
+using std::vector;
+
+// Counts the checks that reach the disk. Paths containing slowPart take
+// slowFor to answer, like a share that has gone away.
+struct CountingProbe {
+    std::shared_ptr<std::atomic<size_t>> calls = std::make_shared<std::atomic<size_t>>(0);
+    std::shared_ptr<std::atomic<size_t>> slowCalls = std::make_shared<std::atomic<size_t>>(0);
+    string slowPart;
+    std::chrono::milliseconds slowFor{ 0 };
+
+    bool operator()(const string& path, bool& failed) const {
+        ++*calls;
+        if (!slowPart.empty() && path.find(slowPart) != string::npos) {
+            ++*slowCalls;
+            std::this_thread::sleep_for(slowFor);
+        }
+        return pathExistsOnDisk(path, failed);
+    }
+};
+
+// There is no UI thread here; completions run on the thread that finished
+// the check.
+void postAtOnce(std::function<void()> completion) {
+    completion();
+}
+
+// Waits for the completion. callTime is how long checkPaths() itself took.
+FileStatBatchResult checkAndWait(FileStatService& service, const vector<string>& paths, double* callTime = nullptr) {
+    auto answer = std::make_shared<std::promise<FileStatBatchResult>>();
+    std::future<FileStatBatchResult> result = answer->get_future();
+    const auto start = Clock::now();
+    service.checkPaths(paths, [answer](FileStatBatchResult batchResult) { answer->set_value(std::move(batchResult)); });
+    if (callTime) {
+        *callTime = millisecondsSince(start);
+    }
+    return result.get();
+}
+
+size_t countMismatches(const FileStatBatchResult& result, const vector<FileStatState>& expected) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        mismatches += result.states[i] != expected[i] || result.existsAt(i) != (expected[i] != FileStatState::Missing);
+    }
+    return mismatches;
+}
+
+// Session entries: the first files of paths, half of them missing on disk,
+// an unsaved file and a missing file that a buffer holds. Only the missing
+// saved files without a buffer may leave the model and the tree.
+bool sessionFilesLeave(FileStatService& service, const vector<string>& paths, size_t count) {
+    VFolder stored;
+    vector<string> sessionPaths;
+    int order = 0;
+    for (size_t i = 0; i < count; ++i) {
+        VFile file = makeFile(order);
+        file.path = paths[i];
+        file.name = std::filesystem::path(paths[i]).filename().string();
+        stored.fileList.push_back(file);
+        sessionPaths.push_back(paths[i]);
+    }
+    VFile unsaved = makeFile(order);
+    unsaved.name = "new 1";
+    unsaved.path = paths[1];
+    unsaved.backupFilePath = paths[1] + "@backup";
+    stored.fileList.push_back(unsaved);
+    VFile held = makeFile(order);
+    held.path = paths[3];
+    held.name = "held";
+    held.bufferID = firstBufferID;
+    stored.fileList.push_back(held);
+    sessionPaths.push_back(paths[3]);
+
+    InMemoryHostBridge host;
+    SimulatedPlugin plugin(host);
+    plugin.loadModel(stored);
+    const size_t itemsBefore = plugin.tree().itemCount();
+    const FileStatBatchResult result = checkAndWait(service, sessionPaths);
+    const size_t removed = plugin.sessionFilesChecked(sessionPaths, result);
+    const size_t missing = count / 2;
+    if (removed != missing || plugin.model().getAllFiles().size() != count + 2 - missing
+        || plugin.tree().itemCount() != itemsBefore - missing) {
+        std::printf("session check: %zu entries removed, %zu missing on disk; %zu tree items of %zu left\n",
+            removed, missing, plugin.tree().itemCount(), itemsBefore);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+
+int runFileStatCheck(size_t fileCount) {
+    int result = 0;
+    std::mt19937 random(20256);
+    const std::filesystem::path directory = std::filesystem::temp_directory_path()
+        / ("host_simulator_stats_" + std::to_string(random()));
+
+    // Directories of 50 files with a missing file next to each one, and a
+    // directory that does not exist with 100 files in it.
+    vector<string> paths;
+    vector<FileStatState> expected;
+    size_t directoryCount = 0;
+    for (size_t i = 0; i < fileCount; ++i) {
+        const std::filesystem::path subDirectory = directory / ("dir" + std::to_string(i / 50));
+        if (i % 50 == 0) {
+            std::filesystem::create_directories(subDirectory);
+            ++directoryCount;
+        }
+        const std::filesystem::path file = subDirectory / ("file" + std::to_string(i) + ".txt");
+        std::ofstream(file, std::ios::binary) << i;
+        paths.push_back(file.string());
+        expected.push_back(FileStatState::Exists);
+        paths.push_back((subDirectory / ("missing" + std::to_string(i) + ".txt")).string());
+        expected.push_back(FileStatState::Missing);
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        paths.push_back((directory / "gone" / ("file" + std::to_string(i) + ".txt")).string());
+        expected.push_back(FileStatState::Missing);
+    }
+
+    // Every directory once, then the files of the ones that exist.
+    CountingProbe probe;
+    FileStatOptions options;
+    options.cacheLifetime = std::chrono::minutes(1);
+    options.probe = probe;
+    options.post = postAtOnce;
+    FileStatService service(options);
+    auto start = Clock::now();
+    const FileStatBatchResult first = checkAndWait(service, paths);
+    const double firstTime = millisecondsSince(start);
+    const size_t firstCalls = *probe.calls;
+    if (const size_t mismatches = countMismatches(first, expected)) {
+        std::printf("%zu of %zu paths have the wrong state\n", mismatches, paths.size());
+        result = 1;
+    }
+    if (firstCalls != directoryCount + 1 + fileCount * 2 || first.cacheHits != 0) {
+        std::printf("%zu stats for %zu directories and %zu files, %zu expected\n",
+            firstCalls, directoryCount + 1, fileCount * 2, directoryCount + 1 + fileCount * 2);
+        result = 1;
+    }
+
+    // The same paths again come from the cache without touching the disk.
+    start = Clock::now();
+    const FileStatBatchResult repeat = checkAndWait(service, paths);
+    const double repeatTime = millisecondsSince(start);
+    if (countMismatches(repeat, expected) || repeat.cacheHits != paths.size() || *probe.calls != firstCalls) {
+        std::printf("repeat check: %zu cache hits of %zu paths, %zu stats\n",
+            repeat.cacheHits, paths.size(), *probe.calls - firstCalls);
+        result = 1;
+    }
+
+    // A file deleted from disk is answered from the cache until its path is
+    // dropped from it, as NPPN_FILEDELETED does.
+    if (fileCount > 0) {
+        std::error_code ec;
+        std::filesystem::remove(paths.front(), ec);
+        const FileStatState cached = checkAndWait(service, { paths.front() }).states.front();
+        service.invalidatePath(paths.front());
+        if (cached != FileStatState::Exists || checkAndWait(service, { paths.front() }).states.front() != FileStatState::Missing) {
+            std::printf("a deleted file is not seen as missing once its path is dropped from the cache\n");
+            result = 1;
+        }
+        expected.front() = FileStatState::Missing;
+    }
+
+    if (fileCount >= 11 && !sessionFilesLeave(service, vector<string>(paths.begin() + 2, paths.begin() + 22), 20)) {
+        result = 1;
+    }
+
+    // A directory that does not answer times out and counts as existing,
+    // while the other directories keep going; checkPaths() itself returns at
+    // once. A timeout is no answer, so the next check tries the directory
+    // again.
+    CountingProbe slowProbe;
+    slowProbe.slowPart = "offline";
+    slowProbe.slowFor = std::chrono::milliseconds(1000);
+    FileStatOptions slowOptions;
+    slowOptions.maxWorkers = 4;
+    slowOptions.perPathTimeout = std::chrono::milliseconds(100);
+    slowOptions.cacheLifetime = std::chrono::minutes(1);
+    slowOptions.probe = slowProbe;
+    slowOptions.post = postAtOnce;
+    FileStatService slowService(slowOptions);
+    vector<string> slowPaths = paths;
+    vector<FileStatState> slowExpected = expected;
+    for (size_t i = 0; i < 50; ++i) {
+        slowPaths.push_back((directory / "offline" / ("file" + std::to_string(i) + ".txt")).string());
+        slowExpected.push_back(FileStatState::TimedOut);
+    }
+    double slowCallTime = 0;
+    start = Clock::now();
+    const FileStatBatchResult slow = checkAndWait(slowService, slowPaths, &slowCallTime);
+    const double slowTime = millisecondsSince(start);
+    if (countMismatches(slow, slowExpected) || slow.timedOutCount != 50 || slowTime >= slowProbe.slowFor.count()
+        || slowCallTime >= slowOptions.perPathTimeout.count()) {
+        std::printf("unreachable directory: %zu of %zu paths wrong, %zu timed out, %.3f ms (%.3f ms in checkPaths)\n",
+            countMismatches(slow, slowExpected), slowPaths.size(), slow.timedOutCount, slowTime, slowCallTime);
+        result = 1;
+    }
+    const FileStatBatchResult slowRepeat = checkAndWait(slowService, slowPaths);
+    if (countMismatches(slowRepeat, slowExpected) || slowRepeat.cacheHits != slowPaths.size() - 50
+        || *slowProbe.slowCalls != 2) {
+        std::printf("unreachable directory: checked %zu times, %zu cache hits of %zu paths\n",
+            static_cast<size_t>(*slowProbe.slowCalls), slowRepeat.cacheHits, slowPaths.size());
+        result = 1;
+    }
+
+    // More stuck calls than threads: the pool stays within twice maxWorkers,
+    // and once every thread is stuck the waiting directories time out too.
+    vector<string> offlinePaths;
+    for (size_t i = 0; i < 12; ++i) {
+        offlinePaths.push_back((directory / ("offline" + std::to_string(i)) / "file.txt").string());
+    }
+    const FileStatBatchResult offline = checkAndWait(slowService, offlinePaths);
+    if (offline.timedOutCount != offlinePaths.size() || slowService.threadCount() > slowOptions.maxWorkers * 2) {
+        std::printf("%zu unreachable directories: %zu timed out, %zu stat threads\n",
+            offlinePaths.size(), offline.timedOutCount, slowService.threadCount());
+        result = 1;
+    }
+
+    // A single file that times out is not cached; it is checked again.
+    if (fileCount > 1) {
+        CountingProbe fileProbe;
+        fileProbe.slowPart = "offline.txt";
+        fileProbe.slowFor = std::chrono::milliseconds(1000);
+        slowOptions.probe = fileProbe;
+        FileStatService fileService(slowOptions);
+        const string slowFile = (std::filesystem::path(paths[2]).parent_path() / "offline.txt").string();
+        std::ofstream(slowFile, std::ios::binary) << "slow";
+        const FileStatBatchResult once = checkAndWait(fileService, { slowFile });
+        const FileStatBatchResult twice = checkAndWait(fileService, { slowFile });
+        if (once.states[0] != FileStatState::TimedOut || twice.states[0] != FileStatState::TimedOut
+            || twice.cacheHits != 0 || *fileProbe.slowCalls != 2) {
+            std::printf("a file that timed out was answered from the cache\n");
+            result = 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+
+    std::printf("%zu paths in %zu directories: %.3f ms with %zu stats, %.3f ms again from the cache; "
+        "an unreachable directory of 50 files timed out after %.3f ms, %.3f ms of it in checkPaths; "
+        "%zu stat threads for %zu stuck calls\n",
+        paths.size(), directoryCount + 1, firstTime, firstCalls, repeatTime, slowTime, slowCallTime,
+        slowService.threadCount(), offlinePaths.size() + 2);
+    if (result == 0) {
+        std::printf("missing directories, the cache, timeouts and the session check answer as expected\n");
+    }
+    return result;
+}
@@ -0,0 +1,34 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario stats: writes files to a temporary directory and checks them
+// through the batched existence check behind session loading
+// (Services/FileStatService.h): files that exist and that are missing, a
+// missing directory answering for its files, repeated checks answered from
+// the cache and a deleted file dropped from it, and session entries of
+// missing files leaving the model and the tree (SimulatedPlugin). A share
+// that does not answer is stood in for by a slow probe: checkPaths() must
+// return at once, its paths must come back timed out and counted as existing
+// within the per-path timeout, and a directory or file that timed out must be
+// checked again next time. More stuck calls than threads must not take the
+// stat threads past twice maxWorkers.
+// Returns the process exit code.
+int runFileStatCheck(size_t fileCount);
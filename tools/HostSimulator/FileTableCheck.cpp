@@ -0,0 +1,177 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "FileTableCheck.h"
+#include "ModelFixture.h"
+#include "model/BufferStates.h"
+#include "model/BufferSync.h"
+#include "model/FileTable.h"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+
+
+namespace {
+
+// What the table answers, by walking the model.
+vector<VFile*> walk(const VFolder& folder, const std::function<bool(const VFile&)>& wanted) {
+    vector<VFile*> found;
+    for (VFile* file : folder.getAllFiles()) {
+        if (wanted(*file)) found.push_back(file);
+    }
+    return found;
+}
+
+struct Query {
+    const char* name;
+    unsigned states;
+    unsigned without;
+    std::function<bool(const VFile&)> wanted;
+};
+
+}  // namespace
+
+
+int runFileTableCheck(size_t fileCount) {
+    int result = 0;
+
+    auto root = std::make_unique<VFolder>();
+    fillClonedFolders(*root, fileCount, 5, true);
+    bufferStates.clear();
+    fileTable.clear();
+    std::mt19937 random(7);
+    for (VFile* file : root->getAllFiles()) {
+        bufferStates.bind(*file);
+        if (file->view == 0 && random() % 10 == 0) file->setEdited(true);
+        if (file->view == 0 && random() % 25 == 0) file->setReadOnly(true);
+    }
+    for (UINT_PTR bufferID = firstBufferID; bufferID < firstBufferID + fileCount; bufferID += 37) {
+        bufferStates.setSavePoint(bufferID, false);
+    }
+
+    auto start = Clock::now();
+    const size_t rows = fileTable.count(*root, 0);
+    const std::chrono::duration<double, std::milli> buildTime = Clock::now() - start;
+    std::printf("%zu files in %zu rows, built in %.2f ms\n", root->getAllFiles().size(), rows, buildTime.count());
+
+    const Query queries[] = {
+        { "unsaved", FileTable::Unsaved, 0, [](const VFile& f) { return f.hasUnsavedChanges(); } },
+        { "in view 1", FileTable::SubView, 0, [](const VFile& f) { return f.view == 1; } },
+        { "read-only", FileTable::ReadOnly, 0, [](const VFile& f) { return f.readOnly(); } },
+        { "unsaved, writable, view 0", FileTable::Unsaved | FileTable::MainView, FileTable::ReadOnly,
+            [](const VFile& f) { return f.hasUnsavedChanges() && !f.readOnly() && f.view == 0; } },
+    };
+    const int repeats = 20;
+    for (const Query& query : queries) {
+        vector<VFile*> selected, walked;
+        start = Clock::now();
+        for (int i = 0; i < repeats; ++i) selected = fileTable.select(*root, query.states, query.without);
+        const Clock::duration tableTime = (Clock::now() - start) / repeats;
+        start = Clock::now();
+        for (int i = 0; i < repeats; ++i) walked = walk(*root, query.wanted);
+        const Clock::duration walkTime = (Clock::now() - start) / repeats;
+        if (selected != walked || fileTable.count(*root, query.states, query.without) != walked.size()) {
+            std::printf("%s: %zu files from the table, %zu from a walk\n", query.name, selected.size(), walked.size());
+            result = 1;
+        }
+        std::printf("%-26s %6zu files  %8.1f us  (walk %8.1f us)\n", query.name, selected.size(), microsPer(tableTime, 1), microsPer(walkTime, 1));
+    }
+
+    // Below one folder, and by buffer.
+    const VFolder& folder = root->folderList[root->folderList.size() / 2];
+    if (fileTable.select(*root, FileTable::Unsaved, 0, &folder) != walk(folder, [](const VFile& f) { return f.hasUnsavedChanges(); })
+        || fileTable.select(*root, 0, 0, &folder.folderList[0]) != folder.folderList[0].getAllFiles()) {
+        std::printf("a query below %s does not match the walk\n", folder.name.c_str());
+        result = 1;
+    }
+    Clock::duration tableTime{}, walkTime{};
+    for (UINT_PTR bufferID = firstBufferID; bufferID < firstBufferID + fileCount; bufferID += fileCount / 50 + 1) {
+        start = Clock::now();
+        const vector<VFile*> entries = fileTable.withBuffer(*root, bufferID);
+        tableTime += Clock::now() - start;
+        start = Clock::now();
+        const vector<VFile*> walked = walk(*root, [bufferID](const VFile& f) { return f.bufferID == bufferID; });
+        walkTime += Clock::now() - start;
+        if (entries != walked) {
+            std::printf("buffer %zu: %zu entries from the table, %zu from a walk\n", static_cast<size_t>(bufferID), entries.size(), walked.size());
+            result = 1;
+            break;
+        }
+    }
+    std::printf("%-26s %6d times   %8.1f us  (walk %8.1f us)\n", "by buffer ID", 50, microsPer(tableTime, 50), microsPer(walkTime, 50));
+
+    // States changed after the table was built are seen by the next query.
+    const UINT_PTR cloned = firstBufferID + (fileCount / 10) * 5;
+    const vector<VFile*> clones = fileTable.withBuffer(*root, cloned);
+    clones.front()->setReadOnly(true);
+    bufferStates.setSavePoint(cloned, false);
+    markActiveFile(*root, cloned, 1);
+    const vector<VFile*> active = fileTable.select(*root, FileTable::Active);
+    const vector<VFile*> changed = fileTable.select(*root, FileTable::Unsaved | FileTable::ReadOnly);
+    if (clones.size() != 2 || active.size() != 1 || active.front() != clones.back()
+        || std::find(changed.begin(), changed.end(), clones.back()) == changed.end()) {
+        std::printf("a change to buffer %zu is not seen by the next query\n", static_cast<size_t>(cloned));
+        result = 1;
+    }
+    markBufferSaved(*root, cloned, clones.front()->path);
+    if (fileTable.count(*root, FileTable::Unsaved) != walk(*root, [](const VFile& f) { return f.hasUnsavedChanges(); }).size()
+        || fileTable.count(*root, FileTable::ReadOnly) != walk(*root, [](const VFile& f) { return f.readOnly(); }).size()) {
+        std::printf("saving buffer %zu is not seen by the next query\n", static_cast<size_t>(cloned));
+        result = 1;
+    }
+
+    // Save the edited files of one folder, as the folder menu does.
+    const size_t elsewhere = fileTable.count(*root, FileTable::Unsaved) - fileTable.count(*root, FileTable::Unsaved, 0, &folder);
+    start = Clock::now();
+    vector<UINT_PTR> toSave;
+    for (const VFile* file : fileTable.select(*root, FileTable::Unsaved, 0, &folder)) {
+        if (std::find(toSave.begin(), toSave.end(), file->bufferID) == toSave.end()) toSave.push_back(file->bufferID);
+    }
+    for (UINT_PTR bufferID : toSave) {
+        bufferStates.setSavePoint(bufferID, true);
+        markBufferSaved(*root, bufferID, fileTable.withBuffer(*root, bufferID).front()->path);
+    }
+    const std::chrono::duration<double, std::micro> saveTime = Clock::now() - start;
+    if (fileTable.count(*root, FileTable::Unsaved, 0, &folder) != 0 || fileTable.count(*root, FileTable::Unsaved) != elsewhere) {
+        std::printf("saving the edited files of %s left %zu of them\n", folder.name.c_str(), fileTable.count(*root, FileTable::Unsaved, 0, &folder));
+        result = 1;
+    }
+    std::printf("saved %zu edited buffers of %s in %.0f us\n", toSave.size(), folder.name.c_str(), saveTime.count());
+
+    // Closed files leave the table.
+    for (UINT_PTR bufferID = firstBufferID; bufferID < firstBufferID + fileCount; bufferID += 3) {
+        removeClosedBuffer(*root, bufferID, 0);
+        removeClosedBuffer(*root, bufferID, 1);
+    }
+    if (fileTable.select(*root, 0) != root->getAllFiles()
+        || fileTable.select(*root, FileTable::Unsaved) != walk(*root, [](const VFile& f) { return f.hasUnsavedChanges(); })) {
+        std::printf("the table does not follow closed files\n");
+        result = 1;
+    }
+
+    fileTable.clear();
+    bufferStates.clear();
+    root.reset();
+
+    if (result == 0) {
+        std::printf("file table queries match the model\n");
+    }
+    return result;
+}
@@ -0,0 +1,30 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario columns: builds a model with cloned, edited, read-only and
+// active files and checks that the queries of model/FileTable (by state, by
+// view, by buffer, below a folder) give the files a walk over the model
+// finds, also after states change through the VFile setters, save points,
+// saves and activations, and after files are closed. Times each query
+// against the walk, and saves the edited files of one folder the way the
+// folder menu does.
+// Returns the process exit code.
+int runFileTableCheck(size_t fileCount);
@@ -0,0 +1,212 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "ModelFixture.h"
+
+
+namespace {
+
+void fillRandomFolder(VFolder& folder, int depth, size_t& filesLeft, int& order, std::mt19937& random,
+        int maxDepth, int maxSubFolders) {
+    const size_t files = std::min<size_t>(filesLeft, 1 + random() % 8);
+    for (size_t i = 0; i < files; ++i) {
+        folder.fileList.push_back(makeFile(order));
+    }
+    filesLeft -= files;
+
+    const int subFolders = depth < maxDepth ? static_cast<int>(random() % (maxSubFolders + 1)) : 0;
+    for (int i = 0; i < subFolders && filesLeft > 0; ++i) {
+        VFolder subFolder;
+        subFolder.name = "folder" + std::to_string(order);
+        subFolder.setOrder(order++);
+        subFolder.isExpanded = random() % 3 != 0;
+        fillRandomFolder(subFolder, depth + 1, filesLeft, order, random, maxDepth, maxSubFolders);
+        folder.folderList.push_back(std::move(subFolder));
+    }
+}
+
+void fillLevels(VFolder& folder, int& order, size_t& files, size_t fileCount, int depth, bool withBuffers) {
+    for (int i = 0; i < 8 && files < fileCount; ++i) {
+        VFile file;
+        file.name = "File" + std::to_string(order) + ".txt";
+        file.path = "C:\\Projects\\" + folder.name + "\\" + file.name;
+        if (withBuffers) {
+            file.bufferID = static_cast<UINT_PTR>(order + 1);
+        }
+        file.setOrder(order++);
+        folder.fileList.push_back(file);
+        ++files;
+    }
+    if (depth == 3) {
+        return;
+    }
+    for (int i = 0; i < 8 && files < fileCount; ++i) {
+        VFolder subFolder;
+        subFolder.name = "folder" + std::to_string(order);
+        subFolder.setOrder(order++);
+        fillLevels(subFolder, order, files, fileCount, depth + 1, withBuffers);
+        folder.folderList.push_back(std::move(subFolder));
+    }
+}
+
+const char* const extensions[] = { ".txt", ".cpp", ".h", ".properties", ".json", ".xml" };
+const char* const projectDirectories[] = { "src", "include", "config", "docs", "build", "test" };
+const char* const projectSubFolders[] = { "src", "include", "test", "docs" };
+const char* const repositories[] = { "quality-assurance", "web-frontend", "billing-service", "mobile-app" };
+const char* const repositoryDirectories[] = { "src\\main\\java\\com\\example", "src\\test\\java\\com\\example", "resources", "docs" };
+
+}  // namespace
+
+
+VFile makeFile(int& order) {
+    VFile file;
+    file.name = "file" + std::to_string(order) + ".txt";
+    file.setOrder(order++);
+    return file;
+}
+
+VFile makeRandomFile(int& order, std::mt19937& random) {
+    VFile file;
+    file.name = "File" + std::to_string(order) + extensions[random() % std::size(extensions)];
+    file.path = string("C:\\Projects\\") + projectDirectories[random() % std::size(projectDirectories)] + "\\"
+        + std::to_string(random() % 500) + "\\" + file.name;
+    file.setOrder(order++);
+    return file;
+}
+
+void addRandomFolder(VFolder& parent, size_t& filesLeft, int& order, std::mt19937& random, bool expanded,
+        int maxDepth, int maxSubFolders) {
+    VFolder folder;
+    folder.name = "folder" + std::to_string(order);
+    folder.setOrder(order++);
+    folder.isExpanded = expanded;
+    fillRandomFolder(folder, 1, filesLeft, order, random, maxDepth, maxSubFolders);
+    parent.folderList.push_back(std::move(folder));
+}
+
+VFolder levelledTree(size_t fileCount, bool withBuffers) {
+    VFolder root;
+    root.setOrder(-1);
+    int order = 0;
+    size_t files = 0;
+    while (files < fileCount) {
+        VFolder folder;
+        folder.name = "top" + std::to_string(order);
+        folder.setOrder(order++);
+        fillLevels(folder, order, files, fileCount, 1, withBuffers);
+        root.folderList.push_back(std::move(folder));
+    }
+    return root;
+}
+
+vector<UINT_PTR> fillClonedFolders(VFolder& root, size_t fileCount, size_t cloneEvery, bool withSubFolders) {
+    vector<UINT_PTR> cloned;
+    int order = 0;
+    size_t files = 0;
+    const auto addFiles = [&](VFolder& folder, int count) {
+        for (int i = 0; i < count && files < fileCount; ++i, ++files) {
+            VFile file;
+            file.name = "File" + std::to_string(files) + ".cpp";
+            file.path = "C:\\Projects\\" + folder.name + "\\" + file.name;
+            file.bufferID = firstBufferID + files;
+            file.setOrder(order++);
+            folder.fileList.push_back(file);
+            if (files % cloneEvery == 0) {
+                file.view = 1;
+                file.setOrder(order++);
+                folder.fileList.push_back(file);
+                cloned.push_back(file.bufferID);
+            }
+        }
+    };
+    while (files < fileCount) {
+        VFolder folder;
+        folder.name = "Folder" + std::to_string(root.folderList.size());
+        folder.setOrder(order++);
+        if (withSubFolders) {
+            addFiles(folder, 60);
+            VFolder subFolder;
+            subFolder.name = folder.name + "Sub";
+            subFolder.setOrder(order++);
+            addFiles(subFolder, 40);
+            folder.folderList.push_back(std::move(subFolder));
+        }
+        else {
+            addFiles(folder, 100);
+        }
+        root.folderList.push_back(std::move(folder));
+    }
+    return cloned;
+}
+
+void fillProjects(VFolder& root, size_t fileCount) {
+    int order = 0;
+    size_t files = 0;
+    for (int project = 0; files < fileCount; ++project) {
+        VFolder projectFolder;
+        projectFolder.name = "Project" + std::to_string(project);
+        projectFolder.setOrder(order++);
+        const string projectPath = "C:\\Users\\developer\\source\\repos\\" + projectFolder.name.str() + "\\";
+        for (const char* subFolderName : projectSubFolders) {
+            VFolder subFolder;
+            subFolder.name = subFolderName;
+            subFolder.setOrder(order++);
+            for (int i = 0; i < 40 && files < fileCount; ++i, ++files) {
+                VFile file;
+                file.name = "module" + std::to_string(i % 10) + "_" + std::to_string(files) + ".cpp";
+                file.path = projectPath + subFolderName + "\\" + file.name;
+                if (files % 10 == 0) {
+                    file.backupFilePath = "C:\\Users\\developer\\AppData\\Roaming\\Notepad++\\backup\\" + file.name + "@2025-06-01_120000";
+                }
+                file.setOrder(order++);
+                subFolder.fileList.push_back(file);
+                if (files % 4 == 0) {
+                    file.view = 1;
+                    file.setOrder(order++);
+                    subFolder.fileList.push_back(file);
+                }
+            }
+            projectFolder.folderList.push_back(std::move(subFolder));
+        }
+        root.folderList.push_back(std::move(projectFolder));
+    }
+}
+
+string repositoryDirectory(int repository) {
+    return repositoryBase + string(repositories[repository % std::size(repositories)]) + "-" + std::to_string(repository);
+}
+
+vector<string> fillRepositories(VFolder& root, size_t fileCount) {
+    vector<string> paths;
+    int order = 0;
+    size_t files = 0;
+    for (int repository = 0; files < fileCount; ++repository) {
+        VFolder folder;
+        folder.name = "Project" + std::to_string(repository);
+        folder.setOrder(order++);
+        for (int i = 0; i < 200 && files < fileCount; ++i, ++files) {
+            VFile file;
+            file.name = "Module" + std::to_string(files) + (i % 3 ? ".java" : ".xml");
+            file.path = repositoryDirectory(repository) + "\\" + repositoryDirectories[i % std::size(repositoryDirectories)] + "\\" + file.name;
+            file.setOrder(order++);
+            paths.push_back(file.path.str());
+            folder.fileList.push_back(file);
+        }
+        root.folderList.push_back(std::move(folder));
+    }
+    return paths;
+}
@@ -0,0 +1,72 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "model/VData.h"
+
+#include <chrono>
+#include <random>
+
+
+// Models the scenario checks build, and the timers they report with. Every
+// builder numbers what it adds in pre-order, going on from order.
+
+using Clock = std::chrono::steady_clock;
+
+inline double microsPer(Clock::duration elapsed, size_t count) {
+    return count ? std::chrono::duration<double, std::micro>(elapsed).count() / count : 0;
+}
+
+inline double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline double kib(size_t bytes) {
+    return bytes / 1024.0;
+}
+
+// "file<order>.txt", without a path.
+VFile makeFile(int& order);
+
+// A file with one of a few extensions in one of a few thousand directories.
+VFile makeRandomFile(int& order, std::mt19937& random);
+
+// Adds a folder holding up to eight files and up to maxSubFolders subfolders,
+// nested up to maxDepth deep; two in three of the subfolders are expanded.
+void addRandomFolder(VFolder& parent, size_t& filesLeft, int& order, std::mt19937& random, bool expanded,
+    int maxDepth = 6, int maxSubFolders = 4);
+
+// Top folders of three levels with eight files and eight subfolders in each,
+// the files with paths and, if asked, buffer IDs.
+VFolder levelledTree(size_t fileCount, bool withBuffers = false);
+
+// Folders of 100 buffers numbered from firstBufferID, 40 of them in a
+// subfolder if asked; every cloneEvery-th buffer is cloned to the other view
+// next to its original. Returns the cloned buffers.
+inline constexpr UINT_PTR firstBufferID = 1000;
+vector<UINT_PTR> fillClonedFolders(VFolder& root, size_t fileCount, size_t cloneEvery, bool withSubFolders);
+
+// Projects of a few folders that repeat in each, with deep paths; every
+// fourth file is open in both views and every tenth has a backup.
+void fillProjects(VFolder& root, size_t fileCount);
+
+// One folder per repository, its files spread over a few directories of it.
+// Returns the paths in the order they were added.
+inline constexpr const char* repositoryBase = "C:\\Users\\developer\\Development\\GitHub\\";
+string repositoryDirectory(int repository);
+vector<string> fillRepositories(VFolder& root, size_t fileCount);
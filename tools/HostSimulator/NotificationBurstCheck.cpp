@@ -0,0 +1,118 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "NotificationBurstCheck.h"
+#include "SimulatedPlugin.h"
+
+#include <cstdio>
+
+
+namespace {
+
+std::wstring pathOf(size_t index) {
+    return L"C:\\Projects\\burst\\file" + std::to_wstring(index) + L".txt";
+}
+
+size_t entriesOf(const VFolder& root, HostBufferID bufferID) {
+    size_t count = 0;
+    for (const VFile* file : root.getAllFiles()) {
+        if (file->bufferID == bufferID) ++count;
+    }
+    return count;
+}
+
+}
+
+
+int runNotificationBurstCheck(size_t fileCount) {
+    InMemoryHostBridge host;
+    setHostBridge(&host);
+    SimulatedPlugin plugin(host);
+    plugin.loadModel(VFolder());
+    plugin.setCoalescing(true);
+
+    const size_t files = std::max<size_t>(fileCount, 4);
+    vector<HostBufferID> bufferIDs;
+    bufferIDs.push_back(host.openBuffer(pathOf(0)));
+    plugin.fileOpened(bufferIDs.back());
+    plugin.nppReady();
+    for (size_t i = 1; i < files; ++i) {
+        bufferIDs.push_back(host.openBuffer(pathOf(i)));
+        plugin.fileOpened(bufferIDs.back());
+        plugin.bufferActivated(bufferIDs.back(), HOST_MAIN_VIEW);
+    }
+    plugin.flushQueued();
+    const VFolder& root = plugin.model();
+    if (root.getAllFiles().size() != files) {
+        std::printf("%zu entries for %zu open files\n", root.getAllFiles().size(), files);
+        return 1;
+    }
+
+    // A close, then an open that gets the freed buffer ID, in one burst.
+    int result = 0;
+    size_t reused = 0;
+    for (size_t i = 1; i < files && result == 0; i += files / 4) {
+        const HostBufferID bufferID = bufferIDs[i];
+        const std::wstring newPath = L"C:\\Projects\\burst\\reused" + std::to_wstring(i) + L".txt";
+        host.closeBuffer(bufferID, HOST_MAIN_VIEW);
+        plugin.fileClosed(bufferID);
+        host.reopenBuffer(bufferID, newPath);
+        plugin.fileOpened(bufferID);
+        plugin.bufferActivated(bufferID, HOST_MAIN_VIEW);
+        plugin.flushQueued();
+
+        optional<VFile*> entry = root.findFileByBufferID(bufferID, HOST_MAIN_VIEW);
+        if (!entry || !((*entry)->path == hostPathToUtf8(newPath)) || entriesOf(root, bufferID) != 1
+            || root.findFileByPath(hostPathToUtf8(pathOf(i)))) {
+            std::printf("buffer %zu closed and reused in one burst: %s\n", static_cast<size_t>(bufferID),
+                entry ? (*entry)->path.str().c_str() : "no entry");
+            result = 1;
+        }
+        ++reused;
+    }
+
+    // A move to the other view: the close of the old view arrives before the
+    // activation in the new one, and the entry follows the buffer where it is.
+    size_t moved = 0;
+    for (size_t i = 2; i < files && result == 0; i += files / 4) {
+        const HostBufferID bufferID = bufferIDs[i];
+        const int order = (*root.findFileByBufferID(bufferID, HOST_MAIN_VIEW))->getOrder();
+        host.openBufferInView(bufferID, HOST_SUB_VIEW);
+        host.closeBuffer(bufferID, HOST_MAIN_VIEW);
+        plugin.fileClosed(bufferID);
+        plugin.bufferActivated(bufferID, HOST_SUB_VIEW);
+        plugin.flushQueued();
+
+        optional<VFile*> entry = root.findFileByBufferID(bufferID, HOST_SUB_VIEW);
+        if (!entry || (*entry)->getOrder() != order || entriesOf(root, bufferID) != 1) {
+            std::printf("buffer %zu moved to the other view within a burst: %zu entries\n",
+                static_cast<size_t>(bufferID), entriesOf(root, bufferID));
+            result = 1;
+        }
+        ++moved;
+    }
+    if (result == 0 && root.getAllFiles().size() != files) {
+        std::printf("%zu entries for %zu open files after the bursts\n", root.getAllFiles().size(), files);
+        result = 1;
+    }
+
+    setHostBridge(nullptr);
+    if (result == 0) {
+        std::printf("%zu files, %zu buffer IDs closed and reused and %zu buffers moved within a burst: bursts apply as they arrived\n",
+            files, reused, moved);
+    }
+    return result;
+}
@@ -0,0 +1,273 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "OrderKeyCheck.h"
+#include "ModelFixture.h"
+#include "model/VData.h"
+
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+enum class Edit { Insert, Clone, Wrap, Unwrap, MoveFolder };
+
+// Names in tree order, children by order; every name is unique.
+void layoutOf(const VFolder& folder, vector<string>& names) {
+    for (VBase* child : const_cast<VFolder&>(folder).getAllDirectChildren()) {
+        names.push_back(child->name);
+        if (const VFolder* subFolder = dynamic_cast<const VFolder*>(child)) {
+            layoutOf(*subFolder, names);
+        }
+    }
+}
+
+vector<string> layoutOf(const VFolder& root) {
+    vector<string> names;
+    layoutOf(root, names);
+    return names;
+}
+
+vector<string> namesOf(const VBase& entry) {
+    vector<string> names{ entry.name };
+    if (const VFolder* folder = dynamic_cast<const VFolder*>(&entry)) {
+        layoutOf(*folder, names);
+    }
+    return names;
+}
+
+VFolder& parentOf(VFolder& root, int order) {
+    VFolder* parent = root.findParentFolder(order);		// None for files of the root
+    return parent ? *parent : root;
+}
+
+size_t entriesFrom(const VFolder& root, int order) {
+    size_t count = 0;
+    for (VBase* entry : const_cast<VFolder&>(root).getAllChildren()) {
+        if (entry->getOrder() >= order) ++count;
+    }
+    return count;
+}
+
+struct Tally {
+    size_t edits = 0;
+    size_t renumbered = 0;		// Orders set by the edit
+    size_t shifted = 0;			// Orders a shift of every later entry would set
+    size_t spreads = 0;
+};
+
+// What an edit did: the entries it took out and where it put which back.
+struct Change {
+    vector<string> removed;
+    vector<string> inserted;
+    string before;				// Empty for the end
+    uint64_t revisions = 0;		// modelRevision bumps of the orderBefore() call
+    size_t size = 0;			// Entries placed
+    size_t shifted = 0;
+};
+
+void placeBefore(VFolder& root, VBase& entry, int nextOrder, Change& change) {
+    if (nextOrder != endOrder) {
+        change.before = root.getChildByOrder(nextOrder).value()->name;
+    }
+    change.shifted = entriesFrom(root, nextOrder);
+    const uint64_t revision = modelRevision;
+    root.orderBefore(entry, nextOrder);
+    change.revisions = modelRevision - revision;
+    change.inserted = namesOf(entry);
+    change.size = change.inserted.size();
+}
+
+// One edit the way the panel makes it. Returns false if the model has
+// nothing to apply it to.
+bool edit(VFolder& root, Edit kind, std::mt19937& random, size_t step, Change& change) {
+    const vector<VBase*> entries = root.getAllChildren();
+    if (entries.empty()) {
+        return false;
+    }
+    VBase* entry = entries[random() % entries.size()];
+    VFolder& parent = parentOf(root, entry->getOrder());
+
+    switch (kind) {
+    case Edit::Insert: {		// A new file, dropped above an entry
+        VFile file;
+        file.name = "Inserted" + std::to_string(step);
+        const int nextOrder = entry->getOrder();
+        placeBefore(root, file, nextOrder, change);
+        parent.fileList.push_back(file);
+        return true;
+    }
+    case Edit::Clone: {			// bindActivatedBuffer() for the other view
+        VFile* original = dynamic_cast<VFile*>(entry);
+        if (!original) return false;
+        VFile file = *original;
+        file.name = "Clone" + std::to_string(step);
+        placeBefore(root, file, root.orderAbove(original->getOrder()), change);
+        parent.fileList.push_back(file);
+        return true;
+    }
+    case Edit::Wrap: {			// wrapFileInFolder()
+        VFile* wrapped = dynamic_cast<VFile*>(entry);
+        if (!wrapped) return false;
+        const int order = wrapped->getOrder();
+        const int nextOrder = root.orderAbove(order);
+        VFolder folder;
+        folder.name = "Wrapper" + std::to_string(step);
+        folder.fileList.push_back(*wrapped);
+        change.removed = namesOf(*wrapped);
+        parent.removeFile(order);
+        placeBefore(root, folder, nextOrder, change);
+        parent.folderList.push_back(std::move(folder));
+        return true;
+    }
+    case Edit::Unwrap: {		// unwrapFolder(): the children keep their orders
+        VFolder* unwrapped = dynamic_cast<VFolder*>(entry);
+        if (!unwrapped) return false;
+        VFolder folder = *unwrapped;
+        change.removed = { folder.name };
+        change.inserted = {};
+        const uint64_t revision = modelRevision;
+        parent.removeFolder(folder.getOrder());
+        vector<VBase*> children = folder.getAllDirectChildren();
+        parent.addChildren(children);
+        change.revisions = modelRevision - revision - 2;	// removeFolder() and addChildren() themselves
+        return true;
+    }
+    case Edit::MoveFolder: {	// moveFolderIntoFolder(): to the end of another folder
+        VFolder* moved = dynamic_cast<VFolder*>(entry);
+        if (!moved) return false;
+        VBase* target = entries[random() % entries.size()];
+        if (!dynamic_cast<VFolder*>(target) || target == moved || moved->getChildByOrder(target->getOrder())) return false;
+        const int targetOrder = target->getOrder();
+        VFolder folder = *moved;
+        change.removed = namesOf(folder);
+        parent.removeFolder(folder.getOrder());
+        VFolder& into = *root.findFolderByOrder(targetOrder).value();
+        placeBefore(root, folder, root.orderAbove(into.getLastOrder()), change);
+        into.folderList.push_back(std::move(folder));
+        return true;
+    }
+    }
+    return false;
+}
+
+vector<string> expectedAfter(vector<string> layout, const Change& change) {
+    std::erase_if(layout, [&](const string& name) {
+        return std::find(change.removed.begin(), change.removed.end(), name) != change.removed.end();
+    });
+    const auto at = change.before.empty() ? layout.end() : std::find(layout.begin(), layout.end(), change.before);
+    layout.insert(at, change.inserted.begin(), change.inserted.end());
+    return layout;
+}
+
+}
+
+
+int runOrderKeyCheck(size_t fileCount) {
+    int result = 0;
+    // Numbered one after another, the way stores were written before orders
+    // had gaps.
+    VFolder stored = levelledTree(fileCount);
+
+    // Loading a store from before the gaps spreads it once.
+    VFolder root = json(stored).get<VFolder>();
+    root.setOrder(-1);
+    const vector<string> loaded = layoutOf(root);
+    if (!root.ordersAreDense()) {
+        std::printf("a store numbered one after another is not seen as dense\n");
+        result = 1;
+    }
+    root.spreadOrders();
+    if (layoutOf(root) != loaded || !root.ordersFollowTree() || root.ordersAreDense()) {
+        std::printf("spreading the loaded orders changed the layout\n");
+        result = 1;
+    }
+    std::printf("%zu files: %d entries spread up to order %d\n", fileCount, stored.getLastOrder() + 1, root.getLastOrder());
+
+    std::mt19937 random(20461);
+    const Edit kinds[] = { Edit::Insert, Edit::Clone, Edit::Wrap, Edit::Unwrap, Edit::MoveFolder };
+    const char* names[] = { "insert", "clone", "wrap", "unwrap", "move folder" };
+    Tally tallies[std::size(kinds)];
+    const size_t edits = 2000;
+    for (size_t step = 0, made = 0; made < edits && result == 0; ++step) {
+        const size_t k = step % std::size(kinds);
+        vector<string> layout = layoutOf(root);
+        Change change;
+        if (!edit(root, kinds[k], random, step, change)) {
+            continue;
+        }
+        ++made;
+        if (!root.ordersFollowTree() || layoutOf(root) != expectedAfter(std::move(layout), change)) {
+            std::printf("%s %zu left the tree out of order\n", names[k], step);
+            result = 1;
+        }
+        Tally& tally = tallies[k];
+        tally.edits++;
+        tally.renumbered += change.revisions;
+        tally.shifted += change.shifted;
+        if (change.revisions > change.size) tally.spreads++;
+    }
+    for (size_t k = 0; k < std::size(kinds); ++k) {
+        const Tally& tally = tallies[k];
+        if (tally.edits == 0) continue;
+        std::printf("%-11s %4zu edits: %.1f orders set each, a shift would set %.1f; %zu spreads\n", names[k],
+            tally.edits, static_cast<double>(tally.renumbered) / tally.edits,
+            static_cast<double>(tally.shifted) / tally.edits, tally.spreads);
+    }
+    if (tallies[3].renumbered != 0) {
+        std::printf("unwrapping renumbered entries\n");
+        result = 1;
+    }
+
+    // Inserting at the top again and again halves the same gap until it runs
+    // out; then the entries around it are spread, keeping the layout, and
+    // the rest of the tree keeps its keys.
+    const size_t entryCount = root.getAllChildren().size();
+    size_t spreads = 0, renumbered = 0, widest = 0;
+    const size_t inserts = 100;
+    for (size_t i = 0; i < inserts && result == 0; ++i) {
+        vector<string> layout = layoutOf(root);
+        const int first = root.orderAbove(root.getOrder());
+        Change change;
+        VFile file;
+        file.name = "Top" + std::to_string(i);
+        placeBefore(root, file, first, change);
+        parentOf(root, root.orderAbove(file.getOrder())).fileList.push_back(file);
+        if (!root.ordersFollowTree() || layoutOf(root) != expectedAfter(std::move(layout), change)) {
+            std::printf("insert %zu at the top left the tree out of order\n", i);
+            result = 1;
+        }
+        renumbered += change.revisions;
+        widest = std::max<size_t>(widest, change.revisions);
+        if (change.revisions > 1) spreads++;
+    }
+    std::printf("%zu inserts at the top: %.1f orders set each, %zu spreads of at most %zu of %zu entries\n", inserts,
+        static_cast<double>(renumbered) / inserts, spreads, widest, entryCount);
+    if (spreads == 0 || spreads > inserts / 4) {
+        std::printf("the gap at the top did not run out as expected\n");
+        result = 1;
+    }
+    if (widest > entryCount / 8) {
+        std::printf("a gap that ran out renumbered most of the tree\n");
+        result = 1;
+    }
+
+    if (result == 0) {
+        std::printf("sparse orders keep the tree order\n");
+    }
+    return result;
+}
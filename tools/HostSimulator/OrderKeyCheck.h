@@ -0,0 +1,29 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario orders: loads a nested model stored with orders one after
+// another, spreads them, then inserts, clones, wraps, unwraps and moves
+// entries through the sparse order keys of model/VData. Counts the entries
+// each edit renumbers against what shifting every later order would, checks
+// the tree order after every edit, and that a gap that runs out spreads the
+// tree without changing its layout.
+// Returns the process exit code.
+int runOrderKeyCheck(size_t fileCount);
@@ -0,0 +1,178 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "PathTrieCheck.h"
+#include "ModelFixture.h"
+#include "AllocationCounter.h"
+#include "model/BufferSync.h"
+#include "model/FileIndex.h"
+#include "model/FileTable.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+
+namespace {
+
+bool startsWithDirectory(const string& path, const string& directory) {
+    return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0
+        && (path[directory.size()] == '\\' || path[directory.size()] == '/');
+}
+
+}  // namespace
+
+
+int runPathTrieCheck(size_t fileCount) {
+    int result = 0;
+
+    const char* const unusual[] = { "C:", "C:\\", "C:\\file.txt", "\\\\server\\share\\folder\\file.txt",
+        "D:/mixed\\separators/file.txt", "new 1", "C:\\folder\\\\twice", "relative\\path.txt", "C:\\trailing\\" };
+    for (const char* text : unusual) {
+        const PooledPath path = text;
+        if (path.str() != text || !(path == text) || path.size() != string(text).size()) {
+            std::printf("\"%s\" came back as \"%s\"\n", text, path.str().c_str());
+            result = 1;
+        }
+    }
+
+    auto root = std::make_unique<VFolder>();
+    const vector<string> paths = fillRepositories(*root, fileCount);
+
+    const vector<VFile*> files = root->getAllFiles();
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!(files[i]->path == paths[i])) {
+            std::printf("%s came back as %s\n", paths[i].c_str(), files[i]->path.str().c_str());
+            result = 1;
+            break;
+        }
+    }
+
+    // The same paths on another drive, so that none of them is stored yet,
+    // in the trie, as whole interned texts and as std::string. Their file and
+    // directory names are in the string pool already, as the model's are.
+    vector<string> elsewhere = paths;
+    for (string& path : elsewhere) {
+        path[0] = 'E';
+    }
+    const PathTrieStats modelStats = pathTrie().stats();
+    vector<PooledPath> trie;
+    trie.reserve(elsewhere.size());
+    AllocationSnapshot before = allocationSnapshot();
+    for (const string& path : elsewhere) {
+        trie.emplace_back(path);
+    }
+    const size_t trieBytes = allocationSnapshot().bytes - before.bytes;
+    vector<PooledString> whole;
+    whole.reserve(elsewhere.size());
+    before = allocationSnapshot();
+    for (const string& path : elsewhere) {
+        whole.emplace_back(path);
+    }
+    const size_t wholeBytes = allocationSnapshot().bytes - before.bytes;
+    vector<string> copies;
+    copies.reserve(elsewhere.size());
+    before = allocationSnapshot();
+    for (const string& path : elsewhere) {
+        copies.push_back(path);
+    }
+    const size_t stringBytes = allocationSnapshot().bytes - before.bytes;
+    const size_t handles = elsewhere.size() * sizeof(PooledPath);
+    std::printf("%zu paths in %zu trie nodes: %.1f KiB; as whole interned texts %.1f KiB, as std::string %.1f KiB\n",
+        files.size(), modelStats.nodes, kib(handles + trieBytes), kib(handles + wholeBytes),
+        kib(elsewhere.size() * sizeof(string) + stringBytes));
+    trie.clear();
+    whole.clear();
+    copies.clear();
+    if (trieBytes >= wholeBytes) {
+        std::printf("the trie takes more than the whole paths\n");
+        result = 1;
+    }
+
+    // Files below each project directory, by trie and by text. The first
+    // query takes the path column of the file table.
+    const size_t projects = root->folderList.size();
+    const auto columnStart = Clock::now();
+    fileTable.under(*root, PooledPath(repositoryBase));
+    const Clock::duration columnTime = Clock::now() - columnStart;
+    size_t found = 0;
+    Clock::duration trieTime{}, scanTime{};
+    for (size_t project = 0; project < projects && result == 0; ++project) {
+        const string text = repositoryDirectory(static_cast<int>(project));
+        const PooledPath directory = text;
+        auto start = Clock::now();
+        const vector<VFile*> below = fileTable.under(*root, directory);
+        trieTime += Clock::now() - start;
+        start = Clock::now();
+        vector<VFile*> scanned;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (startsWithDirectory(paths[i], text)) scanned.push_back(files[i]);
+        }
+        scanTime += Clock::now() - start;
+        if (below != scanned || below.size() != root->folderList[project].fileList.size()) {
+            std::printf("%zu files found below %s, %zu by text\n", below.size(), text.c_str(), scanned.size());
+            result = 1;
+        }
+        found += below.size();
+    }
+    std::printf("files below %zu project directories: %zu found in %.0f us, a scan of the path texts takes %.0f us;"
+        " taking the path column took %.0f us\n", projects, found, microsPer(trieTime, 1), microsPer(scanTime, 1), microsPer(columnTime, 1));
+
+    // Renaming a directory moves its files and nothing else; the index
+    // finds them under the new name.
+    const string from = repositoryDirectory(0);
+    const string to = string(repositoryBase) + "renamed-on-disk";
+    const size_t inFirst = root->folderList[0].fileList.size();
+    const auto renameStart = Clock::now();
+    vector<VFile*> moved = renameDirectory(*root, from, to + "\\");
+    const std::chrono::duration<double, std::micro> renameTime = Clock::now() - renameStart;
+    fileIndex.build(*root);
+    if (renameDirectory(*root, to, from).size() != inFirst) {
+        std::printf("renaming %s back did not move its files\n", to.c_str());
+        result = 1;
+    }
+    moved = renameDirectory(*root, from, to);
+    if (moved.size() != inFirst || fileTable.under(*root, from).size() != 0 || fileTable.under(*root, to).size() != inFirst) {
+        std::printf("renaming %s moved %zu of %zu files\n", from.c_str(), moved.size(), inFirst);
+        result = 1;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        const string expected = i < inFirst ? to + paths[i].substr(from.size()) : paths[i];
+        if (!(files[i]->path == expected)) {
+            std::printf("%s is %s after the rename\n", paths[i].c_str(), files[i]->path.str().c_str());
+            result = 1;
+            break;
+        }
+    }
+    if (fileIndex.find(*root, "renamed-on-disk").size() != inFirst) {
+        std::printf("the file index does not find the renamed directory\n");
+        result = 1;
+    }
+    std::printf("renaming a directory of %zu files: %.0f us before the file index is built\n", inFirst, renameTime.count());
+    fileIndex.clear();
+
+    fileTable.clear();  // Its rows hold paths
+    root.reset();
+    if (pathTrie().stats().nodes != 0) {
+        std::printf("%zu path nodes are left after the model is gone\n", pathTrie().stats().nodes);
+        result = 1;
+    }
+
+    if (result == 0) {
+        std::printf("paths share their directories\n");
+    }
+    return result;
+}
@@ -0,0 +1,30 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario paths: builds a model of deep project paths and checks that the
+// path trie of model/PathTrie gives every path back as it was written,
+// including drive roots, UNC shares, mixed separators and buffers without a
+// directory. Measures the paths as whole interned strings against trie
+// nodes, times finding the files below each project directory against a
+// scan of the path texts, and renames directories through renameDirectory()
+// of model/BufferSync, checking the moved paths and the file index.
+// Returns the process exit code.
+int runPathTrieCheck(size_t fileCount);
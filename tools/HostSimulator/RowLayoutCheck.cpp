@@ -0,0 +1,119 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RowLayoutCheck.h"
+#include "ModelFixture.h"
+#include "model/VisibleRows.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+void expectedRows(const VFolder& folder, vector<const VBase*>& rows) {
+    vector<const VBase*> children;
+    for (const VFile& file : folder.fileList) children.push_back(&file);
+    for (const VFolder& subFolder : folder.folderList) children.push_back(&subFolder);
+    std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) { return a->getOrder() < b->getOrder(); });
+    for (const VBase* child : children) {
+        rows.push_back(child);
+        const VFolder* subFolder = dynamic_cast<const VFolder*>(child);
+        if (subFolder && subFolder->isExpanded) {
+            expectedRows(*subFolder, rows);
+        }
+    }
+}
+
+bool matches(const VisibleRows& layout, const VFolder& root) {
+    vector<const VBase*> rows;
+    expectedRows(root, rows);
+    if (layout.rowCount() != rows.size()) {
+        std::printf("row count %zu, expected %zu\n", layout.rowCount(), rows.size());
+        return false;
+    }
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const optional<size_t> rowOfItem = layout.rowOf(rows[row]);
+        if (layout.itemAt(row) != rows[row] || !rowOfItem || *rowOfItem != row) {
+            std::printf("row %zu does not match\n", row);
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+int runRowLayoutCheck(size_t fileCount) {
+    std::mt19937 random(20251);
+    VFolder root;
+    size_t filesLeft = fileCount;
+    int order = 0;
+    while (filesLeft > 0) {
+        addRandomFolder(root, filesLeft, order, random, true);
+    }
+    vector<VFolder*> folders = root.getAllFolders();
+    if (folders.empty()) {
+        std::printf("no entries\n");
+        return 0;
+    }
+
+    VisibleRows layout;
+    const auto buildStart = Clock::now();
+    layout.build(root);
+    const auto buildTime = Clock::now() - buildStart;
+
+    const size_t operations = 100000;
+    Clock::duration toggleTime{};
+    Clock::duration lookupTime{};
+    size_t checksum = 0;
+    for (size_t i = 0; i < operations; ++i) {
+        VFolder* folder = folders[random() % folders.size()];
+        auto start = Clock::now();
+        layout.setExpanded(folder, !folder->isExpanded);
+        toggleTime += Clock::now() - start;
+
+        const size_t rows = layout.rowCount();
+        start = Clock::now();
+        VBase* item = layout.itemAt(rows ? random() % rows : 0);
+        checksum += item ? layout.rowOf(item).value_or(0) : 0;
+        lookupTime += Clock::now() - start;
+    }
+
+    std::printf("%zu entries, %zu folders, %zu visible rows\n", layout.entryCount(), folders.size(), layout.rowCount());
+    std::printf("build %.2f ms, expand/collapse %.3f us, row lookup and back %.3f us (checksum %zu)\n",
+        std::chrono::duration<double, std::milli>(buildTime).count(),
+        microsPer(toggleTime, operations), microsPer(lookupTime, operations), checksum);
+
+    // Compare with a full walk; a rebuild has to agree with the updates too.
+    for (size_t i = 0; i < 200; ++i) {
+        VFolder* folder = folders[random() % folders.size()];
+        layout.setExpanded(folder, !folder->isExpanded);
+        if (!matches(layout, root)) {
+            std::printf("mismatch after %zu expansion changes\n", i + 1);
+            return 1;
+        }
+    }
+    layout.build(root);
+    if (!matches(layout, root)) {
+        std::printf("mismatch after rebuild\n");
+        return 1;
+    }
+    std::printf("rows match a full walk\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SiblingStepCheck.h"
+#include "ModelFixture.h"
+#include "model/FileSequence.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+// A collapsed folder of files directly in it.
+VFolder hiddenFolder(size_t files, int& order) {
+    VFolder folder;
+    folder.name = "hidden" + std::to_string(order);
+    folder.setOrder(order++);
+    folder.isExpanded = false;
+    for (size_t i = 0; i < files; ++i) {
+        VFile file;
+        file.name = "hidden" + std::to_string(order) + ".txt";
+        file.setOrder(order++);
+        folder.fileList.push_back(std::move(file));
+    }
+    return folder;
+}
+
+// The file FileSequence should step to, found by walking every entry.
+const VBase* expectedStep(const VFolder& root, const VFile* from, bool forward, SiblingScope scope) {
+    vector<const VBase*> entries;
+    vector<const VFolder*> parents;
+    vector<bool> hidden;
+    const auto walk = [&](auto&& self, const VFolder& folder, bool isHidden) -> void {
+        vector<const VBase*> children;
+        for (const VFile& file : folder.fileList) children.push_back(&file);
+        for (const VFolder& subFolder : folder.folderList) children.push_back(&subFolder);
+        std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) { return a->getOrder() < b->getOrder(); });
+        for (const VBase* child : children) {
+            if (const VFolder* subFolder = dynamic_cast<const VFolder*>(child)) {
+                self(self, *subFolder, isHidden || !subFolder->isExpanded);
+            }
+            else {
+                entries.push_back(child);
+                parents.push_back(&folder);
+                hidden.push_back(isHidden);
+            }
+        }
+    };
+    walk(walk, root, false);
+
+    const size_t start = std::find(entries.begin(), entries.end(), from) - entries.begin();
+    const size_t count = entries.size();
+    for (size_t i = 1; i < count; ++i) {
+        const size_t index = forward ? (start + i) % count : (start + count - i) % count;
+        const bool inScope = scope == SiblingScope::AllFiles
+            || (scope == SiblingScope::VisibleFiles && !hidden[index])
+            || (scope == SiblingScope::CurrentFolder && parents[index] == parents[start]);
+        if (inScope) {
+            return entries[index];
+        }
+    }
+    return nullptr;
+}
+
+bool sequenceMatches(FileSequence& sequence, const VFolder& root, std::mt19937& random) {
+    const vector<VFile*> files = root.getAllFiles();
+    for (size_t i = 0; i < 500; ++i) {
+        const VFile* from = files[random() % files.size()];
+        const bool forward = random() % 2 == 0;
+        const SiblingScope scope = static_cast<SiblingScope>(random() % 3);
+        if (sequence.step(root, from, forward, scope) != expectedStep(root, from, forward, scope)) {
+            std::printf("step %s from order %d in scope %d does not match\n", forward ? "forward" : "back",
+                from->getOrder(), static_cast<int>(scope));
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+int runSiblingStepCheck(size_t fileCount) {
+    std::mt19937 random(20391);
+    VFolder root;
+    size_t filesLeft = fileCount - fileCount / 4;
+    int order = 0;
+    while (filesLeft > 0) {
+        addRandomFolder(root, filesLeft, order, random, true);
+        // A quarter of the files in one collapsed folder halfway through.
+        if (root.folderList.size() == 8) {
+            root.folderList.push_back(hiddenFolder(fileCount / 4, order));
+        }
+    }
+    const vector<VFile*> files = root.getAllFiles();
+    if (files.size() < 2 || root.folderList.size() < 9) {
+        std::printf("no entries\n");
+        return 0;
+    }
+    VFolder& hidden = root.folderList[8];
+
+    FileSequence sequence;
+    auto start = Clock::now();
+    sequence.step(root, files[0], true, SiblingScope::AllFiles);
+    const auto buildTime = Clock::now() - start;
+
+    const size_t operations = 100000;
+    size_t checksum = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < operations; ++i) {
+        checksum += sequence.step(root, files[i % files.size()], i % 2 == 0, SiblingScope::VisibleFiles) ? 1 : 0;
+    }
+    const auto stepTime = Clock::now() - start;
+
+    // Out of the collapsed folder from the file in its middle, the way the
+    // active file can be hidden: one jump to either side.
+    const VFile* inside = &hidden.fileList[hidden.fileList.size() / 2];
+    const size_t outOperations = 10000;
+    start = Clock::now();
+    for (size_t i = 0; i < outOperations; ++i) {
+        checksum += sequence.step(root, inside, i % 2 == 0, SiblingScope::VisibleFiles) ? 1 : 0;
+    }
+    const auto outTime = Clock::now() - start;
+    for (const bool forward : { true, false }) {
+        if (sequence.step(root, inside, forward, SiblingScope::VisibleFiles) != expectedStep(root, inside, forward, SiblingScope::VisibleFiles)) {
+            std::printf("stepping %s out of the collapsed folder does not match\n", forward ? "forward" : "back");
+            return 1;
+        }
+    }
+    std::printf("%zu files, %zu in a collapsed folder: build %.2f ms, step %.3f us, step out of the collapsed folder %.3f us (checksum %zu)\n",
+        files.size(), hidden.fileList.size(), std::chrono::duration<double, std::milli>(buildTime).count(),
+        microsPer(stepTime, operations), microsPer(outTime, outOperations), checksum);
+
+    // The first step after an edit pays for the rebuild.
+    const size_t edits = 50;
+    Clock::duration editedTime{};
+    for (size_t i = 0; i < edits; ++i) {
+        VFile* edited = files[random() % files.size()];
+        edited->setOrder(edited->getOrder());
+        start = Clock::now();
+        checksum += sequence.step(root, edited, true, SiblingScope::VisibleFiles) ? 1 : 0;
+        editedTime += Clock::now() - start;
+    }
+    std::printf("first step after an edit %.3f ms\n", microsPer(editedTime, edits) / 1000);
+
+    // Expansion changes need no rebuild; other changes rebuild on the next step.
+    for (size_t i = 0; i < 20; ++i) {
+        vector<VFolder*> folders = root.getAllFolders();
+        VFolder* folder = folders[random() % folders.size()];
+        folder->isExpanded = !folder->isExpanded;
+        if (i % 5 == 4) {
+            ++modelRevision;
+        }
+        if (!sequenceMatches(sequence, root, random)) {
+            return 1;
+        }
+    }
+
+    // With every file hidden, no other file is visible from inside.
+    VFolder onlyHidden;
+    int hiddenOrder = 0;
+    onlyHidden.folderList.push_back(hiddenFolder(5, hiddenOrder));
+    const VFile* first = &onlyHidden.folderList[0].fileList[0];
+    if (sequence.step(onlyHidden, first, true, SiblingScope::VisibleFiles) != nullptr
+        || sequence.step(onlyHidden, first, false, SiblingScope::VisibleFiles) != nullptr
+        || sequence.step(onlyHidden, first, true, SiblingScope::AllFiles) != &onlyHidden.folderList[0].fileList[1]) {
+        std::printf("stepping inside a model of hidden files does not match\n");
+        return 1;
+    }
+    sequence.clear();
+
+    std::printf("file steps match a full walk\n");
+    return 0;
+}
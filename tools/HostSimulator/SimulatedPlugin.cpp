@@ -0,0 +1,180 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SimulatedPlugin.h"
+#include "BufferHandlers.h"
+#include "TreeItems.h"
+#include "model/BufferStates.h"
+#include "model/FileTable.h"
+
+#include <fstream>
+
+
+SimulatedPlugin::SimulatedPlugin(InMemoryHostBridge& host) : host(host) {
+    // What the panel does on TVN_DELETEITEM and TVN_ITEMEXPANDING.
+    treeView.onDeleted = [](HTREEITEM item) { treeItemDeleted(item); };
+    treeView.onExpanding = [this](HTREEITEM item) {
+        if (const TreeItemSpec* spec = treeView.find(item)) {
+            if (optional<VFolder*> folder = root.findFolderByOrder(static_cast<int>(spec->param))) {
+                materializeFolder(*folder);
+            }
+        }
+    };
+    setTreeControl(&treeView);
+    // The tree items of the model are the only ones, so nothing else is needed
+    // to give a file its item or to select it.
+    hooks.writeStorage = [this] { writeStorage(); };
+}
+
+SimulatedPlugin::~SimulatedPlugin() {
+    setTreeControl(nullptr);
+}
+
+void SimulatedPlugin::loadModel(const VFolder& storedRoot) {
+    treeView.clear();
+    forgetTreeItems();
+    root = storedRoot;
+    root.setOrder(-1);
+    bufferStates.clear();
+
+    const bool darkMode = host.isDarkModeEnabled();
+    HTREEITEM prevItem = TVI_FIRST;
+    for (VBase* child : root.getAllDirectChildren()) {
+        if (VFile* file = dynamic_cast<VFile*>(child)) {
+            prevItem = addFileToTree(file, TVI_ROOT, darkMode, prevItem);
+        }
+        else {
+            prevItem = addFolderToTree(static_cast<VFolder*>(child), TVI_ROOT, prevItem);
+        }
+    }
+}
+
+void SimulatedPlugin::nppReady() {
+    flushQueued();
+    startupOrShutdown = false;
+    isNppReady = true;
+
+    // syncVDataWithBufferIDs: bind stored entries to the buffers Notepad++ restored.
+    for (int view = HOST_MAIN_VIEW; view <= HOST_SUB_VIEW; ++view) {
+        const int count = host.openFileCount(view);
+        for (int index = 0; index < count; ++index) {
+            const HostBufferID bufferID = host.bufferIDAt(index, view);
+            const string path = hostPathToUtf8(host.fullPathOfBuffer(bufferID));
+            VFile* vFile = path.find_first_of("/\\") != string::npos
+                ? root.findFileByPath(path, view)
+                : root.findFileByName(path, view);
+            if (vFile && vFile->bufferID == 0) {
+                vFile->bufferID = bufferID;
+                bufferStates.bind(*vFile);
+            }
+        }
+    }
+    ++fileStateRevision;
+
+    // bufferActivated() resolves the real view from the buffer position.
+    bufferActivated(host.currentBufferID(), HOST_MAIN_VIEW);
+    flushQueued();
+}
+
+void SimulatedPlugin::bufferActivated(HostBufferID bufferID, int view) {
+    if (coalescing) {
+        queue.push(QueuedNotificationKind::Activated, bufferID, view);
+        return;
+    }
+    handleBufferActivated(root, host, bufferID, view, true, hooks);
+}
+
+void SimulatedPlugin::fileOpened(HostBufferID bufferID) {
+    const intptr_t position = host.positionOfBuffer(bufferID, HOST_MAIN_VIEW);
+    const int view = position == -1 ? HOST_MAIN_VIEW : positionView(position);
+    if (coalescing) {
+        queue.push(QueuedNotificationKind::Opened, bufferID, view);
+        return;
+    }
+    handleBufferActivated(root, host, bufferID, view, true, hooks);
+}
+
+void SimulatedPlugin::fileClosed(HostBufferID bufferID) {
+    if (!isNppReady || startupOrShutdown) return;
+    const unsigned openViews = openViewsOfBuffer(host, bufferID);
+    if (coalescing) {
+        queue.push(QueuedNotificationKind::Closed, bufferID, HOST_MAIN_VIEW, openViews);
+        return;
+    }
+    handleBufferClosed(root, host, bufferID, openViews, hooks);
+}
+
+void SimulatedPlugin::fileRenamed(HostBufferID bufferID) {
+    flushQueued();
+    if (!isNppReady) return;
+    if (host.positionOfBuffer(bufferID, HOST_MAIN_VIEW) == -1) return;
+
+    handleBufferRenamed(root, bufferID, hostPathToUtf8(host.fullPathOfBuffer(bufferID)), hooks);
+}
+
+void SimulatedPlugin::fileSaved(HostBufferID bufferID) {
+    flushQueued();
+    if (!isNppReady) return;
+
+    handleBufferSaved(root, host, bufferID, hostPathToUtf8(host.fullPathOfBuffer(bufferID)), hooks);
+}
+
+size_t SimulatedPlugin::sessionFilesChecked(const vector<string>& paths, const FileStatBatchResult& result) {
+    flushQueued();
+    return handleSessionFilesChecked(root, paths, result, hooks);
+}
+
+void SimulatedPlugin::flushQueued() {
+    if (queue.empty()) return;
+
+    // ScopedStorageWriteBatch: one write for the whole batch.
+    inBatch = true;
+    for (const QueuedNotification& queued : queue.take()) {
+        if (queued.kind == QueuedNotificationKind::Closed) {
+            handleBufferClosed(root, host, queued.bufferID, queued.openViews, hooks);
+        }
+        else {
+            handleBufferActivated(root, host, queued.bufferID, queued.view, queued.selectItem, hooks);
+        }
+    }
+    inBatch = false;
+    if (writePending) {
+        writePending = false;
+        writeStorageNow();
+    }
+}
+
+void SimulatedPlugin::writeStorage() {
+    if (inBatch) {
+        writePending = true;
+        return;
+    }
+    writeStorageNow();
+}
+
+void SimulatedPlugin::writeStorageNow() {
+    // Same serialization as writeJsonFile(); the file is only written when
+    // a storage path was given, so runs measure the model and JSON cost.
+    const json vDataJson = root;
+    const std::string serialized = vDataJson.dump(4);
+    lastStorageBytes = serialized.size();
+    ++writes;
+
+    if (!storagePath.empty()) {
+        std::ofstream file(storagePath, std::ios::binary | std::ios::trunc);
+        file.write(serialized.data(), static_cast<std::streamsize>(serialized.size()));
+    }
+}
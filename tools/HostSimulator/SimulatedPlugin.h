@@ -0,0 +1,85 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "BufferHandlers.h"
+#include "model/BufferSync.h"
+#include "Bridge/InMemoryHostBridge.h"
+#include "Bridge/HeadlessTreeControl.h"
+#include "Services/NotificationQueue.h"
+
+#include <filesystem>
+
+
+// The plugin's notification handlers with the panel's TreeView replaced by a
+// HeadlessTreeControl: the same handlers (BufferHandlers), and through them
+// the same model updates (BufferSync), tree item code (TreeItems) and host
+// queries, with one storage write wherever the plugin calls writeJsonFile().
+// Startup gating follows beNotified: NPPN_BUFFERACTIVATED is ignored until
+// NPPN_READY, NPPN_FILEOPENED is not.
+// With coalescing on, opens, activations and closes go through the same
+// NotificationQueue as in the plugin and are applied by flushQueued().
+
+class SimulatedPlugin {
+public:
+    explicit SimulatedPlugin(InMemoryHostBridge& host);
+    ~SimulatedPlugin();
+
+    // Model as loaded from the storage file when the panel opens; fills the
+    // tree like the panel does once population has finished.
+    void loadModel(const VFolder& storedRoot);
+    void setStoragePath(const std::filesystem::path& path) { storagePath = path; }
+    void setCoalescing(bool enabled) { coalescing = enabled; }
+
+    void nppReady();
+    void bufferActivated(HostBufferID bufferID, int view);
+    void fileOpened(HostBufferID bufferID);
+    void fileClosed(HostBufferID bufferID);
+    void fileRenamed(HostBufferID bufferID);
+    void fileSaved(HostBufferID bufferID);
+    // The completion of the panel's checkOpenFilesOnDisk().
+    size_t sessionFilesChecked(const vector<string>& paths, const FileStatBatchResult& result);
+
+    // The panel's WM_VF_FLUSH_NOTIFICATIONS.
+    void flushQueued();
+    bool hasQueued() const { return !queue.empty(); }
+
+    bool isStarting() const { return startupOrShutdown; }
+    const VFolder& model() const { return root; }
+    const HeadlessTreeControl& tree() const { return treeView; }
+    void resetTreeOperations() { treeView.resetOperations(); }
+    size_t storageWrites() const { return writes; }
+    size_t storageBytes() const { return lastStorageBytes; }
+
+private:
+    void writeStorage();
+    void writeStorageNow();
+
+    InMemoryHostBridge& host;
+    HeadlessTreeControl treeView;
+    BufferHandlerHooks hooks;
+    VFolder root;
+    std::filesystem::path storagePath;
+    bool startupOrShutdown = true;
+    bool isNppReady = false;
+    bool coalescing = false;
+    NotificationQueue queue;
+    bool inBatch = false;
+    bool writePending = false;
+    size_t writes = 0;
+    size_t lastStorageBytes = 0;
+};
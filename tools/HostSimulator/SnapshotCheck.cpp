@@ -0,0 +1,147 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SnapshotCheck.h"
+#include "ModelFixture.h"
+#include "model/ModelSnapshot.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+
+namespace {
+
+// A folder some levels down, and the number of folders above it.
+VFolder& pickFolder(VFolder& root, std::mt19937& random, size_t& depth) {
+    VFolder* folder = &root;
+    depth = 0;
+    while (!folder->folderList.empty() && random() % 4 != 0) {
+        folder = &folder->folderList[random() % folder->folderList.size()];
+        ++depth;
+    }
+    return *folder;
+}
+
+}
+
+
+int runSnapshotCheck(size_t fileCount) {
+    std::mt19937 random(20256);
+    VFolder root = levelledTree(fileCount);
+    int order = root.getLastOrder() + 1;
+
+    SnapshotPublisher publisher;
+    auto start = Clock::now();
+    const auto first = publisher.publish(root);
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::printf("%zu files: first snapshot %.2f ms, %zu nodes\n", fileCount, elapsed.count(), publisher.lastPublish().created);
+
+    start = Clock::now();
+    const VFolder copy = root;
+    elapsed = Clock::now() - start;
+    std::printf("deep copy of the model %.2f ms\n", elapsed.count());
+
+    start = Clock::now();
+    const auto same = publisher.publish(root);
+    elapsed = Clock::now() - start;
+    std::printf("publish without changes %.2f ms, %zu nodes copied\n", elapsed.count(), publisher.lastPublish().created);
+    int result = 0;
+    if (same != first || json(first->root()) != json(root)) {
+        std::printf("first snapshot does not match the model\n");
+        result = 1;
+    }
+    if (json(first->toVFolder()) != json(root)) {
+        std::printf("snapshot does not turn back into the model\n");
+        result = 1;
+    }
+
+    // Renames and state changes copy one path; an added file renumbers
+    // nothing here because it takes a fresh order.
+    const string firstJson = json(first->root()).dump();
+    size_t copied = 0, pathLengths = 0, steps = 0;
+    std::map<uint64_t, size_t> fileCounts;
+    std::mutex countsMutex;
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> reads{ 0 };
+    std::atomic<size_t> mismatches{ 0 };
+    vector<std::pair<uint64_t, size_t>> seen;
+
+    std::thread reader([&]() {
+        while (!done) {
+            const auto snapshot = publisher.current();
+            seen.emplace_back(snapshot->sequence(), snapshot->allFiles().size());
+            ++reads;
+        }
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(countsMutex);
+        fileCounts[first->sequence()] = root.getAllFiles().size();
+    }
+    for (size_t step = 0; step < 500; ++step) {
+        size_t depth = 0;
+        VFolder& folder = pickFolder(root, random, depth);
+        if (step % 5 == 4 || folder.fileList.empty()) {
+            VFile file;
+            file.name = "Added" + std::to_string(step) + ".txt";
+            file.setOrder(order++);
+            folder.fileList.push_back(file);
+        }
+        else {
+            VFile& file = folder.fileList[random() % folder.fileList.size()];
+            if (step % 2) file.name = "Renamed" + std::to_string(step) + ".txt";
+            else file.setEdited(!file.edited());
+        }
+        const size_t modelFiles = root.getAllFiles().size();
+        {
+            std::lock_guard<std::mutex> lock(countsMutex);
+            fileCounts[publisher.current()->sequence() + 1] = modelFiles;
+        }
+        const auto snapshot = publisher.publish(root);
+        copied += publisher.lastPublish().created;
+        pathLengths += depth + 2;	// The file, its folder and the folders above, and the root
+        ++steps;
+        if (step % 50 == 0 && json(snapshot->root()) != json(root)) {
+            std::printf("snapshot %llu does not match the model\n", static_cast<unsigned long long>(snapshot->sequence()));
+            result = 1;
+        }
+    }
+    done = true;
+    reader.join();
+
+    for (const auto& [sequence, count] : seen) {
+        if (fileCounts.at(sequence) != count) ++mismatches;
+    }
+    std::printf("%zu changes: %.1f nodes copied per change for a path of %.1f\n", steps,
+        static_cast<double>(copied) / steps, static_cast<double>(pathLengths) / steps);
+    std::printf("reader took %zu snapshots, %zu of them inconsistent\n", reads.load(), mismatches.load());
+    if (copied != pathLengths || mismatches != 0) {
+        result = 1;
+    }
+    if (json(first->root()).dump() != firstJson || json(publisher.current()->root()) != json(root)) {
+        std::printf("an older snapshot changed, or the last one does not match the model\n");
+        result = 1;
+    }
+    if (result == 0) {
+        std::printf("snapshots match the model\n");
+    }
+    return result;
+}
@@ -0,0 +1,27 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario snapshots: publishes model/ModelSnapshot snapshots of a nested
+// model while changing it, counts the nodes each change copies, checks every
+// snapshot against the model it was taken from and that older snapshots stay
+// as they were, and reads snapshots on another thread in the meantime.
+// Returns the process exit code.
+int runSnapshotCheck(size_t fileCount);
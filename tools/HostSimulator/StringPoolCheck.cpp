@@ -0,0 +1,193 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "StringPoolCheck.h"
+#include "ModelFixture.h"
+#include "AllocationCounter.h"
+#include "model/ModelSnapshot.h"
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+
+namespace {
+
+// Names are in the string pool, paths in the path trie.
+struct Texts {
+    vector<const PooledString*> names;
+    vector<const PooledPath*> paths;
+
+    size_t size() const { return names.size() + paths.size(); }
+};
+
+void collect(const VFolder& folder, Texts& texts, size_t& containers) {
+    texts.names.push_back(&folder.name);
+    texts.paths.push_back(&folder.path);
+    containers += !folder.fileList.empty() + !folder.folderList.empty();
+    for (const VFile& file : folder.fileList) {
+        texts.names.push_back(&file.name);
+        texts.paths.push_back(&file.path);
+        texts.paths.push_back(&file.backupFilePath);
+    }
+    for (const VFolder& subFolder : folder.folderList) {
+        collect(subFolder, texts, containers);
+    }
+}
+
+void collect(const SnapshotFolder& folder, Texts& texts) {
+    texts.names.push_back(&folder.name);
+    texts.paths.push_back(&folder.path);
+    for (const auto& file : folder.files) {
+        texts.names.push_back(&file->name);
+        texts.paths.push_back(&file->path);
+        texts.paths.push_back(&file->backupFilePath);
+    }
+    for (const auto& subFolder : folder.folders) {
+        collect(*subFolder, texts);
+    }
+}
+
+// Clones follow their original in the same folder.
+bool clonesShareTexts(const VFolder& folder) {
+    for (size_t i = 1; i < folder.fileList.size(); ++i) {
+        const VFile& original = folder.fileList[i - 1];
+        const VFile& clone = folder.fileList[i];
+        if (clone.view == 1 && (&clone.name.str() != &original.name.str() || !(clone.path == original.path))) {
+            return false;
+        }
+    }
+    for (const VFolder& subFolder : folder.folderList) {
+        if (!clonesShareTexts(subFolder)) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+
+int runStringPoolCheck(size_t fileCount) {
+    int result = 0;
+
+    // The second tree finds every text in the pool and the trie already, so
+    // the difference is what they allocated.
+    AllocationSnapshot before = allocationSnapshot();
+    auto root = std::make_unique<VFolder>();
+    fillProjects(*root, fileCount);
+    const size_t withPool = allocationSnapshot().bytes - before.bytes;
+    before = allocationSnapshot();
+    auto second = std::make_unique<VFolder>();
+    fillProjects(*second, fileCount);
+    const size_t withoutPool = allocationSnapshot().bytes - before.bytes;
+    second.reset();
+    const size_t poolBytes = withPool - withoutPool;
+
+    // The plugin holds the model and the snapshot published from it.
+    auto snapshots = std::make_unique<SnapshotPublisher>();
+    std::shared_ptr<const ModelSnapshot> snapshot = snapshots->publish(*root);
+    Texts texts;
+    size_t containers = 0;
+    collect(*root, texts, containers);
+    Texts modelTexts = texts;
+    collect(snapshot->root(), texts);
+    const StringPoolStats stats = stringPool().stats();
+    const PathTrieStats trieStats = pathTrie().stats();
+
+    // As std::string members, the model's texts and then the snapshot's.
+    vector<string> copies;
+    copies.reserve(texts.size());
+    before = allocationSnapshot();
+    const auto copyAll = [&copies](const Texts& some) {
+        for (const PooledString* name : some.names) copies.push_back(name->str());
+        for (const PooledPath* path : some.paths) copies.push_back(path->str());
+    };
+    copyAll(modelTexts);
+    const size_t stringAllocations = allocationSnapshot().count - before.count;
+    modelTexts.names.assign(texts.names.begin() + modelTexts.names.size(), texts.names.end());
+    modelTexts.paths.assign(texts.paths.begin() + modelTexts.paths.size(), texts.paths.end());
+    copyAll(modelTexts);
+    const AllocationSnapshot copied = allocationSnapshot();
+    const size_t stringBytes = texts.size() * sizeof(string) + copied.bytes - before.bytes;
+    const size_t handleBytes = texts.names.size() * sizeof(PooledString) + texts.paths.size() * sizeof(PooledPath);
+    const size_t pooledBytes = handleBytes + poolBytes;
+    copies.clear();
+    copies.shrink_to_fit();
+
+    std::printf("%zu files, %zu names and paths in the model and its snapshot: %zu distinct texts of %.1f KiB, %zu path nodes\n",
+        fileCount, texts.size(), stats.strings, kib(stats.bytes), trieStats.nodes);
+    std::printf("as std::string %.1f KiB, pooled %.1f KiB (%.1f KiB handles, %.1f KiB pool and trie): %.1f KiB saved, %.0f%%\n",
+        kib(stringBytes), kib(pooledBytes), kib(handleBytes), kib(poolBytes),
+        kib(stringBytes) - kib(pooledBytes), 100.0 * (1.0 - static_cast<double>(pooledBytes) / stringBytes));
+    if (pooledBytes >= stringBytes) {
+        std::printf("pooling the texts saved nothing\n");
+        result = 1;
+    }
+
+    if (!clonesShareTexts(*root)) {
+        std::printf("a clone does not share the texts of its original\n");
+        result = 1;
+    }
+
+    // Copying the tree allocates its lists and nothing for the texts in them.
+    before = allocationSnapshot();
+    {
+        const VFolder copy = *root;
+    }
+    const size_t copyAllocations = allocationSnapshot().count - before.count;
+    std::printf("copying the tree: %zu allocations, std::string members would add %zu\n",
+        copyAllocations, stringAllocations);
+    if (copyAllocations != containers) {
+        std::printf("copying the tree made %zu allocations for %zu lists\n", copyAllocations, containers);
+        result = 1;
+    }
+
+    // Snapshots copy the model on the UI thread and drop the copies on
+    // others, while the model goes on renaming files.
+    {
+        vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([copy = VFolder(*root)]() mutable {
+                for (int round = 0; round < 20; ++round) {
+                    VFolder again = copy;
+                    copy = std::move(again);
+                }
+            });
+        }
+        for (VFolder& project : root->folderList) {
+            for (VFolder& subFolder : project.folderList) {
+                for (VFile& file : subFolder.fileList) {
+                    file.name = "renamed_" + file.name;
+                }
+            }
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    snapshot.reset();
+    snapshots.reset();
+    root.reset();
+    if (stringPool().stats().strings != 0 || pathTrie().stats().nodes != 0) {
+        std::printf("%zu texts and %zu path nodes are left after the model is gone\n",
+            stringPool().stats().strings, pathTrie().stats().nodes);
+        result = 1;
+    }
+
+    if (result == 0) {
+        std::printf("names and paths are stored once\n");
+    }
+    return result;
+}
@@ -0,0 +1,29 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario strings: builds a model shaped like several checked-out projects,
+// with every fourth file also open in the second view, and measures its names
+// in model/StringPool and paths in model/PathTrie against the same texts as
+// std::string members. Checks that clones share their texts, that copying the
+// tree allocates nothing for them, and that the pool and the trie let go of
+// every text once copies made and dropped on several threads are gone.
+// Returns the process exit code.
+int runStringPoolCheck(size_t fileCount);
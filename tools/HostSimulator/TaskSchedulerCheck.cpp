@@ -0,0 +1,217 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TaskSchedulerCheck.h"
+#include "ModelFixture.h"
+#include "Services/TaskScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+// Counts down to zero; the caller waits for it.
+class Latch {
+public:
+    explicit Latch(size_t count) : count(count) {}
+
+    void arrive() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--count == 0) done.notify_all();
+    }
+
+    bool wait(std::chrono::seconds limit) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return done.wait_for(lock, limit, [this]() { return count == 0; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t count;
+};
+
+// Splits [first, last) until the pieces are small, the way a search splits a
+// folder; every piece is a task submitted from a worker.
+void sumRange(TaskScheduler& scheduler, uint64_t first, uint64_t last, std::atomic<uint64_t>& sum, Latch& latch) {
+    if (last - first <= 4096) {
+        uint64_t piece = 0;
+        for (uint64_t i = first; i < last; ++i) piece += i;
+        sum += piece;
+        latch.arrive();
+        return;
+    }
+    const uint64_t middle = first + (last - first) / 2;
+    scheduler.submit([&scheduler, first, middle, &sum, &latch]() { sumRange(scheduler, first, middle, sum, latch); });
+    sumRange(scheduler, middle, last, sum, latch);
+}
+
+size_t pieceCount(uint64_t length) {
+    return length <= 4096 ? 1 : pieceCount(length / 2) + pieceCount(length - length / 2);
+}
+
+void spin(std::chrono::microseconds duration) {
+    const auto until = Clock::now() + duration;
+    while (Clock::now() < until) {}
+}
+
+}
+
+
+int runTaskSchedulerCheck(size_t taskCount) {
+    int result = 0;
+
+    {
+        TaskScheduler scheduler;
+        const uint64_t length = static_cast<uint64_t>(taskCount) * 4096;
+        std::atomic<uint64_t> sum{ 0 };
+        Latch latch(pieceCount(length));
+        const auto start = Clock::now();
+        scheduler.submit([&]() { sumRange(scheduler, 0, length, sum, latch); });
+        const bool finished = latch.wait(std::chrono::seconds(60));
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        const TaskSchedulerStats stats = scheduler.stats();
+        std::printf("split sum on %zu workers: %zu pieces in %.1f ms, %llu tasks run, %llu stolen\n",
+            scheduler.workerCount(), pieceCount(length), elapsed.count(),
+            static_cast<unsigned long long>(stats.executed), static_cast<unsigned long long>(stats.stolen));
+        if (!finished || sum != length * (length - 1) / 2) {
+            std::printf("split sum is wrong\n");
+            result = 1;
+        }
+    }
+
+    {
+        // Every 50th task is 100 times longer; idle workers take the short ones.
+        TaskScheduler scheduler;
+        std::chrono::microseconds serial{ 0 };
+        Latch latch(taskCount);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < taskCount; ++i) {
+            const std::chrono::microseconds duration(i % 50 == 0 ? 2000 : 20);
+            serial += duration;
+            scheduler.submit([duration, &latch]() { spin(duration); latch.arrive(); });
+        }
+        const bool finished = latch.wait(std::chrono::seconds(60));
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        std::printf("%zu uneven tasks: %.1f ms, %.1f ms one after the other\n", taskCount, elapsed.count(), serial.count() / 1000.0);
+        if (!finished) {
+            std::printf("uneven tasks did not finish\n");
+            result = 1;
+        }
+    }
+
+    {
+        // One worker, held up until everything is queued.
+        TaskScheduler scheduler(1);
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool holding = false;
+        bool open = false;
+        std::string order;
+        Latch latch(4);
+        scheduler.submit([&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            holding = true;
+            changed.notify_all();
+            changed.wait(lock, [&]() { return open; });
+            latch.arrive();
+        });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return holding; });
+        }
+        scheduler.submit([&]() { order += 'L'; latch.arrive(); }, TaskPriority::Low);
+        scheduler.submit([&]() { order += 'N'; latch.arrive(); }, TaskPriority::Normal);
+        scheduler.submit([&]() { order += 'H'; latch.arrive(); }, TaskPriority::High);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        changed.notify_all();
+        latch.wait(std::chrono::seconds(10));
+        std::printf("priorities ran in the order %s\n", order.c_str());
+        if (order != "HNL") {
+            result = 1;
+        }
+    }
+
+    {
+        TaskScheduler scheduler;
+        std::mutex mutex;
+        std::condition_variable woken;
+        size_t wakes = 0;
+        scheduler.setUiWaker([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++wakes;
+            woken.notify_all();
+        });
+        const std::thread::id ui = std::this_thread::get_id();
+        std::atomic<size_t> ranOnUi{ 0 };
+        for (size_t i = 0; i < taskCount; ++i) {
+            scheduler.submit([&]() {
+                scheduler.postToUi([&]() {
+                    if (std::this_thread::get_id() == ui) ++ranOnUi;
+                });
+            });
+        }
+        size_t completed = 0;
+        size_t handled = 0;
+        const auto limit = Clock::now() + std::chrono::seconds(60);
+        while (completed < taskCount && Clock::now() < limit) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                woken.wait_for(lock, std::chrono::milliseconds(100), [&]() { return wakes > handled; });
+                handled = wakes;
+            }
+            completed += scheduler.runCompletions();
+        }
+        std::printf("%zu completions on the calling thread after %zu wake-ups\n", ranOnUi.load(), wakes);
+        if (completed != taskCount || ranOnUi != taskCount) {
+            result = 1;
+        }
+    }
+
+    {
+        TaskScheduler scheduler(2);
+        std::atomic<size_t> ran{ 0 };
+        for (size_t i = 0; i < taskCount; ++i) {
+            scheduler.submit([&ran]() { spin(std::chrono::microseconds(200)); ++ran; });
+        }
+        const auto start = Clock::now();
+        scheduler.shutdown();
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        const size_t before = ran;
+        scheduler.submit([&ran]() { ++ran; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::printf("shut down in %.1f ms with %zu of %zu tasks run\n", elapsed.count(), before, taskCount);
+        if (ran != before) {
+            std::printf("a task ran after shutdown\n");
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        std::printf("scheduler checks passed\n");
+    }
+    return result;
+}
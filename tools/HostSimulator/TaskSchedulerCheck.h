@@ -0,0 +1,27 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario tasks: runs Services/TaskScheduler through a recursive split of
+// a sum (tasks that submit tasks, and get stolen), a batch of tasks of very
+// different lengths, the order of priorities on a single worker, completions
+// handed back to the calling thread, and a shutdown with tasks still queued.
+// Returns the process exit code.
+int runTaskSchedulerCheck(size_t taskCount);
@@ -0,0 +1,365 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TraceScript.h"
+#include "AllocationCounter.h"
+#include "model/Session.h"
+
+#include <sstream>
+
+
+using Clock = std::chrono::steady_clock;
+
+
+namespace {
+
+// Everything but open, ready and idle acts on an existing tab.
+bool addressesTab(TraceOp op) {
+    return op != TraceOp::Open && op != TraceOp::Ready && op != TraceOp::Idle;
+}
+
+bool parseOp(const std::string& word, TraceOp& op) {
+    static const std::map<std::string, TraceOp> ops = {
+        { "open", TraceOp::Open },
+        { "activate", TraceOp::Activate },
+        { "close", TraceOp::Close },
+        { "clone", TraceOp::Clone },
+        { "move", TraceOp::Move },
+        { "rename", TraceOp::Rename },
+        { "save", TraceOp::Save },
+        { "ready", TraceOp::Ready },
+        { "idle", TraceOp::Idle }
+    };
+    auto it = ops.find(word);
+    if (it == ops.end()) return false;
+    op = it->second;
+    return true;
+}
+
+std::string restOfLine(std::istringstream& line) {
+    std::string rest;
+    std::getline(line >> std::ws, rest);
+    return rest;
+}
+
+VFile storedFile(const std::string& path, int view, int order) {
+    VFile file;
+    file.setOrder(order);
+    file.path = path;
+    file.name = fileNameOfPath(path);
+    file.view = view;
+    return file;
+}
+
+template <typename Handler>
+void timed(ReplayReport& report, SimulatedPlugin& plugin, InMemoryHostBridge& host, const char* name, Handler&& handler) {
+    HandlerStats& stats = report.handlers[name];
+    stats.micros.reserve(stats.micros.size() + 1);
+
+    const size_t queriesBefore = host.queryCount();
+    const size_t treeOperationsBefore = plugin.tree().operationCount();
+    const AllocationSnapshot before = allocationSnapshot();
+    const Clock::time_point start = Clock::now();
+    {
+        ScopedHostEvent hostEvent;
+        handler();
+    }
+    const Clock::time_point end = Clock::now();
+    const AllocationSnapshot after = allocationSnapshot();
+
+    stats.micros.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    stats.allocations += after.count - before.count;
+    stats.allocatedBytes += after.bytes - before.bytes;
+    stats.hostQueries += host.queryCount() - queriesBefore;
+    stats.treeOperations += plugin.tree().operationCount() - treeOperationsBefore;
+}
+
+// Notepad++ activates the neighbouring tab after a close.
+void activateCurrent(ReplayReport& report, SimulatedPlugin& plugin, InMemoryHostBridge& host) {
+    if (plugin.isStarting()) return;
+    const HostBufferID current = host.currentBufferID();
+    if (current == 0) return;
+    const int view = positionView(host.positionOfBuffer(current, HOST_MAIN_VIEW));
+    timed(report, plugin, host, "bufferActivated", [&]() { plugin.bufferActivated(current, view); });
+}
+
+}
+
+
+bool parseTraceScript(std::istream& input, Trace& trace, std::string& error) {
+    std::string text;
+    size_t lineNumber = 0;
+    while (std::getline(input, text)) {
+        ++lineNumber;
+        const size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+
+        std::istringstream line(text);
+        std::string word;
+        if (!(line >> word)) continue;
+
+        TraceAction action;
+        if (!parseOp(word, action.op)) {
+            error = "line " + std::to_string(lineNumber) + ": unknown action '" + word + "'";
+            return false;
+        }
+        if ((action.op == TraceOp::Open || addressesTab(action.op)) && !(line >> action.view)) {
+            error = "line " + std::to_string(lineNumber) + ": missing view";
+            return false;
+        }
+        if (action.op == TraceOp::Open) {
+            action.path = restOfLine(line);
+        }
+        else if (addressesTab(action.op)) {
+            if (!(line >> action.index)) {
+                error = "line " + std::to_string(lineNumber) + ": missing tab index";
+                return false;
+            }
+            action.path = restOfLine(line);
+        }
+        if ((action.op == TraceOp::Open || action.op == TraceOp::Rename) && action.path.empty()) {
+            error = "line " + std::to_string(lineNumber) + ": missing path";
+            return false;
+        }
+        trace.actions.push_back(std::move(action));
+    }
+    return true;
+}
+
+Trace sessionRestoreScenario(size_t fileCount) {
+    // A stored model of folders holding 25 files each, restored by Notepad++
+    // one tab at a time before NPPN_READY.
+    constexpr size_t filesPerFolder = 25;
+    Trace trace;
+    int order = 0;
+    for (size_t first = 0; first < fileCount; first += filesPerFolder) {
+        VFolder folder;
+        folder.setOrder(order++);
+        folder.name = "folder" + std::to_string(first / filesPerFolder);
+        folder.isExpanded = true;
+        for (size_t i = first; i < std::min(fileCount, first + filesPerFolder); ++i) {
+            const std::string path = "C:\\work\\project\\" + folder.name + "\\file" + std::to_string(i) + ".cpp";
+            folder.fileList.push_back(storedFile(path, HOST_MAIN_VIEW, order++));
+            trace.actions.push_back({ TraceOp::Open, HOST_MAIN_VIEW, 0, path });
+        }
+        trace.storedModel.folderList.push_back(std::move(folder));
+    }
+    trace.actions.push_back({ TraceOp::Ready, HOST_MAIN_VIEW, 0, {} });
+    for (size_t i = 0; i < fileCount; i += 10) {
+        trace.actions.push_back({ TraceOp::Activate, HOST_MAIN_VIEW, static_cast<int>(i), {} });
+    }
+    return trace;
+}
+
+Trace massCloseScenario(size_t fileCount) {
+    // Open files one by one after startup, then close every tab ("Close All").
+    Trace trace;
+    trace.actions.push_back({ TraceOp::Ready, HOST_MAIN_VIEW, 0, {} });
+    for (size_t i = 0; i < fileCount; ++i) {
+        trace.actions.push_back({ TraceOp::Open, HOST_MAIN_VIEW, 0, "C:\\work\\scratch\\file" + std::to_string(i) + ".txt" });
+        trace.actions.push_back({ TraceOp::Idle, HOST_MAIN_VIEW, 0, {} });
+    }
+    for (size_t i = 0; i < fileCount; ++i) {
+        trace.actions.push_back({ TraceOp::Close, HOST_MAIN_VIEW, 0, {} });
+    }
+    return trace;
+}
+
+Trace sessionXmlScenario(const std::filesystem::path& sessionFile) {
+    // What the plugin sees on startup with this session.xml and a storage
+    // file created from it by listOpenFiles().
+    Trace trace;
+    const Session session = loadSessionFromXMLFile(sessionFile);
+    int order = 0;
+    for (int view = HOST_MAIN_VIEW; view <= HOST_SUB_VIEW; ++view) {
+        const SessionView& sessionView = view == HOST_MAIN_VIEW ? session.mainView : session.subView;
+        for (const SessionFile& sessionFile : sessionView.files) {
+            const std::string& path = sessionFile.filename;
+            trace.storedModel.fileList.push_back(storedFile(path, view, order++));
+            trace.actions.push_back({ TraceOp::Open, view, 0, path });
+        }
+    }
+    trace.actions.push_back({ TraceOp::Ready, HOST_MAIN_VIEW, 0, {} });
+
+    const SessionView& activeView = session.activeView == HOST_SUB_VIEW ? session.subView : session.mainView;
+    if (activeView.activeIndex >= 0 && activeView.activeIndex < static_cast<int>(activeView.files.size())) {
+        trace.actions.push_back({ TraceOp::Activate, session.activeView == HOST_SUB_VIEW ? HOST_SUB_VIEW : HOST_MAIN_VIEW, activeView.activeIndex, {} });
+    }
+    return trace;
+}
+
+Trace notificationTraceScenario(const std::vector<NotificationRecord>& records, size_t& ignored) {
+    // A scratch host tracks where each recorded buffer is, so the actions can
+    // address tabs by view and index like a text trace.
+    Trace trace;
+    InMemoryHostBridge layout;
+    std::map<uint64_t, HostBufferID> buffers;
+    ignored = 0;
+
+    const auto path = [](uint64_t recordedID) { return "C:\\trace\\buffer" + std::to_string(recordedID) + ".txt"; };
+    const auto tabOf = [&](HostBufferID bufferID, int preferredView, int& view, int& index) {
+        const intptr_t position = layout.positionOfBuffer(bufferID, preferredView == HOST_SUB_VIEW ? HOST_SUB_VIEW : HOST_MAIN_VIEW);
+        if (position == -1) return false;
+        view = positionView(position);
+        index = positionIndex(position);
+        return true;
+    };
+
+    // A pause this long means Notepad++ went back to its message loop, which
+    // ends a burst of queued notifications.
+    constexpr uint64_t idleGapMicros = 20000;
+    uint64_t lastTimestamp = records.empty() ? 0 : records.front().timestampMicros;
+
+    for (const NotificationRecord& record : records) {
+        if (record.timestampMicros - lastTimestamp >= idleGapMicros) {
+            trace.actions.push_back({ TraceOp::Idle, HOST_MAIN_VIEW, 0, {} });
+        }
+        lastTimestamp = record.timestampMicros;
+
+        if (record.source != NotificationSource::Notepad) {
+            ++ignored;
+            continue;
+        }
+
+        const int recordedView = record.view == HOST_SUB_VIEW ? HOST_SUB_VIEW : HOST_MAIN_VIEW;
+        auto known = buffers.find(record.bufferID);
+        int view = recordedView;
+        int index = 0;
+
+        switch (record.code) {
+        case TRACE_NPPN_READY:
+            trace.actions.push_back({ TraceOp::Ready, HOST_MAIN_VIEW, 0, {} });
+            break;
+
+        case TRACE_NPPN_FILEOPENED:
+        case TRACE_NPPN_BUFFERACTIVATED:
+            if (known == buffers.end()) {
+                // Opened, or already open when the recording started.
+                buffers[record.bufferID] = layout.openBuffer(utf8ToHostPath(path(record.bufferID)), recordedView);
+                trace.actions.push_back({ TraceOp::Open, recordedView, 0, path(record.bufferID) });
+            }
+            else if (record.code == TRACE_NPPN_BUFFERACTIVATED && tabOf(known->second, recordedView, view, index)) {
+                if (view != recordedView) {
+                    // Showed up in the other view: clone or the first half of a move.
+                    layout.openBufferInView(known->second, recordedView);
+                    trace.actions.push_back({ TraceOp::Clone, view, index, {} });
+                }
+                else {
+                    layout.activateDocument(view, index);
+                    trace.actions.push_back({ TraceOp::Activate, view, index, {} });
+                }
+            }
+            break;
+
+        case TRACE_NPPN_FILECLOSED:
+            if (known != buffers.end() && tabOf(known->second, recordedView, view, index)) {
+                layout.closeBuffer(known->second, view);
+                trace.actions.push_back({ TraceOp::Close, view, index, {} });
+                if (layout.positionOfBuffer(known->second, HOST_MAIN_VIEW) == -1) {
+                    buffers.erase(known);
+                }
+            }
+            break;
+
+        case TRACE_NPPN_FILERENAMED:
+        case TRACE_NPPN_FILESAVED:
+            if (known != buffers.end() && tabOf(known->second, recordedView, view, index)) {
+                const bool renamed = record.code == TRACE_NPPN_FILERENAMED;
+                const std::string newPath = renamed ? path(record.bufferID) + ".renamed" + std::to_string(trace.actions.size()) : std::string();
+                if (renamed) layout.renameBuffer(known->second, utf8ToHostPath(newPath));
+                trace.actions.push_back({ renamed ? TraceOp::Rename : TraceOp::Save, view, index, newPath });
+            }
+            break;
+
+        default:
+            ++ignored;
+            break;
+        }
+    }
+    return trace;
+}
+
+ReplayReport replayTrace(const Trace& trace, SimulatedPlugin& plugin, InMemoryHostBridge& host) {
+    ReplayReport report;
+    const Clock::time_point start = Clock::now();
+
+    for (const TraceAction& action : trace.actions) {
+        ++report.actions;
+        const int otherView = 1 - action.view;
+        const HostBufferID bufferID = addressesTab(action.op) ? host.bufferIDAt(action.index, action.view) : 0;
+        if (addressesTab(action.op) && bufferID == 0) {
+            continue;    // The trace refers to a tab that is not there
+        }
+
+        switch (action.op) {
+        case TraceOp::Open: {
+            const HostBufferID opened = host.openBuffer(utf8ToHostPath(action.path), action.view);
+            timed(report, plugin, host, "fileOpened", [&]() { plugin.fileOpened(opened); });
+            if (!plugin.isStarting()) {
+                timed(report, plugin, host, "bufferActivated", [&]() { plugin.bufferActivated(opened, action.view); });
+            }
+            break;
+        }
+        case TraceOp::Activate:
+            host.activateDocument(action.view, action.index);
+            if (!plugin.isStarting()) {
+                timed(report, plugin, host, "bufferActivated", [&]() { plugin.bufferActivated(bufferID, action.view); });
+            }
+            break;
+        case TraceOp::Close:
+            host.closeBuffer(bufferID, action.view);
+            timed(report, plugin, host, "fileClosed", [&]() { plugin.fileClosed(bufferID); });
+            activateCurrent(report, plugin, host);
+            break;
+        case TraceOp::Clone:
+            host.openBufferInView(bufferID, otherView);
+            timed(report, plugin, host, "bufferActivated", [&]() { plugin.bufferActivated(bufferID, otherView); });
+            break;
+        case TraceOp::Move:
+            host.openBufferInView(bufferID, otherView);
+            timed(report, plugin, host, "bufferActivated", [&]() { plugin.bufferActivated(bufferID, otherView); });
+            host.closeBuffer(bufferID, action.view);
+            timed(report, plugin, host, "fileClosed", [&]() { plugin.fileClosed(bufferID); });
+            break;
+        case TraceOp::Rename:
+            host.renameBuffer(bufferID, utf8ToHostPath(action.path));
+            timed(report, plugin, host, "fileRenamed", [&]() { plugin.fileRenamed(bufferID); });
+            break;
+        case TraceOp::Save:
+            if (!action.path.empty()) {
+                host.renameBuffer(bufferID, utf8ToHostPath(action.path));
+            }
+            timed(report, plugin, host, "fileSaved", [&]() { plugin.fileSaved(bufferID); });
+            break;
+        case TraceOp::Ready:
+            timed(report, plugin, host, "nppReady", [&]() { plugin.nppReady(); });
+            break;
+        case TraceOp::Idle:
+            if (plugin.hasQueued()) {
+                timed(report, plugin, host, "flushQueued", [&]() { plugin.flushQueued(); });
+            }
+            break;
+        }
+    }
+
+    // The end of the trace stands in for the idle message that ends a burst.
+    if (plugin.hasQueued()) {
+        timed(report, plugin, host, "flushQueued", [&]() { plugin.flushQueued(); });
+    }
+
+    report.wallTime = Clock::now() - start;
+    return report;
+}
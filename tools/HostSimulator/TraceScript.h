@@ -0,0 +1,95 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "SimulatedPlugin.h"
+#include "model/NotificationTrace.h"
+
+#include <chrono>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// A trace is a list of host-side actions. Replaying one changes the in-memory
+// tab layout the way Notepad++ would and sends the notifications Notepad++
+// sends for it; only the plugin handlers are timed.
+//
+// Text form, one action per line (tabs are addressed by view and index at
+// the time of the action; '#' starts a comment):
+//   open <view> <path>
+//   activate <view> <index>
+//   close <view> <index>
+//   clone <view> <index>            (into the other view)
+//   move <view> <index>             (to the other view)
+//   rename <view> <index> <path>
+//   save <view> <index> [<path>]
+//   ready
+//   idle                            (message loop turn: ends a notification burst)
+
+enum class TraceOp {
+    Open,
+    Activate,
+    Close,
+    Clone,
+    Move,
+    Rename,
+    Save,
+    Ready,
+    Idle
+};
+
+struct TraceAction {
+    TraceOp op = TraceOp::Ready;
+    int view = HOST_MAIN_VIEW;
+    int index = 0;
+    std::string path;    // UTF-8
+};
+
+struct Trace {
+    VFolder storedModel;                // Storage file content before the trace starts
+    std::vector<TraceAction> actions;
+};
+
+bool parseTraceScript(std::istream& input, Trace& trace, std::string& error);
+
+// Built-in workloads.
+Trace sessionRestoreScenario(size_t fileCount);
+Trace massCloseScenario(size_t fileCount);
+Trace sessionXmlScenario(const std::filesystem::path& sessionFile);
+
+// Turns a trace recorded by the plugin into host actions. Paths are made up
+// from the recorded buffer IDs; notifications the simulator has no handler
+// for (Scintilla, other NPPN_*) are counted in ignored.
+Trace notificationTraceScenario(const std::vector<NotificationRecord>& records, size_t& ignored);
+
+struct HandlerStats {
+    std::vector<double> micros;
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    size_t hostQueries = 0;
+    size_t treeOperations = 0;  // Calls on the HeadlessTreeControl
+};
+
+struct ReplayReport {
+    std::map<std::string, HandlerStats> handlers;
+    std::chrono::duration<double, std::milli> wallTime{ 0 };
+    size_t actions = 0;
+};
+
+ReplayReport replayTrace(const Trace& trace, SimulatedPlugin& plugin, InMemoryHostBridge& host);
@@ -0,0 +1,371 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TreeRenderCheck.h"
+#include "ModelFixture.h"
+#include "TreeRenderer.h"
+#include "Bridge/HeadlessTreeControl.h"
+#include "Bridge/InMemoryHostBridge.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+vector<VBase*> childrenInOrder(VFolder& folder) {
+    vector<VBase*> children;
+    for (VFile& file : folder.fileList) children.push_back(&file);
+    for (VFolder& subFolder : folder.folderList) children.push_back(&subFolder);
+    std::sort(children.begin(), children.end(), [](const VBase* a, const VBase* b) {
+        return a->getOrder() < b->getOrder();
+    });
+    return children;
+}
+
+bool removeEntry(VFolder& parent, const VBase* entry) {
+    for (auto it = parent.fileList.begin(); it != parent.fileList.end(); ++it) {
+        if (&*it == entry) {
+            parent.fileList.erase(it);
+            return true;
+        }
+    }
+    for (auto it = parent.folderList.begin(); it != parent.folderList.end(); ++it) {
+        if (&*it == entry) {
+            parent.folderList.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+VFolder& parentOf(VFolder& root, const VBase* entry) {
+    VFolder* parent = root.findParentFolder(entry->getOrder());
+    return parent ? *parent : root;
+}
+
+bool matches(const HeadlessTreeControl& tree, HTREEITEM parentItem, VFolder& folder) {
+    const vector<HTREEITEM> items = tree.childrenOf(parentItem);
+    if (parentItem != TVI_ROOT && lazyFolderItems.contains(parentItem)) {
+        for (VFile* file : folder.getAllFiles()) if (file->hTreeItem) return false;
+        for (VFolder* subFolder : folder.getAllFolders()) if (subFolder->hTreeItem) return false;
+        return items.empty();
+    }
+
+    const vector<VBase*> children = childrenInOrder(folder);
+    if (items.size() != children.size()) {
+        std::printf("%s: %zu items for %zu entries\n", folder.name.c_str(), items.size(), children.size());
+        return false;
+    }
+    for (size_t i = 0; i < children.size(); ++i) {
+        const TreeItemSpec* spec = tree.find(items[i]);
+        if (items[i] != children[i]->hTreeItem || !spec || spec->param != children[i]->getOrder()
+                || spec->text != utf8ToHostPath(children[i]->name)) {
+            std::printf("%s: item %zu does not match\n", folder.name.c_str(), i);
+            return false;
+        }
+        VFolder* subFolder = dynamic_cast<VFolder*>(children[i]);
+        if (subFolder && !matches(tree, items[i], *subFolder)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What the filter should show, worked out per entry from fuzzyScore().
+bool expectedShown(const VBase* entry, const string& folded) {
+    if (const VFolder* folder = dynamic_cast<const VFolder*>(entry)) {
+        for (const VFile* file : const_cast<VFolder*>(folder)->getAllFiles()) {
+            if (expectedShown(file, folded)) return true;
+        }
+        return false;
+    }
+    const VFile* file = static_cast<const VFile*>(entry);
+    return fuzzyScore(folded, foldCase(file->name)) >= 0 || fuzzyScore(folded, foldCase(file->path.str())) >= 0;
+}
+
+// Shown entries have their items, expanded, in model order; hidden ones none.
+bool matchesFiltered(const HeadlessTreeControl& tree, HTREEITEM parentItem, VFolder& folder, const string& folded) {
+    vector<VBase*> shown;
+    for (VBase* child : childrenInOrder(folder)) {
+        const bool expected = expectedShown(child, folded);
+        if (expected != treeFilter.shows(child)) {
+            std::printf("%s: filter disagrees on order %d\n", folder.name.c_str(), child->getOrder());
+            return false;
+        }
+        if (expected) {
+            shown.push_back(child);
+        }
+        else if (child->hTreeItem) {
+            std::printf("%s: hidden order %d kept its item\n", folder.name.c_str(), child->getOrder());
+            return false;
+        }
+    }
+
+    const vector<HTREEITEM> items = tree.childrenOf(parentItem);
+    if (items.size() != shown.size()) {
+        std::printf("%s: %zu items for %zu shown entries\n", folder.name.c_str(), items.size(), shown.size());
+        return false;
+    }
+    for (size_t i = 0; i < shown.size(); ++i) {
+        if (items[i] != shown[i]->hTreeItem) {
+            std::printf("%s: item %zu does not match\n", folder.name.c_str(), i);
+            return false;
+        }
+        VFolder* subFolder = dynamic_cast<VFolder*>(shown[i]);
+        if (subFolder && (!tree.isExpanded(items[i]) || !matchesFiltered(tree, items[i], *subFolder, folded))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// After the filter is cleared, folders show their saved expansion again.
+bool expansionRestored(const HeadlessTreeControl& tree, VFolder& root) {
+    for (VFolder* folder : root.getAllFolders()) {
+        if (folder->hTreeItem && !lazyFolderItems.contains(folder->hTreeItem)
+                && tree.isExpanded(folder->hTreeItem) != folder->isExpanded) {
+            std::printf("%s is %s\n", folder->name.c_str(), folder->isExpanded ? "collapsed" : "expanded");
+            return false;
+        }
+    }
+    return true;
+}
+
+struct MoveStats {
+    size_t moves = 0;
+    size_t inserts = 0;     // Items, children included
+    size_t deletes = 0;
+    size_t updates = 0;
+    size_t sorts = 0;
+};
+
+}
+
+
+int runTreeRenderCheck(size_t fileCount) {
+    InMemoryHostBridge host;
+    setHostBridge(&host);
+    HeadlessTreeControl tree;
+    tree.onDeleted = [](HTREEITEM item) { treeItemDeleted(item); };
+    setTreeControl(&tree);
+    forgetTreeItems();
+
+    // One large expanded folder first, the rest nested at random.
+    std::mt19937 random(20252);
+    VFolder root;
+    root.setOrder(-1);
+    int order = 0;
+    VFolder large;
+    large.name = "large";
+    large.setOrder(order++);
+    large.isExpanded = true;
+    const size_t largeFiles = std::min<size_t>(500, fileCount / 2);
+    for (size_t i = 0; i < largeFiles; ++i) {
+        large.fileList.push_back(makeFile(order));
+    }
+    root.folderList.push_back(std::move(large));
+    size_t filesLeft = fileCount - largeFiles;
+    while (filesLeft > 0) {
+        addRandomFolder(root, filesLeft, order, random, true, 4, 3);
+    }
+    root.spreadOrders();
+
+    // The first render fills the empty control.
+    renderTree(root);
+    std::printf("%zu items after the first render, %zu entries in the model\n",
+        tree.itemCount(), root.getAllFiles().size() + root.getAllFolders().size());
+    int exitCode = matches(tree, TVI_ROOT, root) ? 0 : 1;
+
+    // Moving the large folder behind its last sibling keeps its 500 items.
+    // Moves give the moved entries new keys with orderBefore(), as the panel
+    // does, so the orders of the rest stay as they are.
+    tree.resetOperations();
+    size_t insertedBefore = insertedTreeItems;
+    size_t deletedBefore = deletedTreeItems;
+    {
+        ScopedTreeRender render(root);
+        VFolder copy = root.folderList.front();
+        removeEntry(root, &root.folderList.front());
+        root.orderBefore(copy, endOrder);
+        root.folderList.push_back(std::move(copy));
+    }
+    const size_t largeInserts = insertedTreeItems - insertedBefore;
+    std::printf("large folder (%zu files) moved to the end: %zu items inserted, %zu deleted, %zu lParam updates\n", largeFiles,
+        largeInserts, deletedTreeItems - deletedBefore, tree.count(TreeOperationKind::Set));
+    if (largeInserts >= largeFiles || !matches(tree, TVI_ROOT, root)) {
+        exitCode = 1;
+    }
+
+    MoveStats reorders, folderMoves, fileMoves;
+    for (size_t i = 0; i < 300 && exitCode == 0; ++i) {
+        tree.resetOperations();
+        insertedBefore = insertedTreeItems;
+        deletedBefore = deletedTreeItems;
+        MoveStats* stats = nullptr;
+        {
+            ScopedTreeRender render(root);
+            vector<VFolder*> folders = root.getAllFolders();
+            const int kind = static_cast<int>(random() % 3);
+            if (kind == 0) {
+                // Reorder a folder among its siblings.
+                VFolder* folder = folders[random() % folders.size()];
+                VFolder& parent = parentOf(root, folder);
+                vector<VBase*> siblings = childrenInOrder(parent);
+                VBase* before = siblings[random() % siblings.size()];
+                const int nextOrder = before != folder ? before->getOrder() : root.orderAbove(parent.getLastOrder());
+                VFolder copy = *folder;
+                removeEntry(parent, folder);
+                root.orderBefore(copy, nextOrder);
+                parent.folderList.push_back(std::move(copy));
+                stats = &reorders;
+            }
+            else if (kind == 1) {
+                // Move a folder to the end of another folder.
+                VFolder* folder = folders[random() % folders.size()];
+                VFolder* target = folders[random() % folders.size()];
+                if (target == folder || folder->getChildByOrder(target->getOrder())) {
+                    continue;
+                }
+                const int targetOrder = target->getOrder();
+                VFolder copy = *folder;
+                removeEntry(parentOf(root, folder), folder);
+                target = root.findFolderByOrder(targetOrder).value();
+                root.orderBefore(copy, root.orderAbove(target->getLastOrder()));
+                target->folderList.push_back(std::move(copy));
+                stats = &folderMoves;
+            }
+            else {
+                // Move a file in front of any entry.
+                vector<VFile*> files = root.getAllFiles();
+                VFile* file = files[random() % files.size()];
+                vector<VBase*> entries(folders.begin(), folders.end());
+                entries.insert(entries.end(), files.begin(), files.end());
+                VBase* before = entries[random() % entries.size()];
+                if (before == file) {
+                    continue;
+                }
+                const int beforeOrder = before->getOrder();
+                VFile copy = *file;
+                removeEntry(parentOf(root, file), file);
+                before = root.getChildByOrder(beforeOrder).value();
+                VFolder& target = parentOf(root, before);
+                root.orderBefore(copy, beforeOrder);
+                target.fileList.push_back(std::move(copy));
+                stats = &fileMoves;
+            }
+        }
+        stats->moves++;
+        stats->inserts += insertedTreeItems - insertedBefore;
+        stats->deletes += deletedTreeItems - deletedBefore;
+        stats->updates += tree.count(TreeOperationKind::Set);
+        stats->sorts += tree.count(TreeOperationKind::Sort);
+        if (!matches(tree, TVI_ROOT, root)) {
+            std::printf("tree differs from the model after move %zu\n", i + 1);
+            exitCode = 1;
+        }
+    }
+
+    std::printf("%-22s %6s %9s %9s %9s %9s\n", "per move", "moves", "inserts", "deletes", "updates", "sorts");
+    const auto report = [](const char* name, const MoveStats& stats) {
+        const double moves = stats.moves ? static_cast<double>(stats.moves) : 1.0;
+        std::printf("%-22s %6zu %9.1f %9.1f %9.1f %9.1f\n", name, stats.moves,
+            stats.inserts / moves, stats.deletes / moves, stats.updates / moves, stats.sorts / moves);
+    };
+    report("reorder folder", reorders);
+    report("folder into folder", folderMoves);
+    report("file to any position", fileMoves);
+    std::printf(exitCode == 0 ? "tree matches the model after every move\n" : "tree does not match the model\n");
+
+    setTreeControl(nullptr);
+    setHostBridge(nullptr);
+    return exitCode;
+}
+
+int runTreeFilterCheck(size_t fileCount) {
+    InMemoryHostBridge host;
+    setHostBridge(&host);
+    HeadlessTreeControl tree;
+    tree.onDeleted = [](HTREEITEM item) { treeItemDeleted(item); };
+    setTreeControl(&tree);
+    forgetTreeItems();
+    treeFilter.clear();
+
+    std::mt19937 random(20253);
+    VFolder root;
+    root.setOrder(-1);
+    int order = 0;
+    size_t filesLeft = fileCount;
+    while (filesLeft > 0) {
+        addRandomFolder(root, filesLeft, order, random, random() % 2 == 0, 4, 3);
+    }
+    for (VFolder* folder : root.getAllFolders()) {
+        for (VFile& file : folder->fileList) {
+            file.path = "C:\\Work\\" + folder->name + "\\" + file.name;
+        }
+    }
+    ++modelRevision;
+    renderTree(root);
+    std::printf("%zu entries, %zu items before filtering\n",
+        root.getAllFiles().size() + root.getAllFolders().size(), tree.itemCount());
+
+    // The panel builds the candidates when the filter box gets the focus.
+    const auto buildStart = Clock::now();
+    treeFilter.setQuery(root, "");
+    const std::chrono::duration<double, std::milli> buildTime = Clock::now() - buildStart;
+    std::printf("candidates built in %.3f ms\n", buildTime.count());
+
+    // Type a query, take part of it back, type on, then clear it.
+    const string typed = "Fi1.TXt";
+    vector<string> keystrokes;
+    for (size_t i = 1; i <= typed.size(); ++i) keystrokes.push_back(typed.substr(0, i));
+    for (size_t i = typed.size() - 1; i >= 3; --i) keystrokes.push_back(typed.substr(0, i));
+    keystrokes.push_back("fo1\\f");
+    keystrokes.push_back("fo1\\fi2");
+    keystrokes.push_back("");
+
+    int exitCode = 0;
+    std::printf("%-10s %8s %8s %10s %9s %9s\n", "query", "matches", "scored", "filter ms", "inserts", "deletes");
+    for (const string& query : keystrokes) {
+        const auto start = Clock::now();
+        const size_t scored = treeFilter.setQuery(root, query);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+        tree.resetOperations();
+        filterTree(root, query);
+        std::printf("%-10s %8zu %8zu %10.3f %9zu %9zu\n", query.empty() ? "(cleared)" : query.c_str(),
+            treeFilter.matchCount(), scored, elapsed.count(),
+            tree.count(TreeOperationKind::Insert), tree.count(TreeOperationKind::Delete));
+
+        const bool ok = query.empty()
+            ? matches(tree, TVI_ROOT, root) && expansionRestored(tree, root)
+            : matchesFiltered(tree, TVI_ROOT, root, foldCase(query));
+        if (!ok) {
+            std::printf("tree does not match the filter after \"%s\"\n", query.c_str());
+            exitCode = 1;
+            break;
+        }
+    }
+    if (exitCode == 0) {
+        std::printf("tree matches the filter after every keystroke\n");
+    }
+
+    treeFilter.clear();
+    setTreeControl(nullptr);
+    setHostBridge(nullptr);
+    return exitCode;
+}
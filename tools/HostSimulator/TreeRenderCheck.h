@@ -0,0 +1,34 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario moves: fills a HeadlessTreeControl from a synthetic model, then
+// applies random folder reorders, folder-into-folder moves and file moves
+// inside a ScopedTreeRender the way the drag-and-drop handlers do. Reports
+// the control operations per kind of move, checks the tree against the model
+// after each one and that reordering a large folder keeps its items. Returns
+// the process exit code.
+int runTreeRenderCheck(size_t fileCount);
+
+// --scenario filter: types a query into the tree filter one keystroke at a
+// time, takes part of it back and clears it. Reports how many files each
+// keystroke had to score and how long that took, and checks the tree against
+// a filter worked out per entry after each one.
+int runTreeFilterCheck(size_t fileCount);
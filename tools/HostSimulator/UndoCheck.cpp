@@ -0,0 +1,258 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UndoCheck.h"
+#include "ModelFixture.h"
+#include "model/TreeJournal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <set>
+
+
+namespace {
+
+enum class Edit { MoveFile, ReorderFiles, MoveFolder, Wrap, Unwrap, Rename };
+
+size_t stateOf(const VFolder& root) {
+    return std::hash<string>{}(json(root).dump());
+}
+
+vector<VFolder*> foldersWith(VFolder& root, const std::function<bool(const VFolder&)>& wanted) {
+    vector<VFolder*> found;
+    if (wanted(root)) found.push_back(&root);
+    for (VFolder* folder : root.getAllFolders()) {
+        if (wanted(*folder)) found.push_back(folder);
+    }
+    return found;
+}
+
+// One edit of the kind the panel makes, with keys given the way it gives
+// them: only the entries it places get new ones (orderBefore()). Returns
+// false if the model has nothing to apply it to.
+bool edit(VFolder& root, Edit kind, std::mt19937& random, size_t step) {
+    const auto pick = [&](const vector<VFolder*>& folders) { return folders[random() % folders.size()]; };
+    // After everything in the folder, as a drop onto it places an entry.
+    const auto placeInto = [&](VBase& entry, const VFolder& folder) {
+        root.orderBefore(entry, root.orderAbove(folder.getLastOrder()));
+    };
+    const auto any = [](const VFolder&) { return true; };
+    const auto withFiles = [](const VFolder& folder) { return !folder.fileList.empty(); };
+    const auto withFolders = [](const VFolder& folder) { return !folder.folderList.empty(); };
+
+    switch (kind) {
+    case Edit::MoveFile: {
+        const auto sources = foldersWith(root, withFiles);
+        if (sources.empty()) return false;
+        VFolder* source = pick(sources);
+        const size_t index = random() % source->fileList.size();
+        VFile file = std::move(source->fileList[index]);
+        source->fileList.erase(source->fileList.begin() + index);
+        VFolder* target = pick(foldersWith(root, any));
+        placeInto(file, *target);
+        target->fileList.push_back(std::move(file));
+        break;
+    }
+    case Edit::ReorderFiles: {
+        const auto folders = foldersWith(root, [](const VFolder& folder) { return folder.fileList.size() > 1; });
+        if (folders.empty()) return false;
+        VFolder* folder = pick(folders);
+        const size_t index = random() % folder->fileList.size();
+        const int nextOrder = folder->fileList[(index + 1 + random() % (folder->fileList.size() - 1)) % folder->fileList.size()].getOrder();
+        VFile file = std::move(folder->fileList[index]);
+        folder->fileList.erase(folder->fileList.begin() + index);
+        root.orderBefore(file, nextOrder);
+        folder->fileList.push_back(std::move(file));
+        break;
+    }
+    case Edit::MoveFolder: {
+        const auto parents = foldersWith(root, withFolders);
+        if (parents.empty()) return false;
+        VFolder* parent = pick(parents);
+        const size_t index = random() % parent->folderList.size();
+        VFolder moved = std::move(parent->folderList[index]);
+        parent->folderList.erase(parent->folderList.begin() + index);
+        VFolder* target = pick(foldersWith(root, any));	// Detached, so never into itself
+        placeInto(moved, *target);
+        target->folderList.push_back(std::move(moved));
+        break;
+    }
+    case Edit::Wrap: {
+        const auto folders = foldersWith(root, withFiles);
+        if (folders.empty()) return false;
+        VFolder* folder = pick(folders);
+        const size_t index = random() % folder->fileList.size();
+        const int nextOrder = root.orderAbove(folder->fileList[index].getOrder());
+        VFolder wrapper;
+        wrapper.name = "New folder";
+        wrapper.isExpanded = true;
+        wrapper.fileList.push_back(std::move(folder->fileList[index]));
+        folder->fileList.erase(folder->fileList.begin() + index);
+        root.orderBefore(wrapper, nextOrder);	// In the file's place
+        folder->folderList.push_back(std::move(wrapper));
+        break;
+    }
+    case Edit::Unwrap: {
+        const auto parents = foldersWith(root, withFolders);
+        if (parents.empty()) return false;
+        VFolder* parent = pick(parents);
+        const size_t index = random() % parent->folderList.size();
+        VFolder unwrapped = std::move(parent->folderList[index]);
+        parent->folderList.erase(parent->folderList.begin() + index);
+        // Its contents keep their keys, which lie where the folder was.
+        for (VFile& file : unwrapped.fileList) parent->fileList.push_back(std::move(file));
+        for (VFolder& folder : unwrapped.folderList) parent->folderList.push_back(std::move(folder));
+        break;
+    }
+    case Edit::Rename: {
+        const auto folders = root.getAllFolders();
+        if (folders.empty()) return false;
+        pick(folders)->name = "Renamed" + std::to_string(step);
+        return true;
+    }
+    }
+    return true;
+}
+
+}
+
+
+int runUndoCheck(size_t fileCount) {
+    std::mt19937 random(20257);
+    VFolder root = levelledTree(fileCount, true);
+    root.spreadOrders();
+    treeJournal.clear();
+    treeJournal.setBudget(TreeJournal::defaultBudget);
+
+    const size_t edits = 200;
+    const Edit kinds[] = { Edit::MoveFile, Edit::ReorderFiles, Edit::MoveFolder, Edit::Wrap, Edit::Unwrap, Edit::Rename };
+    vector<size_t> states{ stateOf(root) };
+    vector<Edit> made;
+    double editMillis = 0;
+    for (size_t step = 0; made.size() < edits; ++step) {
+        const Edit kind = kinds[step % std::size(kinds)];
+        const auto start = Clock::now();
+        bool changed = false;
+        {
+            ScopedJournalEntry entry(root);
+            changed = edit(root, kind, random, step);
+        }
+        editMillis += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (changed && stateOf(root) != states.back()) {	// Swapping a file with itself changes nothing
+            made.push_back(kind);
+            states.push_back(stateOf(root));
+        }
+    }
+    std::printf("%zu files: %zu edits recorded in %.2f ms each, %zu entries, %.1f KiB\n", fileCount, edits,
+        editMillis / edits, treeJournal.entryCount(), kib(treeJournal.bytesUsed()));
+
+    // Undo all that the budget kept, then redo it, comparing every step.
+    int result = 0;
+    size_t folders = 0, placed = 0, renamePlaced = 0, undos = 0;
+    double undoMillis = 0;
+    const size_t first = made.size() - treeJournal.entryCount();
+    for (size_t k = made.size(); k > first; --k) {
+        const auto start = Clock::now();
+        const bool undone = treeJournal.undo(root);
+        undoMillis += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (!undone || stateOf(root) != states[k - 1]) {
+            std::printf("undo of edit %zu did not restore the model\n", k);
+            result = 1;
+            break;
+        }
+        folders += treeJournal.lastApply().folders;
+        placed += treeJournal.lastApply().files;
+        if (made[k - 1] == Edit::Rename) renamePlaced += treeJournal.lastApply().files;
+        ++undos;
+    }
+    for (size_t k = first + 1; result == 0 && k <= made.size(); ++k) {
+        if (!treeJournal.redo(root) || stateOf(root) != states[k]) {
+            std::printf("redo of edit %zu did not restore the model\n", k);
+            result = 1;
+        }
+    }
+    if (undos > 0) {
+        std::printf("undo %.3f ms: %.1f folders and %.1f files put back of %zu files\n", undoMillis / undos,
+            static_cast<double>(folders) / undos, static_cast<double>(placed) / undos, fileCount);
+    }
+    if (renamePlaced != 0) {
+        std::printf("undoing a rename put %zu files back\n", renamePlaced);
+        result = 1;
+    }
+
+    // A revision that moved on without a change to the layout keeps the
+    // journal; a new edit after an undo drops what could be redone.
+    ++modelRevision;
+    if (!treeJournal.undo(root) || stateOf(root) != states[made.size() - 1]) {
+        std::printf("undo after an unrelated revision failed\n");
+        result = 1;
+    }
+    {
+        ScopedJournalEntry entry(root);
+        edit(root, Edit::Rename, random, edits);
+    }
+    if (treeJournal.canRedo()) {
+        std::printf("redo is still possible after a new edit\n");
+        result = 1;
+    }
+
+    // A file added outside the journal ends the history.
+    VFile added;
+    added.name = "Outside.txt";
+    added.setOrder(root.getLastOrder() + 1);
+    root.fileList.push_back(added);
+    const size_t outside = stateOf(root);
+    if (treeJournal.undo(root) || treeJournal.entryCount() != 0 || stateOf(root) != outside) {
+        std::printf("the journal did not notice an edit made outside it\n");
+        result = 1;
+    }
+
+    // A small budget keeps the newest entries only, and they still undo.
+    const size_t budget = 64 * 1024;
+    treeJournal.setBudget(budget);
+    vector<size_t> recent{ stateOf(root) };
+    for (size_t step = 0; recent.size() <= 50; ++step) {
+        bool changed = false;
+        {
+            ScopedJournalEntry entry(root);
+            changed = edit(root, kinds[step % std::size(kinds)], random, edits + step);
+        }
+        if (changed && stateOf(root) != recent.back()) {
+            recent.push_back(stateOf(root));
+        }
+    }
+    const size_t kept = treeJournal.entryCount();
+    std::printf("budget of %zu KiB: %zu entries kept, %.1f KiB\n", budget / 1024, kept, kib(treeJournal.bytesUsed()));
+    if (kept == 0 || (kept > 1 && treeJournal.bytesUsed() > budget)) {
+        std::printf("the budget does not hold\n");
+        result = 1;
+    }
+    size_t undone = 0;
+    while (treeJournal.undo(root)) ++undone;
+    if (undone != kept || stateOf(root) != recent[recent.size() - 1 - kept]) {
+        std::printf("%zu of %zu kept entries could be undone\n", undone, kept);
+        result = 1;
+    }
+    treeJournal.setBudget(TreeJournal::defaultBudget);
+    treeJournal.clear();
+
+    if (result == 0) {
+        std::printf("undo and redo restore the model\n");
+    }
+    return result;
+}
@@ -0,0 +1,28 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+
+// --scenario undo: makes random moves, wraps, unwraps and renames on a nested
+// model through model/TreeJournal, undoes them all and redoes them all, and
+// compares the model with what it was after every step. Counts the folders
+// and files each undo puts back, checks that an edit made outside the
+// journal clears it and that the memory budget holds.
+// Returns the process exit code.
+int runUndoCheck(size_t fileCount);
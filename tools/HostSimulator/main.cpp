@@ -0,0 +1,221 @@
+// This file is part of VirtualFolders.
+// Copyright 2025 by FatihCoskun.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ContentSearchCheck.h"
+#include "FileIndexCheck.h"
+#include "RowLayoutCheck.h"
+#include "SnapshotCheck.h"
+#include "TaskSchedulerCheck.h"
+#include "TraceScript.h"
+#include "TreeRenderCheck.h"
+#include "UndoCheck.h"
+#include "OrderKeyCheck.h"
+#include "StringPoolCheck.h"
+#include "PathTrieCheck.h"
+#include "BufferStateCheck.h"
+#include "FileTableCheck.h"
+#include "FileStatCheck.h"
+#include "SiblingStepCheck.h"
+#include "NotificationBurstCheck.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+namespace {
+
+void printUsage() {
+    std::puts(
+        "Usage: host_simulator [options]\n"
+        "  --scenario restore|mass-close|rows|moves|filter|index|search|tasks|snapshots|undo|orders|strings|paths|buffers|columns|stats|siblings|bursts  Built-in workload (default: restore)\n"
+        "  --files N                                                                                                                                     Number of files for the built-in workload (default: 1000)\n"
+        "  --trace FILE                                                                                                                                  Replay a text trace (see TraceScript.h)\n"
+        "  --replay FILE                                                                                                                                 Replay a binary trace recorded by the plugin (VirtualFolders.trace)\n"
+        "  --session FILE                                                                                                                                Replay a startup with this session.xml\n"
+        "  --storage FILE                                                                                                                                Also write the storage file to disk on every save\n"
+        "  --dark                                                                                                                                        Report dark mode as enabled\n"
+        "  --coalesce                                                                                                                                    Queue opens, activations and closes and apply them once per burst");
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0;
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void printReport(const ReplayReport& report, const SimulatedPlugin& plugin, size_t populateOperations) {
+    std::printf("%-16s %8s %10s %9s %9s %9s %9s %10s %10s %9s %9s\n",
+        "handler", "calls", "total ms", "mean us", "p50 us", "p95 us", "max us", "allocs/call", "KiB/call", "host/call", "tree/call");
+    for (const auto& [name, stats] : report.handlers) {
+        const size_t calls = stats.micros.size();
+        if (calls == 0) continue;
+        double total = 0;
+        for (double micros : stats.micros) total += micros;
+        const double maxMicros = *std::max_element(stats.micros.begin(), stats.micros.end());
+        std::printf("%-16s %8zu %10.2f %9.2f %9.2f %9.2f %9.2f %10.1f %10.2f %9.1f %9.1f\n",
+            name.c_str(), calls, total / 1000.0, total / calls,
+            percentile(stats.micros, 0.50), percentile(stats.micros, 0.95), maxMicros,
+            static_cast<double>(stats.allocations) / calls,
+            static_cast<double>(stats.allocatedBytes) / calls / 1024.0,
+            static_cast<double>(stats.hostQueries) / calls,
+            static_cast<double>(stats.treeOperations) / calls);
+    }
+    std::printf("\n%zu actions in %.2f ms, %zu storage writes (last %zu bytes), %zu files in the model\n",
+        report.actions, report.wallTime.count(), plugin.storageWrites(), plugin.storageBytes(),
+        plugin.model().getAllFiles().size());
+    std::printf("tree: %zu items, %zu control operations to populate, %zu inserts and %zu deletes since\n",
+        plugin.tree().itemCount(), populateOperations,
+        plugin.tree().count(TreeOperationKind::Insert), plugin.tree().count(TreeOperationKind::Delete));
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    std::string scenario = "restore";
+    std::string traceFile;
+    std::string recordedFile;
+    std::string sessionFile;
+    std::string storageFile;
+    size_t fileCount = 1000;
+    bool darkMode = false;
+    bool coalesce = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const auto hasValue = [&]() { return i + 1 < argc; };
+        if (!std::strcmp(argv[i], "--scenario") && hasValue()) scenario = argv[++i];
+        else if (!std::strcmp(argv[i], "--files") && hasValue()) fileCount = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--trace") && hasValue()) traceFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--replay") && hasValue()) recordedFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--session") && hasValue()) sessionFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--storage") && hasValue()) storageFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--dark")) darkMode = true;
+        else if (!std::strcmp(argv[i], "--coalesce")) coalesce = true;
+        else {
+            printUsage();
+            return std::strcmp(argv[i], "--help") ? 2 : 0;
+        }
+    }
+
+    if (scenario == "rows") {
+        return runRowLayoutCheck(fileCount);
+    }
+    if (scenario == "moves") {
+        return runTreeRenderCheck(fileCount);
+    }
+    if (scenario == "filter") {
+        return runTreeFilterCheck(fileCount);
+    }
+    if (scenario == "index") {
+        return runFileIndexCheck(fileCount);
+    }
+    if (scenario == "search") {
+        return runContentSearchCheck(fileCount);
+    }
+    if (scenario == "tasks") {
+        return runTaskSchedulerCheck(fileCount);
+    }
+    if (scenario == "snapshots") {
+        return runSnapshotCheck(fileCount);
+    }
+    if (scenario == "undo") {
+        return runUndoCheck(fileCount);
+    }
+    if (scenario == "orders") {
+        return runOrderKeyCheck(fileCount);
+    }
+    if (scenario == "strings") {
+        return runStringPoolCheck(fileCount);
+    }
+    if (scenario == "paths") {
+        return runPathTrieCheck(fileCount);
+    }
+    if (scenario == "buffers") {
+        return runBufferStateCheck(fileCount);
+    }
+    if (scenario == "columns") {
+        return runFileTableCheck(fileCount);
+    }
+    if (scenario == "stats") {
+        return runFileStatCheck(fileCount);
+    }
+    if (scenario == "siblings") {
+        return runSiblingStepCheck(fileCount);
+    }
+    if (scenario == "bursts") {
+        return runNotificationBurstCheck(fileCount);
+    }
+
+    Trace trace;
+    if (!traceFile.empty()) {
+        std::ifstream input(traceFile);
+        std::string error;
+        if (!input.is_open()) {
+            std::fprintf(stderr, "Cannot open trace %s\n", traceFile.c_str());
+            return 1;
+        }
+        if (!parseTraceScript(input, trace, error)) {
+            std::fprintf(stderr, "%s: %s\n", traceFile.c_str(), error.c_str());
+            return 1;
+        }
+    }
+    else if (!recordedFile.empty()) {
+        std::ifstream input(recordedFile, std::ios::binary);
+        std::vector<NotificationRecord> records;
+        std::string error;
+        if (!input.is_open() || !readNotificationTrace(input, records, error)) {
+            std::fprintf(stderr, "%s: %s\n", recordedFile.c_str(), input.is_open() ? error.c_str() : "cannot open");
+            return 1;
+        }
+        size_t ignored = 0;
+        trace = notificationTraceScenario(records, ignored);
+        std::printf("%zu recorded notifications, %zu without a simulated handler\n\n", records.size(), ignored);
+    }
+    else if (!sessionFile.empty()) {
+        trace = sessionXmlScenario(sessionFile);
+    }
+    else if (scenario == "restore") {
+        trace = sessionRestoreScenario(fileCount);
+    }
+    else if (scenario == "mass-close") {
+        trace = massCloseScenario(fileCount);
+    }
+    else {
+        printUsage();
+        return 2;
+    }
+
+    InMemoryHostBridge host;
+    host.setDarkMode(darkMode);
+    setHostBridge(&host);
+
+    SimulatedPlugin plugin(host);
+    plugin.loadModel(trace.storedModel);
+    const size_t populateOperations = plugin.tree().operationCount();
+    plugin.resetTreeOperations();
+    plugin.setCoalescing(coalesce);
+    if (!storageFile.empty()) {
+        plugin.setStoragePath(storageFile);
+    }
+
+    const ReplayReport report = replayTrace(trace, plugin, host);
+    printReport(report, plugin, populateOperations);
+    return 0;
+}